@@ -0,0 +1,28 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+/// @brief Keep the compiler from dropping the computation of `v`.
+///
+template<typename T>
+inline auto keep(T const& v) noexcept -> void {
+    asm volatile("" : : "r,m"(v) : "memory");
+}
+
+/// @brief Time `f`, which performs `ops` operations per call, and print the best of a few runs per operation.
+///
+template<typename F>
+inline auto bench(char const* name, std::size_t ops, F&& f) -> double {
+    f();
+    auto best = 1e300;
+    for (auto round = 0; round < 5; round++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, elapsed / (double)ops);
+    }
+    std::printf("%-48s %10.2f ns/op\n", name, best);
+    return best;
+}
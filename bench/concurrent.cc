@@ -0,0 +1,89 @@
+#include "../src/concurrent.cc"
+#include "bench.cc"
+
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+constexpr usize KEYS = 1 << 20;
+
+constexpr usize OPS = 1 << 20;
+
+// What callers did before: one `HashMap` behind one mutex.
+struct Locked final {
+
+    std::mutex lock;
+
+    HashMap<u64, u64> map;
+
+    inline auto get(u64 k) -> bool {
+        auto guard = std::lock_guard(this->lock);
+        return this->map.contains(k);
+    }
+
+    inline auto insert(u64 k, u64 v) -> void {
+        auto guard = std::lock_guard(this->lock);
+        this->map.insert(k, v);
+    }
+};
+
+struct Sharded final {
+
+    ConcurrentHashMap<u64, u64> map;
+
+    inline auto get(u64 k) -> bool {
+        return this->map.get(k).is_some();
+    }
+
+    inline auto insert(u64 k, u64 v) -> void {
+        this->map.insert(k, v);
+    }
+};
+
+// `threads` threads each running `OPS` operations on a map of `KEYS` entries, `writes` in every 100 of them inserts.
+template<typename M>
+static auto run(char const* name, M& map, usize threads, usize writes) -> void {
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s threads=%zu writes=%zu%%", name, threads, writes);
+    bench(label, threads * OPS, [&] {
+        auto workers = std::vector<std::thread>();
+        for (auto t = (usize)0; t < threads; t++) {
+            workers.emplace_back([&map, t, writes] {
+                auto rng = std::mt19937_64(t);
+                auto hits = (usize)0;
+                for (auto i = (usize)0; i < OPS; i++) {
+                    auto k = rng() % (KEYS * 2);
+                    if (i % 100 < writes) map.insert(k, i);
+                    else hits += map.get(k);
+                }
+                keep(hits);
+            });
+        }
+        for (auto& w : workers) w.join();
+    });
+}
+
+auto main() -> int {
+    auto cores = (usize)std::max(std::thread::hardware_concurrency(), 1u);
+    auto counts = std::vector<usize>();
+    for (auto t = (usize)1; t < cores; t *= 2) counts.push_back(t);
+    counts.push_back(cores);
+    std::printf("aggregate time per operation, lower is better; %zu cores\n", cores);
+    for (auto writes : { (usize)0, (usize)10, (usize)50 }) {
+        for (auto threads : counts) {
+            auto locked = Locked();
+            auto sharded = Sharded();
+            for (auto k = (u64)0; k < KEYS; k++) {
+                locked.insert(k * 2, k);
+                sharded.insert(k * 2, k);
+            }
+            run("HashMap + std::mutex", locked, threads, writes);
+            run("ConcurrentHashMap", sharded, threads, writes);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "../src/hash.cc"
+#include "bench.cc"
+
+#include <bit>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace coding;
+
+constexpr usize N = 1 << 20;
+
+// The hash of `x` through a fresh hasher of `B`, or `std::hash` for `B = void`.
+template<typename B, typename T>
+static auto hash_of(T const& x) -> u64 {
+    if constexpr (std::is_void_v<B>) {
+        if constexpr (std::is_same_v<T, std::string>) return std::hash<std::string_view>{}(x);
+        else return std::hash<T>{}(x);
+    }
+    else return hash::hash_one(B(), x);
+}
+
+template<typename B>
+static auto throughput(char const* name) -> void {
+    auto rng = std::mt19937_64(42);
+    auto ints = std::vector<u64>(N);
+    for (auto& x : ints) x = rng();
+    char label[128];
+    std::snprintf(label, sizeof(label), "%s u64", name);
+    bench(label, N, [&] {
+        auto acc = (u64)0;
+        for (auto x : ints) acc ^= hash_of<B>(x);
+        keep(acc);
+    });
+    for (auto len : { (usize)8, (usize)32, (usize)256, (usize)4096 }) {
+        auto count = std::max((usize)64, N * 8 / len / 16);
+        auto strings = std::vector<std::string>(count);
+        for (auto& s : strings) {
+            s.resize(len);
+            for (auto& c : s) c = (char)rng();
+        }
+        std::snprintf(label, sizeof(label), "%s string len=%zu", name, len);
+        auto ns = bench(label, count, [&] {
+            auto acc = (u64)0;
+            for (auto& s : strings) acc ^= hash_of<B>(s);
+            keep(acc);
+        });
+        std::printf("%-48s %10.2f GB/s\n", label, (double)len / ns);
+    }
+}
+
+// How evenly keys of a pattern spread over the buckets of a table of `1 << bits` by the low bits, as the
+// Swiss table indexes: the chi-square statistic over its expected value, about 1 when uniform.
+template<typename B, typename F>
+static auto spread(F key, usize bits) -> double {
+    auto buckets = std::vector<u64>((usize)1 << bits);
+    auto n = buckets.size() * 8;
+    for (auto i = (u64)0; i < n; i++) buckets[hash_of<B>(key(i)) & (buckets.size() - 1)]++;
+    auto expected = (double)n / (double)buckets.size();
+    auto chi = 0.0;
+    for (auto b : buckets) chi += ((double)b - expected) * ((double)b - expected) / expected;
+    return chi / (double)(buckets.size() - 1);
+}
+
+// The mean fraction of output bits flipped by flipping one input bit, 0.5 for a good mix, and the worst
+// deviation from 0.5 of any input bit.
+template<typename B>
+static auto avalanche() -> std::pair<double, double> {
+    auto rng = std::mt19937_64(7);
+    auto flips = std::vector<double>(64);
+    constexpr auto SAMPLES = 4096;
+    for (auto s = 0; s < SAMPLES; s++) {
+        auto x = rng();
+        auto h = hash_of<B>(x);
+        for (auto bit = 0; bit < 64; bit++) flips[bit] += std::popcount(h ^ hash_of<B>(x ^ ((u64)1 << bit))) / 64.0;
+    }
+    auto mean = 0.0;
+    auto worst = 0.0;
+    for (auto f : flips) {
+        mean += f / SAMPLES / 64;
+        worst = std::max(worst, std::abs(f / SAMPLES - 0.5));
+    }
+    return { mean, worst };
+}
+
+template<typename B>
+static auto quality(char const* name) -> void {
+    auto [mean, worst] = avalanche<B>();
+    std::printf("%-24s sequential %6.2f  strided(4096) %6.2f  high bits %6.2f  avalanche %.3f (worst bit off by %.3f)\n", name,
+        spread<B>([](u64 i) { return i; }, 16),
+        spread<B>([](u64 i) { return i * 4096; }, 16),
+        spread<B>([](u64 i) { return i << 40; }, 16),
+        mean, worst);
+}
+
+auto main() -> int {
+    std::printf("throughput\n");
+    throughput<hash::FixedState>("WyHasher");
+    throughput<hash::FxState>("FxHasher");
+    throughput<void>("std::hash");
+    std::printf("\ndistribution over 65536 low-bit buckets, chi-square / expected (about 1 is uniform)\n");
+    quality<hash::FixedState>("WyHasher");
+    quality<hash::FxState>("FxHasher");
+    quality<void>("std::hash");
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "../src/hashmap.cc"
+#include "bench.cc"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+static auto label(char const* name, usize n, char const* what) -> char const* {
+    static char buf[128];
+    std::snprintf(buf, sizeof(buf), "%s %s n=%zu", name, what, n);
+    return buf;
+}
+
+// Insert, hit and miss workloads on `HashMap` against `std::unordered_map`, which it replaced.
+template<typename Map>
+static auto run(char const* name, std::vector<u64> const& keys, std::vector<u64> const& misses) -> void {
+    auto n = keys.size();
+    bench(label(name, n, "insert"), n, [&] {
+        auto map = Map();
+        for (auto k : keys) map[k] = k;
+        keep(map.size());
+    });
+    auto map = Map();
+    for (auto k : keys) map[k] = k;
+    bench(label(name, n, "hit"), n, [&] {
+        auto sum = (u64)0;
+        for (auto k : keys) sum += map.find(k)->second;
+        keep(sum);
+    });
+    bench(label(name, n, "miss"), n, [&] {
+        auto found = (usize)0;
+        for (auto k : misses) found += map.find(k) != map.end();
+        keep(found);
+    });
+}
+
+// The same through this repo's interface.
+template<typename H>
+static auto run_ours(char const* name, std::vector<u64> const& keys, std::vector<u64> const& misses) -> void {
+    auto n = keys.size();
+    bench(label(name, n, "insert"), n, [&] {
+        auto map = HashMap<u64, u64, H>();
+        for (auto k : keys) map.insert(k, k);
+        keep(map.len());
+    });
+    auto map = HashMap<u64, u64, H>();
+    for (auto k : keys) map.insert(k, k);
+    bench(label(name, n, "hit"), n, [&] {
+        auto sum = (u64)0;
+        for (auto k : keys) sum += *map.get(k);
+        keep(sum);
+    });
+    bench(label(name, n, "miss"), n, [&] {
+        auto found = (usize)0;
+        for (auto k : misses) found += map.contains(k);
+        keep(found);
+    });
+}
+
+auto main() -> int {
+    auto rng = std::mt19937_64(38);
+    for (auto n : { (usize)1000, (usize)100000, (usize)4000000 }) {
+        auto keys = std::vector<u64>(n);
+        auto misses = std::vector<u64>(n);
+        // Even keys are present, odd ones are not.
+        for (auto& k : keys) k = rng() & ~(u64)1;
+        for (auto& k : misses) k = rng() | 1;
+        run<std::unordered_map<u64, u64>>("std::unordered_map", keys, misses);
+        run_ours<hash::RandomState>("HashMap<RandomState>", keys, misses);
+        run_ours<hash::FxState>("HashMap<FxState>", keys, misses);
+    }
+    // Text keys, looked up by `str` without building a `String`.
+    auto words = std::vector<std::string>();
+    for (auto i = 0; i < 100000; i++) words.push_back("key-" + std::to_string(rng()));
+    auto ours = HashMap<String, u32>();
+    auto theirs = std::unordered_map<std::string, u32>();
+    for (auto i = 0u; i < words.size(); i++) {
+        ours.insert(String(words[i].c_str()), i);
+        theirs[words[i]] = i;
+    }
+    bench("std::unordered_map<std::string> hit n=100000", words.size(), [&] {
+        auto sum = (u64)0;
+        for (auto& w : words) sum += theirs.find(w)->second;
+        keep(sum);
+    });
+    bench("HashMap<String> hit by str n=100000", words.size(), [&] {
+        auto sum = (u64)0;
+        for (auto& w : words) sum += *ours.get(str(w.c_str()));
+        keep(sum);
+    });
+    return 0;
+}
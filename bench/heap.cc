@@ -0,0 +1,64 @@
+#include "../src/heap.cc"
+#include "bench.cc"
+
+#include <queue>
+#include <random>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+// Push every value then pop them all, heapify from a vector, and `push_pop` on a full heap.
+template<usize D>
+static auto arity(std::vector<u64> const& values) -> void {
+    auto n = values.size();
+    char label[128];
+    std::snprintf(label, sizeof(label), "DaryHeap<D=%zu> push+pop n=%zu", D, n);
+    bench(label, n, [&] {
+        auto heap = DaryHeap<u64, D>::with_capacity(n);
+        for (auto v : values) heap.push(v);
+        auto sum = (u64)0;
+        while (!heap.is_empty()) sum += heap.pop().unwrap();
+        keep(sum);
+    });
+    std::snprintf(label, sizeof(label), "DaryHeap<D=%zu> from_vec n=%zu", D, n);
+    bench(label, n, [&] {
+        auto heap = DaryHeap<u64, D>::from_vec(values);
+        keep(*heap.peek());
+    });
+    std::snprintf(label, sizeof(label), "DaryHeap<D=%zu> push_pop n=%zu", D, n);
+    auto full = DaryHeap<u64, D>::from_vec(values);
+    bench(label, n, [&] {
+        auto sum = (u64)0;
+        for (auto v : values) sum += full.push_pop(v >> 1);
+        keep(sum);
+    });
+    std::snprintf(label, sizeof(label), "IndexedHeap<D=%zu> decrease_key n=%zu", D, n);
+    bench(label, n, [&] {
+        auto heap = IndexedHeap<u64, D>::with_capacity(n);
+        for (auto id = (usize)0; id < n; id++) heap.push(id, values[id] | ((u64)1 << 63));
+        for (auto id = (usize)0; id < n; id++) heap.decrease_key(values[id] % n, values[id] >> 2);
+        keep(heap.peek()->key);
+    });
+}
+
+auto main() -> int {
+    auto rng = std::mt19937_64(46);
+    for (auto n : { (usize)100000, (usize)4000000 }) {
+        auto values = std::vector<u64>(n);
+        for (auto& v : values) v = rng() >> 1;
+        char label[128];
+        std::snprintf(label, sizeof(label), "std::priority_queue push+pop n=%zu", n);
+        bench(label, n, [&] {
+            auto heap = std::priority_queue<u64>();
+            for (auto v : values) heap.push(v);
+            auto sum = (u64)0;
+            for (; !heap.empty(); heap.pop()) sum += heap.top();
+            keep(sum);
+        });
+        arity<2>(values);
+        arity<4>(values);
+        arity<8>(values);
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include "../src/measure.cc"
+#include "bench.cc"
+
+#include <random>
+#include <vector>
+
+using namespace coding;
+using namespace coding::measure;
+
+// A sum and an axpy over `Length` against the same over `double`, which should time alike, then the `convert`
+// kernels against a plain loop.
+auto main() -> int {
+    auto rng = std::mt19937_64(50);
+    for (auto n : { (usize)4096, (usize)4000000 }) {
+        auto numbers = std::vector<double>(n);
+        for (auto& x : numbers) x = (double)(rng() >> 11) * 0x1p-53;
+        auto lengths = std::vector<Length>(n);
+        for (auto i = (usize)0; i < n; i++) lengths[i] = Length(numbers[i]);
+        auto out = std::vector<double>(n);
+        auto quantities = std::vector<Length>(n);
+        char label[128];
+
+        std::snprintf(label, sizeof(label), "double sum n=%zu", n);
+        bench(label, n, [&] {
+            auto sum = 0.0;
+            for (auto x : numbers) sum += x;
+            keep(sum);
+        });
+        std::snprintf(label, sizeof(label), "Length sum n=%zu", n);
+        bench(label, n, [&] {
+            auto sum = Length();
+            for (auto x : lengths) sum += x;
+            keep(sum);
+        });
+        std::snprintf(label, sizeof(label), "double axpy n=%zu", n);
+        bench(label, n, [&] {
+            for (auto i = (usize)0; i < n; i++) out[i] = out[i] * 0.5 + numbers[i] * 2.0;
+            keep(out[n / 2]);
+        });
+        std::snprintf(label, sizeof(label), "Length axpy n=%zu", n);
+        bench(label, n, [&] {
+            for (auto i = (usize)0; i < n; i++) quantities[i] = quantities[i] * 0.5 + lengths[i] * 2.0;
+            keep(quantities[n / 2]);
+        });
+
+        std::snprintf(label, sizeof(label), "plain loop ft->m n=%zu", n);
+        bench(label, n, [&] {
+            for (auto i = (usize)0; i < n; i++) out[i] = numbers[i] * 0.3048;
+            keep(out[n / 2]);
+        });
+        std::snprintf(label, sizeof(label), "convert ft->m numbers n=%zu", n);
+        bench(label, n, [&] {
+            convert(numbers, 1.0_ft, 1.0_m, out);
+            keep(out[n / 2]);
+        });
+        std::snprintf(label, sizeof(label), "convert ft->Length n=%zu", n);
+        bench(label, n, [&] {
+            convert(numbers, 1.0_ft, quantities);
+            keep(quantities[n / 2]);
+        });
+        std::snprintf(label, sizeof(label), "convert Length->ft n=%zu", n);
+        bench(label, n, [&] {
+            convert(lengths, 1.0_ft, out);
+            keep(out[n / 2]);
+        });
+    }
+    return 0;
+}
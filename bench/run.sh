@@ -0,0 +1,18 @@
+#!/bin/sh
+# Build and run the benchmark drivers, all of them or those named: `bench/run.sh [hashmap ...]`.
+# Drivers are single files including the headers under `src/` by relative path, built optimized for this machine.
+set -e
+dir=$(cd "$(dirname "$0")" && pwd)
+out=${TMPDIR:-/tmp}/coding-bench
+mkdir -p "$out"
+cxx=${CXX:-g++}
+flags=${CXXFLAGS:--std=c++20 -O2 -march=native -DNDEBUG -pthread}
+names=$*
+if [ -z "$names" ]; then
+    names=$(cd "$dir" && ls *.cc | sed 's/\.cc$//' | grep -v '^bench$')
+fi
+for name in $names; do
+    echo "== $name"
+    $cxx $flags "$dir/$name.cc" -o "$out/$name"
+    "$out/$name"
+done
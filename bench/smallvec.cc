@@ -0,0 +1,79 @@
+#include "../src/smallvec.cc"
+#include "bench.cc"
+
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+static usize allocations = 0;
+
+auto operator new(std::size_t n) -> void* {
+    allocations++;
+    if (auto p = std::malloc(n)) return p;
+    throw std::bad_alloc();
+}
+
+auto operator new(std::size_t n, std::align_val_t a) -> void* {
+    allocations++;
+    if (auto p = std::aligned_alloc((std::size_t)a, (n + (std::size_t)a - 1) / (std::size_t)a * (std::size_t)a)) return p;
+    throw std::bad_alloc();
+}
+
+auto operator delete(void* p) noexcept -> void { std::free(p); }
+auto operator delete(void* p, std::size_t) noexcept -> void { std::free(p); }
+auto operator delete(void* p, std::align_val_t) noexcept -> void { std::free(p); }
+auto operator delete(void* p, std::size_t, std::align_val_t) noexcept -> void { std::free(p); }
+
+constexpr usize LISTS = 100000;
+
+// Short lists as a parser builds them, of 1 to `most` elements, each built, read and dropped.
+template<typename V>
+static auto lists(char const* name, std::vector<u32> const& sizes) -> void {
+    auto before = allocations;
+    bench(name, LISTS, [&] {
+        auto sum = (u64)0;
+        for (auto i = (usize)0; i < LISTS; i++) {
+            auto v = V();
+            for (auto k = (u32)0; k < sizes[i]; k++) v.push_back(k * i);
+            for (auto x : v) sum += x;
+        }
+        keep(sum);
+    });
+    // `bench` runs the body six times.
+    std::printf("%-48s %10.2f allocations/op\n", name, (double)(allocations - before) / (6.0 * LISTS));
+}
+
+// Moving vectors around, as when they sit in a growing `std::vector`.
+template<typename V>
+static auto moves(char const* name) -> void {
+    bench(name, LISTS, [&] {
+        auto outer = std::vector<V>();
+        for (auto i = (usize)0; i < LISTS; i++) {
+            auto v = V();
+            for (auto k = (u32)0; k < 4; k++) v.push_back(k);
+            outer.push_back(mv(v));
+        }
+        keep(outer.size());
+    });
+}
+
+auto main() -> int {
+    auto rng = std::mt19937_64(41);
+    for (auto most : { 4u, 8u, 16u }) {
+        auto sizes = std::vector<u32>(LISTS);
+        for (auto& n : sizes) n = 1 + (u32)(rng() % most);
+        std::printf("lists of 1 to %u u32\n", most);
+        lists<std::vector<u32>>("std::vector<u32>", sizes);
+        lists<SmallVec<u32, 8>>("SmallVec<u32, 8>", sizes);
+        if (most <= 8) lists<ArrayVec<u32, 8>>("ArrayVec<u32, 8>", sizes);
+    }
+    std::printf("vectors of 4 moved into a growing std::vector\n");
+    moves<std::vector<u32>>("std::vector<u32>");
+    moves<SmallVec<u32, 4>>("SmallVec<u32, 4>");
+    return 0;
+}
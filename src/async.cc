@@ -0,0 +1,1164 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "measure.cc"
+#include "mutex.cc"
+#include "option.cc"
+#include "result.cc"
+#include "str.cc"
+#include "thread.cc"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <coroutine>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <queue>
+#include <span>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define CODING_ASYNC_IO_URING
+#endif
+
+/// @brief Coroutine-based asynchronous I/O.
+///
+/// `Task<T>` is a lazy coroutine: it starts when awaited or handed to a runtime.
+/// `Runtime` drives tasks and its `Reactor` on the calling thread, `ThreadedRuntime` on a set of workers
+/// plus one reactor thread. The reactor waits on `epoll` for pipes and sockets, and submits regular-file
+/// reads and writes to `io_uring` when the kernel supports it (they are done synchronously otherwise).
+///
+namespace coding::async {
+
+    using thread::RawMutex;
+
+    namespace futex = thread::futex;
+
+    /// @brief An `errno` value.
+    ///
+    using Errno = int;
+
+    /// @brief The result of an I/O operation.
+    /// @tparam T the `Ok` type
+    ///
+    template<typename T> using IoResult = Result<T, Errno>;
+
+    using Clock = std::chrono::steady_clock;
+
+    class Reactor;
+
+    /// @brief Something that resumes coroutines. The runtime of the current thread is `Executor::current`.
+    ///
+    class Executor {
+
+    public:
+
+        virtual ~Executor() = default;
+
+        /// @brief Queue a suspended coroutine to be resumed. Callable from any thread.
+        ///
+        virtual auto schedule(std::coroutine_handle<> h) noexcept -> void = 0;
+
+        /// @brief The reactor completing this executor's I/O and timers.
+        ///
+        virtual auto reactor() noexcept -> Reactor& = 0;
+
+        /// @brief The executor running on the current thread, if any.
+        ///
+        inline static thread_local Executor* current = nullptr;
+
+        /// @brief The executor running on the current thread.
+        ///
+        /// # Panic
+        ///
+        /// Panics if called outside of a runtime.
+        ///
+        inline static auto get() noexcept -> Executor& {
+            if (!current) panic("no async runtime on the current thread");
+            return *current;
+        }
+    };
+
+    template<typename T>
+    struct PromiseValue {
+
+        Option<T> value;
+
+        inline auto return_value(T v) noexcept {
+            this->value = Option<T>(mv(v));
+        }
+
+        inline auto take() noexcept -> T {
+            return mv(this->value).unwrap();
+        }
+    };
+
+    template<>
+    struct PromiseValue<void> {
+
+        inline auto return_void() noexcept {}
+
+        inline auto take() noexcept {}
+    };
+
+    /// @brief A lazily started coroutine producing `T`. Acts like a Rust `Future`.
+    /// @note Awaiting a `Task` transfers control symmetrically, so deep `co_await` chains do not grow the stack.
+    /// @tparam T the output type, may be `void`
+    ///
+    template<typename T = void>
+    class Task final {
+
+    public:
+
+        struct promise_type : PromiseValue<T> {
+
+            /// @brief Who to resume when this task finishes.
+            ///
+            std::coroutine_handle<> continuation = std::noop_coroutine();
+
+            inline auto get_return_object() noexcept -> Task {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            inline auto initial_suspend() noexcept -> std::suspend_always {
+                return {};
+            }
+
+            struct Final {
+
+                inline auto await_ready() noexcept -> bool {
+                    return false;
+                }
+
+                inline auto await_suspend(std::coroutine_handle<promise_type> h) noexcept -> std::coroutine_handle<> {
+                    return h.promise().continuation;
+                }
+
+                inline auto await_resume() noexcept {}
+            };
+
+            inline auto final_suspend() noexcept -> Final {
+                return {};
+            }
+
+            inline auto unhandled_exception() noexcept {
+                panic("unhandled exception in `Task`");
+            }
+        };
+
+        using Handle = std::coroutine_handle<promise_type>;
+
+    private:
+
+        Handle h;
+
+    public:
+
+        inline explicit Task(Handle h) noexcept : h(h) {}
+
+        Task(Task const&) = delete;
+
+        inline Task(Task&& other) noexcept : h(std::exchange(other.h, nullptr)) {}
+
+        inline ~Task() noexcept {
+            if (this->h) this->h.destroy();
+        }
+
+        inline auto operator co_await() noexcept {
+            struct Awaiter {
+
+                Handle h;
+
+                inline auto await_ready() noexcept -> bool {
+                    return false;
+                }
+
+                inline auto await_suspend(std::coroutine_handle<> caller) noexcept -> std::coroutine_handle<> {
+                    this->h.promise().continuation = caller;
+                    return this->h;
+                }
+
+                inline auto await_resume() noexcept -> T {
+                    return this->h.promise().take();
+                }
+            };
+            return Awaiter{ this->h };
+        }
+
+        /// @brief The underlying coroutine.
+        ///
+        inline auto handle() const noexcept -> Handle {
+            return this->h;
+        }
+
+        /// @brief Take the output of a finished task.
+        /// @warning The behaviour is undefined unless the task is done.
+        ///
+        inline auto take() noexcept -> T {
+            return this->h.promise().take();
+        }
+    };
+
+    /// @brief A fire-and-forget coroutine that frees itself when finished.
+    ///
+    struct Detached final {
+
+        struct promise_type {
+
+            inline auto get_return_object() noexcept -> Detached {
+                return Detached{ std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+
+            inline auto initial_suspend() noexcept -> std::suspend_always {
+                return {};
+            }
+
+            inline auto final_suspend() noexcept -> std::suspend_never {
+                return {};
+            }
+
+            inline auto return_void() noexcept {}
+
+            inline auto unhandled_exception() noexcept {
+                panic("unhandled exception in a detached task");
+            }
+        };
+
+        std::coroutine_handle<promise_type> h;
+    };
+
+    inline auto detach(Task<void> task) noexcept -> Detached {
+        co_await task;
+    }
+
+    template<typename T> using Value = std::conditional_t<std::is_void_v<T>, unit, T>;
+
+    /// @brief Run `task`, then store its output and signal `done`.
+    ///
+    template<typename T>
+    inline auto complete(Task<T> task, Option<Value<T>>* out, thread::Done* done) noexcept -> Detached {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            *out = Option<unit>(unit());
+        }
+        else *out = Option<T>(co_await task);
+        done->set();
+    }
+
+    /// @brief A pending operation parked in the reactor.
+    ///
+    struct Waiter {
+
+        /// @brief Retry the operation once the descriptor is ready.
+        /// @return `false` if it would still block
+        ///
+        bool (*attempt)(Waiter*) noexcept;
+
+        /// @brief The suspended coroutine.
+        ///
+        std::coroutine_handle<> h = nullptr;
+
+        /// @brief Where to resume `h`.
+        ///
+        Executor* ex = nullptr;
+
+        /// @brief Non-negative result, or a negated `errno`.
+        ///
+        isize result = 0;
+    };
+
+    /// @brief Readiness interest of one descriptor: at most one pending reader and one pending writer.
+    ///
+    struct Registration final {
+
+        RawMutex lock = RawMutex();
+
+        int fd;
+
+        Waiter* reader = nullptr;
+
+        Waiter* writer = nullptr;
+
+        bool added = false;
+    };
+
+#ifdef CODING_ASYNC_IO_URING
+    /// @brief A minimal `io_uring` instance driven through raw system calls.
+    ///
+    class Uring final {
+
+    private:
+
+        int ring = -1;
+
+        u8* sq_ptr = nullptr;
+
+        usize sq_size = 0;
+
+        u8* cq_ptr = nullptr;
+
+        usize cq_size = 0;
+
+        io_uring_sqe* sqes = nullptr;
+
+        usize sqes_size = 0;
+
+        u32 *sq_head, *sq_tail, *sq_mask, *sq_array, *cq_head, *cq_tail, *cq_mask;
+
+        u32 entries = 0;
+
+        io_uring_cqe* cqes;
+
+        RawMutex lock;
+
+    public:
+
+        /// @brief Try to set up a ring, `is_available()` tells whether it worked.
+        /// @param n number of submission entries, `0` for no ring
+        ///
+        inline Uring(u32 n) noexcept {
+            if (n == 0) return;
+            auto p = io_uring_params();
+            std::memset(&p, 0, sizeof(p));
+            auto fd = (int)syscall(__NR_io_uring_setup, n, &p);
+            if (fd < 0) return;
+            this->sq_size = p.sq_off.array + p.sq_entries * sizeof(u32);
+            this->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+            auto single = p.features & IORING_FEAT_SINGLE_MMAP;
+            if (single) this->sq_size = this->cq_size = std::max(this->sq_size, this->cq_size);
+            auto sq = mmap(nullptr, this->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if (sq == MAP_FAILED) {
+                ::close(fd);
+                return;
+            }
+            this->sq_ptr = (u8*)sq;
+            if (single) this->cq_ptr = this->sq_ptr;
+            else {
+                auto cq = mmap(nullptr, this->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                if (cq == MAP_FAILED) {
+                    munmap(this->sq_ptr, this->sq_size);
+                    ::close(fd);
+                    return;
+                }
+                this->cq_ptr = (u8*)cq;
+            }
+            this->sqes_size = p.sq_entries * sizeof(io_uring_sqe);
+            auto sqes = mmap(nullptr, this->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED) {
+                if (this->cq_ptr != this->sq_ptr) munmap(this->cq_ptr, this->cq_size);
+                munmap(this->sq_ptr, this->sq_size);
+                ::close(fd);
+                return;
+            }
+            this->sqes = (io_uring_sqe*)sqes;
+            this->sq_head = (u32*)(this->sq_ptr + p.sq_off.head);
+            this->sq_tail = (u32*)(this->sq_ptr + p.sq_off.tail);
+            this->sq_mask = (u32*)(this->sq_ptr + p.sq_off.ring_mask);
+            this->sq_array = (u32*)(this->sq_ptr + p.sq_off.array);
+            this->cq_head = (u32*)(this->cq_ptr + p.cq_off.head);
+            this->cq_tail = (u32*)(this->cq_ptr + p.cq_off.tail);
+            this->cq_mask = (u32*)(this->cq_ptr + p.cq_off.ring_mask);
+            this->cqes = (io_uring_cqe*)(this->cq_ptr + p.cq_off.cqes);
+            this->entries = p.sq_entries;
+            this->ring = fd;
+        }
+
+        Uring(Uring const&) = delete;
+
+        inline ~Uring() noexcept {
+            if (this->ring < 0) return;
+            munmap(this->sqes, this->sqes_size);
+            if (this->cq_ptr != this->sq_ptr) munmap(this->cq_ptr, this->cq_size);
+            munmap(this->sq_ptr, this->sq_size);
+            ::close(this->ring);
+        }
+
+        inline auto is_available() const noexcept -> bool {
+            return this->ring >= 0;
+        }
+
+        /// @brief The ring descriptor, readable while completions are pending.
+        ///
+        inline auto fd() const noexcept -> int {
+            return this->ring;
+        }
+
+        /// @brief Submit one read or write at the current file position.
+        /// @return `false` if the ring is full or the submission failed, and then the kernel never sees the entry
+        ///
+        inline auto submit(u8 opcode, int fd, void* buf, u32 len, u64 user_data) noexcept -> bool {
+            this->lock.lock();
+            auto tail = std::atomic_ref(*this->sq_tail).load(std::memory_order_relaxed);
+            auto head = std::atomic_ref(*this->sq_head).load(std::memory_order_acquire);
+            if (tail - head >= this->entries) {
+                this->lock.unlock();
+                return false;
+            }
+            auto idx = tail & *this->sq_mask;
+            auto sqe = &this->sqes[idx];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = opcode;
+            sqe->fd = fd;
+            sqe->addr = (u64)buf;
+            sqe->len = len;
+            sqe->off = (u64)-1;
+            sqe->user_data = user_data;
+            this->sq_array[idx] = idx;
+            std::atomic_ref(*this->sq_tail).store(tail + 1, std::memory_order_release);
+            auto n = syscall(__NR_io_uring_enter, this->ring, 1, 0, 0, nullptr, 0);
+            while (n < 0 && errno == EINTR) n = syscall(__NR_io_uring_enter, this->ring, 1, 0, 0, nullptr, 0);
+            // The kernel only reads the ring inside `io_uring_enter`: an entry it did not consume is taken back,
+            // so that the caller running the operation itself never runs it a second time.
+            auto ok = std::atomic_ref(*this->sq_head).load(std::memory_order_acquire) != head;
+            if (!ok) std::atomic_ref(*this->sq_tail).store(tail, std::memory_order_release);
+            this->lock.unlock();
+            return ok;
+        }
+
+        /// @brief Consume every available completion.
+        /// @param f called with the `user_data` and result of each completion
+        ///
+        template<typename F>
+        inline auto reap(F f) noexcept {
+            auto head = std::atomic_ref(*this->cq_head).load(std::memory_order_relaxed);
+            auto tail = std::atomic_ref(*this->cq_tail).load(std::memory_order_acquire);
+            for (; head != tail; head++) {
+                auto cqe = &this->cqes[head & *this->cq_mask];
+                f(cqe->user_data, cqe->res);
+            }
+            std::atomic_ref(*this->cq_head).store(head, std::memory_order_release);
+        }
+    };
+#endif
+
+    /// @brief Waits for descriptor readiness, file completions and timer deadlines, then schedules the waiting coroutines.
+    ///
+    class Reactor final {
+
+    private:
+
+        struct Timer {
+
+            Clock::time_point at;
+
+            u64 seq;
+
+            std::coroutine_handle<> h;
+
+            Executor* ex;
+
+            inline auto operator>(Timer const& rhs) const noexcept -> bool {
+                return this->at != rhs.at ? this->at > rhs.at : this->seq > rhs.seq;
+            }
+        };
+
+        int epfd;
+
+        /// @brief An `eventfd` interrupting `epoll_wait`.
+        ///
+        int wakefd;
+
+        RawMutex timers_lock;
+
+        std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers;
+
+        u64 seq = 0;
+
+#ifdef CODING_ASYNC_IO_URING
+        Uring ring;
+#endif
+
+        /// @brief Arm the one-shot interest of `r`, the caller holds `r.lock`.
+        ///
+        inline auto arm(Registration& r) noexcept {
+            auto e = epoll_event();
+            e.events = EPOLLONESHOT | (r.reader ? (u32)(EPOLLIN | EPOLLRDHUP) : 0) | (r.writer ? (u32)EPOLLOUT : 0);
+            e.data.ptr = &r;
+            if (!r.added) {
+                epoll_ctl(this->epfd, EPOLL_CTL_ADD, r.fd, &e);
+                r.added = true;
+            }
+            else epoll_ctl(this->epfd, EPOLL_CTL_MOD, r.fd, &e);
+        }
+
+        inline auto dispatch(Registration& r, u32 events) noexcept {
+            Waiter* done[2];
+            auto n = 0;
+            r.lock.lock();
+            if (r.reader && (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) && r.reader->attempt(r.reader)) {
+                done[n++] = r.reader;
+                r.reader = nullptr;
+            }
+            if (r.writer && (events & (EPOLLOUT | EPOLLHUP | EPOLLERR)) && r.writer->attempt(r.writer)) {
+                done[n++] = r.writer;
+                r.writer = nullptr;
+            }
+            if (r.reader || r.writer) this->arm(r);
+            r.lock.unlock();
+            for (auto i = 0; i < n; i++) done[i]->ex->schedule(done[i]->h);
+        }
+
+        inline auto expire() noexcept {
+            auto now = Clock::now();
+            auto due = std::vector<Timer>();
+            this->timers_lock.lock();
+            while (!this->timers.empty() && this->timers.top().at <= now) {
+                due.push_back(this->timers.top());
+                this->timers.pop();
+            }
+            this->timers_lock.unlock();
+            for (auto& t : due) t.ex->schedule(t.h);
+        }
+
+    public:
+
+        /// @brief Whether a thread is blocked (or about to block) in `poll`.
+        ///
+        std::atomic<bool> sleeping = false;
+
+        /// @brief Create the `epoll` instance.
+        /// @param uring whether to submit regular-file reads and writes to `io_uring` when the kernel supports it
+        ///
+        /// # Panic
+        ///
+        /// Panics if the kernel refuses to create one.
+        ///
+#ifdef CODING_ASYNC_IO_URING
+        inline explicit Reactor(bool uring = true) noexcept : ring(uring ? 256 : 0) {
+#else
+        inline explicit Reactor([[maybe_unused]] bool uring = true) noexcept {
+#endif
+            this->epfd = epoll_create1(EPOLL_CLOEXEC);
+            this->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (this->epfd < 0 || this->wakefd < 0) panic("failed to create the async reactor");
+            auto e = epoll_event();
+            e.events = EPOLLIN;
+            e.data.ptr = nullptr;
+            epoll_ctl(this->epfd, EPOLL_CTL_ADD, this->wakefd, &e);
+#ifdef CODING_ASYNC_IO_URING
+            if (this->ring.is_available()) {
+                e.data.ptr = &this->ring;
+                epoll_ctl(this->epfd, EPOLL_CTL_ADD, this->ring.fd(), &e);
+            }
+#endif
+        }
+
+        Reactor(Reactor const&) = delete;
+
+        inline ~Reactor() noexcept {
+            ::close(this->wakefd);
+            ::close(this->epfd);
+        }
+
+        /// @brief Interrupt a blocked `poll`.
+        ///
+        inline auto wake() noexcept {
+            auto one = (u64)1;
+            [[maybe_unused]] auto _ = ::write(this->wakefd, &one, sizeof(one));
+        }
+
+        /// @brief Resume `h` on `ex` once `at` has passed.
+        ///
+        inline auto add_timer(Clock::time_point at, std::coroutine_handle<> h, Executor* ex) noexcept {
+            this->timers_lock.lock();
+            this->timers.push(Timer{ at, this->seq++, h, ex });
+            auto earliest = this->timers.top().h == h;
+            this->timers_lock.unlock();
+            if (earliest && this->sleeping.load(std::memory_order_seq_cst)) this->wake();
+        }
+
+        /// @brief Park `w` until `r` becomes readable or writable, then retry it.
+        ///
+        inline auto wait(Registration& r, Waiter* w, bool write) noexcept {
+            r.lock.lock();
+            if (write) r.writer = w;
+            else r.reader = w;
+            this->arm(r);
+            r.lock.unlock();
+        }
+
+        /// @brief Stop watching a descriptor before it is closed.
+        ///
+        inline auto remove(Registration& r) noexcept {
+            if (r.added) epoll_ctl(this->epfd, EPOLL_CTL_DEL, r.fd, nullptr);
+            r.added = false;
+        }
+
+        /// @brief Whether regular-file operations go through `io_uring`.
+        ///
+        inline auto has_uring() const noexcept -> bool {
+#ifdef CODING_ASYNC_IO_URING
+            return this->ring.is_available();
+#else
+            return false;
+#endif
+        }
+
+        /// @brief Submit a regular-file read or write, completing `w` later.
+        /// @return `false` if it could not be submitted
+        ///
+        inline auto submit(Waiter* w, bool write, int fd, void* buf, usize len) noexcept -> bool {
+#ifdef CODING_ASYNC_IO_URING
+            auto opcode = (u8)(write ? IORING_OP_WRITE : IORING_OP_READ);
+            return this->ring.is_available() && this->ring.submit(opcode, fd, buf, (u32)std::min(len, (usize)UINT32_MAX), (u64)w);
+#else
+            return false;
+#endif
+        }
+
+        /// @brief Wait for events once and schedule everything that became ready.
+        /// @param block whether to block until something happens, bounded by the earliest timer
+        ///
+        inline auto poll(bool block) noexcept {
+            auto timeout = 0;
+            if (block) {
+                this->sleeping.store(true, std::memory_order_seq_cst);
+                timeout = -1;
+                this->timers_lock.lock();
+                if (!this->timers.empty()) {
+                    auto d = this->timers.top().at - Clock::now();
+                    timeout = d <= Clock::duration::zero() ? 0 : (int)std::chrono::ceil<std::chrono::milliseconds>(d).count();
+                }
+                this->timers_lock.unlock();
+            }
+            epoll_event events[64];
+            auto n = epoll_wait(this->epfd, events, 64, timeout);
+            this->sleeping.store(false, std::memory_order_relaxed);
+            for (auto i = 0; i < n; i++) {
+                auto p = events[i].data.ptr;
+                if (p == nullptr) {
+                    auto v = (u64)0;
+                    [[maybe_unused]] auto _ = ::read(this->wakefd, &v, sizeof(v));
+                }
+#ifdef CODING_ASYNC_IO_URING
+                else if (p == &this->ring) {
+                    this->ring.reap([](u64 user_data, i32 res) {
+                        auto w = (Waiter*)user_data;
+                        w->result = res;
+                        w->ex->schedule(w->h);
+                    });
+                }
+#endif
+                else this->dispatch(*(Registration*)p, events[i].events);
+            }
+            this->expire();
+        }
+    };
+
+    /// @brief Awaitable suspending the current task until a deadline.
+    ///
+    struct Sleep final {
+
+        Clock::time_point at;
+
+        inline auto await_ready() const noexcept -> bool {
+            return Clock::now() >= this->at;
+        }
+
+        inline auto await_suspend(std::coroutine_handle<> h) const noexcept {
+            auto& ex = Executor::get();
+            ex.reactor().add_timer(this->at, h, &ex);
+        }
+
+        inline auto await_resume() const noexcept {}
+    };
+
+    /// @brief Suspend the current task until `at`.
+    ///
+    inline auto sleep_until(Clock::time_point at) noexcept -> Sleep {
+        return Sleep{ at };
+    }
+
+    /// @brief Suspend the current task for a while.
+    /// @param t the duration
+    ///
+    inline auto sleep(measure::Time t) noexcept -> Sleep {
+        return Sleep{ Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(t.value())) };
+    }
+
+    /// @brief A single-threaded runtime, driving tasks and the reactor on the thread calling `block_on`.
+    ///
+    class Runtime final : public Executor {
+
+    private:
+
+        Reactor r;
+
+        RawMutex lock;
+
+        std::deque<std::coroutine_handle<>> ready;
+
+        inline auto has_ready() noexcept -> bool {
+            this->lock.lock();
+            auto ans = !this->ready.empty();
+            this->lock.unlock();
+            return ans;
+        }
+
+        inline auto run_ready() noexcept {
+            auto batch = std::deque<std::coroutine_handle<>>();
+            this->lock.lock();
+            batch.swap(this->ready);
+            this->lock.unlock();
+            for (auto h : batch) h.resume();
+        }
+
+    public:
+
+        /// @brief Create the runtime.
+        /// @param uring whether regular files go through `io_uring` when the kernel supports it, `false` to read and
+        /// write them synchronously
+        ///
+        inline explicit Runtime(bool uring = true) noexcept : r(uring) {}
+
+        Runtime(Runtime const&) = delete;
+
+        inline auto schedule(std::coroutine_handle<> h) noexcept -> void override {
+            this->lock.lock();
+            this->ready.push_back(h);
+            this->lock.unlock();
+            if (this->r.sleeping.load(std::memory_order_seq_cst)) this->r.wake();
+        }
+
+        inline auto reactor() noexcept -> Reactor& override {
+            return this->r;
+        }
+
+        /// @brief Start a task in the background. It runs whenever `block_on` drives this runtime.
+        ///
+        inline auto spawn(Task<void> task) noexcept {
+            this->schedule(detach(mv(task)).h);
+        }
+
+        /// @brief Drive the runtime until `task` finishes.
+        /// @return the output of `task`
+        ///
+        template<typename T>
+        inline auto block_on(Task<T> task) noexcept -> T {
+            auto outer = Executor::current;
+            Executor::current = this;
+            auto h = task.handle();
+            this->schedule(h);
+            loop {
+                this->run_ready();
+                if (h.done()) break;
+                this->r.sleeping.store(true, std::memory_order_seq_cst);
+                if (this->has_ready()) {
+                    this->r.sleeping.store(false, std::memory_order_relaxed);
+                    continue;
+                }
+                this->r.poll(true);
+            }
+            Executor::current = outer;
+            return task.take();
+        }
+    };
+
+    /// @brief A multi-threaded runtime: worker threads resume tasks from a shared queue while a
+    /// dedicated thread waits in the reactor.
+    ///
+    class ThreadedRuntime final : public Executor {
+
+    private:
+
+        Reactor r;
+
+        RawMutex lock;
+
+        std::deque<std::coroutine_handle<>> ready;
+
+        alignas(thread::CACHE_LINE) std::atomic<u32> signal = 0;
+
+        std::atomic<u32> sleepers = 0;
+
+        std::atomic<bool> stop = false;
+
+        std::vector<std::thread> workers;
+
+        std::thread io;
+
+        inline auto pop() noexcept -> std::coroutine_handle<> {
+            this->lock.lock();
+            auto h = std::coroutine_handle<>();
+            if (!this->ready.empty()) {
+                h = this->ready.front();
+                this->ready.pop_front();
+            }
+            this->lock.unlock();
+            return h;
+        }
+
+        inline auto work() noexcept {
+            Executor::current = this;
+            while (!this->stop.load(std::memory_order_relaxed)) {
+                if (auto h = this->pop()) {
+                    h.resume();
+                    continue;
+                }
+                this->sleepers.fetch_add(1, std::memory_order_seq_cst);
+                auto s = this->signal.load(std::memory_order_seq_cst);
+                if (auto h = this->pop()) {
+                    this->sleepers.fetch_sub(1, std::memory_order_relaxed);
+                    h.resume();
+                    continue;
+                }
+                if (!this->stop.load(std::memory_order_relaxed)) futex::wait(this->signal, s);
+                this->sleepers.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+    public:
+
+        /// @brief Start the runtime.
+        /// @param n number of worker threads, `0` for one per hardware thread
+        ///
+        inline ThreadedRuntime(usize n = 0) noexcept {
+            if (n == 0) n = std::max((usize)std::thread::hardware_concurrency(), (usize)1);
+            for (auto i = (usize)0; i < n; i++) this->workers.emplace_back([this] { this->work(); });
+            this->io = std::thread([this] {
+                Executor::current = this;
+                while (!this->stop.load(std::memory_order_relaxed)) this->r.poll(true);
+            });
+        }
+
+        ThreadedRuntime(ThreadedRuntime const&) = delete;
+
+        /// @brief Stop and join every thread.
+        /// @warning Tasks still suspended are leaked, finish your work before dropping the runtime.
+        ///
+        inline ~ThreadedRuntime() noexcept {
+            this->stop.store(true, std::memory_order_relaxed);
+            this->signal.fetch_add(1, std::memory_order_seq_cst);
+            futex::wake_all(this->signal);
+            this->r.wake();
+            for (auto& t : this->workers) t.join();
+            this->io.join();
+        }
+
+        inline auto schedule(std::coroutine_handle<> h) noexcept -> void override {
+            this->lock.lock();
+            this->ready.push_back(h);
+            this->lock.unlock();
+            this->signal.fetch_add(1, std::memory_order_seq_cst);
+            if (this->sleepers.load(std::memory_order_seq_cst)) futex::wake(this->signal);
+        }
+
+        inline auto reactor() noexcept -> Reactor& override {
+            return this->r;
+        }
+
+        /// @brief Start a task in the background.
+        ///
+        inline auto spawn(Task<void> task) noexcept {
+            this->schedule(detach(mv(task)).h);
+        }
+
+        /// @brief Run `task` on the workers and block the calling thread until it finishes.
+        /// @return the output of `task`
+        ///
+        template<typename T>
+        inline auto block_on(Task<T> task) noexcept -> T {
+            auto out = Option<Value<T>>();
+            auto done = thread::Done();
+            this->schedule(complete(mv(task), &out, &done).h);
+            done.wait();
+            if constexpr (!std::is_void_v<T>) return mv(out).unwrap();
+        }
+    };
+
+    class Io;
+
+    /// @brief Awaitable read, write, accept or readiness wait on an `Io`.
+    ///
+    /// The operation is first tried right away; only if it would block is the task parked in the reactor,
+    /// which retries it as soon as the descriptor is ready. No allocation happens either way.
+    ///
+    struct IoOp final : Waiter {
+
+        enum Kind : u8 { Read, Write, Accept, Writable };
+
+        Kind kind;
+
+        int fd;
+
+        void* buf;
+
+        usize len;
+
+        Registration* reg;
+
+        Reactor* reactor;
+
+        /// @brief Whether `fd` is a regular file, which `epoll` cannot watch.
+        ///
+        bool file;
+
+        inline IoOp(Kind kind, int fd, void* buf, usize len, Registration* reg, Reactor* reactor, bool file) noexcept
+            : Waiter{ &IoOp::try_once }, kind(kind), fd(fd), buf(buf), len(len), reg(reg), reactor(reactor), file(file) {}
+
+        inline static auto try_once(Waiter* w) noexcept -> bool {
+            auto self = static_cast<IoOp*>(w);
+            loop {
+                isize n;
+                switch (self->kind) {
+                case Read: n = ::read(self->fd, self->buf, self->len); break;
+                case Write: n = ::write(self->fd, self->buf, self->len); break;
+                case Accept: n = accept4(self->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC); break;
+                default: self->result = 0; return true;
+                }
+                if (n >= 0) {
+                    self->result = n;
+                    return true;
+                }
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+                self->result = -errno;
+                return true;
+            }
+        }
+
+        inline auto uses_uring() const noexcept -> bool {
+            return this->file && (this->kind == Read || this->kind == Write) && this->reactor->has_uring();
+        }
+
+        inline auto await_ready() noexcept -> bool {
+            if (this->kind == Writable || this->uses_uring()) return false;
+            if (this->file) {
+                try_once(this);
+                return true;
+            }
+            return try_once(this);
+        }
+
+        inline auto await_suspend(std::coroutine_handle<> h) noexcept -> bool {
+            this->h = h;
+            this->ex = &Executor::get();
+            if (this->uses_uring()) {
+                if (this->reactor->submit(this, this->kind == Write, this->fd, this->buf, this->len)) return true;
+                try_once(this);
+                return false;
+            }
+            this->reactor->wait(*this->reg, this, this->kind != Read && this->kind != Accept);
+            return true;
+        }
+
+        inline auto await_resume() const noexcept -> IoResult<usize> {
+            if (this->result < 0) return IoResult<usize>::err((Errno)-this->result);
+            return IoResult<usize>::ok((usize)this->result);
+        }
+    };
+
+    /// @brief An owned file descriptor driven by a runtime's reactor: a pipe, a socket or a regular file.
+    /// @note At most one read (or accept) and one write may be pending on the same `Io` at a time.
+    ///
+    class Io final {
+
+    private:
+
+        int raw = -1;
+
+        Reactor* reactor = nullptr;
+
+        std::unique_ptr<Registration> reg;
+
+        bool file = false;
+
+    public:
+
+        /// @brief Take ownership of `fd`, bound to the reactor of the current runtime.
+        ///
+        /// # Panic
+        ///
+        /// Panics if called outside of a runtime.
+        ///
+        inline explicit Io(int fd) noexcept : Io(fd, Executor::get().reactor()) {}
+
+        /// @brief Take ownership of `fd`, bound to `reactor`. Switches pipes and sockets to non-blocking mode.
+        ///
+        inline Io(int fd, Reactor& reactor) noexcept : raw(fd), reactor(&reactor), reg(new Registration{ .fd = fd }) {
+            struct stat st;
+            this->file = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+            if (!this->file) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        }
+
+        Io(Io const&) = delete;
+
+        inline Io(Io&& other) noexcept
+            : raw(std::exchange(other.raw, -1)), reactor(other.reactor), reg(mv(other.reg)), file(other.file) {}
+
+        inline auto operator=(Io&& other) noexcept -> Io& {
+            if (this != &other) {
+                this->close();
+                this->raw = std::exchange(other.raw, -1);
+                this->reactor = other.reactor;
+                this->reg = mv(other.reg);
+                this->file = other.file;
+            }
+            return *this;
+        }
+
+        /// @warning The behaviour is undefined if an operation is still pending.
+        ///
+        inline ~Io() noexcept {
+            this->close();
+        }
+
+        /// @brief Close the descriptor now.
+        ///
+        inline auto close() noexcept -> void {
+            if (this->raw < 0) return;
+            this->reactor->remove(*this->reg);
+            ::close(this->raw);
+            this->raw = -1;
+        }
+
+        inline auto fd() const noexcept -> int {
+            return this->raw;
+        }
+
+        /// @brief Read up to `buf.size()` bytes.
+        /// @return number of bytes read, `0` at end of stream
+        ///
+        [[nodiscard]] inline auto read(std::span<char> buf) noexcept -> IoOp {
+            return IoOp(IoOp::Read, this->raw, buf.data(), buf.size(), this->reg.get(), this->reactor, this->file);
+        }
+
+        /// @brief Write up to `buf.size()` bytes.
+        /// @return number of bytes written
+        ///
+        [[nodiscard]] inline auto write(std::span<char const> buf) noexcept -> IoOp {
+            return IoOp(IoOp::Write, this->raw, (void*)buf.data(), buf.size(), this->reg.get(), this->reactor, this->file);
+        }
+
+        [[nodiscard]] inline auto write(str s) noexcept -> IoOp {
+            return this->write(std::span<char const>(s.head, s.len));
+        }
+
+        /// @brief Wait until the descriptor is writable.
+        ///
+        [[nodiscard]] inline auto writable() noexcept -> IoOp {
+            return IoOp(IoOp::Writable, this->raw, nullptr, 0, this->reg.get(), this->reactor, this->file);
+        }
+
+        /// @brief Write the whole buffer, retrying short writes.
+        ///
+        inline auto write_all(std::span<char const> buf) noexcept -> Task<IoResult<usize>> {
+            auto done = (usize)0;
+            while (done < buf.size()) {
+                auto r = co_await this->write(buf.subspan(done));
+                if (r.is_err()) co_return r;
+                done += r.unwrap();
+            }
+            co_return IoResult<usize>::ok(done);
+        }
+
+        /// @brief Accept a connection on a listening socket.
+        ///
+        inline auto accept() noexcept -> Task<IoResult<Io>> {
+            auto reactor = this->reactor;
+            auto r = co_await IoOp(IoOp::Accept, this->raw, nullptr, 0, this->reg.get(), reactor, false);
+            if (r.is_err()) co_return IoResult<Io>::err(r.unwrap_err());
+            co_return IoResult<Io>::ok(Io((int)r.unwrap(), *reactor));
+        }
+    };
+
+    /// @brief Create a pipe, returning its read and write ends, bound to the reactor of the current runtime.
+    ///
+    /// # Panic
+    ///
+    /// Panics if called outside of a runtime.
+    ///
+    inline auto pipe() noexcept -> IoResult<std::pair<Io, Io>> {
+        int fds[2];
+        if (pipe2(fds, O_NONBLOCK | O_CLOEXEC) < 0) return IoResult<std::pair<Io, Io>>::err(errno);
+        return IoResult<std::pair<Io, Io>>::ok({ Io(fds[0]), Io(fds[1]) });
+    }
+
+    /// @brief Create a connected pair of Unix stream sockets, bound to the reactor of the current runtime.
+    ///
+    /// # Panic
+    ///
+    /// Panics if called outside of a runtime.
+    ///
+    inline auto socketpair() noexcept -> IoResult<std::pair<Io, Io>> {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, fds) < 0) return IoResult<std::pair<Io, Io>>::err(errno);
+        return IoResult<std::pair<Io, Io>>::ok({ Io(fds[0]), Io(fds[1]) });
+    }
+
+    /// @brief Open a file, bound to the reactor of the current runtime.
+    /// @param path the path
+    /// @param flags `open(2)` flags
+    /// @param mode permission bits for created files
+    ///
+    /// # Panic
+    ///
+    /// Panics if called outside of a runtime.
+    ///
+    inline auto open(str path, int flags, mode_t mode = 0644) noexcept -> IoResult<Io> {
+        auto p = std::string(&path);
+        auto fd = ::open(p.c_str(), flags | O_CLOEXEC, mode);
+        if (fd < 0) return IoResult<Io>::err(errno);
+        return IoResult<Io>::ok(Io(fd));
+    }
+
+    inline auto unix_address(str path, sockaddr_un& addr) noexcept -> bool {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.len >= sizeof(addr.sun_path)) return false;
+        std::memcpy(addr.sun_path, path.head, path.len);
+        return true;
+    }
+
+    /// @brief Listen on a Unix stream socket bound at `path`.
+    ///
+    inline auto listen_unix(str path, int backlog = 128) noexcept -> IoResult<Io> {
+        auto addr = sockaddr_un();
+        if (!unix_address(path, addr)) return IoResult<Io>::err(ENAMETOOLONG);
+        auto fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) return IoResult<Io>::err(errno);
+        if (::bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(fd, backlog) < 0) {
+            auto e = errno;
+            ::close(fd);
+            return IoResult<Io>::err(e);
+        }
+        return IoResult<Io>::ok(Io(fd));
+    }
+
+    /// @brief Connect to a Unix stream socket at `path`.
+    ///
+    inline auto connect_unix(str path) noexcept -> Task<IoResult<Io>> {
+        auto addr = sockaddr_un();
+        if (!unix_address(path, addr)) co_return IoResult<Io>::err(ENAMETOOLONG);
+        auto fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) co_return IoResult<Io>::err(errno);
+        auto io = Io(fd);
+        if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            if (errno != EINPROGRESS && errno != EAGAIN) co_return IoResult<Io>::err(errno);
+            co_await io.writable();
+            auto e = 0;
+            auto len = (socklen_t)sizeof(e);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &e, &len);
+            if (e) co_return IoResult<Io>::err(e);
+        }
+        co_return IoResult<Io>::ok(mv(io));
+    }
+}
@@ -0,0 +1,694 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "log.cc"
+#include "mutex.cc"
+#include "str.cc"
+#include "thread.cc"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Binary log sites take a literal format with one `{}` per argument, e.g. `coding_binfo("got {} bytes from {}", n, peer)`.
+// The caller copies only the raw arguments, formatting happens on a background thread or offline with `log::decode`.
+#define coding_blog(level,fmt,...) {if constexpr((level)<=CODING_LOG_LEVEL){static auto& _coding_module=coding::log::Module::get(CODING_LOG_MODULE);if(_coding_module.enabled(level)){[]<typename... _CodingArgs>(_CodingArgs const&... _coding_args){static_assert(coding::log::placeholders(fmt)==sizeof...(_CodingArgs),"binary log format needs one {} per argument");static auto const _coding_site=coding::log::Binary::site<_CodingArgs...>(fmt,__FILE__,__LINE__,level);coding::log::Binary::get().record(_coding_site,_coding_args...);}(__VA_ARGS__);}}}
+
+#define coding_btrace(fmt,...) coding_blog(40,fmt __VA_OPT__(,) __VA_ARGS__)
+
+#define coding_bdebug(fmt,...) coding_blog(30,fmt __VA_OPT__(,) __VA_ARGS__)
+
+#define coding_binfo(fmt,...) coding_blog(20,fmt __VA_OPT__(,) __VA_ARGS__)
+
+#define coding_bwarn(fmt,...) coding_blog(10,fmt __VA_OPT__(,) __VA_ARGS__)
+
+#define coding_berror(fmt,...) coding_blog(0,fmt __VA_OPT__(,) __VA_ARGS__)
+
+namespace coding::log {
+
+    /// @brief The encoded type of a binary log argument.
+    ///
+    enum class Arg : u8 { Bool, Char, I8, I16, I32, I64, U8, U16, U32, U64, F32, F64, Str, Ptr };
+
+    template<typename T>
+    constexpr bool UNSUPPORTED_ARG = false;
+
+    /// @brief How a binary log argument of type `T` is encoded.
+    ///
+    template<typename T>
+    consteval auto arg_kind() -> Arg {
+        using U = std::remove_cvref_t<T>;
+        if constexpr (std::is_same_v<U, bool>) return Arg::Bool;
+        else if constexpr (std::is_same_v<U, char>) return Arg::Char;
+        else if constexpr (std::is_enum_v<U>) return arg_kind<std::underlying_type_t<U>>();
+        else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+            if constexpr (sizeof(U) == 1) return Arg::I8;
+            else if constexpr (sizeof(U) == 2) return Arg::I16;
+            else if constexpr (sizeof(U) == 4) return Arg::I32;
+            else return Arg::I64;
+        }
+        else if constexpr (std::is_integral_v<U>) {
+            if constexpr (sizeof(U) == 1) return Arg::U8;
+            else if constexpr (sizeof(U) == 2) return Arg::U16;
+            else if constexpr (sizeof(U) == 4) return Arg::U32;
+            else return Arg::U64;
+        }
+        else if constexpr (std::is_same_v<U, float>) return Arg::F32;
+        else if constexpr (std::is_floating_point_v<U>) return Arg::F64;
+        else if constexpr (std::is_same_v<U, str> || std::is_convertible_v<U const&, std::string_view>) return Arg::Str;
+        else if constexpr (std::is_pointer_v<U>) return Arg::Ptr;
+        else static_assert(UNSUPPORTED_ARG<T>, "binary log arguments are numbers, strings or pointers");
+    }
+
+    /// @brief Encoded size of fixed-size arguments.
+    ///
+    inline constexpr auto arg_size(Arg kind) noexcept -> usize {
+        switch (kind) {
+            case Arg::Bool: case Arg::Char: case Arg::I8: case Arg::U8: return 1;
+            case Arg::I16: case Arg::U16: return 2;
+            case Arg::I32: case Arg::U32: case Arg::F32: return 4;
+            default: return 8;
+        }
+    }
+
+    /// @brief Count the `{}` placeholders of a binary log format.
+    ///
+    consteval auto placeholders(std::string_view fmt) -> usize {
+        auto n = (usize)0;
+        for (auto i = (usize)0; i + 1 < fmt.size(); i++) {
+            if (fmt[i] == '{' && fmt[i + 1] == '}') {
+                n++;
+                i++;
+            }
+        }
+        return n;
+    }
+
+    /// @brief The colored level tag used by the text macros.
+    ///
+    inline auto level_prefix(int level) noexcept -> std::string_view {
+        if (level <= LOG_LEVEL_ERROR) return " \033[31;1mERROR\033[0m ";
+        if (level <= LOG_LEVEL_WARN) return " \033[33;1mWARN\033[0m  ";
+        if (level <= LOG_LEVEL_INFO) return " \033[32mINFO\033[0m  ";
+        if (level <= LOG_LEVEL_DEBUG) return " \033[34mDEBUG\033[0m ";
+        return " \033[35mTRACE\033[0m ";
+    }
+
+    /// @brief A registered binary log site. Sites are immutable and never freed.
+    ///
+    struct Site final {
+
+        u32 id;
+
+        int level;
+
+        u32 line;
+
+        std::string file;
+
+        std::string format;
+
+        std::vector<Arg> args;
+    };
+
+    /// @brief A cheap monotonic tick counter: the TSC on x86, nanoseconds elsewhere.
+    ///
+    inline auto ticks() noexcept -> u64 {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return (u64)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    /// @brief Maps ticks to wall-clock time from pairs of readings taken at drain time.
+    ///
+    struct ClockSync final {
+
+        u64 first_ticks = 0;
+
+        i64 first_ns = 0;
+
+        u64 last_ticks = 0;
+
+        i64 last_ns = 0;
+
+        bool ready = false;
+
+        inline static auto now_ns() noexcept -> i64 {
+            return (i64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+
+        inline auto add(u64 t, i64 ns) noexcept {
+            if (!this->ready) {
+                this->first_ticks = t;
+                this->first_ns = ns;
+                this->ready = true;
+            }
+            this->last_ticks = t;
+            this->last_ns = ns;
+        }
+
+        /// @brief Unix time in nanoseconds of a tick reading, interpolated from the first and last sync.
+        ///
+        inline auto to_ns(u64 t) const noexcept -> i64 {
+            auto rate = this->last_ticks > this->first_ticks
+                ? (double)(this->last_ns - this->first_ns) / (double)(this->last_ticks - this->first_ticks)
+                : 1.0;
+            return this->last_ns + (i64)((double)(i64)(t - this->last_ticks) * rate);
+        }
+    };
+
+    /// @brief Tags of the binary stream written by `Binary::output` and read by `decode`.
+    /// Anything else is a site id starting a record: `u32 id, u64 ticks`, then the arguments.
+    ///
+    namespace frame {
+
+        constexpr char MAGIC[8] = { 'C', 'O', 'D', 'B', 'L', 'O', 'G', '1' };
+
+        /// @brief `u32 id, i32 level, u32 line, u16 argc, u8 kinds[argc], string file, string format`.
+        ///
+        constexpr u32 SITE = UINT32_MAX;
+
+        /// @brief `u64 ticks, i64 unix_ns`.
+        ///
+        constexpr u32 CLOCK = UINT32_MAX - 1;
+
+        /// @brief `u64 records_dropped`.
+        ///
+        constexpr u32 DROP = UINT32_MAX - 2;
+    }
+
+    template<typename T>
+    inline auto from_bytes(unsigned char const* raw) noexcept -> T {
+        T v;
+        std::memcpy(&v, raw, sizeof(T));
+        return v;
+    }
+
+    /// @brief Formats one record, reading its arguments from `in` with `in.read(void*, usize) -> bool`.
+    /// @return whether every argument could be read
+    ///
+    template<typename R>
+    inline auto format_record(Site const& site, i64 ns, R& in, std::ostream& out) -> bool {
+        auto secs = (std::time_t)(ns / 1000000000);
+        out << Timestamp{ secs } << level_prefix(site.level) << site.file << ":" << site.line << " :: ";
+        auto arg = (usize)0;
+        auto scratch = std::string();
+        auto fmt = std::string_view(site.format);
+        for (auto i = (usize)0; i < fmt.size(); i++) {
+            if (fmt[i] != '{' || i + 1 == fmt.size() || fmt[i + 1] != '}') {
+                out.put(fmt[i]);
+                continue;
+            }
+            i++;
+            if (arg == site.args.size()) return false;
+            auto kind = site.args[arg++];
+            if (kind == Arg::Str) {
+                u32 len;
+                if (!in.read(&len, 4)) return false;
+                scratch.resize(len);
+                if (!in.read(scratch.data(), len)) return false;
+                out << scratch;
+                continue;
+            }
+            unsigned char raw[8] = {};
+            if (!in.read(raw, arg_size(kind))) return false;
+            switch (kind) {
+                case Arg::Bool: out << (from_bytes<bool>(raw) ? "true" : "false"); break;
+                case Arg::Char: out << from_bytes<char>(raw); break;
+                case Arg::I8: out << (int)from_bytes<i8>(raw); break;
+                case Arg::I16: out << from_bytes<i16>(raw); break;
+                case Arg::I32: out << from_bytes<i32>(raw); break;
+                case Arg::I64: out << from_bytes<i64>(raw); break;
+                case Arg::U8: out << (unsigned)from_bytes<u8>(raw); break;
+                case Arg::U16: out << from_bytes<u16>(raw); break;
+                case Arg::U32: out << from_bytes<u32>(raw); break;
+                case Arg::U64: out << from_bytes<u64>(raw); break;
+                case Arg::F32: out << from_bytes<f32>(raw); break;
+                case Arg::F64: out << from_bytes<f64>(raw); break;
+                case Arg::Ptr: out << (void*)(uintptr_t)from_bytes<u64>(raw); break;
+                case Arg::Str: break;
+            }
+        }
+        out.put('\n');
+        return true;
+    }
+
+    /// @brief The binary logging backend: per-thread rings of raw arguments, formatted away from the caller.
+    ///
+    /// A log call copies the site id, a tick count and its raw arguments into the ring of its thread
+    /// and publishes them with a release store, nothing else. The background thread polls the rings:
+    /// by default it formats the records as text lines written through the text backend's sink,
+    /// after `output(fd)` it writes the binary stream as is, to be turned into text later by `decode`.
+    ///
+    class Binary final {
+
+    private:
+
+        thread::RawMutex registry;
+
+        Ring* rings = nullptr;
+
+        thread::RawMutex sites_lock;
+
+        std::vector<Site*> sites;
+
+        /// @brief Held while draining, there is only ever one consumer.
+        ///
+        thread::RawMutex draining;
+
+        /// @brief The raw output, if any.
+        ///
+        std::unique_ptr<FdSink> raw;
+
+        /// @brief Number of sites already described in the raw output.
+        ///
+        usize described = 0;
+
+        ClockSync clock;
+
+        std::vector<Site*> snapshot_sites;
+
+        std::vector<std::pair<Ring*, usize>> snapshot;
+
+        std::ostringstream text;
+
+        std::string frames;
+
+        std::vector<iovec> batch;
+
+        std::atomic<Overflow> policy = Overflow::Drop;
+
+        alignas(thread::CACHE_LINE) std::atomic<u32> signal = 0;
+
+        std::atomic<bool> sleeping = false;
+
+        std::atomic<bool> stopped = false;
+
+        inline static thread_local Ring* ring = nullptr;
+
+        inline static thread_local bool exited = false;
+
+        /// @brief Closes the ring of the thread when it exits.
+        ///
+        struct Owner final {
+
+            inline ~Owner() noexcept {
+                if (ring) ring->closed.store(true, std::memory_order_release);
+                ring = nullptr;
+                exited = true;
+            }
+        };
+
+        /// @brief Reads a ring between two positions, across its wrap-around.
+        ///
+        struct RingReader final {
+
+            Ring const& ring;
+
+            usize at;
+
+            usize end;
+
+            inline auto read(void* dst, usize n) noexcept -> bool {
+                if (this->end - this->at < n) return false;
+                auto i = this->at % Ring::CAPACITY;
+                auto first = std::min(n, Ring::CAPACITY - i);
+                std::memcpy(dst, this->ring.data.get() + i, first);
+                std::memcpy((char*)dst + first, this->ring.data.get(), n - first);
+                this->at += n;
+                return true;
+            }
+        };
+
+        template<typename T>
+        inline auto put_frame(T const& v) {
+            this->frames.append((char const*)&v, sizeof(T));
+        }
+
+        inline auto put_frame_str(std::string_view s) {
+            this->put_frame((u32)s.size());
+            this->frames.append(s);
+        }
+
+        inline auto slow_ring() noexcept -> Ring* {
+            if (exited) return nullptr;
+            auto r = new Ring();
+            this->registry.lock();
+            r->next = this->rings;
+            this->rings = r;
+            this->registry.unlock();
+            ring = r;
+            thread_local Owner owner;
+            (void)owner;
+            return r;
+        }
+
+        /// @brief Write everything currently buffered. The caller holds `draining`.
+        /// @return whether anything was written
+        ///
+        inline auto drain_locked() noexcept -> bool {
+            this->snapshot.clear();
+            this->registry.lock();
+            for (auto p = &this->rings; *p;) {
+                auto r = *p;
+                if (r->closed.load(std::memory_order_acquire) && r->head.load(std::memory_order_relaxed) == r->tail.load(std::memory_order_acquire)) {
+                    *p = r->next;
+                    delete r;
+                    continue;
+                }
+                this->snapshot.emplace_back(r, 0);
+                p = &r->next;
+            }
+            this->registry.unlock();
+
+            auto any = false;
+            auto dropped = (u64)0;
+            for (auto& [r, t] : this->snapshot) {
+                t = r->tail.load(std::memory_order_acquire);
+                any |= t != r->head.load(std::memory_order_relaxed);
+                dropped += r->dropped.exchange(0, std::memory_order_relaxed);
+            }
+            if (!any && !dropped) return false;
+
+            // Sites are registered before their first record is published, so this sees all of them.
+            this->sites_lock.lock();
+            this->snapshot_sites = this->sites;
+            this->sites_lock.unlock();
+            this->clock.add(ticks(), ClockSync::now_ns());
+
+            if (this->raw) this->write_raw(dropped);
+            else this->write_text(dropped);
+            for (auto [r, t] : this->snapshot) r->head.store(t, std::memory_order_release);
+            return true;
+        }
+
+        inline auto write_text(u64 dropped) -> void {
+            this->text.str({});
+            for (auto [r, t] : this->snapshot) {
+                auto in = RingReader{ *r, r->head.load(std::memory_order_relaxed), t };
+                u32 id;
+                u64 tick;
+                while (in.read(&id, 4) && in.read(&tick, 8)) {
+                    if (id >= this->snapshot_sites.size()) break;
+                    if (!format_record(*this->snapshot_sites[id], this->clock.to_ns(tick), in, this->text)) break;
+                }
+            }
+            if (dropped) this->text << "... " << dropped << " binary log records dropped\n";
+            auto s = this->text.view();
+            Backend::get().write(s.data(), s.size());
+        }
+
+        inline auto write_raw(u64 dropped) -> void {
+            this->frames.clear();
+            for (; this->described < this->snapshot_sites.size(); this->described++) {
+                auto& site = *this->snapshot_sites[this->described];
+                this->put_frame(frame::SITE);
+                this->put_frame(site.id);
+                this->put_frame((i32)site.level);
+                this->put_frame(site.line);
+                this->put_frame((u16)site.args.size());
+                for (auto a : site.args) this->put_frame(a);
+                this->put_frame_str(site.file);
+                this->put_frame_str(site.format);
+            }
+            this->put_frame(frame::CLOCK);
+            this->put_frame(this->clock.last_ticks);
+            this->put_frame(this->clock.last_ns);
+            if (dropped) {
+                this->put_frame(frame::DROP);
+                this->put_frame(dropped);
+            }
+            this->batch.clear();
+            this->batch.push_back(iovec{ this->frames.data(), this->frames.size() });
+            for (auto [r, t] : this->snapshot) {
+                auto h = r->head.load(std::memory_order_relaxed);
+                if (t == h) continue;
+                auto at = h % Ring::CAPACITY;
+                auto first = std::min(t - h, Ring::CAPACITY - at);
+                this->batch.push_back(iovec{ r->data.get() + at, first });
+                if (t - h > first) this->batch.push_back(iovec{ r->data.get(), t - h - first });
+            }
+            this->raw->write(this->batch);
+        }
+
+        /// @brief Poll the rings, backing off to at most 100 ms between polls when idle.
+        /// Producers wake the thread on a best-effort basis, a missed wake-up only delays output.
+        ///
+        inline auto run() noexcept {
+            auto idle = std::chrono::microseconds(100);
+            loop {
+                this->draining.lock();
+                auto wrote = this->drain_locked();
+                this->draining.unlock();
+                if (wrote) {
+                    idle = std::chrono::microseconds(100);
+                    continue;
+                }
+                auto s = this->signal.load(std::memory_order_acquire);
+                this->sleeping.store(true, std::memory_order_relaxed);
+                thread::futex::wait_for(this->signal, s, idle);
+                this->sleeping.store(false, std::memory_order_relaxed);
+                idle = std::min(idle * 2, std::chrono::microseconds(100000));
+            }
+        }
+
+        inline Binary() noexcept {
+            Backend::get();
+            this->clock.add(ticks(), ClockSync::now_ns());
+            std::thread([this] { this->run(); }).detach();
+            std::atexit([] { Binary::get().stop(); });
+            thread::on_panic([] { Binary::get().flush(); });
+        }
+
+    public:
+
+        Binary(Binary const&) = delete;
+
+        /// @brief The process-wide binary backend, started on first use and never destroyed.
+        ///
+        inline static auto get() noexcept -> Binary& {
+            static auto binary = new Binary();
+            return *binary;
+        }
+
+        /// @brief Register a log site, once per call site.
+        /// @tparam A the argument types
+        /// @return the site id
+        ///
+        template<typename... A>
+        inline static auto site(std::string_view format, std::string_view file, u32 line, int level) noexcept -> u32 {
+            auto& b = get();
+            b.sites_lock.lock();
+            auto s = new Site{ (u32)b.sites.size(), level, line, std::string(file), std::string(format), { arg_kind<A>()... } };
+            b.sites.push_back(s);
+            b.sites_lock.unlock();
+            return s->id;
+        }
+
+        /// @brief Queue a record of site `id` on the calling thread.
+        ///
+        template<typename... A>
+        inline auto record(u32 id, A const&... args) noexcept {
+            // Fixed-size arguments always fit, strings share what is left and are cut to fit.
+            constexpr auto fixed = 12 + (min_size<A>() + ... + (usize)0);
+            static_assert(fixed <= RECORD, "too many binary log arguments for one record");
+            thread_local char scratch[RECORD];
+            auto p = scratch;
+            [[maybe_unused]] auto end = scratch + sizeof(scratch);
+            [[maybe_unused]] auto rest = fixed - 12;
+            auto t = ticks();
+            std::memcpy(p, &id, 4);
+            std::memcpy(p + 4, &t, 8);
+            p += 12;
+            (put(p, end, rest, args), ...);
+            auto r = ring ? ring : this->slow_ring();
+            if (!r) [[unlikely]] return;
+            while (!r->push(scratch, (usize)(p - scratch), std::memory_order_release)) {
+                this->wake();
+                if (this->policy.load(std::memory_order_relaxed) == Overflow::Drop) {
+                    r->dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            if (this->sleeping.load(std::memory_order_relaxed)) [[unlikely]] this->wake();
+            if (this->stopped.load(std::memory_order_relaxed)) [[unlikely]] this->flush();
+        }
+
+        /// @brief Wake the background thread if it is asleep.
+        ///
+        inline auto wake() noexcept {
+            if (this->sleeping.exchange(false, std::memory_order_relaxed)) {
+                this->signal.fetch_add(1, std::memory_order_release);
+                thread::futex::wake(this->signal);
+            }
+        }
+
+        /// @brief Write every record queued so far.
+        ///
+        inline auto flush() noexcept -> void {
+            this->draining.lock();
+            while (this->drain_locked());
+            this->draining.unlock();
+            Backend::get().flush();
+        }
+
+        inline auto stop() noexcept -> void {
+            this->stopped.store(true, std::memory_order_relaxed);
+            this->flush();
+        }
+
+        /// @brief Write the binary stream to `fd` instead of formatting it, for `decode` to read later.
+        /// @param fd a file opened for writing, owned by the caller
+        ///
+        inline auto output(int fd) noexcept {
+            this->draining.lock();
+            while (this->drain_locked());
+            this->raw = std::make_unique<FdSink>(fd);
+            this->described = 0;
+            auto iov = iovec{ (void*)frame::MAGIC, sizeof(frame::MAGIC) };
+            this->raw->write({ &iov, 1 });
+            this->draining.unlock();
+        }
+
+        inline auto set_overflow(Overflow policy) noexcept {
+            this->policy.store(policy, std::memory_order_relaxed);
+        }
+
+    private:
+
+        /// @brief Largest encoded record, arguments included.
+        ///
+        constexpr static usize RECORD = 1024;
+
+        /// @brief Encoded size of an argument of type `T`, counting strings as empty.
+        ///
+        template<typename T>
+        inline static consteval auto min_size() noexcept -> usize {
+            constexpr auto kind = arg_kind<T>();
+            return kind == Arg::Str ? 4 : arg_size(kind);
+        }
+
+        /// @brief Append `v` at `p`, keeping `rest` bytes before `end` for the fixed parts of the arguments after it.
+        /// A string longer than the room left is cut, its last three bytes replaced by `...`.
+        ///
+        template<typename T>
+        inline static auto put(char*& p, char* end, usize& rest, T const& v) noexcept {
+            constexpr auto kind = arg_kind<T>();
+            rest -= min_size<T>();
+            if constexpr (kind == Arg::Str) {
+                auto s = std::string_view();
+                if constexpr (std::is_same_v<std::remove_cvref_t<T>, str>) s = std::string_view(v.head, v.len);
+                else if constexpr (std::is_pointer_v<std::remove_cvref_t<T>>) s = v ? std::string_view(v) : std::string_view("(null)");
+                else s = std::string_view(v);
+                auto left = (usize)(end - p);
+                auto room = left > 4 + rest ? left - 4 - rest : 0;
+                auto n = (u32)std::min(s.size(), room);
+                std::memcpy(p, &n, 4);
+                std::memcpy(p + 4, s.data(), n);
+                if (n < s.size() && n >= 3) std::memcpy(p + 4 + n - 3, "...", 3);
+                p += 4 + n;
+            }
+            else if constexpr (kind == Arg::Ptr) {
+                auto x = (u64)(uintptr_t)v;
+                std::memcpy(p, &x, 8);
+                p += 8;
+            }
+            else if constexpr (kind == Arg::F64) {
+                auto x = (f64)v;
+                std::memcpy(p, &x, 8);
+                p += 8;
+            }
+            else {
+                static_assert(sizeof(T) == arg_size(kind));
+                std::memcpy(p, &v, sizeof(T));
+                p += sizeof(T);
+            }
+        }
+    };
+
+    /// @brief Turn a binary log written after `Binary::get().output(fd)` back into text lines.
+    /// @param in the binary stream
+    /// @param out where to write the lines
+    /// @return whether the whole stream was well-formed
+    ///
+    inline auto decode(std::istream& in, std::ostream& out) -> bool {
+        struct Reader final {
+
+            std::istream& in;
+
+            inline auto read(void* dst, usize n) -> bool {
+                return (bool)this->in.read((char*)dst, (std::streamsize)n);
+            }
+
+            inline auto read_str(std::string& s) -> bool {
+                u32 n;
+                if (!this->read(&n, 4)) return false;
+                s.resize(n);
+                return this->read(s.data(), n);
+            }
+        };
+        auto r = Reader{ in };
+        char magic[sizeof(frame::MAGIC)];
+        if (!r.read(magic, sizeof(magic)) || std::memcmp(magic, frame::MAGIC, sizeof(magic))) return false;
+        auto sites = std::vector<Site>();
+        auto clock = ClockSync();
+        u32 tag;
+        while (r.read(&tag, 4)) {
+            if (tag == frame::SITE) {
+                auto site = Site();
+                i32 level;
+                u16 argc;
+                if (!r.read(&site.id, 4) || !r.read(&level, 4) || !r.read(&site.line, 4) || !r.read(&argc, 2)) return false;
+                site.level = level;
+                site.args.resize(argc);
+                if (argc && !r.read(site.args.data(), argc)) return false;
+                if (!r.read_str(site.file) || !r.read_str(site.format)) return false;
+                if (site.id >= sites.size()) sites.resize(site.id + 1);
+                sites[site.id] = mv(site);
+            }
+            else if (tag == frame::CLOCK) {
+                u64 t;
+                i64 ns;
+                if (!r.read(&t, 8) || !r.read(&ns, 8)) return false;
+                clock.add(t, ns);
+            }
+            else if (tag == frame::DROP) {
+                u64 n;
+                if (!r.read(&n, 8)) return false;
+                out << "... " << n << " binary log records dropped\n";
+            }
+            else {
+                u64 t;
+                if (tag >= sites.size() || !r.read(&t, 8)) return false;
+                if (!format_record(sites[tag], clock.to_ns(t), r, out)) return false;
+            }
+        }
+        return in.eof();
+    }
+
+    /// @brief Write binary log records to `fd` as a binary stream instead of text, see `decode`.
+    ///
+    inline auto binary_output(int fd) noexcept {
+        Binary::get().output(fd);
+    }
+}
@@ -0,0 +1,567 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "option.cc"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace coding::collections {
+
+    /// @brief Kernels over arrays of 64-bit words, AVX2 where available and `std::popcount` otherwise.
+    ///
+    namespace bits {
+
+        inline constexpr usize WORD = 64;
+
+        struct And { inline static auto word(u64 a, u64 b) noexcept -> u64 { return a & b; } };
+
+        struct Or { inline static auto word(u64 a, u64 b) noexcept -> u64 { return a | b; } };
+
+        struct Xor { inline static auto word(u64 a, u64 b) noexcept -> u64 { return a ^ b; } };
+
+        /// @brief `a & ~b`.
+        ///
+        struct AndNot { inline static auto word(u64 a, u64 b) noexcept -> u64 { return a & ~b; } };
+
+#if defined(__AVX2__)
+        template<typename Op>
+        inline auto vector(__m256i a, __m256i b) noexcept -> __m256i {
+            if constexpr (std::is_same_v<Op, And>) return _mm256_and_si256(a, b);
+            else if constexpr (std::is_same_v<Op, Or>) return _mm256_or_si256(a, b);
+            else if constexpr (std::is_same_v<Op, Xor>) return _mm256_xor_si256(a, b);
+            else return _mm256_andnot_si256(b, a);
+        }
+
+        /// @brief Byte popcounts of `v` by nibble table lookup, summed into four 64-bit lanes.
+        ///
+        inline auto popcount(__m256i v) noexcept -> __m256i {
+            auto table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+            auto low = _mm256_set1_epi8(0x0f);
+            auto lo = _mm256_shuffle_epi8(table, _mm256_and_si256(v, low));
+            auto hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+            return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+        }
+
+        inline auto sum(__m256i v) noexcept -> usize {
+            return (usize)(_mm256_extract_epi64(v, 0) + _mm256_extract_epi64(v, 1) + _mm256_extract_epi64(v, 2) + _mm256_extract_epi64(v, 3));
+        }
+
+        inline auto load(u64 const* p) noexcept -> __m256i {
+            return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+        }
+#endif
+
+        /// @brief Number of ones in `n` words.
+        ///
+        inline auto count(u64 const* a, usize n) noexcept -> usize {
+            auto total = (usize)0;
+            auto i = (usize)0;
+#if defined(__AVX2__)
+            auto acc = _mm256_setzero_si256();
+            for (; i + 4 <= n; i += 4) acc = _mm256_add_epi64(acc, popcount(load(a + i)));
+            total = sum(acc);
+#endif
+            for (; i < n; i++) total += (usize)std::popcount(a[i]);
+            return total;
+        }
+
+        /// @brief Number of ones in `op(a, b)` over `n` words, without storing it.
+        ///
+        template<typename Op>
+        inline auto count(u64 const* a, u64 const* b, usize n) noexcept -> usize {
+            auto total = (usize)0;
+            auto i = (usize)0;
+#if defined(__AVX2__)
+            auto acc = _mm256_setzero_si256();
+            for (; i + 4 <= n; i += 4) acc = _mm256_add_epi64(acc, popcount(vector<Op>(load(a + i), load(b + i))));
+            total = sum(acc);
+#endif
+            for (; i < n; i++) total += (usize)std::popcount(Op::word(a[i], b[i]));
+            return total;
+        }
+
+        /// @brief `a = op(a, b)` over `n` words.
+        ///
+        template<typename Op>
+        inline auto apply(u64* a, u64 const* b, usize n) noexcept -> void {
+            auto i = (usize)0;
+#if defined(__AVX2__)
+            for (; i + 4 <= n; i += 4) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), vector<Op>(load(a + i), load(b + i)));
+            }
+#endif
+            for (; i < n; i++) a[i] = Op::word(a[i], b[i]);
+        }
+
+        /// @brief Position of the `k`-th one of `w`, counting from zero. `k` must be less than `popcount(w)`.
+        ///
+        inline auto select(u64 w, usize k) noexcept -> usize {
+#if defined(__BMI2__)
+            return (usize)std::countr_zero(_pdep_u64((u64)1 << k, w));
+#else
+            for (; k > 0; k--) w &= w - 1;
+            return (usize)std::countr_zero(w);
+#endif
+        }
+    }
+
+    /// @brief A growable vector of bits packed into 64-bit words. Acts like Rust's `BitVec`, for bitmaps too large for
+    /// `std::bitset` and too hot for `std::vector<bool>`.
+    ///
+    /// Bits past `len()` in the last word are kept zero, so whole-vector counts and boolean operations run word by word,
+    /// four words per AVX2 instruction.
+    ///
+    class BitVec final {
+
+    private:
+
+        std::vector<u64> data;
+
+        usize count = 0;
+
+        inline static auto words_for(usize n) noexcept -> usize {
+            return (n + bits::WORD - 1) / bits::WORD;
+        }
+
+        /// @brief Clear the bits past `len()` in the last word.
+        ///
+        inline auto trim() noexcept -> void {
+            if (auto tail = this->count % bits::WORD) this->data.back() &= ((u64)1 << tail) - 1;
+        }
+
+        inline auto check(usize i) const noexcept -> void {
+            if (i >= this->count) [[unlikely]] panic("bit index out of range");
+        }
+
+        inline auto check(BitVec const& rhs) const noexcept -> void {
+            if (this->count != rhs.count) [[unlikely]] panic("bit vectors differ in length");
+        }
+
+        template<typename Op>
+        inline auto apply(BitVec const& rhs) noexcept -> BitVec& {
+            this->check(rhs);
+            bits::apply<Op>(this->data.data(), rhs.data.data(), this->data.size());
+            return *this;
+        }
+
+    public:
+
+        /// @brief Iterates the positions of the ones in increasing order, a `tzcnt` and a `blsr` per one.
+        ///
+        class Ones final {
+
+        private:
+
+            u64 const* words = nullptr;
+
+            usize n = 0;
+
+            usize w = 0;
+
+            u64 rest = 0;
+
+            inline auto skip() noexcept -> void {
+                while (this->rest == 0 && ++this->w < this->n) this->rest = this->words[this->w];
+            }
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = usize;
+            using difference_type = isize;
+
+            inline Ones() noexcept = default;
+
+            inline Ones(u64 const* words, usize n, usize w) noexcept : words(words), n(n), w(w) {
+                if (w < n) {
+                    this->rest = words[w];
+                    this->skip();
+                }
+            }
+
+            inline auto operator*() const noexcept -> usize {
+                return this->w * bits::WORD + (usize)std::countr_zero(this->rest);
+            }
+
+            inline auto operator++() noexcept -> Ones& {
+                this->rest &= this->rest - 1;
+                this->skip();
+                return *this;
+            }
+
+            inline auto operator++(int) noexcept -> Ones {
+                auto it = *this;
+                ++*this;
+                return it;
+            }
+
+            inline auto operator==(Ones const& rhs) const noexcept -> bool {
+                return this->w == rhs.w && this->rest == rhs.rest;
+            }
+
+            inline auto begin() const noexcept -> Ones {
+                return *this;
+            }
+
+            inline auto end() const noexcept -> Ones {
+                return Ones(this->words, this->n, this->n);
+            }
+        };
+
+        inline BitVec() noexcept = default;
+
+        /// @brief `n` bits, all `value`.
+        ///
+        inline explicit BitVec(usize n, bool value = false) noexcept : data(words_for(n), value ? ~(u64)0 : 0), count(n) {
+            this->trim();
+        }
+
+        inline static auto with_capacity(usize n) noexcept -> BitVec {
+            auto v = BitVec();
+            v.reserve(n);
+            return v;
+        }
+
+        /// @brief Bits from whole words, the `n` low bits of `words` in order.
+        ///
+        inline static auto from_words(u64 const* words, usize n) noexcept -> BitVec {
+            auto v = BitVec();
+            v.data.assign(words, words + words_for(n));
+            v.count = n;
+            v.trim();
+            return v;
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->count;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->count == 0;
+        }
+
+        inline auto capacity() const noexcept -> usize {
+            return this->data.capacity() * bits::WORD;
+        }
+
+        inline auto reserve(usize n) noexcept -> void {
+            this->data.reserve(words_for(this->count + n));
+        }
+
+        /// @brief The backing words, bit `i` being bit `i % 64` of word `i / 64`. Bits past `len()` are zero.
+        ///
+        inline auto words() const noexcept -> u64 const* {
+            return this->data.data();
+        }
+
+        inline auto word_count() const noexcept -> usize {
+            return this->data.size();
+        }
+
+        inline auto get(usize i) const noexcept -> bool {
+            this->check(i);
+            return (this->data[i / bits::WORD] >> (i % bits::WORD)) & 1;
+        }
+
+        inline auto operator[](usize i) const noexcept -> bool {
+            return this->get(i);
+        }
+
+        inline auto set(usize i, bool value = true) noexcept -> void {
+            this->check(i);
+            auto mask = (u64)1 << (i % bits::WORD);
+            auto& w = this->data[i / bits::WORD];
+            w = value ? w | mask : w & ~mask;
+        }
+
+        inline auto reset(usize i) noexcept -> void {
+            this->set(i, false);
+        }
+
+        inline auto flip(usize i) noexcept -> void {
+            this->check(i);
+            this->data[i / bits::WORD] ^= (u64)1 << (i % bits::WORD);
+        }
+
+        inline auto push(bool value) noexcept -> void {
+            if (this->count % bits::WORD == 0) this->data.push_back(0);
+            this->data.back() |= (u64)value << (this->count % bits::WORD);
+            this->count++;
+        }
+
+        inline auto pop() noexcept -> Option<bool> {
+            if (this->count == 0) return Option<bool>();
+            auto value = this->get(this->count - 1);
+            this->resize(this->count - 1);
+            return Option<bool>(value);
+        }
+
+        /// @brief Truncate, or extend with `value` bits.
+        ///
+        inline auto resize(usize n, bool value = false) noexcept -> void {
+            if (value && n > this->count) {
+                if (auto tail = this->count % bits::WORD) this->data.back() |= ~(u64)0 << tail;
+            }
+            this->data.resize(words_for(n), value ? ~(u64)0 : 0);
+            this->count = n;
+            this->trim();
+        }
+
+        inline auto clear() noexcept -> void {
+            this->data.clear();
+            this->count = 0;
+        }
+
+        /// @brief Set every bit to `value`.
+        ///
+        inline auto fill(bool value) noexcept -> void {
+            std::fill(this->data.begin(), this->data.end(), value ? ~(u64)0 : 0);
+            this->trim();
+        }
+
+        /// @brief Number of ones.
+        ///
+        inline auto count_ones() const noexcept -> usize {
+            return bits::count(this->data.data(), this->data.size());
+        }
+
+        inline auto count_zeros() const noexcept -> usize {
+            return this->count - this->count_ones();
+        }
+
+        /// @brief Number of ones in `*this & rhs`, without building it. The size of a filter conjunction.
+        ///
+        inline auto count_and(BitVec const& rhs) const noexcept -> usize {
+            this->check(rhs);
+            return bits::count<bits::And>(this->data.data(), rhs.data.data(), this->data.size());
+        }
+
+        /// @brief Number of ones in `*this & ~rhs`, without building it.
+        ///
+        inline auto count_and_not(BitVec const& rhs) const noexcept -> usize {
+            this->check(rhs);
+            return bits::count<bits::AndNot>(this->data.data(), rhs.data.data(), this->data.size());
+        }
+
+        inline auto any() const noexcept -> bool {
+            return std::any_of(this->data.begin(), this->data.end(), [](u64 w) { return w != 0; });
+        }
+
+        inline auto none() const noexcept -> bool {
+            return !this->any();
+        }
+
+        inline auto all() const noexcept -> bool {
+            return this->count_ones() == this->count;
+        }
+
+        /// @brief The positions of the ones.
+        ///
+        inline auto ones() const noexcept -> Ones {
+            return Ones(this->data.data(), this->data.size(), 0);
+        }
+
+        /// @brief The position of the first one at or after `i`, if any.
+        ///
+        inline auto next_one(usize i) const noexcept -> Option<usize> {
+            if (i >= this->count) return Option<usize>();
+            auto w = i / bits::WORD;
+            auto rest = this->data[w] & (~(u64)0 << (i % bits::WORD));
+            while (rest == 0) {
+                if (++w == this->data.size()) return Option<usize>();
+                rest = this->data[w];
+            }
+            return Option<usize>(w * bits::WORD + (usize)std::countr_zero(rest));
+        }
+
+        /// @brief `*this &= rhs`, lengths must match.
+        ///
+        inline auto and_with(BitVec const& rhs) noexcept -> BitVec& {
+            return this->apply<bits::And>(rhs);
+        }
+
+        inline auto or_with(BitVec const& rhs) noexcept -> BitVec& {
+            return this->apply<bits::Or>(rhs);
+        }
+
+        inline auto xor_with(BitVec const& rhs) noexcept -> BitVec& {
+            return this->apply<bits::Xor>(rhs);
+        }
+
+        /// @brief `*this &= ~rhs`, lengths must match.
+        ///
+        inline auto and_not_with(BitVec const& rhs) noexcept -> BitVec& {
+            return this->apply<bits::AndNot>(rhs);
+        }
+
+        /// @brief Flip every bit.
+        ///
+        inline auto negate() noexcept -> BitVec& {
+            for (auto& w : this->data) w = ~w;
+            this->trim();
+            return *this;
+        }
+
+        inline auto operator&=(BitVec const& rhs) noexcept -> BitVec& {
+            return this->and_with(rhs);
+        }
+
+        inline auto operator|=(BitVec const& rhs) noexcept -> BitVec& {
+            return this->or_with(rhs);
+        }
+
+        inline auto operator^=(BitVec const& rhs) noexcept -> BitVec& {
+            return this->xor_with(rhs);
+        }
+
+        inline auto operator==(BitVec const& rhs) const noexcept -> bool {
+            return this->count == rhs.count && this->data == rhs.data;
+        }
+    };
+
+    /// @brief A succinct rank/select index over a `BitVec`, after Vigna's rank9.
+    ///
+    /// Every 512-bit block stores its absolute rank and the seven in-block word ranks packed in 9 bits each,
+    /// 25% extra space, so `rank` is two loads and a popcount. `select` jumps to a block through a sample
+    /// taken every `SAMPLE` ones, then searches the few blocks between samples. Built in one pass over the words.
+    ///
+    /// @warning The index borrows the vector and does not follow changes to it, rebuild after writing.
+    ///
+    class RankSelect final {
+
+    private:
+
+        inline constexpr static usize BLOCK = 8;
+
+        inline constexpr static usize SAMPLE = 4096;
+
+        BitVec const* vec;
+
+        /// @brief Per block, the ones before it and the packed ones before each of its words.
+        ///
+        std::vector<u64> blocks;
+
+        /// @brief Block holding every `SAMPLE`-th one.
+        ///
+        std::vector<u32> samples;
+
+        usize ones = 0;
+
+        inline auto absolute(usize b) const noexcept -> usize {
+            return (usize)this->blocks[b * 2];
+        }
+
+        /// @brief Ones in block `b` before its word `j`, zero for the first word whose field is never set.
+        ///
+        inline auto relative(usize b, usize j) const noexcept -> usize {
+            return (usize)(this->blocks[b * 2 + 1] >> (63 - j * 9)) & 0x1ff;
+        }
+
+        template<bool One>
+        inline auto before(usize b, usize j) const noexcept -> usize {
+            return One ? this->relative(b, j) : j * bits::WORD - this->relative(b, j);
+        }
+
+        /// @brief The `k`-th one or zero inside block `b`, `k` counted from the block start.
+        ///
+        template<bool One>
+        inline auto select_in(usize b, usize k) const noexcept -> usize {
+            auto n = this->vec->word_count();
+            auto j = (usize)1;
+            for (; j < BLOCK && b * BLOCK + j < n; j++) {
+                if (this->before<One>(b, j) > k) break;
+            }
+            auto w = b * BLOCK + --j;
+            auto word = this->vec->words()[w];
+            return w * bits::WORD + bits::select(One ? word : ~word, k - this->before<One>(b, j));
+        }
+
+    public:
+
+        inline explicit RankSelect(BitVec const& vec) noexcept : vec(&vec) {
+            auto words = vec.words();
+            auto n = vec.word_count();
+            auto count = (n + BLOCK - 1) / BLOCK;
+            this->blocks.resize(count * 2 + 2);
+            auto total = (usize)0;
+            for (auto b = (usize)0; b < count; b++) {
+                this->blocks[b * 2] = total;
+                auto packed = (u64)0;
+                auto inside = (usize)0;
+                for (auto j = (usize)0; j < BLOCK; j++) {
+                    if (j > 0) packed |= (u64)inside << (63 - j * 9);
+                    if (b * BLOCK + j < n) {
+                        auto w = words[b * BLOCK + j];
+                        inside += (usize)std::popcount(w);
+                        // Sample the block of every multiple of `SAMPLE` among the ones up to here.
+                        while (this->samples.size() * SAMPLE < total + inside) this->samples.push_back((u32)b);
+                    }
+                }
+                this->blocks[b * 2 + 1] = packed;
+                total += inside;
+            }
+            this->blocks[count * 2] = total;
+            this->ones = total;
+        }
+
+        inline auto count_ones() const noexcept -> usize {
+            return this->ones;
+        }
+
+        /// @brief Number of ones before position `i`, `i` at most `len()`.
+        ///
+        inline auto rank1(usize i) const noexcept -> usize {
+            if (i > this->vec->len()) [[unlikely]] panic("rank past the end of the bit vector");
+            auto w = i / bits::WORD;
+            auto b = w / BLOCK;
+            auto j = w % BLOCK;
+            auto r = this->absolute(b) + this->relative(b, j);
+            if (auto shift = i % bits::WORD) r += (usize)std::popcount(this->vec->words()[w] << (bits::WORD - shift));
+            return r;
+        }
+
+        /// @brief Number of zeros before position `i`.
+        ///
+        inline auto rank0(usize i) const noexcept -> usize {
+            return i - this->rank1(i);
+        }
+
+        /// @brief Position of the `k`-th one, counting from zero.
+        ///
+        inline auto select1(usize k) const noexcept -> Option<usize> {
+            if (k >= this->ones) return Option<usize>();
+            auto lo = (usize)this->samples[k / SAMPLE];
+            auto hi = k / SAMPLE + 1 < this->samples.size() ? (usize)this->samples[k / SAMPLE + 1] + 1 : this->blocks.size() / 2 - 1;
+            // The last block in [lo, hi) starting with at most `k` ones before it.
+            while (hi - lo > 1) {
+                auto mid = lo + (hi - lo) / 2;
+                if (this->absolute(mid) <= k) lo = mid;
+                else hi = mid;
+            }
+            return Option<usize>(this->select_in<true>(lo, k - this->absolute(lo)));
+        }
+
+        /// @brief Position of the `k`-th zero, counting from zero.
+        ///
+        inline auto select0(usize k) const noexcept -> Option<usize> {
+            if (k >= this->vec->len() - this->ones) return Option<usize>();
+            auto lo = (usize)0;
+            auto hi = this->blocks.size() / 2 - 1;
+            while (hi - lo > 1) {
+                auto mid = lo + (hi - lo) / 2;
+                if (mid * BLOCK * bits::WORD - this->absolute(mid) <= k) lo = mid;
+                else hi = mid;
+            }
+            return Option<usize>(this->select_in<false>(lo, k - (lo * BLOCK * bits::WORD - this->absolute(lo))));
+        }
+    };
+}
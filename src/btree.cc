@@ -0,0 +1,769 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "hashmap.cc"
+#include "ops.cc"
+#include "option.cc"
+#include "smallvec.cc"
+#include "thread.cc"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace coding::collections {
+
+    namespace btree {
+
+        /// @brief Construct `value` at `a[i]`, shifting `a[i..len)` right by one.
+        ///
+        template<typename T>
+        inline auto insert_at(T* a, usize len, usize i, T&& value) noexcept {
+            collections::relocate(a + i + 1, a + i, len - i);
+            new (a + i) T(mv(value));
+        }
+
+        /// @brief Destroy `a[i]`, shifting `a[i + 1..len)` left by one.
+        ///
+        template<typename T>
+        inline auto erase_at(T* a, usize len, usize i) noexcept {
+            a[i].~T();
+            collections::relocate(a + i, a + i + 1, len - i - 1);
+        }
+
+        template<typename T>
+        inline auto destroy(T* a, usize n) noexcept {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (auto i = (usize)0; i < n; i++) a[i].~T();
+            }
+        }
+
+        /// @brief Uninitialized room for `N` elements.
+        ///
+        template<typename T, usize N>
+        struct Slots final {
+
+            alignas(T) unsigned char raw[sizeof(T) * N];
+
+            inline auto data() noexcept -> T* {
+                return std::launder(reinterpret_cast<T*>(this->raw));
+            }
+
+            inline auto data() const noexcept -> T const* {
+                return std::launder(reinterpret_cast<T const*>(this->raw));
+            }
+        };
+
+        /// @brief Number of keys `< key` among the sorted `keys`, branch-free for arithmetic keys so the scan vectorizes.
+        ///
+        template<typename K>
+        inline auto lower(K const* keys, usize n, K const& key) noexcept -> usize {
+            if constexpr (std::is_arithmetic_v<K>) {
+                auto c = (usize)0;
+                for (auto i = (usize)0; i < n; i++) c += keys[i] < key;
+                return c;
+            }
+            else return (usize)(std::lower_bound(keys, keys + n, key) - keys);
+        }
+
+        /// @brief Number of keys `<= key` among the sorted `keys`.
+        ///
+        template<typename K>
+        inline auto upper(K const* keys, usize n, K const& key) noexcept -> usize {
+            if constexpr (std::is_arithmetic_v<K>) {
+                auto c = (usize)0;
+                for (auto i = (usize)0; i < n; i++) c += !(key < keys[i]);
+                return c;
+            }
+            else return (usize)(std::upper_bound(keys, keys + n, key) - keys);
+        }
+    }
+
+    /// @brief An ordered map on a B+ tree. Acts like Rust's `BTreeMap`.
+    ///
+    /// Keys of a node sit in one array of about four cache lines, so a lookup takes one or two misses per level
+    /// instead of one per comparison, and arithmetic keys are searched with a vectorized linear scan.
+    /// Entries live in the leaves, which are linked in order for range scans.
+    /// Inserts and removals invalidate iterators.
+    ///
+    /// @tparam K the key type
+    /// @tparam V the value type
+    ///
+    template<typename K, typename V>
+        requires (ops::Eq<K> and ops::Ord<K>)
+    class TreeMap final {
+
+    private:
+
+        /// @brief Keys per node, never fewer than `MIN` outside the root.
+        ///
+        inline constexpr static usize CAP = std::clamp<usize>(256 / sizeof(K), 8, 64) / 2 * 2;
+
+        inline constexpr static usize MIN = CAP / 2;
+
+        inline constexpr static usize MAX_HEIGHT = 32;
+
+        /// @brief Leaves and inner nodes hold one slot of slack, so an insert lands before the split.
+        ///
+        struct Leaf final {
+
+            usize len = 0;
+
+            Leaf* prev = nullptr;
+
+            Leaf* next = nullptr;
+
+            btree::Slots<K, CAP + 1> k;
+
+            btree::Slots<V, CAP + 1> v;
+
+            inline auto keys() noexcept -> K* { return this->k.data(); }
+            inline auto vals() noexcept -> V* { return this->v.data(); }
+        };
+
+        /// @brief `kids[i]` holds keys in `[keys[i - 1], keys[i])`.
+        ///
+        struct Inner final {
+
+            usize len = 0;
+
+            btree::Slots<K, CAP + 1> k;
+
+            void* kids[CAP + 2];
+
+            inline auto keys() noexcept -> K* { return this->k.data(); }
+        };
+
+        struct Step final {
+
+            Inner* node;
+
+            usize i;
+        };
+
+        void* root = nullptr;
+
+        /// @brief Levels of inner nodes above the leaves.
+        ///
+        usize height = 0;
+
+        usize count = 0;
+
+        Leaf* head = nullptr;
+
+        Leaf* tail = nullptr;
+
+        inline auto descend(K const& key, Step* path) const noexcept -> Leaf* {
+            auto node = this->root;
+            for (auto l = (usize)0; l < this->height; l++) {
+                auto inner = static_cast<Inner*>(node);
+                auto i = btree::upper(inner->keys(), inner->len, key);
+                if (path) path[l] = { inner, i };
+                node = inner->kids[i];
+            }
+            return static_cast<Leaf*>(node);
+        }
+
+        /// @brief Insert separator `sep` and its right child `kid` into the inner nodes of `path`, splitting upwards.
+        ///
+        inline auto insert_up(Step* path, K sep, void* kid) noexcept {
+            for (auto l = this->height; l-- > 0;) {
+                auto [node, i] = path[l];
+                btree::insert_at(node->keys(), node->len, i, mv(sep));
+                std::memmove(node->kids + i + 2, node->kids + i + 1, (node->len - i) * sizeof(void*));
+                node->kids[i + 1] = kid;
+                if (++node->len <= CAP) return;
+                auto right = new Inner;
+                right->len = CAP - MIN;
+                sep = mv(node->keys()[MIN]);
+                node->keys()[MIN].~K();
+                collections::relocate(right->keys(), node->keys() + MIN + 1, right->len);
+                std::memcpy(right->kids, node->kids + MIN + 1, (right->len + 1) * sizeof(void*));
+                node->len = MIN;
+                kid = right;
+            }
+            auto top = new Inner;
+            new (top->keys()) K(mv(sep));
+            top->kids[0] = this->root;
+            top->kids[1] = kid;
+            top->len = 1;
+            this->root = top;
+            this->height++;
+        }
+
+        /// @brief Remove key `i` and child `i + 1` of `node`.
+        ///
+        inline static auto remove_kid(Inner* node, usize i) noexcept {
+            btree::erase_at(node->keys(), node->len, i);
+            std::memmove(node->kids + i + 1, node->kids + i + 2, (node->len - i - 1) * sizeof(void*));
+            node->len--;
+        }
+
+        inline auto unlink(Leaf* leaf) noexcept {
+            if (leaf->prev) leaf->prev->next = leaf->next;
+            else this->head = leaf->next;
+            if (leaf->next) leaf->next->prev = leaf->prev;
+            else this->tail = leaf->prev;
+        }
+
+        /// @brief Move every entry of `b` to the end of its left neighbour `a` and free `b`.
+        ///
+        inline auto merge(Leaf* a, Leaf* b) noexcept {
+            collections::relocate(a->keys() + a->len, b->keys(), b->len);
+            collections::relocate(a->vals() + a->len, b->vals(), b->len);
+            a->len += b->len;
+            this->unlink(b);
+            delete b;
+        }
+
+        /// @brief Refill `leaf`, which is `p.node->kids[p.i]` and has fewer than `MIN` entries, from a sibling.
+        ///
+        inline auto rebalance(Leaf* leaf, Step p) noexcept {
+            auto [parent, i] = p;
+            auto left = i > 0 ? static_cast<Leaf*>(parent->kids[i - 1]) : nullptr;
+            auto right = i < parent->len ? static_cast<Leaf*>(parent->kids[i + 1]) : nullptr;
+            if (left && left->len > MIN) {
+                left->len--;
+                btree::insert_at(leaf->keys(), leaf->len, 0, mv(left->keys()[left->len]));
+                btree::insert_at(leaf->vals(), leaf->len, 0, mv(left->vals()[left->len]));
+                left->keys()[left->len].~K();
+                left->vals()[left->len].~V();
+                leaf->len++;
+                parent->keys()[i - 1] = leaf->keys()[0];
+            }
+            else if (right && right->len > MIN) {
+                new (leaf->keys() + leaf->len) K(mv(right->keys()[0]));
+                new (leaf->vals() + leaf->len) V(mv(right->vals()[0]));
+                leaf->len++;
+                btree::erase_at(right->keys(), right->len, 0);
+                btree::erase_at(right->vals(), right->len, 0);
+                right->len--;
+                parent->keys()[i] = right->keys()[0];
+            }
+            else if (left) {
+                this->merge(left, leaf);
+                remove_kid(parent, i - 1);
+            }
+            else {
+                this->merge(leaf, right);
+                remove_kid(parent, i);
+            }
+        }
+
+        /// @brief Refill the inner `node`, which is `p.node->kids[p.i]` and has fewer than `MIN` keys, from a sibling.
+        ///
+        inline static auto rebalance(Inner* node, Step p) noexcept {
+            auto [parent, i] = p;
+            auto left = i > 0 ? static_cast<Inner*>(parent->kids[i - 1]) : nullptr;
+            auto right = i < parent->len ? static_cast<Inner*>(parent->kids[i + 1]) : nullptr;
+            if (left && left->len > MIN) {
+                btree::insert_at(node->keys(), node->len, 0, mv(parent->keys()[i - 1]));
+                std::memmove(node->kids + 1, node->kids, (node->len + 1) * sizeof(void*));
+                node->kids[0] = left->kids[left->len];
+                node->len++;
+                left->len--;
+                parent->keys()[i - 1] = mv(left->keys()[left->len]);
+                left->keys()[left->len].~K();
+            }
+            else if (right && right->len > MIN) {
+                new (node->keys() + node->len) K(mv(parent->keys()[i]));
+                node->kids[node->len + 1] = right->kids[0];
+                node->len++;
+                parent->keys()[i] = mv(right->keys()[0]);
+                btree::erase_at(right->keys(), right->len, 0);
+                std::memmove(right->kids, right->kids + 1, right->len * sizeof(void*));
+                right->len--;
+            }
+            else {
+                auto j = left ? i - 1 : i;
+                auto a = left ? left : node;
+                auto b = left ? node : right;
+                new (a->keys() + a->len) K(mv(parent->keys()[j]));
+                collections::relocate(a->keys() + a->len + 1, b->keys(), b->len);
+                std::memcpy(a->kids + a->len + 1, b->kids, (b->len + 1) * sizeof(void*));
+                a->len += 1 + b->len;
+                delete b;
+                remove_kid(parent, j);
+            }
+        }
+
+        inline auto release(void* node, usize level) noexcept -> void {
+            if (level == this->height) {
+                auto leaf = static_cast<Leaf*>(node);
+                btree::destroy(leaf->keys(), leaf->len);
+                btree::destroy(leaf->vals(), leaf->len);
+                delete leaf;
+                return;
+            }
+            auto inner = static_cast<Inner*>(node);
+            for (auto i = (usize)0; i <= inner->len; i++) this->release(inner->kids[i], level + 1);
+            btree::destroy(inner->keys(), inner->len);
+            delete inner;
+        }
+
+        /// @brief Link inner levels above `level`, whose `firsts` are their smallest keys, and make the top one the root.
+        ///
+        inline auto build_up(std::vector<void*> level, std::vector<K const*> firsts) noexcept {
+            while (level.size() > 1) {
+                auto groups = (level.size() + CAP) / (CAP + 1);
+                auto next = std::vector<void*>();
+                auto next_firsts = std::vector<K const*>();
+                for (auto g = (usize)0, at = (usize)0; g < groups; g++) {
+                    // Spread the children evenly, so that every node gets at least `MIN + 1` of them.
+                    auto n = level.size() / groups + (g < level.size() % groups);
+                    auto inner = new Inner;
+                    for (auto j = (usize)0; j < n; j++) {
+                        inner->kids[j] = level[at + j];
+                        if (j > 0) new (inner->keys() + j - 1) K(*firsts[at + j]);
+                    }
+                    inner->len = n - 1;
+                    next.push_back(inner);
+                    next_firsts.push_back(firsts[at]);
+                    at += n;
+                }
+                level = mv(next);
+                firsts = mv(next_firsts);
+                this->height++;
+            }
+            this->root = level.empty() ? nullptr : level[0];
+        }
+
+    public:
+
+        using key_type = K;
+
+        using mapped_type = V;
+
+        /// @brief Iterator over the entries in key order, yielding `KeyValue<K const&, V&>`.
+        ///
+        template<bool Const>
+        class Iterator final {
+
+        private:
+
+            friend class TreeMap;
+
+            Leaf* leaf;
+
+            usize i;
+
+            TreeMap const* tree;
+
+            inline Iterator(Leaf* leaf, usize i, TreeMap const* tree) noexcept : leaf(leaf), i(i), tree(tree) {}
+
+        public:
+
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = KeyValue<K const&, std::conditional_t<Const, V const&, V&>>;
+            using difference_type = isize;
+            using reference = value_type;
+
+            inline Iterator() noexcept : leaf(nullptr), i(0), tree(nullptr) {}
+
+            inline auto operator*() const noexcept -> value_type {
+                return { this->leaf->keys()[this->i], this->leaf->vals()[this->i] };
+            }
+
+            inline auto operator++() noexcept -> Iterator& {
+                if (++this->i == this->leaf->len) {
+                    this->leaf = this->leaf->next;
+                    this->i = 0;
+                }
+                return *this;
+            }
+
+            inline auto operator++(int) noexcept -> Iterator { auto t = *this; ++*this; return t; }
+
+            inline auto operator--() noexcept -> Iterator& {
+                if (!this->leaf) {
+                    this->leaf = this->tree->tail;
+                    this->i = this->leaf->len - 1;
+                }
+                else if (this->i == 0) {
+                    this->leaf = this->leaf->prev;
+                    this->i = this->leaf->len - 1;
+                }
+                else this->i--;
+                return *this;
+            }
+
+            inline auto operator--(int) noexcept -> Iterator { auto t = *this; --*this; return t; }
+
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool {
+                return this->leaf == rhs.leaf && this->i == rhs.i;
+            }
+        };
+
+        /// @brief The entries between two iterators, for `for` loops.
+        ///
+        template<bool Const>
+        class Range final {
+
+        private:
+
+            Iterator<Const> first;
+
+            Iterator<Const> last;
+
+        public:
+
+            inline Range(Iterator<Const> first, Iterator<Const> last) noexcept : first(first), last(last) {}
+
+            inline auto begin() const noexcept -> Iterator<Const> { return this->first; }
+            inline auto end() const noexcept -> Iterator<Const> { return this->last; }
+        };
+
+        inline TreeMap() noexcept = default;
+
+        /// @brief Build a map from entries sorted by strictly increasing key in O(n), with full leaves.
+        /// @param entries a range of `KeyValue`s or pairs
+        ///
+        /// # Panic
+        ///
+        /// Panics if the keys are not strictly increasing.
+        ///
+        template<std::ranges::input_range R>
+        inline static auto from_sorted(R&& entries) noexcept -> TreeMap {
+            auto map = TreeMap();
+            auto leaves = std::vector<void*>();
+            auto firsts = std::vector<K const*>();
+            Leaf* leaf = nullptr;
+            for (auto&& e : entries) {
+                auto&& [key, value] = e;
+                if (leaf && !(leaf->keys()[leaf->len - 1] < key)) panic("`TreeMap::from_sorted` on keys not strictly increasing");
+                if (!leaf || leaf->len == CAP) {
+                    auto fresh = new Leaf;
+                    fresh->prev = leaf;
+                    if (leaf) leaf->next = fresh;
+                    else map.head = fresh;
+                    leaf = fresh;
+                    leaves.push_back(leaf);
+                }
+                if constexpr (std::is_lvalue_reference_v<R>) {
+                    new (leaf->keys() + leaf->len) K(key);
+                    new (leaf->vals() + leaf->len) V(value);
+                }
+                else {
+                    new (leaf->keys() + leaf->len) K(mv(key));
+                    new (leaf->vals() + leaf->len) V(mv(value));
+                }
+                leaf->len++;
+                map.count++;
+            }
+            map.tail = leaf;
+            if (leaves.size() > 1 && leaf->len < MIN) {
+                // Even out the last two leaves, the one before is full.
+                auto prev = leaf->prev;
+                auto n = MIN - leaf->len;
+                collections::relocate(leaf->keys() + n, leaf->keys(), leaf->len);
+                collections::relocate(leaf->vals() + n, leaf->vals(), leaf->len);
+                collections::relocate(leaf->keys(), prev->keys() + prev->len - n, n);
+                collections::relocate(leaf->vals(), prev->vals() + prev->len - n, n);
+                prev->len -= n;
+                leaf->len += n;
+            }
+            for (auto l : leaves) firsts.push_back(static_cast<Leaf*>(l)->keys());
+            map.build_up(mv(leaves), mv(firsts));
+            return map;
+        }
+
+        inline TreeMap(TreeMap const& rhs) noexcept {
+            auto entries = std::vector<KeyValue<K, V>>();
+            entries.reserve(rhs.count);
+            for (auto [k, v] : rhs) entries.push_back({ k, v });
+            *this = from_sorted(mv(entries));
+        }
+
+        inline TreeMap(TreeMap&& rhs) noexcept
+            : root(std::exchange(rhs.root, nullptr)), height(std::exchange(rhs.height, 0)), count(std::exchange(rhs.count, 0)),
+            head(std::exchange(rhs.head, nullptr)), tail(std::exchange(rhs.tail, nullptr)) {}
+
+        inline auto operator=(TreeMap rhs) noexcept -> TreeMap& {
+            std::swap(this->root, rhs.root);
+            std::swap(this->height, rhs.height);
+            std::swap(this->count, rhs.count);
+            std::swap(this->head, rhs.head);
+            std::swap(this->tail, rhs.tail);
+            return *this;
+        }
+
+        inline ~TreeMap() noexcept {
+            this->clear();
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->count;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->count == 0;
+        }
+
+        inline auto clear() noexcept {
+            if (this->root) this->release(this->root, 0);
+            this->root = nullptr;
+            this->height = 0;
+            this->count = 0;
+            this->head = this->tail = nullptr;
+        }
+
+        /// @brief Insert or replace the value of `key`.
+        /// @return the replaced value, if any
+        ///
+        inline auto insert(K key, V value) noexcept -> Option<V> {
+            if (!this->root) this->root = this->head = this->tail = new Leaf;
+            Step path[MAX_HEIGHT];
+            auto leaf = this->descend(key, path);
+            auto i = btree::lower(leaf->keys(), leaf->len, key);
+            if (i < leaf->len && !(key < leaf->keys()[i])) return Option<V>(std::exchange(leaf->vals()[i], mv(value)));
+            btree::insert_at(leaf->keys(), leaf->len, i, mv(key));
+            btree::insert_at(leaf->vals(), leaf->len, i, mv(value));
+            this->count++;
+            if (++leaf->len <= CAP) return Option<V>();
+            // Appending past the last key keeps the left leaf full, so ascending inserts fill leaves like a bulk load.
+            auto keep = i == CAP && !leaf->next ? CAP : (CAP + 1) / 2;
+            auto right = new Leaf;
+            right->len = leaf->len - keep;
+            collections::relocate(right->keys(), leaf->keys() + keep, right->len);
+            collections::relocate(right->vals(), leaf->vals() + keep, right->len);
+            leaf->len = keep;
+            right->prev = leaf;
+            right->next = leaf->next;
+            if (leaf->next) leaf->next->prev = right;
+            else this->tail = right;
+            leaf->next = right;
+            this->insert_up(path, right->keys()[0], right);
+            return Option<V>();
+        }
+
+        /// @brief Remove `key`.
+        /// @return its value, if it was present
+        ///
+        inline auto remove(K const& key) noexcept -> Option<V> {
+            if (!this->root) return Option<V>();
+            Step path[MAX_HEIGHT];
+            auto leaf = this->descend(key, path);
+            auto i = btree::lower(leaf->keys(), leaf->len, key);
+            if (i == leaf->len || key < leaf->keys()[i]) return Option<V>();
+            auto value = Option<V>(mv(leaf->vals()[i]));
+            btree::erase_at(leaf->keys(), leaf->len, i);
+            btree::erase_at(leaf->vals(), leaf->len, i);
+            leaf->len--;
+            this->count--;
+            if (this->height == 0) {
+                if (leaf->len == 0) this->clear();
+                return value;
+            }
+            if (leaf->len >= MIN) return value;
+            this->rebalance(leaf, path[this->height - 1]);
+            for (auto l = this->height - 1; l > 0 && path[l].node->len < MIN; l--) rebalance(path[l].node, path[l - 1]);
+            auto top = static_cast<Inner*>(this->root);
+            if (top->len == 0) {
+                this->root = top->kids[0];
+                this->height--;
+                delete top;
+            }
+            return value;
+        }
+
+        /// @brief The value of `key`, or `nullptr`.
+        ///
+        inline auto get(K const& key) noexcept -> V* {
+            if (!this->root) return nullptr;
+            auto leaf = this->descend(key, nullptr);
+            auto i = btree::lower(leaf->keys(), leaf->len, key);
+            return i < leaf->len && !(key < leaf->keys()[i]) ? leaf->vals() + i : nullptr;
+        }
+
+        inline auto get(K const& key) const noexcept -> V const* {
+            return const_cast<TreeMap*>(this)->get(key);
+        }
+
+        inline auto contains(K const& key) const noexcept -> bool {
+            return this->get(key) != nullptr;
+        }
+
+        /// @brief The value of `key`, inserting a default-constructed one first if absent.
+        ///
+        inline auto operator[](K const& key) noexcept -> V& {
+            if (auto v = this->get(key)) return *v;
+            this->insert(key, V());
+            return *this->get(key);
+        }
+
+        /// @brief The first entry with a key not less than `key`.
+        ///
+        inline auto lower_bound(K const& key) const noexcept -> Iterator<true> {
+            if (!this->root) return this->end();
+            auto leaf = this->descend(key, nullptr);
+            auto i = btree::lower(leaf->keys(), leaf->len, key);
+            if (i == leaf->len) return Iterator<true>(leaf->next, 0, this);
+            return Iterator<true>(leaf, i, this);
+        }
+
+        /// @brief The first entry with a key greater than `key`.
+        ///
+        inline auto upper_bound(K const& key) const noexcept -> Iterator<true> {
+            if (!this->root) return this->end();
+            auto leaf = this->descend(key, nullptr);
+            auto i = btree::upper(leaf->keys(), leaf->len, key);
+            if (i == leaf->len) return Iterator<true>(leaf->next, 0, this);
+            return Iterator<true>(leaf, i, this);
+        }
+
+        inline auto lower_bound(K const& key) noexcept -> Iterator<false> {
+            auto it = std::as_const(*this).lower_bound(key);
+            return Iterator<false>(it.leaf, it.i, this);
+        }
+
+        inline auto upper_bound(K const& key) noexcept -> Iterator<false> {
+            auto it = std::as_const(*this).upper_bound(key);
+            return Iterator<false>(it.leaf, it.i, this);
+        }
+
+        /// @brief The entries with keys in `[from, to)`, walking the linked leaves.
+        ///
+        inline auto range(K const& from, K const& to) const noexcept -> Range<true> {
+            if (!(from < to)) return Range<true>(this->end(), this->end());
+            return Range<true>(this->lower_bound(from), this->lower_bound(to));
+        }
+
+        inline auto range(K const& from, K const& to) noexcept -> Range<false> {
+            if (!(from < to)) return Range<false>(this->end(), this->end());
+            return Range<false>(this->lower_bound(from), this->lower_bound(to));
+        }
+
+        inline auto begin() noexcept -> Iterator<false> { return Iterator<false>(this->head, 0, this); }
+        inline auto end() noexcept -> Iterator<false> { return Iterator<false>(nullptr, 0, this); }
+        inline auto begin() const noexcept -> Iterator<true> { return Iterator<true>(this->head, 0, this); }
+        inline auto end() const noexcept -> Iterator<true> { return Iterator<true>(nullptr, 0, this); }
+    };
+
+    /// @brief An ordered set on the B+ tree of `TreeMap`. Acts like Rust's `BTreeSet`.
+    /// @tparam T the element type
+    ///
+    template<typename T>
+        requires (ops::Eq<T> and ops::Ord<T>)
+    class TreeSet final {
+
+    private:
+
+        using Map = TreeMap<T, unit>;
+
+        Map map;
+
+        inline explicit TreeSet(Map map) noexcept : map(mv(map)) {}
+
+    public:
+
+        /// @brief Iterator over the elements in order.
+        ///
+        class Iterator final {
+
+        private:
+
+            typename Map::template Iterator<true> it;
+
+        public:
+
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = T;
+            using difference_type = isize;
+            using reference = T const&;
+
+            inline Iterator() noexcept = default;
+
+            inline Iterator(typename Map::template Iterator<true> it) noexcept : it(it) {}
+
+            inline auto operator*() const noexcept -> T const& { return (*this->it).key; }
+            inline auto operator++() noexcept -> Iterator& { ++this->it; return *this; }
+            inline auto operator++(int) noexcept -> Iterator { auto t = *this; ++this->it; return t; }
+            inline auto operator--() noexcept -> Iterator& { --this->it; return *this; }
+            inline auto operator--(int) noexcept -> Iterator { auto t = *this; --this->it; return t; }
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool { return this->it == rhs.it; }
+        };
+
+        class Range final {
+
+        private:
+
+            Iterator first;
+
+            Iterator last;
+
+        public:
+
+            inline Range(Iterator first, Iterator last) noexcept : first(first), last(last) {}
+
+            inline auto begin() const noexcept -> Iterator { return this->first; }
+            inline auto end() const noexcept -> Iterator { return this->last; }
+        };
+
+        inline TreeSet() noexcept = default;
+
+        /// @brief Build a set from strictly increasing elements in O(n).
+        ///
+        /// # Panic
+        ///
+        /// Panics if the elements are not strictly increasing.
+        ///
+        template<std::ranges::input_range R>
+        inline static auto from_sorted(R&& elements) noexcept -> TreeSet {
+            return TreeSet(Map::from_sorted(std::forward<R>(elements) | std::views::transform([](auto&& x) {
+                return KeyValue<T, unit>{ T(x), unit() };
+            })));
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->map.len();
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->map.is_empty();
+        }
+
+        inline auto clear() noexcept {
+            this->map.clear();
+        }
+
+        /// @return whether `value` was not present
+        ///
+        inline auto insert(T value) noexcept -> bool {
+            return this->map.insert(mv(value), unit()).is_none();
+        }
+
+        /// @return whether `value` was present
+        ///
+        inline auto remove(T const& value) noexcept -> bool {
+            return this->map.remove(value).is_some();
+        }
+
+        inline auto contains(T const& value) const noexcept -> bool {
+            return this->map.contains(value);
+        }
+
+        inline auto lower_bound(T const& value) const noexcept -> Iterator {
+            return Iterator(this->map.lower_bound(value));
+        }
+
+        inline auto upper_bound(T const& value) const noexcept -> Iterator {
+            return Iterator(this->map.upper_bound(value));
+        }
+
+        /// @brief The elements in `[from, to)`.
+        ///
+        inline auto range(T const& from, T const& to) const noexcept -> Range {
+            auto r = this->map.range(from, to);
+            return Range(r.begin(), r.end());
+        }
+
+        inline auto begin() const noexcept -> Iterator { return Iterator(this->map.begin()); }
+        inline auto end() const noexcept -> Iterator { return Iterator(this->map.end()); }
+    };
+}
@@ -0,0 +1,383 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "hash.cc"
+#include "hashmap.cc"
+#include "mutex.cc"
+#include "ops.cc"
+#include "option.cc"
+#include "thread.cc"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace coding::collections {
+
+    /// @brief A thread-safe hash map split by hash into cache-line aligned shards, each a Swiss table behind its own lock.
+    ///
+    /// Writers lock one shard. Readers of trivially copyable keys and values take no lock at all:
+    /// they probe under the shard's sequence counter and retry if a writer got in the way, falling back
+    /// to the lock after a few attempts. Other types are read under the shard lock.
+    ///
+    /// A shard grows incrementally: the full table is kept as `old` next to one twice its size, and every
+    /// write moves a few entries over, so no single write pays for a whole rehash.
+    /// Lookups check both tables until the move is over.
+    ///
+    /// @warning For lock-free reads `==` on keys runs on slots being written, so it must not follow pointers.
+    /// Text keys such as `str` are therefore always read under the lock.
+    /// @note Tables replaced by a resize are freed with the map when readers are lock-free, since one may still
+    /// be probing them. They add up to less than the live tables.
+    ///
+    /// @tparam K the key type
+    /// @tparam V the value type, copied out by reads
+    /// @tparam H the `BuildHasher`, shared by all shards
+    ///
+    template<typename K, typename V, typename H = hash::RandomState>
+        requires (ops::Eq<K> and hash::Hash<K> and hash::BuildHasher<H>)
+    class ConcurrentHashMap final {
+
+    private:
+
+        using Slot = KeyValue<K, V>;
+
+        using Table = RawTable<K, Slot, H, hash::StdEq>;
+
+        constexpr static bool OPTIMISTIC = std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V> && !hash::Text<K>;
+
+        /// @brief Entries moved from the old table by every write during a resize.
+        ///
+        constexpr static usize MIGRATE = 8;
+
+        /// @brief Optimistic reads attempted before taking the lock.
+        ///
+        constexpr static usize RETRIES = 4;
+
+        struct alignas(thread::CACHE_LINE) Shard {
+
+            thread::RawMutex lock;
+
+            /// @brief Odd while a writer is modifying the shard.
+            ///
+            std::atomic<u32> seq = 0;
+
+            std::atomic<Table*> table = nullptr;
+
+            /// @brief The table being moved into `table`, if resizing.
+            ///
+            std::atomic<Table*> old = nullptr;
+
+            /// @brief Slot of `old` to move next.
+            ///
+            usize cursor = 0;
+
+            std::atomic<usize> count = 0;
+
+            std::vector<Table*> retired;
+        };
+
+        /// @brief Holds the shard lock with the sequence counter odd.
+        ///
+        class Writing final {
+
+        private:
+
+            Shard& shard;
+
+        public:
+
+            inline explicit Writing(Shard& shard) noexcept : shard(shard) {
+                shard.lock.lock();
+                shard.seq.store(shard.seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+            }
+
+            Writing(Writing const&) = delete;
+
+            inline ~Writing() noexcept {
+                this->shard.seq.store(this->shard.seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+                this->shard.lock.unlock();
+            }
+        };
+
+        std::unique_ptr<Shard[]> shards;
+
+        u32 bits;
+
+        [[no_unique_address]] H hasher;
+
+        /// @brief The shard of hash `h`, from its top bits since the tables take the low ones.
+        ///
+        inline auto shard(u64 h) const noexcept -> Shard& {
+            return this->shards[(usize)std::rotl(h, (int)this->bits) & (((usize)1 << this->bits) - 1)];
+        }
+
+        template<typename Q>
+        inline static auto lookup(Shard& s, Q const& q, u64 h) noexcept -> std::pair<Table*, Slot*> {
+            if (auto t = s.table.load(std::memory_order_acquire)) {
+                if (auto slot = t->find(q, h)) return { t, slot };
+            }
+            if (auto t = s.old.load(std::memory_order_acquire)) {
+                if (auto slot = t->find(q, h)) return { t, slot };
+            }
+            return { nullptr, nullptr };
+        }
+
+        inline static auto retire(Shard& s, Table* t) noexcept {
+            if constexpr (OPTIMISTIC) s.retired.push_back(t);
+            else delete t;
+        }
+
+        /// @brief Move up to `n` entries of the old table into the current one, retiring the old table once empty.
+        ///
+        inline static auto migrate(Shard& s, usize n) noexcept {
+            auto old = s.old.load(std::memory_order_relaxed);
+            if (!old) return;
+            auto table = s.table.load(std::memory_order_relaxed);
+            for (; n > 0; n--) {
+                s.cursor = old->next_full(s.cursor);
+                if (s.cursor == old->slot_count()) {
+                    s.old.store(nullptr, std::memory_order_release);
+                    retire(s, old);
+                    return;
+                }
+                auto from = old->slot(s.cursor);
+                auto [to, _] = table->find_or_prepare(from->key);
+                new (to) Slot(mv(*from));
+                old->erase(from);
+            }
+        }
+
+        /// @brief Replace the shard table with an empty one of room for `n`, the entries move over by later writes.
+        ///
+        inline auto resize(Shard& s, usize n) noexcept -> Table* {
+            // The previous resize is all but done by now, finish it.
+            migrate(s, ~(usize)0);
+            // Every table hashes like the map, which picked the shard.
+            auto fresh = new Table(this->hasher);
+            fresh->reserve(std::max(n, (usize)16));
+            if (auto table = s.table.load(std::memory_order_relaxed)) {
+                s.old.store(table, std::memory_order_relaxed);
+                s.cursor = 0;
+            }
+            s.table.store(fresh, std::memory_order_release);
+            return fresh;
+        }
+
+        /// @brief The table to insert a new key into, resizing if it is out of room.
+        ///
+        /// A table of twice the old length takes all moved entries plus one insert per `MIGRATE` of them
+        /// before the old table empties, so it never rehashes under optimistic readers.
+        ///
+        inline auto room(Shard& s) noexcept -> Table* {
+            auto table = s.table.load(std::memory_order_relaxed);
+            if (!table || table->growth_left() == 0) [[unlikely]] table = this->resize(s, table ? table->len() * 2 : 0);
+            return table;
+        }
+
+        inline auto insert_new(Shard& s, K key, V value, u64 h) noexcept -> Slot* {
+            auto [slot, _] = this->room(s)->find_or_prepare(key, h);
+            new (slot) Slot{ mv(key), mv(value) };
+            s.count.store(s.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return slot;
+        }
+
+    public:
+
+        /// @brief Construct an empty map.
+        /// @param shards number of shards, rounded up to a power of two, by default four per hardware thread
+        /// @param hasher the `BuildHasher`
+        ///
+        inline explicit ConcurrentHashMap(usize shards = 0, H hasher = H()) noexcept : hasher(mv(hasher)) {
+            if (shards == 0) shards = std::max((usize)16, (usize)std::thread::hardware_concurrency() * 4);
+            shards = std::bit_ceil(shards);
+            this->bits = (u32)std::countr_zero(shards);
+            this->shards = std::make_unique<Shard[]>(shards);
+        }
+
+        ConcurrentHashMap(ConcurrentHashMap const&) = delete;
+
+        inline ~ConcurrentHashMap() noexcept {
+            for (auto i = (usize)0; i < ((usize)1 << this->bits); i++) {
+                auto& s = this->shards[i];
+                delete s.table.load(std::memory_order_relaxed);
+                delete s.old.load(std::memory_order_relaxed);
+                for (auto t : s.retired) delete t;
+            }
+        }
+
+        /// @brief Number of entries, not a snapshot when writers are running.
+        ///
+        inline auto len() const noexcept -> usize {
+            auto n = (usize)0;
+            for (auto i = (usize)0; i < ((usize)1 << this->bits); i++) n += this->shards[i].count.load(std::memory_order_relaxed);
+            return n;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->len() == 0;
+        }
+
+        /// @brief Make room for `n` entries spread evenly, resizing shards at once rather than incrementally.
+        ///
+        inline auto reserve(usize n) noexcept {
+            auto each = n / ((usize)1 << this->bits) + 1;
+            for (auto i = (usize)0; i < ((usize)1 << this->bits); i++) {
+                auto& s = this->shards[i];
+                auto _ = Writing(s);
+                auto table = s.table.load(std::memory_order_relaxed);
+                if (table && table->len() + table->growth_left() >= each) continue;
+                this->resize(s, each);
+                migrate(s, ~(usize)0);
+            }
+        }
+
+        /// @brief A copy of the value of `key`, if present.
+        ///
+        template<typename Q>
+            requires LookupBy<Q, K, H, hash::StdEq>
+        inline auto get(Q const& key) const noexcept -> Option<V> {
+            auto h = hash::hash_one(this->hasher, key);
+            auto& s = this->shard(h);
+            if constexpr (OPTIMISTIC) {
+                for (auto i = (usize)0; i < RETRIES; i++) {
+                    auto seq = s.seq.load(std::memory_order_acquire);
+                    if (seq & 1) {
+                        thread::relax();
+                        continue;
+                    }
+                    auto slot = lookup(s, key, h).second;
+                    alignas(V) unsigned char value[sizeof(V)];
+                    if (slot) std::memcpy(value, (void const*)&slot->value, sizeof(V));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (s.seq.load(std::memory_order_relaxed) != seq) continue;
+                    return slot ? Option<V>(*std::launder(reinterpret_cast<V*>(value))) : Option<V>();
+                }
+            }
+            s.lock.lock();
+            auto slot = lookup(s, key, h).second;
+            auto value = slot ? Option<V>(slot->value) : Option<V>();
+            s.lock.unlock();
+            return value;
+        }
+
+        template<typename Q>
+            requires LookupBy<Q, K, H, hash::StdEq>
+        inline auto contains(Q const& key) const noexcept -> bool {
+            return this->get(key).is_some();
+        }
+
+        /// @brief Insert or replace the value of `key`.
+        /// @return the replaced value, if any
+        ///
+        inline auto insert(K key, V value) noexcept -> Option<V> {
+            auto h = hash::hash_one(this->hasher, key);
+            auto& s = this->shard(h);
+            auto _ = Writing(s);
+            migrate(s, MIGRATE);
+            if (auto slot = lookup(s, key, h).second) return Option<V>(std::exchange(slot->value, mv(value)));
+            this->insert_new(s, mv(key), mv(value), h);
+            return Option<V>();
+        }
+
+        /// @brief Remove `key`.
+        /// @return its value, if it was present
+        ///
+        template<typename Q>
+            requires LookupBy<Q, K, H, hash::StdEq>
+        inline auto remove(Q const& key) noexcept -> Option<V> {
+            auto h = hash::hash_one(this->hasher, key);
+            auto& s = this->shard(h);
+            auto _ = Writing(s);
+            migrate(s, MIGRATE);
+            auto [table, slot] = lookup(s, key, h);
+            if (!slot) return Option<V>();
+            auto value = Option<V>(mv(slot->value));
+            table->erase(slot);
+            s.count.store(s.count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+            return value;
+        }
+
+        /// @brief Compute-if-absent: the value of `key`, inserting `make()` first if absent.
+        /// `make` runs at most once, under the shard lock, so it must not touch this map.
+        /// @return a copy of the value
+        ///
+        template<typename F>
+        inline auto get_or_insert_with(K key, F&& make) noexcept -> V {
+            if constexpr (OPTIMISTIC) {
+                if (auto v = this->get(key); v.is_some()) return mv(v).unwrap();
+            }
+            auto h = hash::hash_one(this->hasher, key);
+            auto& s = this->shard(h);
+            auto _ = Writing(s);
+            migrate(s, MIGRATE);
+            if (auto slot = lookup(s, key, h).second) return slot->value;
+            return this->insert_new(s, mv(key), std::forward<F>(make)(), h)->value;
+        }
+
+        /// @brief Atomically recompute the entry of `key`, like Java's `compute`.
+        /// @param f called under the shard lock with a pointer to the current value or `nullptr`,
+        /// returns the new value, or `None` to remove the entry
+        /// @return what `f` returned
+        ///
+        template<typename F>
+        inline auto compute(K key, F&& f) noexcept -> Option<V> {
+            auto h = hash::hash_one(this->hasher, key);
+            auto& s = this->shard(h);
+            auto _ = Writing(s);
+            migrate(s, MIGRATE);
+            auto [table, slot] = lookup(s, key, h);
+            Option<V> next = std::forward<F>(f)(slot ? &slot->value : nullptr);
+            if (next.is_some()) {
+                if (slot) slot->value = next.unwrap();
+                else this->insert_new(s, mv(key), next.unwrap(), h);
+            }
+            else if (slot) {
+                table->erase(slot);
+                s.count.store(s.count.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+            }
+            return next;
+        }
+
+        /// @brief Call `f(key, value)` on every entry, one shard at a time under its lock.
+        /// Entries written meanwhile in other shards may or may not be visited.
+        ///
+        template<typename F>
+        inline auto for_each(F&& f) const noexcept {
+            for (auto i = (usize)0; i < ((usize)1 << this->bits); i++) {
+                auto& s = this->shards[i];
+                s.lock.lock();
+                for (auto t : { s.table.load(std::memory_order_relaxed), s.old.load(std::memory_order_relaxed) }) {
+                    if (!t) continue;
+                    for (auto j = t->next_full(0); j < t->slot_count(); j = t->next_full(j + 1)) {
+                        auto slot = t->slot(j);
+                        f(std::as_const(slot->key), std::as_const(slot->value));
+                    }
+                }
+                s.lock.unlock();
+            }
+        }
+
+        inline auto clear() noexcept {
+            for (auto i = (usize)0; i < ((usize)1 << this->bits); i++) {
+                auto& s = this->shards[i];
+                auto _ = Writing(s);
+                if (auto t = s.table.load(std::memory_order_relaxed)) t->clear();
+                if (auto t = s.old.load(std::memory_order_relaxed)) {
+                    s.old.store(nullptr, std::memory_order_release);
+                    t->clear();
+                    retire(s, t);
+                }
+                s.count.store(0, std::memory_order_relaxed);
+            }
+        }
+    };
+}
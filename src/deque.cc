@@ -0,0 +1,401 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "option.cc"
+#include "thread.cc"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace coding::collections {
+
+    /// @brief A double-ended queue in a growable power-of-two ring buffer. Acts like Rust's `VecDeque`.
+    ///
+    /// Elements live in one allocation, in at most two contiguous runs: `[head, capacity)` and then `[0, ...)`.
+    /// Pushing and popping at either end is O(1) amortized, indexing is a mask away.
+    /// Trivially copyable elements are moved with `memcpy` when growing, extending and draining.
+    ///
+    /// @tparam T the element type
+    ///
+    template<typename T>
+    class VecDeque final {
+
+    private:
+
+        constexpr static bool TRIVIAL = std::is_trivially_copyable_v<T>;
+
+        T* buf = nullptr;
+
+        usize cap = 0;
+
+        usize head = 0;
+
+        usize count = 0;
+
+        inline static auto allocate(usize n) noexcept -> T* {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+        }
+
+        inline static auto deallocate(T* p) noexcept {
+            if (p) ::operator delete(p, std::align_val_t(alignof(T)));
+        }
+
+        inline auto wrap(usize i) const noexcept -> usize {
+            return i & (this->cap - 1);
+        }
+
+        inline auto slot(usize i) const noexcept -> T* {
+            return this->buf + this->wrap(this->head + i);
+        }
+
+        /// @brief Move every element into a new buffer of `n` slots, starting at index 0.
+        ///
+        inline auto relocate(usize n) noexcept {
+            auto fresh = allocate(n);
+            auto [a, b] = this->as_slices();
+            if constexpr (TRIVIAL) {
+                if (!a.empty()) std::memcpy((void*)fresh, a.data(), a.size() * sizeof(T));
+                if (!b.empty()) std::memcpy((void*)(fresh + a.size()), b.data(), b.size() * sizeof(T));
+            }
+            else {
+                auto p = fresh;
+                for (auto& x : a) {
+                    new (p++) T(mv(x));
+                    x.~T();
+                }
+                for (auto& x : b) {
+                    new (p++) T(mv(x));
+                    x.~T();
+                }
+            }
+            deallocate(this->buf);
+            this->buf = fresh;
+            this->cap = n;
+            this->head = 0;
+        }
+
+        inline auto grow_for(usize extra) noexcept {
+            auto need = this->count + extra;
+            if (need <= this->cap) return;
+            this->relocate(std::bit_ceil(std::max(need, std::max(this->cap * 2, (usize)8))));
+        }
+
+    public:
+
+        /// @brief Random access iterator over the elements in order.
+        ///
+        template<bool Const>
+        class Iterator final {
+
+        private:
+
+            using Owner = std::conditional_t<Const, VecDeque const, VecDeque>;
+
+            Owner* owner;
+
+            usize i;
+
+        public:
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = T;
+            using difference_type = isize;
+            using pointer = std::conditional_t<Const, T const*, T*>;
+            using reference = std::conditional_t<Const, T const&, T&>;
+
+            inline constexpr Iterator() noexcept : owner(nullptr), i(0) {}
+
+            inline constexpr Iterator(Owner* owner, usize i) noexcept : owner(owner), i(i) {}
+
+            inline auto operator*() const noexcept -> reference { return *this->owner->slot(this->i); }
+            inline auto operator->() const noexcept -> pointer { return this->owner->slot(this->i); }
+            inline auto operator[](isize n) const noexcept -> reference { return *this->owner->slot(this->i + n); }
+
+            inline auto operator++() noexcept -> Iterator& { this->i++; return *this; }
+            inline auto operator++(int) noexcept -> Iterator { auto t = *this; this->i++; return t; }
+            inline auto operator--() noexcept -> Iterator& { this->i--; return *this; }
+            inline auto operator--(int) noexcept -> Iterator { auto t = *this; this->i--; return t; }
+            inline auto operator+=(isize n) noexcept -> Iterator& { this->i += n; return *this; }
+            inline auto operator-=(isize n) noexcept -> Iterator& { this->i -= n; return *this; }
+            inline auto operator+(isize n) const noexcept -> Iterator { return Iterator(this->owner, this->i + n); }
+            inline auto operator-(isize n) const noexcept -> Iterator { return Iterator(this->owner, this->i - n); }
+            inline auto operator-(Iterator const& rhs) const noexcept -> isize { return (isize)this->i - (isize)rhs.i; }
+            inline friend auto operator+(isize n, Iterator const& it) noexcept -> Iterator { return it + n; }
+
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool { return this->i == rhs.i; }
+            inline auto operator<=>(Iterator const& rhs) const noexcept { return this->i <=> rhs.i; }
+        };
+
+        /// @brief Construct an empty deque without allocating.
+        ///
+        inline constexpr VecDeque() noexcept = default;
+
+        /// @brief Construct an empty deque with room for at least `n` elements.
+        ///
+        inline static auto with_capacity(usize n) noexcept -> VecDeque {
+            auto d = VecDeque();
+            d.reserve(n);
+            return d;
+        }
+
+        inline VecDeque(std::initializer_list<T> init) noexcept {
+            this->reserve(init.size());
+            for (auto& x : init) this->push_back(x);
+        }
+
+        inline VecDeque(VecDeque const& rhs) noexcept {
+            this->reserve(rhs.count);
+            for (auto i = (usize)0; i < rhs.count; i++) this->push_back(*rhs.slot(i));
+        }
+
+        inline VecDeque(VecDeque&& rhs) noexcept
+            : buf(std::exchange(rhs.buf, nullptr)), cap(std::exchange(rhs.cap, 0)),
+            head(std::exchange(rhs.head, 0)), count(std::exchange(rhs.count, 0)) {}
+
+        inline auto operator=(VecDeque rhs) noexcept -> VecDeque& {
+            std::swap(this->buf, rhs.buf);
+            std::swap(this->cap, rhs.cap);
+            std::swap(this->head, rhs.head);
+            std::swap(this->count, rhs.count);
+            return *this;
+        }
+
+        inline ~VecDeque() noexcept {
+            this->clear();
+            deallocate(this->buf);
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->count;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->count == 0;
+        }
+
+        inline auto capacity() const noexcept -> usize {
+            return this->cap;
+        }
+
+        /// @brief Make room for at least `n` more elements.
+        ///
+        inline auto reserve(usize n) noexcept {
+            this->grow_for(n);
+        }
+
+        inline auto push_back(T value) noexcept {
+            this->grow_for(1);
+            new (this->slot(this->count)) T(mv(value));
+            this->count++;
+        }
+
+        inline auto push_front(T value) noexcept {
+            this->grow_for(1);
+            this->head = this->wrap(this->head - 1);
+            new (this->buf + this->head) T(mv(value));
+            this->count++;
+        }
+
+        inline auto pop_back() noexcept -> Option<T> {
+            if (this->count == 0) return Option<T>();
+            auto p = this->slot(--this->count);
+            auto v = Option<T>(mv(*p));
+            p->~T();
+            return v;
+        }
+
+        inline auto pop_front() noexcept -> Option<T> {
+            if (this->count == 0) return Option<T>();
+            auto p = this->buf + this->head;
+            auto v = Option<T>(mv(*p));
+            p->~T();
+            this->head = this->wrap(this->head + 1);
+            this->count--;
+            return v;
+        }
+
+        /// @brief The first element.
+        ///
+        /// # Panic
+        ///
+        /// Panics if the deque is empty.
+        ///
+        inline auto front() noexcept -> T& {
+            if (this->count == 0) panic("front of empty `VecDeque`");
+            return this->buf[this->head];
+        }
+
+        inline auto front() const noexcept -> T const& {
+            if (this->count == 0) panic("front of empty `VecDeque`");
+            return this->buf[this->head];
+        }
+
+        /// @brief The last element.
+        ///
+        /// # Panic
+        ///
+        /// Panics if the deque is empty.
+        ///
+        inline auto back() noexcept -> T& {
+            if (this->count == 0) panic("back of empty `VecDeque`");
+            return *this->slot(this->count - 1);
+        }
+
+        inline auto back() const noexcept -> T const& {
+            if (this->count == 0) panic("back of empty `VecDeque`");
+            return *this->slot(this->count - 1);
+        }
+
+        /// @brief Index the deque from the front.
+        ///
+        /// # Panic
+        ///
+        /// Panics if `i` is out of bounds.
+        ///
+        inline auto operator[](usize i) noexcept -> T& {
+            if (i >= this->count) panic("index out of bounds of `VecDeque`");
+            return *this->slot(i);
+        }
+
+        inline auto operator[](usize i) const noexcept -> T const& {
+            if (i >= this->count) panic("index out of bounds of `VecDeque`");
+            return *this->slot(i);
+        }
+
+        /// @brief Pointer to the `i`th element, or `nullptr` if out of bounds.
+        ///
+        inline auto get(usize i) noexcept -> T* {
+            return i < this->count ? this->slot(i) : nullptr;
+        }
+
+        inline auto get(usize i) const noexcept -> T const* {
+            return i < this->count ? this->slot(i) : nullptr;
+        }
+
+        /// @brief The elements as two contiguous runs, the front one first. The second run is empty unless the buffer wraps.
+        ///
+        inline auto as_slices() noexcept -> std::pair<std::span<T>, std::span<T>> {
+            auto first = std::min(this->count, this->cap - this->head);
+            return { std::span<T>(this->buf + this->head, first), std::span<T>(this->buf, this->count - first) };
+        }
+
+        inline auto as_slices() const noexcept -> std::pair<std::span<T const>, std::span<T const>> {
+            auto first = std::min(this->count, this->cap - this->head);
+            return { std::span<T const>(this->buf + this->head, first), std::span<T const>(this->buf, this->count - first) };
+        }
+
+        /// @brief Rearrange the elements into one contiguous run, in place when they are trivially copyable.
+        /// @return the elements
+        ///
+        inline auto make_contiguous() noexcept -> std::span<T> {
+            auto [a, b] = this->as_slices();
+            if (b.empty()) return a;
+            if constexpr (TRIVIAL) {
+                auto free = this->cap - this->count;
+                if (free >= a.size()) {
+                    std::memmove((void*)(this->buf + a.size()), b.data(), b.size() * sizeof(T));
+                    std::memcpy((void*)this->buf, a.data(), a.size() * sizeof(T));
+                    this->head = 0;
+                }
+                else if (free >= b.size()) {
+                    auto to = this->head - b.size();
+                    std::memmove((void*)(this->buf + to), a.data(), a.size() * sizeof(T));
+                    std::memcpy((void*)(this->buf + to + a.size()), b.data(), b.size() * sizeof(T));
+                    this->head = to;
+                }
+                else {
+                    std::rotate(this->buf, this->buf + this->head, this->buf + this->cap);
+                    this->head = 0;
+                }
+            }
+            else this->relocate(this->cap);
+            return std::span<T>(this->buf + this->head, this->count);
+        }
+
+        /// @brief Append copies of every element of `items`, with at most two `memcpy` for trivially copyable `T`.
+        ///
+        inline auto extend(std::span<T const> items) noexcept {
+            this->grow_for(items.size());
+            auto at = this->wrap(this->head + this->count);
+            auto first = std::min(items.size(), this->cap - at);
+            if constexpr (TRIVIAL) {
+                if (first) std::memcpy((void*)(this->buf + at), items.data(), first * sizeof(T));
+                if (items.size() > first) std::memcpy((void*)this->buf, items.data() + first, (items.size() - first) * sizeof(T));
+            }
+            else {
+                for (auto i = (usize)0; i < items.size(); i++) new (this->slot(this->count + i)) T(items[i]);
+            }
+            this->count += items.size();
+        }
+
+        /// @brief Append every element of a range.
+        ///
+        template<std::ranges::input_range R>
+            requires (!std::is_convertible_v<R&&, std::span<T const>>)
+        inline auto extend(R&& items) noexcept {
+            if constexpr (std::ranges::sized_range<R>) this->grow_for((usize)std::ranges::size(items));
+            for (auto&& x : items) this->push_back(std::forward<decltype(x)>(x));
+        }
+
+        /// @brief Move up to `out.size()` elements from the front into `out`.
+        /// @return the number of elements moved
+        ///
+        inline auto drain_into(std::span<T> out) noexcept -> usize {
+            auto n = std::min(out.size(), this->count);
+            auto first = std::min(n, this->cap - this->head);
+            if constexpr (TRIVIAL) {
+                if (first) std::memcpy((void*)out.data(), this->buf + this->head, first * sizeof(T));
+                if (n > first) std::memcpy((void*)(out.data() + first), this->buf, (n - first) * sizeof(T));
+            }
+            else {
+                for (auto i = (usize)0; i < n; i++) {
+                    auto p = this->slot(i);
+                    out[i] = mv(*p);
+                    p->~T();
+                }
+            }
+            this->head = n == this->count ? 0 : this->wrap(this->head + n);
+            this->count -= n;
+            return n;
+        }
+
+        /// @brief Remove the first `n` elements, or all of them.
+        ///
+        inline auto drop_front(usize n) noexcept {
+            n = std::min(n, this->count);
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (auto i = (usize)0; i < n; i++) this->slot(i)->~T();
+            }
+            this->head = n == this->count ? 0 : this->wrap(this->head + n);
+            this->count -= n;
+        }
+
+        /// @brief Keep the first `n` elements and drop the rest.
+        ///
+        inline auto truncate(usize n) noexcept {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (auto i = n; i < this->count; i++) this->slot(i)->~T();
+            }
+            this->count = std::min(n, this->count);
+        }
+
+        inline auto clear() noexcept {
+            this->truncate(0);
+            this->head = 0;
+        }
+
+        inline auto begin() noexcept -> Iterator<false> { return Iterator<false>(this, 0); }
+        inline auto end() noexcept -> Iterator<false> { return Iterator<false>(this, this->count); }
+        inline auto begin() const noexcept -> Iterator<true> { return Iterator<true>(this, 0); }
+        inline auto end() const noexcept -> Iterator<true> { return Iterator<true>(this, this->count); }
+    };
+}
@@ -0,0 +1,469 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "btree.cc"
+#include "hashmap.cc"
+#include "ops.cc"
+#include "option.cc"
+
+#include <algorithm>
+#include <compare>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace coding::collections {
+
+    namespace flat {
+
+        /// @brief Arithmetic keys up to this many are searched by a vectorized linear count.
+        ///
+        inline constexpr usize SCAN = 32;
+
+        /// @brief Number of keys `< key` among the sorted `keys`.
+        ///
+        /// Past `SCAN` keys a branchless binary search: the loop runs `log2(n)` times whatever the key, and each step
+        /// adds the comparison times the half length instead of branching on it, so a lookup never mispredicts.
+        ///
+        template<typename K>
+        inline auto lower(K const* keys, usize n, K const& key) noexcept -> usize {
+            if (std::is_arithmetic_v<K> && n <= SCAN) return btree::lower(keys, n, key);
+            if (n == 0) return 0;
+            auto base = keys;
+            while (n > 1) {
+                auto half = n / 2;
+                base += (usize)(base[half - 1] < key) * half;
+                n -= half;
+            }
+            return (usize)(base - keys) + (*base < key);
+        }
+
+        /// @brief Number of keys `<= key` among the sorted `keys`.
+        ///
+        template<typename K>
+        inline auto upper(K const* keys, usize n, K const& key) noexcept -> usize {
+            if (std::is_arithmetic_v<K> && n <= SCAN) return btree::upper(keys, n, key);
+            if (n == 0) return 0;
+            auto base = keys;
+            while (n > 1) {
+                auto half = n / 2;
+                base += (usize)!(key < base[half - 1]) * half;
+                n -= half;
+            }
+            return (usize)(base - keys) + !(key < *base);
+        }
+
+        /// @brief Sort `entries` by key and drop all but the last of equal keys.
+        ///
+        template<typename E, typename Key>
+        inline auto sort_unique(std::vector<E>& entries, Key&& key) noexcept -> void {
+            std::stable_sort(entries.begin(), entries.end(), [&](E const& a, E const& b) { return key(a) < key(b); });
+            auto out = entries.begin();
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                if (out != entries.begin() && !(key(*(out - 1)) < key(*it))) *(out - 1) = mv(*it);
+                else {
+                    if (out != it) *out = mv(*it);
+                    ++out;
+                }
+            }
+            entries.erase(out, entries.end());
+        }
+
+        /// @brief A range whose elements the builders may move from: an rvalue owning its elements, like a temporary
+        /// vector. Lvalues, spans, `std::views::all` and other views of someone else's elements are copied from.
+        ///
+        template<typename R>
+        concept Owning = !std::ranges::borrowed_range<R> && !std::ranges::view<std::remove_cvref_t<R>>;
+    }
+
+    /// @brief An ordered map on two sorted arrays, one of keys and one of values, for tables built once and read often.
+    ///
+    /// Lookups search the key array alone, which is denser than any node-based tree and stays in cache for a
+    /// few thousand keys. Iteration and range queries walk contiguous memory.
+    /// Inserts and removals shift the arrays and cost O(n): build with `from_sorted` or `from_unsorted` instead.
+    /// Inserts and removals invalidate iterators.
+    ///
+    /// @tparam K the key type
+    /// @tparam V the value type
+    ///
+    template<typename K, typename V>
+        requires (ops::Eq<K> and ops::Ord<K>)
+    class FlatMap final {
+
+    private:
+
+        /// @brief The keys, strictly increasing.
+        ///
+        std::vector<K> sorted;
+
+        /// @brief The value of each key, at the same index.
+        ///
+        std::vector<V> mapped;
+
+        inline auto find(K const& key) const noexcept -> usize {
+            auto i = flat::lower(this->sorted.data(), this->sorted.size(), key);
+            return i < this->sorted.size() && this->sorted[i] == key ? i : this->sorted.size();
+        }
+
+    public:
+
+        using key_type = K;
+
+        using mapped_type = V;
+
+        /// @brief Random-access iterator over the entries in key order.
+        ///
+        template<bool Const>
+        class Iterator final {
+
+        private:
+
+            friend class FlatMap;
+
+            K const* key;
+
+            std::conditional_t<Const, V const*, V*> value;
+
+            inline Iterator(K const* key, std::conditional_t<Const, V const*, V*> value) noexcept : key(key), value(value) {}
+
+        public:
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = KeyValue<K const&, std::conditional_t<Const, V const&, V&>>;
+            using difference_type = isize;
+            using reference = value_type;
+
+            inline Iterator() noexcept : key(nullptr), value(nullptr) {}
+
+            inline auto operator*() const noexcept -> value_type { return { *this->key, *this->value }; }
+            inline auto operator[](isize n) const noexcept -> value_type { return { this->key[n], this->value[n] }; }
+            inline auto operator++() noexcept -> Iterator& { ++this->key; ++this->value; return *this; }
+            inline auto operator++(int) noexcept -> Iterator { auto t = *this; ++*this; return t; }
+            inline auto operator--() noexcept -> Iterator& { --this->key; --this->value; return *this; }
+            inline auto operator--(int) noexcept -> Iterator { auto t = *this; --*this; return t; }
+            inline auto operator+=(isize n) noexcept -> Iterator& { this->key += n; this->value += n; return *this; }
+            inline auto operator-=(isize n) noexcept -> Iterator& { this->key -= n; this->value -= n; return *this; }
+            inline auto operator+(isize n) const noexcept -> Iterator { auto t = *this; return t += n; }
+            inline auto operator-(isize n) const noexcept -> Iterator { auto t = *this; return t -= n; }
+            inline friend auto operator+(isize n, Iterator it) noexcept -> Iterator { return it += n; }
+            inline auto operator-(Iterator const& rhs) const noexcept -> isize { return this->key - rhs.key; }
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool { return this->key == rhs.key; }
+            inline auto operator<=>(Iterator const& rhs) const noexcept -> std::strong_ordering { return this->key <=> rhs.key; }
+        };
+
+        /// @brief The entries between two iterators, for `for` loops.
+        ///
+        template<bool Const>
+        class Range final {
+
+        private:
+
+            Iterator<Const> first;
+
+            Iterator<Const> last;
+
+        public:
+
+            inline Range(Iterator<Const> first, Iterator<Const> last) noexcept : first(first), last(last) {}
+
+            inline auto begin() const noexcept -> Iterator<Const> { return this->first; }
+            inline auto end() const noexcept -> Iterator<Const> { return this->last; }
+        };
+
+        inline FlatMap() noexcept = default;
+
+        /// @brief Build a map from entries sorted by strictly increasing key in O(n).
+        /// @param entries a range of `KeyValue`s or pairs
+        ///
+        /// # Panic
+        ///
+        /// Panics if the keys are not strictly increasing.
+        ///
+        template<std::ranges::input_range R>
+        inline static auto from_sorted(R&& entries) noexcept -> FlatMap {
+            auto map = FlatMap();
+            if constexpr (std::ranges::sized_range<R>) map.reserve(std::ranges::size(entries));
+            for (auto&& e : entries) {
+                auto&& [key, value] = e;
+                if (!map.sorted.empty() && !(map.sorted.back() < key)) panic("`FlatMap::from_sorted` on keys not strictly increasing");
+                if constexpr (flat::Owning<R>) {
+                    map.sorted.emplace_back(mv(key));
+                    map.mapped.emplace_back(mv(value));
+                }
+                else {
+                    map.sorted.emplace_back(key);
+                    map.mapped.emplace_back(value);
+                }
+            }
+            return map;
+        }
+
+        /// @brief Build a map from entries in any order in O(n log n). Of equal keys the last entry wins, as if inserted in turn.
+        /// @param entries a range of `KeyValue`s or pairs
+        ///
+        template<std::ranges::input_range R>
+        inline static auto from_unsorted(R&& entries) noexcept -> FlatMap {
+            auto all = std::vector<std::pair<K, V>>();
+            if constexpr (std::ranges::sized_range<R>) all.reserve(std::ranges::size(entries));
+            for (auto&& e : entries) {
+                auto&& [key, value] = e;
+                if constexpr (flat::Owning<R>) all.emplace_back(mv(key), mv(value));
+                else all.emplace_back(key, value);
+            }
+            flat::sort_unique(all, [](auto const& e) -> K const& { return e.first; });
+            return from_sorted(mv(all));
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->sorted.size();
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->sorted.empty();
+        }
+
+        inline auto reserve(usize n) noexcept -> void {
+            this->sorted.reserve(this->sorted.size() + n);
+            this->mapped.reserve(this->mapped.size() + n);
+        }
+
+        inline auto clear() noexcept -> void {
+            this->sorted.clear();
+            this->mapped.clear();
+        }
+
+        /// @brief Release the spare capacity left by building or removals.
+        ///
+        inline auto shrink_to_fit() noexcept -> void {
+            this->sorted.shrink_to_fit();
+            this->mapped.shrink_to_fit();
+        }
+
+        /// @brief The keys in increasing order.
+        ///
+        inline auto keys() const noexcept -> std::span<K const> {
+            return this->sorted;
+        }
+
+        /// @brief The values in the order of their keys.
+        ///
+        inline auto values() noexcept -> std::span<V> {
+            return this->mapped;
+        }
+
+        inline auto values() const noexcept -> std::span<V const> {
+            return this->mapped;
+        }
+
+        /// @brief Insert or replace the value of `key` in O(n).
+        /// @return the replaced value, if any
+        ///
+        inline auto insert(K key, V value) noexcept -> Option<V> {
+            auto i = flat::lower(this->sorted.data(), this->sorted.size(), key);
+            if (i < this->sorted.size() && this->sorted[i] == key) {
+                auto old = Option<V>(mv(this->mapped[i]));
+                this->mapped[i] = mv(value);
+                return old;
+            }
+            this->sorted.insert(this->sorted.begin() + (isize)i, mv(key));
+            this->mapped.insert(this->mapped.begin() + (isize)i, mv(value));
+            return Option<V>();
+        }
+
+        /// @brief Remove `key` in O(n).
+        /// @return its value, if present
+        ///
+        inline auto remove(K const& key) noexcept -> Option<V> {
+            auto i = this->find(key);
+            if (i == this->sorted.size()) return Option<V>();
+            auto old = Option<V>(mv(this->mapped[i]));
+            this->sorted.erase(this->sorted.begin() + (isize)i);
+            this->mapped.erase(this->mapped.begin() + (isize)i);
+            return old;
+        }
+
+        inline auto get(K const& key) noexcept -> V* {
+            auto i = this->find(key);
+            return i == this->sorted.size() ? nullptr : &this->mapped[i];
+        }
+
+        inline auto get(K const& key) const noexcept -> V const* {
+            auto i = this->find(key);
+            return i == this->sorted.size() ? nullptr : &this->mapped[i];
+        }
+
+        inline auto contains(K const& key) const noexcept -> bool {
+            return this->find(key) != this->sorted.size();
+        }
+
+        /// @brief The value of `key`, inserting a default one if absent.
+        ///
+        inline auto operator[](K const& key) noexcept -> V& {
+            auto i = flat::lower(this->sorted.data(), this->sorted.size(), key);
+            if (i == this->sorted.size() || !(this->sorted[i] == key)) {
+                this->sorted.insert(this->sorted.begin() + (isize)i, key);
+                this->mapped.insert(this->mapped.begin() + (isize)i, V());
+            }
+            return this->mapped[i];
+        }
+
+        /// @brief The first entry with a key not less than `key`.
+        ///
+        inline auto lower_bound(K const& key) const noexcept -> Iterator<true> {
+            return this->begin() + (isize)flat::lower(this->sorted.data(), this->sorted.size(), key);
+        }
+
+        /// @brief The first entry with a key greater than `key`.
+        ///
+        inline auto upper_bound(K const& key) const noexcept -> Iterator<true> {
+            return this->begin() + (isize)flat::upper(this->sorted.data(), this->sorted.size(), key);
+        }
+
+        inline auto lower_bound(K const& key) noexcept -> Iterator<false> {
+            return this->begin() + (isize)flat::lower(this->sorted.data(), this->sorted.size(), key);
+        }
+
+        inline auto upper_bound(K const& key) noexcept -> Iterator<false> {
+            return this->begin() + (isize)flat::upper(this->sorted.data(), this->sorted.size(), key);
+        }
+
+        /// @brief The entries with keys in `[from, to)`, none if `to` is not greater than `from`.
+        ///
+        inline auto range(K const& from, K const& to) const noexcept -> Range<true> {
+            auto first = this->lower_bound(from);
+            return Range<true>(first, std::max(first, this->lower_bound(to)));
+        }
+
+        inline auto range(K const& from, K const& to) noexcept -> Range<false> {
+            auto first = this->lower_bound(from);
+            return Range<false>(first, std::max(first, this->lower_bound(to)));
+        }
+
+        inline auto begin() noexcept -> Iterator<false> { return Iterator<false>(this->sorted.data(), this->mapped.data()); }
+        inline auto end() noexcept -> Iterator<false> { return this->begin() + (isize)this->sorted.size(); }
+        inline auto begin() const noexcept -> Iterator<true> { return Iterator<true>(this->sorted.data(), this->mapped.data()); }
+        inline auto end() const noexcept -> Iterator<true> { return this->begin() + (isize)this->sorted.size(); }
+    };
+
+    /// @brief An ordered set on one sorted array, searched like `FlatMap`. For sets built once and read often.
+    /// @tparam T the element type
+    ///
+    template<typename T>
+        requires (ops::Eq<T> and ops::Ord<T>)
+    class FlatSet final {
+
+    private:
+
+        std::vector<T> elements;
+
+    public:
+
+        using Iterator = T const*;
+
+        inline FlatSet() noexcept = default;
+
+        /// @brief Build a set from strictly increasing elements in O(n).
+        ///
+        /// # Panic
+        ///
+        /// Panics if the elements are not strictly increasing.
+        ///
+        template<std::ranges::input_range R>
+        inline static auto from_sorted(R&& elements) noexcept -> FlatSet {
+            auto set = FlatSet();
+            if constexpr (std::ranges::sized_range<R>) set.elements.reserve(std::ranges::size(elements));
+            for (auto&& x : elements) {
+                if (!set.elements.empty() && !(set.elements.back() < x)) panic("`FlatSet::from_sorted` on elements not strictly increasing");
+                if constexpr (flat::Owning<R>) set.elements.emplace_back(mv(x));
+                else set.elements.emplace_back(x);
+            }
+            return set;
+        }
+
+        /// @brief Build a set from elements in any order in O(n log n), dropping duplicates.
+        ///
+        template<std::ranges::input_range R>
+        inline static auto from_unsorted(R&& elements) noexcept -> FlatSet {
+            auto set = FlatSet();
+            for (auto&& x : elements) {
+                if constexpr (flat::Owning<R>) set.elements.emplace_back(mv(x));
+                else set.elements.emplace_back(x);
+            }
+            flat::sort_unique(set.elements, [](T const& x) -> T const& { return x; });
+            return set;
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->elements.size();
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->elements.empty();
+        }
+
+        inline auto reserve(usize n) noexcept -> void {
+            this->elements.reserve(this->elements.size() + n);
+        }
+
+        inline auto clear() noexcept -> void {
+            this->elements.clear();
+        }
+
+        inline auto shrink_to_fit() noexcept -> void {
+            this->elements.shrink_to_fit();
+        }
+
+        /// @brief The elements in increasing order.
+        ///
+        inline auto as_slice() const noexcept -> std::span<T const> {
+            return this->elements;
+        }
+
+        /// @brief Insert `value` in O(n) unless present.
+        /// @return whether it was inserted
+        ///
+        inline auto insert(T value) noexcept -> bool {
+            auto i = flat::lower(this->elements.data(), this->elements.size(), value);
+            if (i < this->elements.size() && this->elements[i] == value) return false;
+            this->elements.insert(this->elements.begin() + (isize)i, mv(value));
+            return true;
+        }
+
+        /// @brief Remove `value` in O(n).
+        /// @return whether it was present
+        ///
+        inline auto remove(T const& value) noexcept -> bool {
+            auto i = flat::lower(this->elements.data(), this->elements.size(), value);
+            if (i == this->elements.size() || !(this->elements[i] == value)) return false;
+            this->elements.erase(this->elements.begin() + (isize)i);
+            return true;
+        }
+
+        inline auto contains(T const& value) const noexcept -> bool {
+            auto i = flat::lower(this->elements.data(), this->elements.size(), value);
+            return i < this->elements.size() && this->elements[i] == value;
+        }
+
+        inline auto lower_bound(T const& value) const noexcept -> Iterator {
+            return this->begin() + flat::lower(this->elements.data(), this->elements.size(), value);
+        }
+
+        inline auto upper_bound(T const& value) const noexcept -> Iterator {
+            return this->begin() + flat::upper(this->elements.data(), this->elements.size(), value);
+        }
+
+        /// @brief The elements in `[from, to)`, none if `to` is not greater than `from`.
+        ///
+        inline auto range(T const& from, T const& to) const noexcept -> std::span<T const> {
+            auto first = this->lower_bound(from);
+            return std::span<T const>(first, std::max(first, this->lower_bound(to)));
+        }
+
+        inline auto begin() const noexcept -> Iterator { return this->elements.data(); }
+        inline auto end() const noexcept -> Iterator { return this->elements.data() + this->elements.size(); }
+    };
+}
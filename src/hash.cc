@@ -1,19 +1,347 @@
 #pragma once
 
 #include "root.cc"
+#include "core.cc"
+#include "str.cc"
 
+#include <bit>
 #include <bitset>
+#include <chrono>
+#include <concepts>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <ranges>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 /// @brief Namespace for hashing.
 /// 
 namespace coding::hash {
 
-    /// @brief Require a type to implement hashing.
+    /// @brief String types that hash and compare by their bytes, so that any of them can look up any other.
+    /// @tparam Self the type itself
+    ///
+    template<typename Self>
+    concept Text = std::same_as<Self, str> || std::same_as<Self, String>
+        || std::convertible_to<Self const&, std::string_view>;
+
+    template<Text T>
+    inline constexpr auto text(T const& s) noexcept -> std::string_view {
+        if constexpr (std::same_as<T, str>) return std::string_view(s.head, s.len);
+        else if constexpr (std::same_as<T, String>) return text(static_cast<str>(s));
+        else return std::string_view(s);
+    }
+
+    /// @brief Multiply into 128 bits and fold the halves, so every input bit reaches every output bit.
+    ///
+    inline constexpr auto fold_mul(u64 a, u64 b) noexcept -> u64 {
+        auto p = (unsigned __int128)a * b;
+        return (u64)p ^ (u64)(p >> 64);
+    }
+
+    /// @brief Require a type to be a streaming hasher. Acts like Rust's `Hasher`.
+    ///
+    /// Values are fed in with `write` for bytes and `write_u64` for words, and `finish` returns the hash
+    /// without consuming the state.
+    ///
+    /// @tparam Self the type itself
+    ///
+    template<typename Self>
+    concept Hasher = requires(Self h, Self const& c, void const* p, usize n, u64 x) {
+        h.write(p, n);
+        h.write_u64(x);
+        { c.finish() } -> std::same_as<u64>;
+    };
+
+    /// @brief Require a type to make fresh `Hasher`s, all hashing alike. Acts like Rust's `BuildHasher`.
+    /// Hash tables hold one and keep it when copied.
+    /// @tparam Self the type itself
+    ///
+    template<typename Self>
+    concept BuildHasher = std::copyable<Self> && requires(Self const& b) {
+        { b.build_hasher() } -> Hasher;
+    };
+
+    namespace wy {
+
+        inline constexpr u64 SECRET[4] = { 0x2d358dccaa6c78a5, 0x8bb84b93962eacc9, 0x4b33a62ed433d4a3, 0x4d5a2da51de1aa47 };
+
+        inline auto r8(u8 const* p) noexcept -> u64 {
+            u64 v;
+            std::memcpy(&v, p, 8);
+            return v;
+        }
+
+        inline auto r4(u8 const* p) noexcept -> u64 {
+            u32 v;
+            std::memcpy(&v, p, 4);
+            return v;
+        }
+
+        inline auto r3(u8 const* p, usize k) noexcept -> u64 {
+            return ((u64)p[0] << 16) | ((u64)p[k >> 1] << 8) | p[k - 1];
+        }
+
+        /// @brief wyhash (final version 4) of `len` bytes at `p`.
+        ///
+        inline auto bytes(void const* data, usize len, u64 seed) noexcept -> u64 {
+            auto p = static_cast<u8 const*>(data);
+            seed ^= fold_mul(seed ^ SECRET[0], SECRET[1]);
+            u64 a, b;
+            if (len <= 16) [[likely]] {
+                if (len >= 4) {
+                    a = (r4(p) << 32) | r4(p + ((len >> 3) << 2));
+                    b = (r4(p + len - 4) << 32) | r4(p + len - 4 - ((len >> 3) << 2));
+                }
+                else if (len > 0) {
+                    a = r3(p, len);
+                    b = 0;
+                }
+                else a = b = 0;
+            }
+            else {
+                auto i = len;
+                if (i > 48) {
+                    auto see1 = seed, see2 = seed;
+                    do {
+                        seed = fold_mul(r8(p) ^ SECRET[1], r8(p + 8) ^ seed);
+                        see1 = fold_mul(r8(p + 16) ^ SECRET[2], r8(p + 24) ^ see1);
+                        see2 = fold_mul(r8(p + 32) ^ SECRET[3], r8(p + 40) ^ see2);
+                        p += 48;
+                        i -= 48;
+                    } while (i > 48);
+                    seed ^= see1 ^ see2;
+                }
+                while (i > 16) {
+                    seed = fold_mul(r8(p) ^ SECRET[1], r8(p + 8) ^ seed);
+                    i -= 16;
+                    p += 16;
+                }
+                a = r8(p + i - 16);
+                b = r8(p + i - 8);
+            }
+            a ^= SECRET[1];
+            b ^= seed;
+            auto m = (unsigned __int128)a * b;
+            return fold_mul((u64)m ^ SECRET[0] ^ len, (u64)(m >> 64) ^ SECRET[1]);
+        }
+    }
+
+    /// @brief A fast keyed hasher after wyhash: one 128-bit multiply per word, and wyhash for byte strings.
+    /// Quality is good enough for any table, and a random seed makes collisions hard to provoke.
+    ///
+    class WyHasher final {
+
+    private:
+
+        u64 state;
+
+    public:
+
+        inline constexpr explicit WyHasher(u64 seed = 0) noexcept : state(seed) {}
+
+        inline auto write(void const* p, usize n) noexcept -> void {
+            this->state = wy::bytes(p, n, this->state);
+        }
+
+        inline auto write_u64(u64 x) noexcept -> void {
+            this->state = fold_mul(this->state ^ wy::SECRET[0], x ^ wy::SECRET[1]);
+        }
+
+        /// @brief One more multiply, a single round leaves low input bits poorly mixed.
+        ///
+        inline auto finish() const noexcept -> u64 {
+            return fold_mul(this->state, wy::SECRET[2]);
+        }
+    };
+
+    /// @brief The hasher of rustc: an add and a multiply per word. Fastest for small integer keys,
+    /// but unkeyed and weak on patterned input, so only for trusted keys.
+    ///
+    class FxHasher final {
+
+    private:
+
+        u64 state = 0;
+
+        inline constexpr static u64 K = 0xf1357aea2e62a9c5;
+
+    public:
+
+        inline auto write(void const* data, usize n) noexcept -> void {
+            auto p = static_cast<u8 const*>(data);
+            for (; n >= 8; p += 8, n -= 8) this->write_u64(wy::r8(p));
+            if (n >= 4) {
+                this->write_u64(wy::r4(p));
+                p += 4;
+                n -= 4;
+            }
+            for (; n > 0; p++, n--) this->write_u64(*p);
+        }
+
+        inline auto write_u64(u64 x) noexcept -> void {
+            this->state = (this->state + x) * K;
+        }
+
+        /// @brief The multiply leaves the best bits on top, rotate them to where tables index.
+        ///
+        inline auto finish() const noexcept -> u64 {
+            return std::rotl(this->state, 26);
+        }
+    };
+
+    /// @brief Builds `WyHasher`s with a fixed seed, for reproducible hashes.
+    ///
+    struct FixedState final {
+
+        u64 seed = 0;
+
+        inline auto build_hasher() const noexcept -> WyHasher {
+            return WyHasher(this->seed);
+        }
+    };
+
+    /// @brief Builds `FxHasher`s.
+    ///
+    struct FxState final {
+
+        inline auto build_hasher() const noexcept -> FxHasher {
+            return FxHasher();
+        }
+    };
+
+    /// @brief A seed drawn from the OS once per thread.
+    ///
+    inline auto thread_seed() noexcept -> u64& {
+        thread_local auto seed = [] {
+            auto device = std::random_device();
+            return ((u64)device() << 32 | device()) ^ (u64)std::chrono::steady_clock::now().time_since_epoch().count();
+        }();
+        return seed;
+    }
+
+    /// @brief Builds `WyHasher`s with a random seed, different for every instance. The default of hash tables.
+    ///
+    /// Seeds differ across processes, so hash flooding cannot be prepared offline, and across tables,
+    /// so copying the contents of one table into another never meets the worst case of its probing.
+    ///
+    struct RandomState final {
+
+        u64 seed;
+
+        inline RandomState() noexcept : seed(thread_seed() += 0x9e3779b97f4a7c15) {}
+
+        inline auto build_hasher() const noexcept -> WyHasher {
+            return WyHasher(this->seed);
+        }
+    };
+
+    /// @brief Types with a `hash` member, which streams their parts into any hasher.
+    ///
+    /// ```
+    /// struct Point {
+    ///     i32 x, y;
+    ///     template<hash::Hasher H> auto hash(H& h) const { hash::write(h, this->x); hash::write(h, this->y); }
+    /// };
+    /// ```
+    ///
+    template<typename T>
+    concept HashMember = requires(T const& v, WyHasher& h) { v.hash(h); };
+
+    template<typename T>
+    concept TupleLike = requires { std::tuple_size<T>::value; };
+
+    template<typename T>
+    inline constexpr auto hashable() noexcept -> bool;
+
+    template<typename T, usize... I>
+    inline constexpr auto hashable_tuple(std::index_sequence<I...>) noexcept -> bool {
+        return (hashable<std::remove_cvref_t<std::tuple_element_t<I, T>>>() && ...);
+    }
+
+    /// @brief Whether `write` knows how to stream a `T`.
+    ///
+    template<typename T>
+    inline constexpr auto hashable() noexcept -> bool {
+        if constexpr (HashMember<T> || Text<T> || std::is_scalar_v<T>) return true;
+        else if constexpr (TupleLike<T>) return hashable_tuple<T>(std::make_index_sequence<std::tuple_size_v<T>>());
+        else if constexpr (std::ranges::input_range<T const>) return hashable<std::remove_cvref_t<std::ranges::range_reference_t<T const>>>();
+        else return requires(T const& v) { { std::hash<T>{}(v) } -> std::convertible_to<usize>; };
+    }
+
+    /// @brief Require a type to be hashable: it has a `hash` member, is text, a scalar, a tuple or range of hashable
+    /// types, or has a `std::hash`.
     /// @tparam Self the type itself
     /// 
     template<typename Self>
-    concept Hash
-        = requires(Self a) {
-            { std::hash<Self>{}(a) } -> std::convertible_to<std::size_t>;
+    concept Hash = hashable<std::remove_cvref_t<Self>>();
+
+    /// @brief Stream `v` into `h`. Equal values stream alike, `Text` types whatever their type.
+    /// Text and ranges write their length, first or after the elements of ranges not sized, so composite values never run
+    /// into each other.
+    ///
+    template<Hasher H, Hash T>
+    inline auto write(H& h, T const& v) noexcept -> void {
+        if constexpr (HashMember<T>) v.hash(h);
+        else if constexpr (Text<T>) {
+            auto s = text(v);
+            h.write_u64(s.size());
+            h.write(s.data(), s.size());
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            // `0.0 == -0.0`, so they must hash alike.
+            h.write_u64(v == 0 ? 0 : std::bit_cast<u64>((double)v));
+        }
+        else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>) h.write_u64((u64)(uintptr_t)v);
+        else if constexpr (std::is_scalar_v<T>) h.write_u64((u64)v);
+        else if constexpr (TupleLike<T>) std::apply([&](auto const&... x) { (write(h, x), ...); }, v);
+        else if constexpr (std::ranges::input_range<T const>) {
+            using E = std::remove_cvref_t<std::ranges::range_reference_t<T const>>;
+            // Integers and enums, which have no `hash` member, are their bytes: one block for all of them.
+            if constexpr (std::ranges::contiguous_range<T const> && (std::is_integral_v<E> || std::is_enum_v<E>)
+                && !HashMember<E> && std::has_unique_object_representations_v<E>) {
+                h.write_u64((u64)std::ranges::size(v));
+                h.write(std::ranges::data(v), (usize)std::ranges::size(v) * sizeof(E));
+            }
+            else if constexpr (std::ranges::sized_range<T const>) {
+                h.write_u64((u64)std::ranges::size(v));
+                for (auto const& x : v) write(h, x);
+            }
+            else {
+                // The length is only known at the end, where it still keeps nested ranges apart.
+                auto n = (u64)0;
+                for (auto const& x : v) {
+                    write(h, x);
+                    n++;
+                }
+                h.write_u64(n);
+            }
+        }
+        else h.write_u64((u64)std::hash<T>{}(v));
+    }
+
+    /// @brief Hash one value with a fresh hasher of `b`.
+    ///
+    template<BuildHasher B, Hash T>
+    inline auto hash_one(B const& b, T const& v) noexcept -> u64 {
+        auto h = b.build_hasher();
+        write(h, v);
+        return h.finish();
+    }
+
+    /// @brief `==`, transparent like `write`: `Text` types compare by their bytes.
+    ///
+    struct StdEq final {
+
+        using is_transparent = void;
+
+        template<typename A, typename B>
+        inline constexpr auto operator()(A const& a, B const& b) const noexcept -> bool {
+            if constexpr (Text<A> && Text<B>) return text(a) == text(b);
+            else return a == b;
+        }
     };
 }
@@ -0,0 +1,647 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "hash.cc"
+#include "ops.cc"
+#include "option.cc"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace coding::collections {
+
+    /// @brief A key with its value, as stored in a `HashMap`.
+    /// @warning Iteration hands these out by reference, never change the key through it.
+    ///
+    template<typename K, typename V>
+    struct KeyValue final {
+
+        K key;
+
+        V value;
+    };
+
+    /// @brief Control bytes of a Swiss table: one per slot, `EMPTY`, `DELETED` or the 7 low bits of a full slot's hash.
+    ///
+    namespace swiss {
+
+        inline constexpr i8 EMPTY = -128;
+
+        inline constexpr i8 DELETED = -2;
+
+        /// @brief Slots probed at once, and the alignment of every probed run.
+        ///
+        inline constexpr usize GROUP = 16;
+
+        /// @brief 16 control bytes matched in parallel, each `match` returns a bit mask with bit `i` for byte `i`.
+        ///
+        class Group final {
+
+        private:
+
+#if defined(__SSE2__)
+            __m128i ctrl;
+#else
+            i8 ctrl[GROUP];
+#endif
+
+        public:
+
+            inline explicit Group(i8 const* p) noexcept {
+#if defined(__SSE2__)
+                this->ctrl = _mm_load_si128(reinterpret_cast<__m128i const*>(p));
+#else
+                std::memcpy(this->ctrl, p, GROUP);
+#endif
+            }
+
+            inline auto match(i8 h2) const noexcept -> u32 {
+#if defined(__SSE2__)
+                return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), this->ctrl));
+#else
+                auto m = (u32)0;
+                for (auto i = (usize)0; i < GROUP; i++) m |= (u32)(this->ctrl[i] == h2) << i;
+                return m;
+#endif
+            }
+
+            inline auto match_empty() const noexcept -> u32 {
+                return this->match(EMPTY);
+            }
+
+            /// @brief Slots that can take a new element, `EMPTY` or `DELETED`.
+            ///
+            inline auto match_free() const noexcept -> u32 {
+#if defined(__SSE2__)
+                return (u32)_mm_movemask_epi8(this->ctrl);
+#else
+                auto m = (u32)0;
+                for (auto i = (usize)0; i < GROUP; i++) m |= (u32)(this->ctrl[i] < 0) << i;
+                return m;
+#endif
+            }
+
+            inline auto match_full() const noexcept -> u32 {
+                return ~this->match_free() & 0xffff;
+            }
+        };
+    }
+
+    /// @brief The open-addressing table behind `HashMap` and `HashSet`, after the Swiss table design.
+    ///
+    /// Slots live in one flat array next to a control byte each, probed 16 at a time with SSE2.
+    /// A lookup touches the control group and the slots whose 7-bit hash tag matches, and usually nothing else.
+    /// Groups are aligned and probed triangularly, and the table grows at a load of 7/8.
+    ///
+    /// @tparam K the key type
+    /// @tparam S the slot type, `K` itself or a `KeyValue` with a `key`
+    /// @tparam H the `BuildHasher`, keys and lookups by other types stream into its hashers alike
+    /// @tparam E the equality, transparent like `hash::write`
+    ///
+    template<typename K, typename S, typename H, typename E>
+    class RawTable final {
+
+    private:
+
+        inline constexpr static usize NONE = ~(usize)0;
+
+        i8* ctrl = nullptr;
+
+        S* slots = nullptr;
+
+        /// @brief Number of slots, zero or a power of two no less than a `GROUP`.
+        ///
+        usize cap = 0;
+
+        usize count = 0;
+
+        /// @brief Inserts into `EMPTY` slots left before the load limit, tombstones count as used.
+        ///
+        usize growth = 0;
+
+        [[no_unique_address]] H hasher;
+
+        [[no_unique_address]] E eq;
+
+        inline static auto key_of(S const& s) noexcept -> K const& {
+            if constexpr (std::is_same_v<S, K>) return s;
+            else return s.key;
+        }
+
+        inline static auto limit(usize cap) noexcept -> usize {
+            return cap - cap / 8;
+        }
+
+        inline static auto ctrl_bytes(usize cap) noexcept -> usize {
+            return (cap + alignof(S) - 1) / alignof(S) * alignof(S);
+        }
+
+        inline constexpr static auto ALIGN = std::max(alignof(S), swiss::GROUP);
+
+        /// @brief Allocate control bytes and slots together, all control bytes `EMPTY`.
+        ///
+        inline auto allocate(usize cap) noexcept {
+            auto p = static_cast<char*>(::operator new(ctrl_bytes(cap) + cap * sizeof(S), std::align_val_t(ALIGN)));
+            this->ctrl = reinterpret_cast<i8*>(p);
+            this->slots = reinterpret_cast<S*>(p + ctrl_bytes(cap));
+            std::memset(this->ctrl, (u8)swiss::EMPTY, cap);
+            this->cap = cap;
+            this->growth = limit(cap) - this->count;
+        }
+
+        inline auto deallocate() noexcept {
+            if (this->ctrl) ::operator delete(this->ctrl, std::align_val_t(ALIGN));
+        }
+
+        inline auto destroy_all() noexcept {
+            if constexpr (!std::is_trivially_destructible_v<S>) {
+                for (auto i = this->next_full(0); i < this->cap; i = this->next_full(i + 1)) this->slots[i].~S();
+            }
+        }
+
+        inline static auto h1(u64 h) noexcept -> usize {
+            return (usize)(h >> 7);
+        }
+
+        inline static auto h2(u64 h) noexcept -> i8 {
+            return (i8)(h & 0x7f);
+        }
+
+        template<typename Q>
+        inline auto find_index(Q const& q, u64 h) const noexcept -> usize {
+            if (this->cap == 0) return NONE;
+            auto mask = this->cap / swiss::GROUP - 1;
+            auto g = h1(h) & mask;
+            // Triangular probing visits every group within `mask + 1` steps. The bound only matters to
+            // optimistic readers racing a writer, who may never observe an `EMPTY` byte.
+            for (auto step = (usize)1; step <= mask + 1; step++) {
+                auto group = swiss::Group(this->ctrl + g * swiss::GROUP);
+                for (auto m = group.match(h2(h)); m; m &= m - 1) {
+                    auto i = g * swiss::GROUP + (usize)std::countr_zero(m);
+                    if (this->eq(key_of(this->slots[i]), q)) [[likely]] return i;
+                }
+                if (group.match_empty()) [[likely]] return NONE;
+                g = (g + step) & mask;
+            }
+            return NONE;
+        }
+
+        /// @brief The first `EMPTY` or `DELETED` slot on the probe sequence of `h`.
+        ///
+        inline auto find_free(u64 h) const noexcept -> usize {
+            auto mask = this->cap / swiss::GROUP - 1;
+            auto g = h1(h) & mask;
+            for (auto step = (usize)1;; step++) {
+                if (auto m = swiss::Group(this->ctrl + g * swiss::GROUP).match_free()) {
+                    return g * swiss::GROUP + (usize)std::countr_zero(m);
+                }
+                g = (g + step) & mask;
+            }
+        }
+
+        /// @brief Move every element into a table of `cap` slots, dropping tombstones.
+        ///
+        inline auto rehash(usize cap) noexcept {
+            auto old_ctrl = this->ctrl;
+            auto old_slots = this->slots;
+            auto old_cap = this->cap;
+            this->allocate(cap);
+            for (auto i = (usize)0; i < old_cap; i++) {
+                if (old_ctrl[i] < 0) continue;
+                auto& s = old_slots[i];
+                auto h = this->hash(key_of(s));
+                auto j = this->find_free(h);
+                this->ctrl[j] = h2(h);
+                new (this->slots + j) S(mv(s));
+                s.~S();
+            }
+            if (old_ctrl) ::operator delete(old_ctrl, std::align_val_t(ALIGN));
+        }
+
+        /// @brief Make room for one insert, cleaning tombstones in place of growing when they are most of the load.
+        ///
+        inline auto grow() noexcept {
+            if (this->cap == 0) this->rehash(swiss::GROUP);
+            else if (this->count <= limit(this->cap) / 2) this->rehash(this->cap);
+            else this->rehash(this->cap * 2);
+        }
+
+    public:
+
+        inline RawTable() noexcept = default;
+
+        inline explicit RawTable(H hasher) noexcept : hasher(mv(hasher)) {}
+
+        inline RawTable(RawTable const& rhs) noexcept : count(rhs.count), hasher(rhs.hasher), eq(rhs.eq) {
+            if (rhs.cap == 0) return;
+            this->allocate(rhs.cap);
+            this->growth = rhs.growth;
+            std::memcpy(this->ctrl, rhs.ctrl, rhs.cap);
+            for (auto i = rhs.next_full(0); i < rhs.cap; i = rhs.next_full(i + 1)) new (this->slots + i) S(rhs.slots[i]);
+        }
+
+        inline RawTable(RawTable&& rhs) noexcept
+            : ctrl(std::exchange(rhs.ctrl, nullptr)), slots(std::exchange(rhs.slots, nullptr)),
+            cap(std::exchange(rhs.cap, 0)), count(std::exchange(rhs.count, 0)), growth(std::exchange(rhs.growth, 0)),
+            hasher(rhs.hasher), eq(rhs.eq) {}
+
+        inline auto operator=(RawTable rhs) noexcept -> RawTable& {
+            std::swap(this->ctrl, rhs.ctrl);
+            std::swap(this->slots, rhs.slots);
+            std::swap(this->cap, rhs.cap);
+            std::swap(this->count, rhs.count);
+            std::swap(this->growth, rhs.growth);
+            std::swap(this->hasher, rhs.hasher);
+            std::swap(this->eq, rhs.eq);
+            return *this;
+        }
+
+        inline ~RawTable() noexcept {
+            this->destroy_all();
+            this->deallocate();
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->count;
+        }
+
+        /// @brief How many elements fit before the table grows.
+        ///
+        inline auto capacity() const noexcept -> usize {
+            return this->cap ? limit(this->cap) : 0;
+        }
+
+        /// @brief Make room for `n` more elements with at most one rehash.
+        ///
+        inline auto reserve(usize n) noexcept {
+            if (n <= this->growth) return;
+            auto need = this->count + n;
+            auto cap = std::max(std::bit_ceil(need + need / 7 + 1), swiss::GROUP);
+            while (limit(cap) < need) cap *= 2;
+            this->rehash(std::max(cap, this->cap));
+        }
+
+        inline auto clear() noexcept {
+            this->destroy_all();
+            if (this->cap) std::memset(this->ctrl, (u8)swiss::EMPTY, this->cap);
+            this->count = 0;
+            this->growth = this->cap ? limit(this->cap) : 0;
+        }
+
+        /// @brief Inserts left before the next insert into an `EMPTY` slot rehashes.
+        ///
+        inline auto growth_left() const noexcept -> usize {
+            return this->growth;
+        }
+
+        template<typename Q>
+        inline auto hash(Q const& q) const noexcept -> u64 {
+            return hash::hash_one(this->hasher, q);
+        }
+
+        /// @brief The slot holding a key equal to `q`, or `nullptr`.
+        ///
+        template<typename Q>
+        inline auto find(Q const& q) const noexcept -> S* {
+            return this->find(q, this->hash(q));
+        }
+
+        /// @brief Same as `find(q)` with the hash of `q` computed already.
+        ///
+        template<typename Q>
+        inline auto find(Q const& q, u64 h) const noexcept -> S* {
+            auto i = this->find_index(q, h);
+            return i == NONE ? nullptr : this->slots + i;
+        }
+
+        /// @brief Find the slot for `q`, or claim one for it.
+        /// @return the slot, and whether it was claimed, in which case the caller must construct it
+        ///
+        template<typename Q>
+        inline auto find_or_prepare(Q const& q) noexcept -> std::pair<S*, bool> {
+            return this->find_or_prepare(q, this->hash(q));
+        }
+
+        /// @brief Same as `find_or_prepare(q)` with the hash of `q` computed already.
+        ///
+        template<typename Q>
+        inline auto find_or_prepare(Q const& q, u64 h) noexcept -> std::pair<S*, bool> {
+            if (auto i = this->find_index(q, h); i != NONE) return { this->slots + i, false };
+            if (this->growth == 0) [[unlikely]] {
+                if (this->cap == 0 || this->ctrl[this->find_free(h)] == swiss::EMPTY) this->grow();
+            }
+            auto i = this->find_free(h);
+            if (this->ctrl[i] == swiss::EMPTY) this->growth--;
+            this->ctrl[i] = h2(h);
+            this->count++;
+            return { this->slots + i, true };
+        }
+
+        /// @brief Destroy the element in `slot`, which must be full.
+        ///
+        inline auto erase(S* slot) noexcept {
+            auto i = (usize)(slot - this->slots);
+            slot->~S();
+            // A probe only passes a group once it was full, and a group never refills with `EMPTY`,
+            // so if this group still has an `EMPTY` no probe went past it.
+            if (swiss::Group(this->ctrl + i / swiss::GROUP * swiss::GROUP).match_empty()) {
+                this->ctrl[i] = swiss::EMPTY;
+                this->growth++;
+            }
+            else this->ctrl[i] = swiss::DELETED;
+            this->count--;
+        }
+
+        /// @brief Index of the first full slot at or after `i`, or the number of slots.
+        ///
+        inline auto next_full(usize i) const noexcept -> usize {
+            while (i < this->cap) {
+                auto g = i & ~(swiss::GROUP - 1);
+                auto m = swiss::Group(this->ctrl + g).match_full() >> (i - g);
+                if (m) return i + (usize)std::countr_zero(m);
+                i = g + swiss::GROUP;
+            }
+            return this->cap;
+        }
+
+        inline auto slot_count() const noexcept -> usize {
+            return this->cap;
+        }
+
+        inline auto slot(usize i) const noexcept -> S* {
+            return this->slots + i;
+        }
+
+        /// @brief Forward iterator over the full slots, in slot order.
+        ///
+        template<typename R>
+        class Iterator final {
+
+        private:
+
+            RawTable const* table;
+
+            usize i;
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::remove_const_t<R>;
+            using difference_type = isize;
+            using pointer = R*;
+            using reference = R&;
+
+            inline Iterator() noexcept : table(nullptr), i(0) {}
+
+            inline Iterator(RawTable const* table, usize i) noexcept : table(table), i(i) {}
+
+            inline auto operator*() const noexcept -> R& { return *this->table->slot(this->i); }
+            inline auto operator->() const noexcept -> R* { return this->table->slot(this->i); }
+            inline auto operator++() noexcept -> Iterator& { this->i = this->table->next_full(this->i + 1); return *this; }
+            inline auto operator++(int) noexcept -> Iterator { auto t = *this; ++*this; return t; }
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool { return this->i == rhs.i; }
+        };
+    };
+
+    /// @brief Keys that a table hashing with `H` and comparing with `E` can look up by `Q`.
+    ///
+    template<typename Q, typename K, typename H, typename E>
+    concept LookupBy = hash::BuildHasher<H> && hash::Hash<Q> && requires(E const& e, Q const& q, K const& k) {
+        { e(k, q) } -> std::convertible_to<bool>;
+    };
+
+    /// @brief A hash map on a flat Swiss table. Acts like Rust's `HashMap`.
+    ///
+    /// Lookups are transparent: a map keyed by `String` is queried with `str`, `std::string_view` or a literal without building a key.
+    /// Iteration walks the flat slot array in an unspecified order.
+    /// Inserts and removals invalidate iterators and pointers to elements only when the table rehashes, and the element itself.
+    ///
+    /// @tparam K the key type
+    /// @tparam V the value type
+    /// @tparam H the `BuildHasher`, by default randomly seeded per map; `hash::FxState` is faster for trusted integer keys
+    ///
+    template<typename K, typename V, typename H = hash::RandomState>
+        requires (ops::Eq<K> and hash::Hash<K> and hash::BuildHasher<H>)
+    class HashMap final {
+
+    private:
+
+        using E = hash::StdEq;
+
+        using Slot = KeyValue<K, V>;
+
+        RawTable<K, Slot, H, E> table;
+
+    public:
+
+        using key_type = K;
+
+        using mapped_type = V;
+
+        using Iterator = typename RawTable<K, Slot, H, E>::template Iterator<Slot>;
+
+        using ConstIterator = typename RawTable<K, Slot, H, E>::template Iterator<Slot const>;
+
+        inline HashMap() noexcept = default;
+
+        inline explicit HashMap(H hasher) noexcept : table(mv(hasher)) {}
+
+        inline static auto with_capacity(usize n) noexcept -> HashMap {
+            auto map = HashMap();
+            map.reserve(n);
+            return map;
+        }
+
+        inline static auto with_hasher(H hasher) noexcept -> HashMap {
+            return HashMap(mv(hasher));
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->table.len();
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->table.len() == 0;
+        }
+
+        inline auto capacity() const noexcept -> usize {
+            return this->table.capacity();
+        }
+
+        /// @brief Make room for `n` more entries with at most one rehash.
+        ///
+        inline auto reserve(usize n) noexcept {
+            this->table.reserve(n);
+        }
+
+        inline auto clear() noexcept {
+            this->table.clear();
+        }
+
+        /// @brief Insert or replace the value of `key`.
+        /// @return the replaced value, if any
+        ///
+        inline auto insert(K key, V value) noexcept -> Option<V> {
+            auto [slot, fresh] = this->table.find_or_prepare(key);
+            if (fresh) {
+                new (slot) Slot{ mv(key), mv(value) };
+                return Option<V>();
+            }
+            return Option<V>(std::exchange(slot->value, mv(value)));
+        }
+
+        /// @brief The value of `key`, or `nullptr`.
+        ///
+        template<typename Q>
+            requires LookupBy<Q, K, H, E>
+        inline auto get(Q const& key) noexcept -> V* {
+            auto slot = this->table.find(key);
+            return slot ? &slot->value : nullptr;
+        }
+
+        template<typename Q>
+            requires LookupBy<Q, K, H, E>
+        inline auto get(Q const& key) const noexcept -> V const* {
+            auto slot = this->table.find(key);
+            return slot ? &slot->value : nullptr;
+        }
+
+        template<typename Q>
+            requires LookupBy<Q, K, H, E>
+        inline auto contains(Q const& key) const noexcept -> bool {
+            return this->table.find(key) != nullptr;
+        }
+
+        /// @brief The value of `key`, inserting the result of `make()` first if absent.
+        ///
+        template<typename F>
+        inline auto get_or_insert_with(K key, F&& make) noexcept -> V& {
+            auto [slot, fresh] = this->table.find_or_prepare(key);
+            if (fresh) new (slot) Slot{ mv(key), std::forward<F>(make)() };
+            return slot->value;
+        }
+
+        /// @brief The value of `key`, inserting a default-constructed one first if absent.
+        ///
+        inline auto operator[](K key) noexcept -> V& {
+            return this->get_or_insert_with(mv(key), [] { return V(); });
+        }
+
+        /// @brief Remove `key`.
+        /// @return its value, if it was present
+        ///
+        template<typename Q>
+            requires LookupBy<Q, K, H, E>
+        inline auto remove(Q const& key) noexcept -> Option<V> {
+            auto slot = this->table.find(key);
+            if (!slot) return Option<V>();
+            auto value = Option<V>(mv(slot->value));
+            this->table.erase(slot);
+            return value;
+        }
+
+        inline auto begin() noexcept -> Iterator { return Iterator(&this->table, this->table.next_full(0)); }
+        inline auto end() noexcept -> Iterator { return Iterator(&this->table, this->table.slot_count()); }
+        inline auto begin() const noexcept -> ConstIterator { return ConstIterator(&this->table, this->table.next_full(0)); }
+        inline auto end() const noexcept -> ConstIterator { return ConstIterator(&this->table, this->table.slot_count()); }
+    };
+
+    /// @brief A hash set on a flat Swiss table. Acts like Rust's `HashSet`, with transparent lookups like `HashMap`.
+    /// @tparam T the element type
+    /// @tparam H the `BuildHasher`, as for `HashMap`
+    ///
+    template<typename T, typename H = hash::RandomState>
+        requires (ops::Eq<T> and hash::Hash<T> and hash::BuildHasher<H>)
+    class HashSet final {
+
+    private:
+
+        using E = hash::StdEq;
+
+        RawTable<T, T, H, E> table;
+
+    public:
+
+        using Iterator = typename RawTable<T, T, H, E>::template Iterator<T const>;
+
+        inline HashSet() noexcept = default;
+
+        inline explicit HashSet(H hasher) noexcept : table(mv(hasher)) {}
+
+        inline static auto with_capacity(usize n) noexcept -> HashSet {
+            auto set = HashSet();
+            set.reserve(n);
+            return set;
+        }
+
+        inline static auto with_hasher(H hasher) noexcept -> HashSet {
+            return HashSet(mv(hasher));
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->table.len();
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->table.len() == 0;
+        }
+
+        inline auto capacity() const noexcept -> usize {
+            return this->table.capacity();
+        }
+
+        inline auto reserve(usize n) noexcept {
+            this->table.reserve(n);
+        }
+
+        inline auto clear() noexcept {
+            this->table.clear();
+        }
+
+        /// @brief Insert `value` unless an equal one is present.
+        /// @return whether it was inserted
+        ///
+        inline auto insert(T value) noexcept -> bool {
+            auto [slot, fresh] = this->table.find_or_prepare(value);
+            if (fresh) new (slot) T(mv(value));
+            return fresh;
+        }
+
+        template<typename Q>
+            requires LookupBy<Q, T, H, E>
+        inline auto contains(Q const& value) const noexcept -> bool {
+            return this->table.find(value) != nullptr;
+        }
+
+        /// @brief The element equal to `value`, or `nullptr`.
+        ///
+        template<typename Q>
+            requires LookupBy<Q, T, H, E>
+        inline auto get(Q const& value) const noexcept -> T const* {
+            return this->table.find(value);
+        }
+
+        /// @return whether `value` was present
+        ///
+        template<typename Q>
+            requires LookupBy<Q, T, H, E>
+        inline auto remove(Q const& value) noexcept -> bool {
+            auto slot = this->table.find(value);
+            if (slot) this->table.erase(slot);
+            return slot != nullptr;
+        }
+
+        inline auto begin() const noexcept -> Iterator { return Iterator(&this->table, this->table.next_full(0)); }
+        inline auto end() const noexcept -> Iterator { return Iterator(&this->table, this->table.slot_count()); }
+    };
+}
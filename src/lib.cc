@@ -3,16 +3,37 @@
 #include "root.cc"
 #include "core.cc"
 
+#include "async.cc"
+#include "binlog.cc"
+#include "bitvec.cc"
+#include "btree.cc"
 #include "collections.cc"
+#include "concurrent.cc"
+#include "deque.cc"
+#include "flatmap.cc"
 #include "hash.cc"
+#include "hashmap.cc"
+#include "heap.cc"
 #include "lazy.cc"
 #include "log.cc"
+#include "logfile.cc"
 #include "measure.cc"
+#include "mutex.cc"
 #include "ops.cc"
 #include "option.cc"
+#include "par.cc"
+#include "persistent.cc"
+#include "pool.cc"
 #include "ptr.cc"
 #include "result.cc"
+#include "serial.cc"
+#include "sharded.cc"
+#include "sketch.cc"
+#include "slog.cc"
+#include "slotmap.cc"
+#include "smallvec.cc"
 #include "str.cc"
+#include "timer.cc"
 
 #include <iostream>
 #include <vector>
@@ -1,12 +1,51 @@
 #pragma once
 
 #include "root.cc"
+#include "core.cc"
+#include "measure.cc"
+#include "mutex.cc"
+#include "option.cc"
+#include "thread.cc"
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
 #include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
 #include <iostream>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
 
-#define coding_log(msg,level,prefix) {if(coding::log::LOG_LEVEL>=level)std::cerr<<coding::log::log_time()<<prefix<<__FILE__<<":"<<__LINE__<<" :: "<<msg<<std::endl;}
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Define `CODING_LOG_LEVEL` before including the library to compile out every log site above that level,
+// e.g. `-DCODING_LOG_LEVEL=20` keeps `coding_info` and more severe. Everything is compiled in by default.
+// The gate is a plain `if`, folded away at any optimization level when the site's level is a constant,
+// so `coding_log` also takes a level computed at runtime, then checked against both bounds on each call.
+#ifndef CODING_LOG_LEVEL
+#define CODING_LOG_LEVEL 255
+#endif
+
+// Log sites belong to the module named by `CODING_LOG_MODULE` where they are expanded, their file by default.
+// Redefine it in a file to tag its log sites, e.g. `#undef CODING_LOG_MODULE` then `#define CODING_LOG_MODULE "net"`.
+#ifndef CODING_LOG_MODULE
+#define CODING_LOG_MODULE __FILE__
+#endif
+
+#define coding_log(msg,level,prefix) {if((level)<=CODING_LOG_LEVEL){static auto& _coding_module=coding::log::Module::get(CODING_LOG_MODULE);if(_coding_module.enabled(level)){auto& _coding_line=coding::log::Line::get();_coding_line.stream<<coding::log::Timestamp()<<prefix<<__FILE__<<":"<<__LINE__<<" :: "<<msg<<'\n';_coding_line.commit();}}}
 
 #define coding_trace(msg) coding_log(msg,40," \033[35mTRACE\033[0m ")
 
@@ -18,11 +57,36 @@
 
 #define coding_error(msg) coding_log(msg,0," \033[31;1mERROR\033[0m ")
 
-namespace coding::log {
+// Rate-limited sites keep a limiter per call site, created once. When a line gets through,
+// it reports how many were suppressed since the previous one.
+#define coding_log_limited(limiter,msg,level,prefix) {if((level)<=CODING_LOG_LEVEL){static auto& _coding_module=coding::log::Module::get(CODING_LOG_MODULE);if(_coding_module.enabled(level)){static auto _coding_limiter=limiter;if(auto _coding_pass=_coding_limiter.admit();_coding_pass.is_some()){auto& _coding_line=coding::log::Line::get();_coding_line.stream<<coding::log::Timestamp()<<prefix<<__FILE__<<":"<<__LINE__<<" :: "<<msg;if(auto _coding_n=_coding_pass.unwrap())_coding_line.stream<<" ["<<_coding_n<<" suppressed]";_coding_line.stream<<'\n';_coding_line.commit();}}}}
 
-    /// @brief Assign to this variable to control log level.
-    /// 
-    inline volatile int LOG_LEVEL = 255;
+#define coding_trace_every_n(n,msg) coding_log_limited(coding::log::EveryN(n),msg,40," \033[35mTRACE\033[0m ")
+#define coding_trace_every(period,msg) coding_log_limited(coding::log::Every(period),msg,40," \033[35mTRACE\033[0m ")
+#define coding_trace_limit(rate,burst,msg) coding_log_limited(coding::log::TokenBucket(rate,burst),msg,40," \033[35mTRACE\033[0m ")
+#define coding_trace_sample(p,msg) coding_log_limited(coding::log::Sample(p),msg,40," \033[35mTRACE\033[0m ")
+
+#define coding_debug_every_n(n,msg) coding_log_limited(coding::log::EveryN(n),msg,30," \033[34mDEBUG\033[0m ")
+#define coding_debug_every(period,msg) coding_log_limited(coding::log::Every(period),msg,30," \033[34mDEBUG\033[0m ")
+#define coding_debug_limit(rate,burst,msg) coding_log_limited(coding::log::TokenBucket(rate,burst),msg,30," \033[34mDEBUG\033[0m ")
+#define coding_debug_sample(p,msg) coding_log_limited(coding::log::Sample(p),msg,30," \033[34mDEBUG\033[0m ")
+
+#define coding_info_every_n(n,msg) coding_log_limited(coding::log::EveryN(n),msg,20," \033[32mINFO\033[0m  ")
+#define coding_info_every(period,msg) coding_log_limited(coding::log::Every(period),msg,20," \033[32mINFO\033[0m  ")
+#define coding_info_limit(rate,burst,msg) coding_log_limited(coding::log::TokenBucket(rate,burst),msg,20," \033[32mINFO\033[0m  ")
+#define coding_info_sample(p,msg) coding_log_limited(coding::log::Sample(p),msg,20," \033[32mINFO\033[0m  ")
+
+#define coding_warn_every_n(n,msg) coding_log_limited(coding::log::EveryN(n),msg,10," \033[33;1mWARN\033[0m  ")
+#define coding_warn_every(period,msg) coding_log_limited(coding::log::Every(period),msg,10," \033[33;1mWARN\033[0m  ")
+#define coding_warn_limit(rate,burst,msg) coding_log_limited(coding::log::TokenBucket(rate,burst),msg,10," \033[33;1mWARN\033[0m  ")
+#define coding_warn_sample(p,msg) coding_log_limited(coding::log::Sample(p),msg,10," \033[33;1mWARN\033[0m  ")
+
+#define coding_error_every_n(n,msg) coding_log_limited(coding::log::EveryN(n),msg,0," \033[31;1mERROR\033[0m ")
+#define coding_error_every(period,msg) coding_log_limited(coding::log::Every(period),msg,0," \033[31;1mERROR\033[0m ")
+#define coding_error_limit(rate,burst,msg) coding_log_limited(coding::log::TokenBucket(rate,burst),msg,0," \033[31;1mERROR\033[0m ")
+#define coding_error_sample(p,msg) coding_log_limited(coding::log::Sample(p),msg,0," \033[31;1mERROR\033[0m ")
+
+namespace coding::log {
 
     constexpr int LOG_LEVEL_DISABLED = -255;
     constexpr int LOG_LEVEL_ERROR = 0;
@@ -31,10 +95,869 @@ namespace coding::log {
     constexpr int LOG_LEVEL_DEBUG = 30;
     constexpr int LOG_LEVEL_TRACE = 40;
 
+    /// @brief The runtime level of a group of log sites, a source file or a tag.
+    ///
+    /// Every log site resolves its module once, into a function-local static,
+    /// so checking whether it is enabled is a single relaxed load.
+    /// Modules are never destroyed and live in a global registry, so levels can be changed at any time.
+    ///
+    class Module final {
+
+    private:
+
+        std::string name;
+
+        std::atomic<int> level;
+
+        /// @brief Whether `level` was set for this module and no longer follows the default level.
+        ///
+        bool pinned = false;
+
+        Module* next = nullptr;
+
+        inline Module(std::string_view name, int level) noexcept : name(name), level(level) {}
+
+        struct Registry final {
+
+            thread::RawMutex lock;
+
+            Module* head = nullptr;
+
+            int fallback = 255;
+
+            /// @brief Levels set by name, applied to modules registered later.
+            ///
+            std::vector<std::pair<std::string, int>> rules;
+        };
+
+        inline static auto registry() noexcept -> Registry& {
+            static auto r = new Registry();
+            return *r;
+        }
+
+        /// @brief Whether `pattern` names this module: the same name, or a trailing part of its path.
+        ///
+        inline auto matches(std::string_view pattern) const noexcept -> bool {
+            auto n = std::string_view(this->name);
+            if (n == pattern) return true;
+            return n.size() > pattern.size() && n.ends_with(pattern) && n[n.size() - pattern.size() - 1] == '/';
+        }
+
+    public:
+
+        Module(Module const&) = delete;
+
+        /// @brief Find or register a module.
+        /// @param name a file path or a tag
+        ///
+        inline static auto get(std::string_view name) noexcept -> Module& {
+            auto& r = registry();
+            r.lock.lock();
+            auto m = r.head;
+            while (m && m->name != name) m = m->next;
+            if (!m) {
+                m = new Module(name, r.fallback);
+                for (auto& [pattern, level] : r.rules) {
+                    if (m->matches(pattern)) {
+                        m->level.store(level, std::memory_order_relaxed);
+                        m->pinned = true;
+                    }
+                }
+                m->next = r.head;
+                r.head = m;
+            }
+            r.lock.unlock();
+            return *m;
+        }
+
+        /// @brief Whether messages of `level` are logged.
+        ///
+        inline auto enabled(int level) const noexcept -> bool {
+            return level <= this->level.load(std::memory_order_relaxed);
+        }
+
+        inline auto get_name() const noexcept -> std::string_view {
+            return this->name;
+        }
+
+        inline auto get_level() const noexcept -> int {
+            return this->level.load(std::memory_order_relaxed);
+        }
+
+        /// @brief Set the level of every module named by `pattern`, now and in the future.
+        /// @param pattern a tag, a file path or a trailing part of one such as `"net/socket.cc"`
+        ///
+        inline static auto set(std::string_view pattern, int level) noexcept {
+            auto& r = registry();
+            r.lock.lock();
+            auto found = false;
+            for (auto& [p, l] : r.rules) {
+                if (p == pattern) {
+                    l = level;
+                    found = true;
+                }
+            }
+            if (!found) r.rules.emplace_back(pattern, level);
+            for (auto m = r.head; m; m = m->next) {
+                if (m->matches(pattern)) {
+                    m->level.store(level, std::memory_order_relaxed);
+                    m->pinned = true;
+                }
+            }
+            r.lock.unlock();
+        }
+
+        /// @brief Set the level of every module that has no level of its own.
+        ///
+        inline static auto set_default(int level) noexcept {
+            auto& r = registry();
+            r.lock.lock();
+            r.fallback = level;
+            for (auto m = r.head; m; m = m->next) {
+                if (!m->pinned) m->level.store(level, std::memory_order_relaxed);
+            }
+            r.lock.unlock();
+        }
+
+        inline static auto get_default() noexcept -> int {
+            auto& r = registry();
+            r.lock.lock();
+            auto level = r.fallback;
+            r.lock.unlock();
+            return level;
+        }
+
+        /// @brief Visit every registered module, e.g. to list them in an admin endpoint.
+        /// @tparam F the visitor type
+        /// @param f visitor called with `Module const&`
+        ///
+        template<typename F>
+        inline static auto for_each(F f) {
+            auto& r = registry();
+            r.lock.lock();
+            for (auto m = r.head; m; m = m->next) f(*(Module const*)m);
+            r.lock.unlock();
+        }
+    };
+
+    /// @brief The default level of every module, kept for compatibility.
+    /// Assigning to it is the same as `set_level(level)`.
+    ///
+    struct DefaultLevel final {
+
+        inline auto operator=(int level) noexcept -> DefaultLevel& {
+            Module::set_default(level);
+            return *this;
+        }
+
+        inline operator int() const noexcept {
+            return Module::get_default();
+        }
+    };
+
+    /// @brief Assign to this variable to control log level.
+    ///
+    inline DefaultLevel LOG_LEVEL;
+
+    /// @brief Set the level of every module without a level of its own.
+    ///
+    inline auto set_level(int level) noexcept {
+        Module::set_default(level);
+    }
+
+    /// @brief Set the level of the modules named by `module`, see `Module::set`.
+    ///
+    inline auto set_level(std::string_view module, int level) noexcept {
+        Module::set(module, level);
+    }
+
+    /// @brief Apply a comma-separated list of `module=level` rules, a bare level setting the default,
+    /// e.g. `"20,net=40,src/db.cc=0"`, typically read from an environment variable.
+    /// @return whether every rule parsed, rules before a malformed one are still applied
+    ///
+    inline auto configure(std::string_view spec) noexcept -> bool {
+        while (!spec.empty()) {
+            auto end = spec.find(',');
+            auto rule = spec.substr(0, end);
+            spec = end == std::string_view::npos ? std::string_view() : spec.substr(end + 1);
+            if (rule.empty()) continue;
+            auto eq = rule.rfind('=');
+            auto num = eq == std::string_view::npos ? rule : rule.substr(eq + 1);
+            auto level = 0;
+            auto [ptr, ec] = std::from_chars(num.data(), num.data() + num.size(), level);
+            if (ec != std::errc() || ptr != num.data() + num.size()) return false;
+            if (eq == std::string_view::npos) set_level(level);
+            else set_level(rule.substr(0, eq), level);
+        }
+        return true;
+    }
+
+    /// @brief A cheap monotonic clock in nanoseconds, with the resolution of the scheduler tick.
+    ///
+    inline auto coarse_ns() noexcept -> i64 {
+        auto ts = timespec();
+#ifdef CLOCK_MONOTONIC_COARSE
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+#else
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+        return (i64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    }
+
+    /// @brief Let through the first of every `n` calls.
+    ///
+    class EveryN final {
+
+    private:
+
+        std::atomic<u64> calls = 0;
+
+        u64 n;
+
+    public:
+
+        inline EveryN(u64 n) noexcept : n(std::max(n, (u64)1)) {}
+
+        /// @brief Count a call with one relaxed increment.
+        /// @return the number of calls suppressed since the last one let through, or `None`
+        ///
+        inline auto admit() noexcept -> Option<u64> {
+            auto c = this->calls.fetch_add(1, std::memory_order_relaxed);
+            if (c % this->n) return Option<u64>();
+            return Option<u64>(c ? this->n - 1 : 0);
+        }
+    };
+
+    /// @brief Let through at most one call per period, in windows aligned on the coarse clock.
+    ///
+    /// The state is one word, the window of the last line in the high half and the calls suppressed
+    /// since in the low half, so a suppressed call costs one relaxed increment.
+    ///
+    class Every final {
+
+    private:
+
+        std::atomic<u64> state = UINT64_C(0xffffffff) << 32;
+
+        i64 period;
+
+    public:
+
+        /// @param period the length of a window, which lets through one line: two lines on either side of a window
+        /// boundary may be almost back to back, so this bounds the rate, not the gap between two lines
+        ///
+        inline Every(measure::Time period) noexcept : period(std::max((i64)(period.value() * 1e9), (i64)1)) {}
+
+        inline auto admit() noexcept -> Option<u64> {
+            auto window = (u64)(u32)(coarse_ns() / this->period);
+            auto s = this->state.fetch_add(1, std::memory_order_relaxed) + 1;
+            while ((s >> 32) != window) {
+                if (this->state.compare_exchange_weak(s, window << 32, std::memory_order_relaxed)) {
+                    auto suppressed = (u64)(u32)s - 1;
+                    return Option<u64>(suppressed);
+                }
+            }
+            return Option<u64>();
+        }
+    };
+
+    /// @brief Let through `rate` calls per second on average and bursts of up to `burst` calls,
+    /// as a token bucket kept as its theoretical arrival time (GCRA).
+    ///
+    class TokenBucket final {
+
+    private:
+
+        /// @brief When the bucket will be full again, in coarse nanoseconds.
+        ///
+        std::atomic<i64> full = 0;
+
+        std::atomic<u64> calls = 0;
+
+        std::atomic<u64> passed = 0;
+
+        i64 interval;
+
+        i64 tolerance;
+
+    public:
+
+        /// @param rate tokens added per second
+        /// @param burst bucket size
+        ///
+        inline TokenBucket(double rate, u64 burst) noexcept
+            : interval(std::max((i64)(1e9 / rate), (i64)1)), tolerance(this->interval * (i64)std::max(burst, (u64)1)) {}
+
+        /// @brief Count a call with one relaxed increment and check the bucket with one relaxed load.
+        ///
+        inline auto admit() noexcept -> Option<u64> {
+            auto c = this->calls.fetch_add(1, std::memory_order_relaxed);
+            auto now = coarse_ns();
+            auto full = this->full.load(std::memory_order_relaxed);
+            loop {
+                auto next = std::max(full, now) + this->interval;
+                if (next - now > this->tolerance) return Option<u64>();
+                if (this->full.compare_exchange_weak(full, next, std::memory_order_relaxed)) break;
+            }
+            auto before = this->passed.exchange(c + 1, std::memory_order_relaxed);
+            return Option<u64>(c >= before ? c - before : 0);
+        }
+    };
+
+    /// @brief Let through each call with probability `p`.
+    ///
+    class Sample final {
+
+    private:
+
+        std::atomic<u64> calls = 0;
+
+        std::atomic<u64> passed = 0;
+
+        u64 threshold;
+
+        /// @brief A per-thread xorshift generator, seeded by a count of threads, as thread indices are reused.
+        ///
+        inline static auto next() noexcept -> u64 {
+            static std::atomic<u64> threads = 0;
+            thread_local u64 x = 0x9e3779b97f4a7c15ull * (threads.fetch_add(1, std::memory_order_relaxed) + 1);
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            return x;
+        }
+
+    public:
+
+        /// @param p the probability of logging, in `[0, 1]`
+        ///
+        inline Sample(double p) noexcept
+            : threshold(p >= 1 ? UINT64_MAX : p <= 0 ? 0 : (u64)(p * 18446744073709551616.0)) {}
+
+        inline auto admit() noexcept -> Option<u64> {
+            auto c = this->calls.fetch_add(1, std::memory_order_relaxed);
+            if (next() >= this->threshold) return Option<u64>();
+            auto before = this->passed.exchange(c + 1, std::memory_order_relaxed);
+            return Option<u64>(c >= before ? c - before : 0);
+        }
+    };
+
+    /// @brief The `yyyy-mm-ddThh:mm:ss` part of the current second, formatted once per second and thread.
+    /// @param t the time in seconds
+    /// @return 19 characters, valid until the thread formats another second
+    ///
+    inline auto second_prefix(std::time_t t) noexcept -> char const* {
+        thread_local std::time_t second = -1;
+        thread_local char text[std::size("yyyy-mm-ddThh:mm:ss")];
+        if (t != second) [[unlikely]] {
+            auto tm = std::tm();
+            gmtime_r(&t, &tm);
+            std::strftime(text, std::size(text), "%FT%T", &tm);
+            second = t;
+        }
+        return text;
+    }
+
+    /// @brief Streams the current UTC time as `yyyy-mm-ddThh:mm:ssZ` without allocating.
+    ///
+    struct Timestamp final {
+
+        std::time_t time = std::time({});
+
+        friend inline auto operator<<(std::ostream& os, Timestamp const& t) -> std::ostream& {
+            return os.write(second_prefix(t.time), 19).put('Z');
+        }
+    };
+
     inline auto log_time() noexcept -> std::string {
-        auto t = std::time({});
-        char s[std::size("yyyy-mm-ddThh:mm:ssZ")];
-        std::strftime(std::data(s), std::size(s), "%FT%TZ", std::gmtime(&t));
-        return s;
+        return std::string(second_prefix(std::time({})), 19) + 'Z';
+    }
+
+    /// @brief Write a whole batch with `writev`, resuming after short writes.
+    /// @param scratch reused copy of the batch, advanced in place
+    /// @return the number of bytes written, less than the batch on error
+    ///
+    inline auto writev_all(int fd, std::span<iovec const> batch, std::vector<iovec>& scratch) noexcept -> usize {
+        auto& iov = scratch;
+        iov.assign(batch.begin(), batch.end());
+        auto at = (usize)0;
+        auto total = (usize)0;
+        while (at < iov.size()) {
+            auto n = ::writev(fd, iov.data() + at, (int)std::min(iov.size() - at, (usize)IOV_MAX));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            total += (usize)n;
+            while (n > 0 && at < iov.size()) {
+                if ((usize)n >= iov[at].iov_len) {
+                    n -= (ssize_t)iov[at].iov_len;
+                    at++;
+                }
+                else {
+                    iov[at].iov_base = (char*)iov[at].iov_base + n;
+                    iov[at].iov_len -= (usize)n;
+                    n = 0;
+                }
+            }
+            while (at < iov.size() && iov[at].iov_len == 0) at++;
+        }
+        return total;
+    }
+
+    /// @brief Where the backend writes drained log lines.
+    /// @note Only ever called by one thread at a time.
+    ///
+    struct Sink {
+
+        inline virtual ~Sink() noexcept = default;
+
+        /// @brief Write a batch of complete lines.
+        /// @param batch the buffers to write, in order
+        ///
+        virtual auto write(std::span<iovec const> batch) noexcept -> void = 0;
+
+        /// @brief Make everything written so far durable, if the sink buffers anything.
+        ///
+        inline virtual auto sync() noexcept -> void {}
+
+        /// @brief Called when the backend runs out of lines, for deferred work such as periodic syncs.
+        /// @return how long the backend may sleep before calling again, `max()` for no limit
+        ///
+        inline virtual auto idle() noexcept -> std::chrono::nanoseconds {
+            return std::chrono::nanoseconds::max();
+        }
+    };
+
+    /// @brief A sink writing to a file descriptor with `writev`, `stderr` by default.
+    ///
+    class FdSink final : public Sink {
+
+    private:
+
+        int fd;
+
+        std::vector<iovec> iov;
+
+    public:
+
+        inline FdSink(int fd = STDERR_FILENO) noexcept : fd(fd) {}
+
+        inline auto write(std::span<iovec const> batch) noexcept -> void override {
+            writev_all(this->fd, batch, this->iov);
+        }
+    };
+
+    /// @brief What a thread does when its log buffer is full.
+    ///
+    enum class Overflow {
+
+        /// @brief Discard the line and count it, the count is reported with the next batch.
+        ///
+        Drop,
+
+        /// @brief Wait for the backend to make room, never losing a line.
+        ///
+        Block,
+    };
+
+    /// @brief A single-producer single-consumer byte ring holding complete log lines of one thread.
+    ///
+    struct Ring final {
+
+        constexpr static usize CAPACITY = (usize)1 << 16;
+
+        /// @brief Bytes consumed so far, written by the backend.
+        ///
+        alignas(thread::CACHE_LINE) std::atomic<usize> head = 0;
+
+        /// @brief Set once the owning thread has exited, the backend frees the ring after draining it.
+        ///
+        std::atomic<bool> closed = false;
+
+        /// @brief Bytes produced so far, written by the owning thread.
+        ///
+        alignas(thread::CACHE_LINE) std::atomic<usize> tail = 0;
+
+        /// @brief The owner's last view of `head`, refreshed only when the ring looks full.
+        ///
+        usize seen = 0;
+
+        std::atomic<u64> dropped = 0;
+
+        Ring* next = nullptr;
+
+        std::unique_ptr<char[]> data = std::make_unique<char[]>(CAPACITY);
+
+        /// @brief Append one line, all or nothing.
+        /// @param order how to publish it, `seq_cst` lets the caller then check whether the consumer sleeps
+        /// @return whether there was room for it
+        ///
+        inline auto push(char const* s, usize n, std::memory_order order = std::memory_order_seq_cst) noexcept -> bool {
+            auto t = this->tail.load(std::memory_order_relaxed);
+            if (t + n - this->seen > CAPACITY) {
+                this->seen = this->head.load(std::memory_order_acquire);
+                if (t + n - this->seen > CAPACITY) return false;
+            }
+            auto at = t % CAPACITY;
+            auto first = std::min(n, CAPACITY - at);
+            std::memcpy(this->data.get() + at, s, first);
+            std::memcpy(this->data.get(), s + first, n - first);
+            this->tail.store(t + n, order);
+            return true;
+        }
+    };
+
+    /// @brief The background thread draining every `Ring` into the `Sink`.
+    ///
+    /// Threads never touch the sink: a log call formats its line, copies it into the ring
+    /// of its thread and only issues a syscall to wake the backend if it was asleep.
+    /// The backend gathers whatever every ring holds into one `writev` batch.
+    /// Lines of one thread keep their order, lines of different threads may be interleaved within a batch.
+    ///
+    class Backend final {
+
+    private:
+
+        /// @brief Registered rings, pushed on attach and unlinked by the drainer.
+        ///
+        thread::RawMutex registry;
+
+        Ring* rings = nullptr;
+
+        /// @brief Held while draining, there is only ever one consumer.
+        ///
+        thread::RawMutex draining;
+
+        std::unique_ptr<Sink> sink = std::make_unique<FdSink>();
+
+        /// @brief The rings being drained with the tail each was read at, reused across batches.
+        ///
+        std::vector<std::pair<Ring*, usize>> snapshot;
+
+        std::vector<iovec> batch;
+
+        std::atomic<Overflow> policy = Overflow::Drop;
+
+        alignas(thread::CACHE_LINE) std::atomic<u32> signal = 0;
+
+        std::atomic<bool> sleeping = false;
+
+        /// @brief Set at exit, lines are then written synchronously.
+        ///
+        std::atomic<bool> stopped = false;
+
+        inline static thread_local bool in_drain = false;
+
+        inline auto pending() noexcept -> bool {
+            this->registry.lock();
+            auto any = false;
+            for (auto r = this->rings; r && !any; r = r->next) {
+                any = r->tail.load(std::memory_order_seq_cst) != r->head.load(std::memory_order_relaxed);
+            }
+            this->registry.unlock();
+            return any;
+        }
+
+        /// @brief Write everything currently buffered. The caller holds `draining`.
+        /// @return whether anything was written
+        ///
+        inline auto drain_locked() noexcept -> bool {
+            in_drain = true;
+            this->snapshot.clear();
+            this->registry.lock();
+            for (auto p = &this->rings; *p;) {
+                auto r = *p;
+                if (r->closed.load(std::memory_order_acquire) && r->head.load(std::memory_order_relaxed) == r->tail.load(std::memory_order_acquire)) {
+                    *p = r->next;
+                    delete r;
+                    continue;
+                }
+                this->snapshot.emplace_back(r, 0);
+                p = &r->next;
+            }
+            this->registry.unlock();
+
+            this->batch.clear();
+            auto dropped = (u64)0;
+            for (auto& [r, t] : this->snapshot) {
+                auto h = r->head.load(std::memory_order_relaxed);
+                t = r->tail.load(std::memory_order_acquire);
+                dropped += r->dropped.exchange(0, std::memory_order_relaxed);
+                if (t == h) continue;
+                auto at = h % Ring::CAPACITY;
+                auto first = std::min(t - h, Ring::CAPACITY - at);
+                this->batch.push_back(iovec{ r->data.get() + at, first });
+                if (t - h > first) this->batch.push_back(iovec{ r->data.get(), t - h - first });
+            }
+            char notice[64];
+            if (dropped) {
+                auto n = std::snprintf(notice, sizeof(notice), "... %llu log lines dropped\n", (unsigned long long)dropped);
+                this->batch.push_back(iovec{ notice, (usize)n });
+            }
+            auto wrote = !this->batch.empty();
+            if (wrote) this->sink->write(this->batch);
+            for (auto [r, t] : this->snapshot) r->head.store(t, std::memory_order_release);
+            in_drain = false;
+            return wrote;
+        }
+
+        inline auto run() noexcept {
+            loop {
+                this->draining.lock();
+                auto wrote = this->drain_locked();
+                this->draining.unlock();
+                if (wrote) continue;
+                this->draining.lock();
+                auto limit = this->sink->idle();
+                this->draining.unlock();
+                auto s = this->signal.load(std::memory_order_acquire);
+                this->sleeping.store(true, std::memory_order_seq_cst);
+                if (!this->pending()) {
+                    if (limit == std::chrono::nanoseconds::max()) thread::futex::wait(this->signal, s);
+                    else thread::futex::wait_for(this->signal, s, limit);
+                }
+                this->sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        inline Backend() noexcept {
+            std::thread([this] { this->run(); }).detach();
+            std::atexit([] { Backend::get().stop(); });
+            thread::on_panic([] { Backend::get().flush(); });
+        }
+
+    public:
+
+        Backend(Backend const&) = delete;
+
+        /// @brief The process-wide backend, started on first use and never destroyed,
+        /// so logging keeps working during static destruction.
+        ///
+        inline static auto get() noexcept -> Backend& {
+            static auto backend = new Backend();
+            return *backend;
+        }
+
+        /// @brief Create the ring of a new thread.
+        ///
+        inline auto attach() noexcept -> Ring* {
+            auto r = new Ring();
+            this->registry.lock();
+            r->next = this->rings;
+            this->rings = r;
+            this->registry.unlock();
+            return r;
+        }
+
+        /// @brief Wake the backend if it is asleep.
+        ///
+        inline auto wake() noexcept {
+            if (this->sleeping.exchange(false, std::memory_order_seq_cst)) {
+                this->signal.fetch_add(1, std::memory_order_release);
+                thread::futex::wake(this->signal);
+            }
+        }
+
+        /// @brief Write a line synchronously, bypassing the rings.
+        ///
+        inline auto write(char const* s, usize n) noexcept {
+            auto iov = iovec{ (void*)s, n };
+            if (in_drain) return this->sink->write({ &iov, 1 });
+            this->draining.lock();
+            this->sink->write({ &iov, 1 });
+            this->draining.unlock();
+        }
+
+        /// @brief Queue a complete line from the calling thread.
+        /// @param ring the ring of the calling thread
+        ///
+        inline auto emit(Ring& ring, char const* s, usize n) noexcept {
+            if (this->stopped.load(std::memory_order_acquire) || in_drain) [[unlikely]] return this->write(s, n);
+            n = std::min(n, Ring::CAPACITY);
+            while (!ring.push(s, n)) {
+                this->wake();
+                if (this->policy.load(std::memory_order_relaxed) == Overflow::Drop) {
+                    ring.dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            if (this->sleeping.load(std::memory_order_seq_cst)) this->wake();
+        }
+
+        /// @brief Write every line queued so far and sync the sink.
+        /// @note Lines queued by other threads while flushing may or may not be included.
+        ///
+        inline auto flush() noexcept -> void {
+            if (in_drain) return;
+            this->draining.lock();
+            while (this->drain_locked());
+            this->sink->sync();
+            this->draining.unlock();
+        }
+
+        /// @brief Flush, then make every later line bypass the rings.
+        ///
+        inline auto stop() noexcept -> void {
+            this->stopped.store(true, std::memory_order_seq_cst);
+            this->flush();
+        }
+
+        /// @brief Replace the sink, after flushing the old one.
+        ///
+        inline auto set_sink(std::unique_ptr<Sink> sink) noexcept {
+            this->draining.lock();
+            while (this->drain_locked());
+            this->sink->sync();
+            this->sink = mv(sink);
+            this->draining.unlock();
+        }
+
+        inline auto set_overflow(Overflow policy) noexcept {
+            this->policy.store(policy, std::memory_order_relaxed);
+        }
+    };
+
+    /// @brief A reusable formatting buffer of the calling thread, used by the `coding_log` macros.
+    ///
+    /// Each thread keeps a small stack of lines, so a message expression may itself log.
+    ///
+    class Line final : std::streambuf {
+
+    private:
+
+        /// @brief Per-thread state, heap-allocated so that logging from destructors running
+        /// after the thread's teardown still finds a valid, if unbuffered, line.
+        ///
+        struct Local final {
+
+            Ring* ring = nullptr;
+
+            std::vector<Line*> lines;
+
+            usize depth = 0;
+
+            /// @brief Set for lines logged after teardown, which bypass the ring.
+            ///
+            bool exited = false;
+        };
+
+        /// @brief Frees `local` and closes its ring when the thread exits.
+        ///
+        struct Owner final {
+
+            inline ~Owner() noexcept {
+                auto l = local;
+                if (l->ring) l->ring->closed.store(true, std::memory_order_release);
+                for (auto line : l->lines) delete line;
+                delete l;
+                local = nullptr;
+                exited = true;
+            }
+        };
+
+        inline static thread_local Local* local = nullptr;
+
+        inline static thread_local bool exited = false;
+
+        std::vector<char> buf = std::vector<char>(256);
+
+        inline Line() noexcept : stream(this) {
+            this->setp(this->buf.data(), this->buf.data() + this->buf.size());
+        }
+
+        inline auto grow() noexcept {
+            auto n = (usize)(this->pptr() - this->pbase());
+            this->buf.resize(this->buf.size() * 2);
+            this->setp(this->buf.data(), this->buf.data() + this->buf.size());
+            this->pbump((int)n);
+        }
+
+        inline auto overflow(int_type c) -> int_type override {
+            this->grow();
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                *this->pptr() = traits_type::to_char_type(c);
+                this->pbump(1);
+            }
+            return traits_type::not_eof(c);
+        }
+
+    public:
+
+        std::ostream stream;
+
+        Line(Line const&) = delete;
+
+        /// @brief Take an empty line, `commit` it when done.
+        ///
+        inline static auto get() noexcept -> Line& {
+            if (!local) [[unlikely]] {
+                local = new Local();
+                if (exited) local->exited = true;
+                else {
+                    thread_local Owner owner;
+                    (void)owner;
+                }
+            }
+            auto l = local;
+            if (l->depth == l->lines.size()) l->lines.push_back(new Line());
+            return *l->lines[l->depth++];
+        }
+
+        /// @brief Room for at least `n` more bytes, to be written directly and then passed to `advance`.
+        ///
+        inline auto reserve(usize n) noexcept -> char* {
+            while ((usize)(this->epptr() - this->pptr()) < n) this->grow();
+            return this->pptr();
+        }
+
+        /// @brief Account for `n` bytes written past `reserve`.
+        ///
+        inline auto advance(usize n) noexcept {
+            this->pbump((int)n);
+        }
+
+        /// @brief Append raw bytes, bypassing the stream.
+        ///
+        inline auto append(std::string_view s) noexcept {
+            std::memcpy(this->reserve(s.size()), s.data(), s.size());
+            this->advance(s.size());
+        }
+
+        /// @brief Hand the formatted line to the backend and reset the buffer.
+        ///
+        inline auto commit() noexcept {
+            auto l = local;
+            auto& backend = Backend::get();
+            auto s = this->pbase();
+            auto n = (usize)(this->pptr() - this->pbase());
+            if (l->exited) [[unlikely]] backend.write(s, n);
+            else {
+                if (!l->ring) l->ring = backend.attach();
+                backend.emit(*l->ring, s, n);
+            }
+            this->setp(this->buf.data(), this->buf.data() + this->buf.size());
+            l->depth--;
+        }
+    };
+
+    /// @brief Choose what threads do when their log buffer is full, `Overflow::Drop` by default.
+    ///
+    inline auto set_overflow(Overflow policy) noexcept {
+        Backend::get().set_overflow(policy);
+    }
+
+    /// @brief Send every later line to `sink` instead of `stderr`.
+    ///
+    inline auto set_sink(std::unique_ptr<Sink> sink) noexcept {
+        Backend::get().set_sink(mv(sink));
+    }
+
+    /// @brief Block until every line logged so far by this thread has reached the sink.
+    /// @note Runs automatically on `panic` and at exit.
+    ///
+    inline auto flush() noexcept -> void {
+        Backend::get().flush();
     }
 }
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "log.cc"
+#include "measure.cc"
+#include "result.cc"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace coding::log {
+
+    /// @brief When a `FileSink` makes written lines durable with `fdatasync`.
+    ///
+    struct Durability final {
+
+        enum Kind {
+
+            /// @brief Leave it to the kernel, lines survive a process crash but not a power loss.
+            ///
+            None,
+
+            /// @brief Sync at most once per `period`, and when the backend goes idle after it elapsed.
+            ///
+            Periodic,
+
+            /// @brief Sync after every `records` lines.
+            ///
+            EveryN,
+        };
+
+        Kind kind = None;
+
+        measure::Time period = measure::Time();
+
+        u64 records = 0;
+
+        inline static auto none() noexcept -> Durability {
+            return Durability{};
+        }
+
+        inline static auto periodic(measure::Time period) noexcept -> Durability {
+            return Durability{ Periodic, period, 0 };
+        }
+
+        inline static auto every(u64 records) noexcept -> Durability {
+            return Durability{ EveryN, measure::Time(), std::max(records, (u64)1) };
+        }
+    };
+
+    /// @brief Options of a `FileSink`.
+    ///
+    struct FileOptions final {
+
+        /// @brief Rotate once the file reaches this many bytes, `0` for no limit.
+        ///
+        u64 max_bytes = 0;
+
+        /// @brief Rotate once the file is this old, zero for no limit.
+        ///
+        measure::Time max_age = measure::Time();
+
+        /// @brief How many rotated files to keep, `0` to keep them all.
+        ///
+        usize keep = 0;
+
+        Durability durability = Durability::none();
+
+        /// @brief Run on a background thread with the path of every rotated file, e.g. `gzip()`.
+        ///
+        std::function<void(std::string const&)> compress = nullptr;
+    };
+
+    /// @brief A compression hook running `gzip` on the rotated file, which replaces it with `<file>.gz`.
+    ///
+    inline auto gzip() noexcept -> std::function<void(std::string const&)> {
+        return [](std::string const& path) {
+            char const* argv[] = { "gzip", "-q", "--", path.c_str(), nullptr };
+            pid_t pid;
+            if (posix_spawnp(&pid, "gzip", nullptr, nullptr, (char* const*)argv, environ) == 0) {
+                auto status = 0;
+                while (waitpid(pid, &status, 0) < 0 && errno == EINTR);
+            }
+        };
+    }
+
+    /// @brief A log file written by the backend thread with `O_APPEND` and one `writev` per batch.
+    ///
+    /// Rotation renames the file to `<path>.<yyyymmddThhmmss>` and reopens `path`, all on the backend thread,
+    /// so logging threads keep filling their rings meanwhile and never wait for it.
+    /// Compression of rotated files runs on a thread of its own.
+    ///
+    class FileSink final : public Sink {
+
+    private:
+
+        std::string path;
+
+        FileOptions options;
+
+        int fd = -1;
+
+        u64 size = 0;
+
+        std::chrono::steady_clock::time_point opened;
+
+        std::chrono::steady_clock::time_point synced;
+
+        /// @brief Lines written since the last sync.
+        ///
+        u64 unsynced = 0;
+
+        bool dirty = false;
+
+        std::vector<iovec> iov;
+
+        /// @brief Rotated files still being compressed, shared with the compression threads.
+        ///
+        struct Compressing final {
+
+            thread::RawMutex lock;
+
+            std::vector<std::string> names;
+        };
+
+        std::shared_ptr<Compressing> compressing = std::make_shared<Compressing>();
+
+        inline FileSink(std::string path, FileOptions options) noexcept : path(mv(path)), options(mv(options)) {}
+
+        inline auto open_file() noexcept -> int {
+            auto fd = ::open(this->path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (fd < 0) return errno;
+            struct stat st {};
+            this->fd = fd;
+            this->size = fstat(fd, &st) == 0 ? (u64)st.st_size : 0;
+            this->opened = std::chrono::steady_clock::now();
+            this->synced = this->opened;
+            return 0;
+        }
+
+        inline auto datasync() noexcept {
+            if (!this->dirty) return;
+            ::fdatasync(this->fd);
+            this->dirty = false;
+            this->unsynced = 0;
+            this->synced = std::chrono::steady_clock::now();
+        }
+
+        inline auto period() const noexcept -> std::chrono::nanoseconds {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(this->options.durability.period.value()));
+        }
+
+        inline auto due() const noexcept -> bool {
+            auto& o = this->options;
+            if (o.max_bytes && this->size >= o.max_bytes) return true;
+            return o.max_age > measure::Time() && std::chrono::steady_clock::now() - this->opened >= std::chrono::duration<double>(o.max_age.value());
+        }
+
+        /// @brief A free name for the file being rotated out, stamped with the current UTC time.
+        ///
+        inline auto rotated_name() const -> std::string {
+            auto t = std::time({});
+            auto tm = std::tm();
+            gmtime_r(&t, &tm);
+            char stamp[std::size("yyyymmddThhmmss")];
+            std::strftime(stamp, std::size(stamp), "%Y%m%dT%H%M%S", &tm);
+            auto base = this->path + "." + stamp;
+            auto name = base;
+            auto ec = std::error_code();
+            for (auto i = 1; std::filesystem::exists(name, ec) || std::filesystem::exists(name + ".gz", ec); i++) {
+                name = base + "." + std::to_string(i);
+            }
+            return name;
+        }
+
+        /// @brief The stamp and counter of a name `rotated_name()` gives, after the `<file>.` prefix, with an
+        /// optional `.gz`, or no stamp for any other name.
+        ///
+        inline static auto rotated_order(std::string_view rest) noexcept -> std::pair<std::string_view, u64> {
+            auto digits = [](std::string_view s) {
+                return !s.empty() && std::all_of(s.begin(), s.end(), [](char c) { return c >= '0' && c <= '9'; });
+            };
+            if (rest.ends_with(".gz")) rest.remove_suffix(3);
+            if (rest.size() < 15 || !digits(rest.substr(0, 8)) || rest[8] != 'T' || !digits(rest.substr(9, 6))) return {};
+            auto stamp = rest.substr(0, 15);
+            rest.remove_prefix(15);
+            if (rest.empty()) return { stamp, 0 };
+            if (rest[0] != '.' || rest.size() > 10 || !digits(rest.substr(1))) return {};
+            return { stamp, std::stoull(std::string(rest.substr(1))) };
+        }
+
+        /// @brief Delete the oldest rotated files beyond `keep`, leaving any still being compressed to a later call.
+        ///
+        inline auto prune() noexcept {
+            if (!this->options.keep) return;
+            auto file = std::filesystem::path(this->path);
+            auto dir = file.has_parent_path() ? file.parent_path() : std::filesystem::path(".");
+            auto prefix = file.filename().string() + ".";
+            auto rotated = std::vector<std::pair<std::pair<std::string, u64>, std::filesystem::path>>();
+            auto ec = std::error_code();
+            for (auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+                auto name = entry.path().filename().string();
+                if (!name.starts_with(prefix)) continue;
+                auto [stamp, i] = rotated_order(std::string_view(name).substr(prefix.size()));
+                if (!stamp.empty()) rotated.push_back({ { std::string(stamp), i }, entry.path() });
+            }
+            if (rotated.size() <= this->options.keep) return;
+            std::sort(rotated.begin(), rotated.end());
+            auto& c = *this->compressing;
+            c.lock.lock();
+            for (auto i = (usize)0; i < rotated.size() - this->options.keep; i++) {
+                auto name = rotated[i].second.filename().string();
+                if (name.ends_with(".gz")) name.resize(name.size() - 3);
+                if (std::find(c.names.begin(), c.names.end(), name) != c.names.end()) continue;
+                std::filesystem::remove(rotated[i].second, ec);
+            }
+            c.lock.unlock();
+        }
+
+        inline auto rotate() noexcept {
+            if (this->options.durability.kind != Durability::None) this->datasync();
+            auto name = this->rotated_name();
+            if (::rename(this->path.c_str(), name.c_str()) != 0) {
+                // Keep appending to the current file rather than losing lines.
+                this->opened = std::chrono::steady_clock::now();
+                return;
+            }
+            ::close(this->fd);
+            this->fd = -1;
+            if (this->open_file() != 0) {
+                // Reopening failed, write to the rotated file until the next attempt.
+                this->fd = ::open(name.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+                return;
+            }
+            if (this->options.compress) {
+                auto& c = *this->compressing;
+                c.lock.lock();
+                c.names.push_back(std::filesystem::path(name).filename().string());
+                c.lock.unlock();
+                std::thread([compress = this->options.compress, compressing = this->compressing, name] {
+                    compress(name);
+                    compressing->lock.lock();
+                    std::erase(compressing->names, std::filesystem::path(name).filename().string());
+                    compressing->lock.unlock();
+                }).detach();
+            }
+            this->prune();
+        }
+
+    public:
+
+        /// @brief Open or create `path` for appending.
+        /// @return the sink, or the `errno` of `open`
+        ///
+        inline static auto open(std::string path, FileOptions options = {}) noexcept -> Result<std::unique_ptr<FileSink>, int> {
+            auto sink = std::unique_ptr<FileSink>(new FileSink(mv(path), mv(options)));
+            if (auto e = sink->open_file()) return Result<std::unique_ptr<FileSink>, int>::err(e);
+            return Result<std::unique_ptr<FileSink>, int>::ok(mv(sink));
+        }
+
+        FileSink(FileSink const&) = delete;
+
+        inline ~FileSink() noexcept {
+            if (this->fd < 0) return;
+            if (this->options.durability.kind != Durability::None) this->datasync();
+            ::close(this->fd);
+        }
+
+        inline auto write(std::span<iovec const> batch) noexcept -> void override {
+            if (this->fd < 0) return;
+            if (this->due()) this->rotate();
+            this->size += writev_all(this->fd, batch, this->iov);
+            this->dirty = true;
+            auto& d = this->options.durability;
+            if (d.kind == Durability::EveryN) {
+                for (auto& v : batch) this->unsynced += (u64)std::count((char const*)v.iov_base, (char const*)v.iov_base + v.iov_len, '\n');
+                if (this->unsynced >= d.records) this->datasync();
+            }
+            else if (d.kind == Durability::Periodic && std::chrono::steady_clock::now() - this->synced >= this->period()) {
+                this->datasync();
+            }
+        }
+
+        inline auto sync() noexcept -> void override {
+            if (this->fd >= 0) this->datasync();
+        }
+
+        inline auto idle() noexcept -> std::chrono::nanoseconds override {
+            if (this->options.durability.kind != Durability::Periodic || !this->dirty) return std::chrono::nanoseconds::max();
+            auto left = this->period() - (std::chrono::steady_clock::now() - this->synced);
+            if (left > std::chrono::nanoseconds(0)) return left;
+            this->datasync();
+            return std::chrono::nanoseconds::max();
+        }
+    };
+}
@@ -1,334 +1,567 @@
 #pragma once
 
 #include "root.cc"
+#include "core.cc"
+#include "thread.cc"
 
 #include <cmath>
+#include <compare>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 /// @brief Helpers with real-world measurement units.
 /// 
+/// Every quantity is a `Quantity` of its dimension, holding the value in SI units: adding metres to seconds
+/// does not compile, multiplying them gives a `Quantity` of the product dimension, and dividing two of the
+/// same dimension gives a plain number, e.g. `t / 1.0_ms` is `t` in milliseconds. A `Quantity` is a
+/// single `double` in a trivially copyable struct, passed in a register and compiled to the same code.
+/// 
 namespace coding::measure {
 
+    /// @brief Exponents of the base dimensions of a quantity.
+    /// 
+    struct Dim final {
+
+        i8 length = 0;
+
+        i8 mass = 0;
+
+        i8 time = 0;
+
+        i8 current = 0;
+
+        /// @brief Angles are dimensionless in SI, but kept apart here so radians never pass for plain numbers.
+        /// 
+        i8 angle = 0;
+
+        inline constexpr auto operator*(Dim rhs) const noexcept -> Dim {
+            return Dim{ (i8)(this->length + rhs.length), (i8)(this->mass + rhs.mass), (i8)(this->time + rhs.time),
+                (i8)(this->current + rhs.current), (i8)(this->angle + rhs.angle) };
+        }
+
+        inline constexpr auto operator/(Dim rhs) const noexcept -> Dim {
+            return Dim{ (i8)(this->length - rhs.length), (i8)(this->mass - rhs.mass), (i8)(this->time - rhs.time),
+                (i8)(this->current - rhs.current), (i8)(this->angle - rhs.angle) };
+        }
+
+        inline constexpr auto operator==(Dim const&) const noexcept -> bool = default;
+    };
+
+    namespace dim {
+
+        inline constexpr Dim NONE = Dim{};
+
+        inline constexpr Dim LENGTH = Dim{ .length = 1 };
+
+        inline constexpr Dim MASS = Dim{ .mass = 1 };
+
+        inline constexpr Dim TIME = Dim{ .time = 1 };
+
+        inline constexpr Dim CURRENT = Dim{ .current = 1 };
+
+        inline constexpr Dim ANGLE = Dim{ .angle = 1 };
+    }
+
+    /// @brief A value of dimension `D` in SI units.
+    /// @tparam D the dimension, `Quantity`s of different dimensions never mix
+    /// @tparam Rep the number type
+    /// 
+    template<Dim D, typename Rep = double>
+        requires std::is_arithmetic_v<Rep>
+    class Quantity final {
+
+    private:
+
+        Rep v = 0;
+
+    public:
+
+        using rep = Rep;
+
+        inline constexpr static Dim dim = D;
+
+        inline constexpr Quantity() noexcept = default;
+
+        /// @brief A quantity of `v` SI units.
+        /// 
+        inline constexpr explicit Quantity(Rep v) noexcept : v(v) {}
+
+        template<typename R>
+        inline constexpr explicit Quantity(Quantity<D, R> q) noexcept : v((Rep)q.value()) {}
+
+        /// @brief The value in SI units.
+        /// 
+        inline constexpr auto value() const noexcept -> Rep {
+            return this->v;
+        }
+
+        /// @brief Dimensionless quantities, such as ratios of two quantities, are plain numbers.
+        /// 
+        inline constexpr operator Rep() const noexcept requires (D == dim::NONE) {
+            return this->v;
+        }
+
+        inline constexpr auto operator+() const noexcept -> Quantity { return *this; }
+        inline constexpr auto operator-() const noexcept -> Quantity { return Quantity(-this->v); }
+        inline constexpr auto operator+=(Quantity rhs) noexcept -> Quantity& { this->v += rhs.v; return *this; }
+        inline constexpr auto operator-=(Quantity rhs) noexcept -> Quantity& { this->v -= rhs.v; return *this; }
+        inline constexpr auto operator*=(Rep k) noexcept -> Quantity& { this->v *= k; return *this; }
+        inline constexpr auto operator/=(Rep k) noexcept -> Quantity& { this->v /= k; return *this; }
+        inline constexpr friend auto operator+(Quantity a, Quantity b) noexcept -> Quantity { return Quantity(a.v + b.v); }
+        inline constexpr friend auto operator-(Quantity a, Quantity b) noexcept -> Quantity { return Quantity(a.v - b.v); }
+        inline constexpr friend auto operator*(Quantity a, Rep k) noexcept -> Quantity { return Quantity(a.v * k); }
+        inline constexpr friend auto operator*(Rep k, Quantity a) noexcept -> Quantity { return Quantity(k * a.v); }
+        inline constexpr friend auto operator/(Quantity a, Rep k) noexcept -> Quantity { return Quantity(a.v / k); }
+        inline constexpr friend auto operator==(Quantity a, Quantity b) noexcept -> bool { return a.v == b.v; }
+        inline constexpr friend auto operator<=>(Quantity a, Quantity b) noexcept { return a.v <=> b.v; }
+    };
+
+    template<typename T>
+    inline constexpr bool IS_QUANTITY = false;
+
+    template<Dim D, typename Rep>
+    inline constexpr bool IS_QUANTITY<Quantity<D, Rep>> = true;
+
+    template<Dim A, Dim B, typename Rep>
+    inline constexpr auto operator*(Quantity<A, Rep> a, Quantity<B, Rep> b) noexcept -> Quantity<A * B, Rep> {
+        return Quantity<A * B, Rep>(a.value() * b.value());
+    }
+
+    template<Dim A, Dim B, typename Rep>
+    inline constexpr auto operator/(Quantity<A, Rep> a, Quantity<B, Rep> b) noexcept -> Quantity<A / B, Rep> {
+        return Quantity<A / B, Rep>(a.value() / b.value());
+    }
+
+    template<Dim D, typename Rep>
+    inline constexpr auto operator/(Rep k, Quantity<D, Rep> a) noexcept -> Quantity<dim::NONE / D, Rep> {
+        return Quantity<dim::NONE / D, Rep>(k / a.value());
+    }
+
+    template<Dim D, typename Rep>
+    inline constexpr auto abs(Quantity<D, Rep> a) noexcept -> Quantity<D, Rep> {
+        return Quantity<D, Rep>(a.value() < 0 ? -a.value() : a.value());
+    }
+
+    /// @brief The number a `Quantity` holds, or a number itself.
+    /// 
+    template<typename T>
+    inline constexpr auto rep_of(T x) noexcept {
+        if constexpr (IS_QUANTITY<T>) return x.value();
+        else return x;
+    }
+
+    /// @brief `out[i] = in[i] * k` over arrays of the same length, of numbers or of `Quantity`s holding them.
+    /// `in` and `out` are either the same array or disjoint: an `out` shifted from `in`, as `in + 1`, is wrong.
+    /// 
+    /// A plain loop only vectorizes at `-O3`, so the AVX2 path is spelled out: two vectors a step, then a scalar tail.
+    /// Its unaligned loads and stores may alias anything, so they read a `Quantity` array as its numbers;
+    /// the tail goes through `value()` and the constructor.
+    /// 
+    /// # Panic
+    /// 
+    /// Panics if `in` and `out` partly overlap.
+    /// 
+    template<typename In, typename Out, typename Rep>
+    inline auto scale(In const* in, Rep k, Out* out, usize n) noexcept -> void {
+        static_assert(sizeof(In) == sizeof(Rep) && sizeof(Out) == sizeof(Rep));
+        static_assert(std::is_standard_layout_v<In> && std::is_standard_layout_v<Out>);
+        auto a = (uintptr_t)in;
+        auto b = (uintptr_t)out;
+        if (a != b && a < b + n * sizeof(Rep) && b < a + n * sizeof(Rep)) panic("`scale` on partly overlapping arrays");
+        auto i = (usize)0;
+#if defined(__AVX2__)
+        if constexpr (std::is_same_v<Rep, double>) {
+            auto f = _mm256_set1_pd(k);
+            auto src = reinterpret_cast<double const*>(in);
+            auto dst = reinterpret_cast<double*>(out);
+            for (; i + 8 <= n; i += 8) {
+                auto x = _mm256_loadu_pd(src + i);
+                auto y = _mm256_loadu_pd(src + i + 4);
+                _mm256_storeu_pd(dst + i, _mm256_mul_pd(x, f));
+                _mm256_storeu_pd(dst + i + 4, _mm256_mul_pd(y, f));
+            }
+        }
+        else if constexpr (std::is_same_v<Rep, float>) {
+            auto f = _mm256_set1_ps(k);
+            auto src = reinterpret_cast<float const*>(in);
+            auto dst = reinterpret_cast<float*>(out);
+            for (; i + 16 <= n; i += 16) {
+                auto x = _mm256_loadu_ps(src + i);
+                auto y = _mm256_loadu_ps(src + i + 8);
+                _mm256_storeu_ps(dst + i, _mm256_mul_ps(x, f));
+                _mm256_storeu_ps(dst + i + 8, _mm256_mul_ps(y, f));
+            }
+        }
+#endif
+        for (; i < n; i++) out[i] = Out(rep_of(in[i]) * k);
+    }
+
+    /// @brief Express quantities in `unit`: `out[i] = in[i] / unit`, e.g. sensor samples in feet with `1.0_ft`.
+    /// @note Multiplies by the reciprocal of `unit`, which may differ from dividing by one ulp.
+    /// 
+    template<Dim D, typename Rep>
+    inline auto to_units(std::span<std::type_identity_t<Quantity<D, Rep>> const> in, Quantity<D, Rep> unit, std::span<std::type_identity_t<Rep>> out) noexcept -> void {
+        if (in.size() != out.size()) panic("quantity spans of different lengths");
+        scale(in.data(), 1 / unit.value(), out.data(), in.size());
+    }
+
+    /// @brief Read numbers in `unit` as quantities: `out[i] = in[i] * unit`.
+    /// 
+    template<Dim D, typename Rep>
+    inline auto from_units(std::span<std::type_identity_t<Rep> const> in, Quantity<D, Rep> unit, std::span<std::type_identity_t<Quantity<D, Rep>>> out) noexcept -> void {
+        if (in.size() != out.size()) panic("quantity spans of different lengths");
+        scale(in.data(), unit.value(), out.data(), in.size());
+    }
+
+    /// @brief Convert numbers between units of one dimension, e.g. feet to metres with `1.0_ft` and `1.0_m`.
+    /// Both units are checked to be of the same dimension. `in` and `out` are the same array or disjoint.
+    /// 
+    template<Dim D, typename Rep>
+    inline auto convert(std::span<std::type_identity_t<Rep> const> in, Quantity<D, Rep> from, Quantity<D, Rep> to, std::span<std::type_identity_t<Rep>> out) noexcept -> void {
+        if (in.size() != out.size()) panic("quantity spans of different lengths");
+        scale(in.data(), from.value() / to.value(), out.data(), in.size());
+    }
+
+    /// @brief `to_units` by the name of the other conversions: quantities to numbers in `unit`.
+    /// 
+    template<Dim D, typename Rep>
+    inline auto convert(std::span<std::type_identity_t<Quantity<D, Rep>> const> in, Quantity<D, Rep> unit, std::span<std::type_identity_t<Rep>> out) noexcept -> void {
+        to_units(in, unit, out);
+    }
+
+    /// @brief `from_units` by the name of the other conversions: numbers in `unit` to quantities.
+    /// 
+    template<Dim D, typename Rep>
+    inline auto convert(std::span<std::type_identity_t<Rep> const> in, Quantity<D, Rep> unit, std::span<std::type_identity_t<Quantity<D, Rep>>> out) noexcept -> void {
+        from_units(in, unit, out);
+    }
+
     /// @brief The angle in radian.
     /// 
-    using Angle = double;
+    using Angle = Quantity<dim::ANGLE>;
 
     /// @brief Convert radian to radian.
     /// @param p angle in radian
     /// @return `Angle` in radian
     /// 
-    inline constexpr auto operator"" _rad(long double p) noexcept -> Angle { return p; }
+    inline constexpr auto operator"" _rad(long double p) noexcept -> Angle { return Angle(p); }
 
     /// @brief Convert degree to radian
     /// @param p angle in degree
     /// @return `Angle` in radian
     /// 
-    inline constexpr auto operator"" _deg(long double p) noexcept -> Angle { return p * M_PI / 180; }
+    inline constexpr auto operator"" _deg(long double p) noexcept -> Angle { return Angle(p * M_PI / 180); }
 
     /// @brief Convert rotation to radian
     /// @param p angle in rotation
     /// @return `Angle` in radian
     /// 
-    inline constexpr auto operator"" _rot(long double p) noexcept -> Angle { return p * 360.0_deg; }
+    inline constexpr auto operator"" _rot(long double p) noexcept -> Angle { return 360.0_deg * (double)p; }
 
     /// @brief The length in metre.
     /// 
-    using Length = double;
+    using Length = Quantity<dim::LENGTH>;
 
     /// @brief Convert metre to metre.
     /// @param l length in metre
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _m(long double l) noexcept -> Length { return l; }
+    inline constexpr auto operator"" _m(long double l) noexcept -> Length { return Length(l); }
 
     /// @brief Convert kilometre to metre.
     /// @param l length in kilometre
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _km(long double l) noexcept -> Length { return l * 1e3; }
+    inline constexpr auto operator"" _km(long double l) noexcept -> Length { return Length(l * 1e3); }
 
     /// @brief Convert decimetre to metre.
     /// @param l length in decimetre
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _dm(long double l) noexcept -> Length { return l * 0.1; }
+    inline constexpr auto operator"" _dm(long double l) noexcept -> Length { return Length(l * 0.1); }
 
     /// @brief Convert centimetre to metre.
     /// @param l length in centimetre
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _cm(long double l) noexcept -> Length { return l * 0.01; }
+    inline constexpr auto operator"" _cm(long double l) noexcept -> Length { return Length(l * 0.01); }
 
     /// @brief Convert milimetre to metre.
     /// @param l length in milimetre
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _mm(long double l) noexcept -> Length { return l * 1e-3; }
+    inline constexpr auto operator"" _mm(long double l) noexcept -> Length { return Length(l * 1e-3); }
 
     /// @brief Convert micrometre to metre.
     /// @param l length in micrometre
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _um(long double l) noexcept -> Length { return l * 1e-6; }
+    inline constexpr auto operator"" _um(long double l) noexcept -> Length { return Length(l * 1e-6); }
 
     /// @brief Convert nanometre to metre.
     /// @param l length in nanometre
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _nm(long double l) noexcept -> Length { return l * 1e-9; }
+    inline constexpr auto operator"" _nm(long double l) noexcept -> Length { return Length(l * 1e-9); }
 
     /// @brief Convert inch to metre.
     /// @param l length in inch
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _in(long double l) noexcept -> Length { return l * 0.0254; }
+    inline constexpr auto operator"" _in(long double l) noexcept -> Length { return Length(l * 0.0254); }
 
     /// @brief Convert foot to metre.
     /// @param l length in foot
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _ft(long double l) noexcept -> Length { return l * 0.3048; }
+    inline constexpr auto operator"" _ft(long double l) noexcept -> Length { return Length(l * 0.3048); }
 
     /// @brief Convert nautical mile to metre.
     /// @param l length in nautical mile
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _nmi(long double l) noexcept -> Length { return l * 1852; }
+    inline constexpr auto operator"" _nmi(long double l) noexcept -> Length { return Length(l * 1852); }
 
     /// @brief Convert astronomical unit to metre.
     /// @param l length in astronomical unit
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _au(long double l) noexcept -> Length { return l * 1.495979e11; }
+    inline constexpr auto operator"" _au(long double l) noexcept -> Length { return Length(l * 1.495979e11); }
 
     /// @brief Convert light year to metre.
     /// @param l length in light year
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _ly(long double l) noexcept -> Length { return l * 9.4607e15; }
+    inline constexpr auto operator"" _ly(long double l) noexcept -> Length { return Length(l * 9.4607e15); }
 
     /// @brief Convert parsec to metre.
     /// @param l length in parsec
     /// @return `Length` in metre
     /// 
-    inline constexpr auto operator"" _pc(long double l) noexcept -> Length { return l * 3.0857e16; }
+    inline constexpr auto operator"" _pc(long double l) noexcept -> Length { return Length(l * 3.0857e16); }
 
     /// @brief The area in m^2.
     /// 
-    using Area = double;
+    using Area = Quantity<dim::LENGTH * dim::LENGTH>;
 
     /// @brief Convert square metre to square metre.
     /// @param a area in square metre
     /// @return `Area` in square metre
     /// 
-    inline constexpr auto operator"" _m2(long double s) noexcept -> Area { return s; }
+    inline constexpr auto operator"" _m2(long double s) noexcept -> Area { return Area(s); }
 
     /// @brief The volume in m^3.
     /// 
-    using Volume = double;
+    using Volume = Quantity<dim::LENGTH * dim::LENGTH * dim::LENGTH>;
 
     /// @brief Convert cubic metre to cubic metre.
     /// @param v volume in cubic metre
     /// @return `Volume` in cubic metre
     /// 
-    inline constexpr auto operator"" _m3(long double v) noexcept -> Volume { return v; }
+    inline constexpr auto operator"" _m3(long double v) noexcept -> Volume { return Volume(v); }
 
     /// @brief Convert litre to cubic metre.
     /// @param v volume in litre
     /// @return `Volume` in cubic metre
     /// 
-    inline constexpr auto operator"" _L(long double v) noexcept -> Volume { return v * 1e-3; }
+    inline constexpr auto operator"" _L(long double v) noexcept -> Volume { return Volume(v * 1e-3); }
 
     /// @brief Convert mililitre to cubic metre.
     /// @param v volume in mililitre
     /// @return `Volume` in cubic metre
     /// 
-    inline constexpr auto operator"" _mL(long double v) noexcept -> Volume { return v * 1e-6; }
+    inline constexpr auto operator"" _mL(long double v) noexcept -> Volume { return Volume(v * 1e-6); }
 
     /// @brief Convert US quart to cubic metre.
     /// @param v volume in US quart
     /// @return `Volume` in cubic metre
     /// 
-    inline constexpr auto operator"" _qt(long double v) noexcept -> Volume { return v * 0.946353e-3; }
+    inline constexpr auto operator"" _qt(long double v) noexcept -> Volume { return Volume(v * 0.946353e-3); }
 
     /// @brief Convert US pint to cubic metre.
     /// @param v volume in US pint
     /// @return `Volume` in cubic metre
     /// 
-    inline constexpr auto operator"" _pt(long double v) noexcept -> Volume { return v * 0.4731765e-3; }
+    inline constexpr auto operator"" _pt(long double v) noexcept -> Volume { return Volume(v * 0.4731765e-3); }
 
     /// @brief Convert US gallon to cubic metre.
     /// @param v volume in US gallon
     /// @return `Volume` in cubic metre
     /// 
-    inline constexpr auto operator"" _gal(long double v) noexcept -> Volume { return v * 3.785412e-3; }
+    inline constexpr auto operator"" _gal(long double v) noexcept -> Volume { return Volume(v * 3.785412e-3); }
 
     /// @brief Convert US cup to cubic metre.
     /// @param v volume in US cup
     /// @return `Volume` in cubic metre
     /// 
-    inline constexpr auto operator"" _cup(long double v) noexcept -> Volume { return v * 0.24e-3; }
+    inline constexpr auto operator"" _cup(long double v) noexcept -> Volume { return Volume(v * 0.24e-3); }
 
     /// @brief The mass in kilogram.
     /// 
-    using Mass = double;
+    using Mass = Quantity<dim::MASS>;
 
     /// @brief Convert kilogram to kilogram.
     /// @param m mass in kilogram
     /// @return `Mass` in kilogram
     /// 
-    inline constexpr auto operator"" _kg(long double m) noexcept -> Mass { return m; }
+    inline constexpr auto operator"" _kg(long double m) noexcept -> Mass { return Mass(m); }
 
     /// @brief Convert ton to kilogram.
     /// @param m mass in ton
     /// @return `Mass` in kilogram
     /// 
-    inline constexpr auto operator"" _t(long double m) noexcept -> Mass { return m * 1e3; }
+    inline constexpr auto operator"" _t(long double m) noexcept -> Mass { return Mass(m * 1e3); }
 
     /// @brief Convert gram to kilogram.
     /// @param m mass in gram
     /// @return `Mass` in kilogram
     /// 
-    inline constexpr auto operator"" _g(long double m) noexcept -> Mass { return m * 1e-3; }
+    inline constexpr auto operator"" _g(long double m) noexcept -> Mass { return Mass(m * 1e-3); }
 
     /// @brief Convert pound to kilogram.
     /// @param m mass in pound
     /// @return `Mass` in kilogram
     /// 
-    inline constexpr auto operator"" _lbs(long double m) noexcept -> Mass { return m * 0.4535924; }
+    inline constexpr auto operator"" _lbs(long double m) noexcept -> Mass { return Mass(m * 0.4535924); }
 
     /// @brief The time in second.
     /// 
-    using Time = double;
+    using Time = Quantity<dim::TIME>;
 
     /// @brief Convert second to second.
     /// @param t time in second
     /// @return `Time` in second
     /// 
-    inline constexpr auto operator"" _s(long double t) noexcept -> Time { return t ; }
+    inline constexpr auto operator"" _s(long double t) noexcept -> Time { return Time(t); }
 
     /// @brief Convert milisecond to second.
     /// @param t time in milisecond
     /// @return `Time` in second
     /// 
-    inline constexpr auto operator"" _ms(long double t) noexcept -> Time { return t * 1e-3; }
+    inline constexpr auto operator"" _ms(long double t) noexcept -> Time { return Time(t * 1e-3); }
 
     /// @brief Convert microsecond to second.
     /// @param t time in microsecond
     /// @return `Time` in second
     /// 
-    inline constexpr auto operator"" _us(long double t) noexcept -> Time { return t * 1e-6; }
+    inline constexpr auto operator"" _us(long double t) noexcept -> Time { return Time(t * 1e-6); }
 
     /// @brief Convert nanosecond to second.
     /// @param t time in nanosecond
     /// @return `Time` in second
     /// 
-    inline constexpr auto operator"" _ns(long double t) noexcept -> Time { return t * 1e-9; }
+    inline constexpr auto operator"" _ns(long double t) noexcept -> Time { return Time(t * 1e-9); }
 
     /// @brief Convert minute to second.
     /// @param t time in minute
     /// @return `Time` in second
     /// 
-    inline constexpr auto operator"" _min(long double t) noexcept -> Time { return t * 60; }
+    inline constexpr auto operator"" _min(long double t) noexcept -> Time { return Time(t * 60); }
 
     /// @brief Convert hour to second.
     /// @param t time in hour
     /// @return `Time` in second
     /// 
-    inline constexpr auto operator"" _h(long double t) noexcept -> Time { return t * 3600; }
+    inline constexpr auto operator"" _h(long double t) noexcept -> Time { return Time(t * 3600); }
 
     /// @brief Convert day to second.
     /// @note A day here is strictly equal to 24 hours.
     /// @param t time in day
     /// @return `Time` in second
     /// 
-    inline constexpr auto operator"" _d(long double t) noexcept -> Time { return t * 86400; }
+    inline constexpr auto operator"" _d(long double t) noexcept -> Time { return Time(t * 86400); }
 
     /// @brief Convert year to second.
     /// @note A year here is strictly equal to 365.25 days.
     /// @param t time in day
     /// @return `Time` in second
     /// 
-    inline constexpr auto operator"" _yr(long double t) noexcept -> Time { return t * 3.15576E7; }
+    inline constexpr auto operator"" _yr(long double t) noexcept -> Time { return Time(t * 3.15576E7); }
 
-    using Impulse = double;
+    using Impulse = Quantity<dim::MASS * dim::LENGTH / dim::TIME>;
 
     using Momentum = Impulse;
 
     /// @brief The force in Newton.
     /// 
-    using Force = double;
+    using Force = Quantity<dim::MASS * dim::LENGTH / (dim::TIME * dim::TIME)>;
 
     /// @brief Convert Newton to Newton.
     /// @param f force in Newton
     /// @return `Force` in Newton
     /// 
-    inline constexpr auto operator"" _N(long double f) noexcept -> Force { return f; }
+    inline constexpr auto operator"" _N(long double f) noexcept -> Force { return Force(f); }
 
     /// @brief The work in Joule.
     /// 
-    using Work = double;
+    using Work = Quantity<dim::MASS * dim::LENGTH * dim::LENGTH / (dim::TIME * dim::TIME)>;
 
     /// @brief Convert Joule to Joule.
     /// @param w work in Joule
     /// @return `Work` in Joule
     /// 
-    inline constexpr auto operator"" _J(long double w) noexcept -> Work { return w; }
+    inline constexpr auto operator"" _J(long double w) noexcept -> Work { return Work(w); }
 
     /// @brief Convert kilojoule to Joule.
     /// @param w work in kilojoule
     /// @return `Work` in Joule
     /// 
-    inline constexpr auto operator"" _kJ(long double w) noexcept -> Work { return w * 1e3; }
+    inline constexpr auto operator"" _kJ(long double w) noexcept -> Work { return Work(w * 1e3); }
 
     /// @brief Convert megajoule to Joule.
     /// @param w work in megajoule
     /// @return `Work` in Joule
     /// 
-    inline constexpr auto operator"" _MJ(long double w) noexcept -> Work { return w * 1e6; }
+    inline constexpr auto operator"" _MJ(long double w) noexcept -> Work { return Work(w * 1e6); }
 
     /// @brief Convert gigajoule to Joule.
     /// @param w work in gigajoule
     /// @return `Work` in Joule
     /// 
-    inline constexpr auto operator"" _GJ(long double w) noexcept -> Work { return w * 1e9; }
+    inline constexpr auto operator"" _GJ(long double w) noexcept -> Work { return Work(w * 1e9); }
 
     /// @brief Convert terajoule to Joule.
     /// @param w work in terajoule
     /// @return `Work` in Joule
     /// 
-    inline constexpr auto operator"" _TJ(long double w) noexcept -> Work { return w * 1e12; }
+    inline constexpr auto operator"" _TJ(long double w) noexcept -> Work { return Work(w * 1e12); }
 
     /// @brief Convert calorie to Joule.
     /// @param w work in calorie
     /// @return `Work` in Joule
     /// 
-    inline constexpr auto operator"" _cal(long double w) noexcept -> Work { return w * 4.184; }
+    inline constexpr auto operator"" _cal(long double w) noexcept -> Work { return Work(w * 4.184); }
 
     using Energy = Work;
 
     /// @brief The current in ampere.
     /// 
-    using Current = double;
+    using Current = Quantity<dim::CURRENT>;
 
     /// @brief Convert Ampere to Ampere.
     /// @param i current in Ampere
     /// @return `Current` in Ampere
     /// 
-    inline constexpr auto operator"" _A(long double i) noexcept -> Current { return i; }
+    inline constexpr auto operator"" _A(long double i) noexcept -> Current { return Current(i); }
 
     /// @brief Convert miliampere to Ampere.
     /// @param i current in miliampere
     /// @return `Current` in Ampere
     /// 
-    inline constexpr auto operator"" _mA(long double i) noexcept -> Current { return i * 1e-3; }
+    inline constexpr auto operator"" _mA(long double i) noexcept -> Current { return Current(i * 1e-3); }
 
     /// @brief The voltage in Volt.
     /// 
-    using Voltage = double;
+    using Voltage = Quantity<dim::MASS * dim::LENGTH * dim::LENGTH / (dim::TIME * dim::TIME * dim::TIME * dim::CURRENT)>;
 
     /// @brief Convert Volt to Volt
     /// @param v voltage in Volt
     /// @return `Voltage` in Volt
     /// 
-    inline constexpr auto operator"" _V(long double v) noexcept -> Voltage { return v ; }
+    inline constexpr auto operator"" _V(long double v) noexcept -> Voltage { return Voltage(v); }
 }
@@ -0,0 +1,759 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "option.cc"
+#include "thread.cc"
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <mutex>
+#include <new>
+#include <source_location>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Define `CODING_LOCK_STATS` before including the library to record wait time and contention of every lock.
+
+/// @brief Thin wrappers around the Linux futex, falling back to `std::atomic::wait` elsewhere.
+///
+namespace coding::thread::futex {
+
+    /// @brief Sleep while `*word == expected`.
+    /// @note Spurious wake-ups are possible, always re-check the condition.
+    /// @param word the futex word
+    /// @param expected the value to sleep on
+    ///
+    inline auto wait(std::atomic<u32>& word, u32 expected) noexcept {
+#ifdef __linux__
+        syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+        word.wait(expected, std::memory_order_relaxed);
+#endif
+    }
+
+    /// @brief Sleep while `*word == expected`, for at most `timeout`.
+    /// @note Spurious wake-ups are possible, always re-check the condition.
+    /// @param word the futex word
+    /// @param expected the value to sleep on
+    /// @param timeout the longest time to sleep
+    ///
+    inline auto wait_for(std::atomic<u32>& word, u32 expected, std::chrono::nanoseconds timeout) noexcept {
+#ifdef __linux__
+        auto ts = timespec{ (time_t)(timeout.count() / 1000000000), (long)(timeout.count() % 1000000000) };
+        syscall(SYS_futex, &word, FUTEX_WAIT_PRIVATE, expected, &ts, nullptr, 0);
+#else
+        if (word.load(std::memory_order_relaxed) == expected) std::this_thread::sleep_for(std::min(timeout, std::chrono::nanoseconds(1000000)));
+#endif
+    }
+
+    /// @brief Wake at most `n` threads sleeping on `word`.
+    /// @param word the futex word
+    /// @param n number of threads to wake
+    ///
+    inline auto wake(std::atomic<u32>& word, u32 n = 1) noexcept {
+#ifdef __linux__
+        syscall(SYS_futex, &word, FUTEX_WAKE_PRIVATE, n, nullptr, nullptr, 0);
+#else
+        if (n == 1) word.notify_one();
+        else word.notify_all();
+#endif
+    }
+
+    /// @brief Wake every thread sleeping on `word`.
+    /// @param word the futex word
+    ///
+    inline auto wake_all(std::atomic<u32>& word) noexcept {
+        wake(word, INT_MAX);
+    }
+}
+
+namespace coding::thread {
+
+    /// @brief Hint the processor that we are in a spin loop.
+    ///
+    inline auto relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    /// @brief A one-shot completion flag, for a waiter that owns it and may drop it as soon as `wait` returns.
+    ///
+    /// `set` wakes the waiter before marking the flag released, and `wait` returns only once it is released,
+    /// so the setting thread never touches the flag after its owner may have freed it.
+    ///
+    class Done final {
+
+    private:
+
+        /// @brief `0` while pending, `1` while `set` is still waking the waiter, `2` once released.
+        ///
+        std::atomic<u32> state = 0;
+
+    public:
+
+        /// @brief Mark done and wake the waiter, last touching the flag with the release.
+        ///
+        inline auto set() noexcept -> void {
+            this->state.store(1, std::memory_order_release);
+            futex::wake(this->state);
+            this->state.store(2, std::memory_order_release);
+        }
+
+        /// @brief Whether `set` has finished, and the flag may be dropped.
+        ///
+        inline auto is_set() const noexcept -> bool {
+            return this->state.load(std::memory_order_acquire) == 2;
+        }
+
+        /// @brief Sleep until `set`, then spin through the few instructions of its wake-up.
+        ///
+        inline auto wait() noexcept -> void {
+            for (auto spins = 0;;) {
+                auto s = this->state.load(std::memory_order_acquire);
+                if (s == 2) return;
+                if (s == 0) futex::wait(this->state, 0);
+                else if (spins++ < 64) relax();
+                else std::this_thread::yield();
+            }
+        }
+    };
+
+    /// @brief Contention counters of a single lock, only recorded with `CODING_LOCK_STATS`.
+    ///
+    struct LockStats final {
+
+        /// @brief Where the lock was constructed, identifying it in reports.
+        ///
+        std::source_location location;
+
+        /// @brief Number of successful acquisitions.
+        ///
+        std::atomic<u64> acquisitions = 0;
+
+        /// @brief Number of acquisitions that could not take the fast path.
+        ///
+        std::atomic<u64> contentions = 0;
+
+        /// @brief Total time spent waiting in nanoseconds.
+        ///
+        std::atomic<u64> wait_ns = 0;
+
+        /// @brief The longest single wait in nanoseconds.
+        ///
+        std::atomic<u64> max_wait_ns = 0;
+
+        /// @brief Intrusive links of the global registry.
+        ///
+        LockStats* prev = nullptr;
+        LockStats* next = nullptr;
+
+        inline LockStats(std::source_location location) noexcept : location(location) {
+            auto _ = std::lock_guard(registry());
+            this->next = head();
+            if (this->next) this->next->prev = this;
+            head() = this;
+        }
+
+        LockStats(LockStats const&) = delete;
+
+        inline ~LockStats() noexcept {
+            auto _ = std::lock_guard(registry());
+            if (this->prev) this->prev->next = this->next;
+            else head() = this->next;
+            if (this->next) this->next->prev = this->prev;
+        }
+
+        /// @brief Record a contended acquisition.
+        /// @param ns time waited in nanoseconds
+        ///
+        inline auto record(u64 ns) noexcept {
+            this->contentions.fetch_add(1, std::memory_order_relaxed);
+            this->wait_ns.fetch_add(ns, std::memory_order_relaxed);
+            auto max = this->max_wait_ns.load(std::memory_order_relaxed);
+            while (ns > max && !this->max_wait_ns.compare_exchange_weak(max, ns, std::memory_order_relaxed));
+        }
+
+        /// @brief Visit the stats of every live lock, e.g. to dump the hottest ones.
+        /// @tparam F the visitor type
+        /// @param f visitor called with `LockStats const&`
+        ///
+        template<typename F>
+        inline static auto for_each(F f) {
+            auto _ = std::lock_guard(registry());
+            for (auto p = head(); p; p = p->next) f(*(LockStats const*)p);
+        }
+
+    private:
+
+        inline static auto registry() noexcept -> std::mutex& {
+            static std::mutex m;
+            return m;
+        }
+
+        inline static auto head() noexcept -> LockStats*& {
+            static LockStats* h = nullptr;
+            return h;
+        }
+    };
+
+    /// @brief Measures a slow-path wait when lock stats are enabled, does nothing otherwise.
+    ///
+    struct WaitTimer final {
+#ifdef CODING_LOCK_STATS
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        inline auto finish(LockStats& stats) const noexcept {
+            auto d = std::chrono::steady_clock::now() - this->start;
+            stats.record((u64)std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        }
+#endif
+    };
+
+    /// @brief A futex-based mutual exclusion primitive without data, the building block of `Mutex<T>`.
+    ///
+    /// The lock word is `0` when unlocked, `1` when locked and `2` when locked with possible sleepers.
+    /// Before sleeping, a contended `lock()` spins for a number of rounds that adapts to how long
+    /// the lock has recently been held, so short critical sections never reach the kernel.
+    ///
+    class RawMutex final {
+
+    private:
+
+        /// @brief The futex word.
+        ///
+        std::atomic<u32> state = 0;
+
+        /// @brief Running average of spin rounds needed to acquire, drives adaptive spinning.
+        ///
+        std::atomic<u32> spins = 0;
+
+        /// @brief Upper bound of spinning rounds before sleeping.
+        ///
+        constexpr static u32 MAX_SPIN = 100;
+
+#ifdef CODING_LOCK_STATS
+    public:
+        LockStats stats;
+#endif
+
+        inline auto lock_slow() noexcept {
+            [[maybe_unused]] auto timer = WaitTimer();
+            auto spins = this->spins.load(std::memory_order_relaxed);
+            auto limit = std::min(spins * 2 + 10, MAX_SPIN);
+            auto n = 0u;
+            for (; n < limit; n++) {
+                auto s = this->state.load(std::memory_order_relaxed);
+                if (s == 0 && this->state.compare_exchange_weak(s, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+                    this->spins.store(spins + ((i32)n - (i32)spins) / 8, std::memory_order_relaxed);
+#ifdef CODING_LOCK_STATS
+                    timer.finish(this->stats);
+#endif
+                    return;
+                }
+                if (s == 2) break;
+                relax();
+            }
+            this->spins.store(spins + ((i32)limit - (i32)spins) / 8, std::memory_order_relaxed);
+            while (this->state.exchange(2, std::memory_order_acquire) != 0) futex::wait(this->state, 2);
+#ifdef CODING_LOCK_STATS
+            timer.finish(this->stats);
+#endif
+        }
+
+    public:
+
+#ifdef CODING_LOCK_STATS
+        inline RawMutex(std::source_location location = std::source_location::current()) noexcept : stats(location) {}
+#else
+        inline constexpr RawMutex(std::source_location = std::source_location::current()) noexcept {}
+#endif
+
+        RawMutex(RawMutex const&) = delete;
+
+        /// @brief Acquire the lock, blocking the current thread until it is available.
+        ///
+        inline auto lock() noexcept {
+            auto expected = 0u;
+            if (!this->state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed)) this->lock_slow();
+#ifdef CODING_LOCK_STATS
+            this->stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+#endif
+        }
+
+        /// @brief Try to acquire the lock without blocking.
+        /// @return whether the lock is acquired
+        ///
+        inline auto try_lock() noexcept -> bool {
+            auto expected = 0u;
+            auto ok = this->state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
+#ifdef CODING_LOCK_STATS
+            if (ok) this->stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+#endif
+            return ok;
+        }
+
+        /// @brief Release the lock.
+        /// @warning The behaviour is undefined unless the lock is held by the caller.
+        ///
+        inline auto unlock() noexcept {
+            if (this->state.exchange(0, std::memory_order_release) == 2) futex::wake(this->state);
+        }
+
+        /// @brief Whether the lock is currently held by anyone.
+        ///
+        inline auto is_locked() const noexcept -> bool {
+            return this->state.load(std::memory_order_relaxed) != 0;
+        }
+    };
+
+    template<typename T> class Mutex;
+
+    /// @brief RAII access to the data protected by a `Mutex`, unlocks when dropped.
+    /// @tparam T the protected type
+    ///
+    template<typename T>
+    class MutexGuard final {
+
+    private:
+
+        Mutex<T>* m;
+
+        inline constexpr MutexGuard(Mutex<T>* m) noexcept : m(m) {}
+
+        friend class Mutex<T>;
+
+    public:
+
+        MutexGuard(MutexGuard const&) = delete;
+
+        inline constexpr MutexGuard(MutexGuard&& other) noexcept : m(other.m) {
+            other.m = nullptr;
+        }
+
+        inline ~MutexGuard() noexcept {
+            if (this->m) this->m->raw.unlock();
+        }
+
+        inline constexpr auto operator*() const noexcept -> T& {
+            return this->m->data;
+        }
+
+        inline constexpr auto operator->() const noexcept -> T* {
+            return &this->m->data;
+        }
+    };
+
+    /// @brief A mutual exclusion lock that owns its data. Acts like Rust's `std::sync::Mutex`.
+    ///
+    /// The data can only be reached through the `MutexGuard` returned by `lock()`.
+    /// The lock itself takes one word: a futex and its adaptive spin estimate.
+    ///
+    /// @tparam T the protected type
+    ///
+    template<typename T>
+    class Mutex final {
+
+    private:
+
+        RawMutex raw;
+
+        T data;
+
+        friend class MutexGuard<T>;
+
+    public:
+
+        /// @brief Construct with the initial value.
+        /// @param value the protected value
+        ///
+        inline constexpr Mutex(T value, std::source_location location = std::source_location::current()) noexcept
+            : raw(location), data(mv(value)) {}
+
+        /// @brief Construct with a default value.
+        ///
+        inline constexpr Mutex(std::source_location location = std::source_location::current()) noexcept
+            requires std::default_initializable<T>
+        : raw(location), data() {}
+
+        Mutex(Mutex const&) = delete;
+
+        /// @brief Acquire the lock, blocking the current thread until it is available.
+        /// @return the guard to access the data
+        ///
+        [[nodiscard]] inline auto lock() noexcept -> MutexGuard<T> {
+            this->raw.lock();
+            return MutexGuard<T>(this);
+        }
+
+        /// @brief Try to acquire the lock without blocking.
+        /// @return the guard, or `None` if the lock is held
+        ///
+        [[nodiscard]] inline auto try_lock() noexcept -> Option<MutexGuard<T>> {
+            if (!this->raw.try_lock()) return Option<MutexGuard<T>>();
+            return Option<MutexGuard<T>>(MutexGuard<T>(this));
+        }
+
+        /// @brief Access the data without locking.
+        /// @warning The caller must guarantee no other thread holds or acquires the lock meanwhile.
+        /// @return the data
+        ///
+        inline constexpr auto get_mut() noexcept -> T& {
+            return this->data;
+        }
+
+#ifdef CODING_LOCK_STATS
+        /// @brief Contention counters of this lock.
+        ///
+        inline auto stats() const noexcept -> LockStats const& {
+            return this->raw.stats;
+        }
+#endif
+    };
+
+    /// @brief A writer-preferring reader-writer lock without data, the building block of `RwLock<T>`.
+    ///
+    /// Readers announce themselves on one of several cache-line padded counters picked by `thread::index()`,
+    /// so concurrent readers on different cores never write the same cache line.
+    /// A writer serializes against other writers with a `RawMutex`, raises the `writer` flag
+    /// and sleeps until every reader counter drains to zero. New readers wait while the flag is up,
+    /// so a stream of readers never starves a writer, but a stream of writers can starve readers.
+    ///
+    class RawRwLock final {
+
+    private:
+
+        /// @brief A reader counter on its own cache line.
+        ///
+        struct alignas(CACHE_LINE) Slot {
+            std::atomic<isize> readers = 0;
+        };
+
+        /// @brief Serializes writers.
+        ///
+        RawMutex writers;
+
+        /// @brief `1` while a writer holds or is acquiring the lock, readers sleep on it.
+        ///
+        std::atomic<u32> writer = 0;
+
+        /// @brief Bumped by readers leaving while a writer waits, the writer sleeps on it.
+        ///
+        std::atomic<u32> drained = 0;
+
+        /// @brief Per-core reader counters.
+        ///
+        Slot* slots;
+
+        /// @brief `slots` length minus one, the length is a power of 2.
+        ///
+        usize mask;
+
+#ifdef CODING_LOCK_STATS
+    public:
+        LockStats read_stats;
+    private:
+#endif
+
+        inline static auto slot_count() noexcept -> usize {
+            auto n = (usize)std::thread::hardware_concurrency();
+            auto p = (usize)1;
+            while (p < n) p <<= 1;
+            return p;
+        }
+
+        inline auto leave(Slot* slot) noexcept {
+            slot->readers.fetch_sub(1, std::memory_order_seq_cst);
+            if (this->writer.load(std::memory_order_seq_cst)) {
+                this->drained.fetch_add(1, std::memory_order_release);
+                futex::wake(this->drained);
+            }
+        }
+
+        inline auto readers() const noexcept -> isize {
+            auto sum = (isize)0;
+            for (auto i = (usize)0; i <= this->mask; i++) sum += this->slots[i].readers.load(std::memory_order_seq_cst);
+            return sum;
+        }
+
+    public:
+
+#ifdef CODING_LOCK_STATS
+        inline RawRwLock(std::source_location location = std::source_location::current()) noexcept
+            : writers(location), slots(new Slot[slot_count()]), mask(slot_count() - 1), read_stats(location) {}
+#else
+        inline RawRwLock(std::source_location location = std::source_location::current()) noexcept
+            : writers(location), slots(new Slot[slot_count()]), mask(slot_count() - 1) {}
+#endif
+
+        RawRwLock(RawRwLock const&) = delete;
+
+        inline ~RawRwLock() noexcept {
+            delete[] this->slots;
+        }
+
+        /// @brief Acquire shared access.
+        /// @return the counter to pass back to `unlock_shared()`
+        ///
+        inline auto lock_shared() noexcept -> void* {
+            auto slot = &this->slots[thread::index() & this->mask];
+            slot->readers.fetch_add(1, std::memory_order_seq_cst);
+            if (!this->writer.load(std::memory_order_seq_cst)) [[likely]] {
+#ifdef CODING_LOCK_STATS
+                this->read_stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+#endif
+                return slot;
+            }
+            [[maybe_unused]] auto timer = WaitTimer();
+            loop {
+                this->leave(slot);
+                while (this->writer.load(std::memory_order_acquire)) futex::wait(this->writer, 1);
+                slot->readers.fetch_add(1, std::memory_order_seq_cst);
+                if (!this->writer.load(std::memory_order_seq_cst)) break;
+            }
+#ifdef CODING_LOCK_STATS
+            timer.finish(this->read_stats);
+            this->read_stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+#endif
+            return slot;
+        }
+
+        /// @brief Try to acquire shared access without blocking.
+        /// @return the counter to pass back to `unlock_shared()`, or `nullptr` if a writer holds or awaits the lock
+        ///
+        inline auto try_lock_shared() noexcept -> void* {
+            auto slot = &this->slots[thread::index() & this->mask];
+            slot->readers.fetch_add(1, std::memory_order_seq_cst);
+            if (this->writer.load(std::memory_order_seq_cst)) {
+                this->leave(slot);
+                return nullptr;
+            }
+#ifdef CODING_LOCK_STATS
+            this->read_stats.acquisitions.fetch_add(1, std::memory_order_relaxed);
+#endif
+            return slot;
+        }
+
+        /// @brief Release shared access.
+        /// @param slot the value returned by `lock_shared()`
+        ///
+        inline auto unlock_shared(void* slot) noexcept {
+            this->leave((Slot*)slot);
+        }
+
+        /// @brief Acquire exclusive access, waiting for every reader to leave.
+        ///
+        inline auto lock() noexcept {
+            this->writers.lock();
+            this->writer.store(1, std::memory_order_seq_cst);
+            auto n = 0u;
+            loop {
+                auto seen = this->drained.load(std::memory_order_acquire);
+                if (this->readers() == 0) break;
+                if (n++ < 64) relax();
+                else futex::wait(this->drained, seen);
+            }
+        }
+
+        /// @brief Release exclusive access.
+        ///
+        inline auto unlock() noexcept {
+            this->writer.store(0, std::memory_order_release);
+            futex::wake_all(this->writer);
+            this->writers.unlock();
+        }
+
+        /// @brief Try to acquire exclusive access without blocking.
+        /// @return whether the lock is acquired, `false` if any reader or writer holds it
+        ///
+        inline auto try_lock() noexcept -> bool {
+            if (!this->writers.try_lock()) return false;
+            this->writer.store(1, std::memory_order_seq_cst);
+            if (this->readers() == 0) return true;
+            this->unlock();
+            return false;
+        }
+
+#ifdef CODING_LOCK_STATS
+        inline auto write_stats() const noexcept -> LockStats const& {
+            return this->writers.stats;
+        }
+#endif
+    };
+
+    template<typename T> class RwLock;
+
+    /// @brief RAII shared access to the data protected by a `RwLock`.
+    /// @tparam T the protected type
+    ///
+    template<typename T>
+    class RwLockReadGuard final {
+
+    private:
+
+        RwLock<T>* l;
+
+        void* slot;
+
+        inline constexpr RwLockReadGuard(RwLock<T>* l, void* slot) noexcept : l(l), slot(slot) {}
+
+        friend class RwLock<T>;
+
+    public:
+
+        RwLockReadGuard(RwLockReadGuard const&) = delete;
+
+        inline constexpr RwLockReadGuard(RwLockReadGuard&& other) noexcept : l(other.l), slot(other.slot) {
+            other.l = nullptr;
+        }
+
+        inline ~RwLockReadGuard() noexcept {
+            if (this->l) this->l->raw.unlock_shared(this->slot);
+        }
+
+        inline constexpr auto operator*() const noexcept -> T const& {
+            return this->l->data;
+        }
+
+        inline constexpr auto operator->() const noexcept -> T const* {
+            return &this->l->data;
+        }
+    };
+
+    /// @brief RAII exclusive access to the data protected by a `RwLock`.
+    /// @tparam T the protected type
+    ///
+    template<typename T>
+    class RwLockWriteGuard final {
+
+    private:
+
+        RwLock<T>* l;
+
+        inline constexpr RwLockWriteGuard(RwLock<T>* l) noexcept : l(l) {}
+
+        friend class RwLock<T>;
+
+    public:
+
+        RwLockWriteGuard(RwLockWriteGuard const&) = delete;
+
+        inline constexpr RwLockWriteGuard(RwLockWriteGuard&& other) noexcept : l(other.l) {
+            other.l = nullptr;
+        }
+
+        inline ~RwLockWriteGuard() noexcept {
+            if (this->l) this->l->raw.unlock();
+        }
+
+        inline constexpr auto operator*() const noexcept -> T& {
+            return this->l->data;
+        }
+
+        inline constexpr auto operator->() const noexcept -> T* {
+            return &this->l->data;
+        }
+    };
+
+    /// @brief A writer-preferring reader-writer lock that owns its data. Acts like Rust's `std::sync::RwLock`.
+    /// @note Readers never contend with each other, writers pay for draining every per-core counter.
+    /// A waiting writer holds off new readers, so readers cannot starve writers, only the other way around.
+    /// Prefer `Mutex` unless reads vastly outnumber writes.
+    /// @tparam T the protected type
+    ///
+    template<typename T>
+    class RwLock final {
+
+    private:
+
+        RawRwLock raw;
+
+        T data;
+
+        friend class RwLockReadGuard<T>;
+        friend class RwLockWriteGuard<T>;
+
+    public:
+
+        /// @brief Construct with the initial value.
+        /// @param value the protected value
+        ///
+        inline RwLock(T value, std::source_location location = std::source_location::current()) noexcept
+            : raw(location), data(mv(value)) {}
+
+        /// @brief Construct with a default value.
+        ///
+        inline RwLock(std::source_location location = std::source_location::current()) noexcept
+            requires std::default_initializable<T>
+        : raw(location), data() {}
+
+        RwLock(RwLock const&) = delete;
+
+        /// @brief Acquire shared access, blocking while a writer holds the lock.
+        /// @return the guard to read the data
+        ///
+        [[nodiscard]] inline auto read() noexcept -> RwLockReadGuard<T> {
+            return RwLockReadGuard<T>(this, this->raw.lock_shared());
+        }
+
+        /// @brief Acquire exclusive access, blocking until every reader and writer leaves.
+        /// @return the guard to modify the data
+        ///
+        [[nodiscard]] inline auto write() noexcept -> RwLockWriteGuard<T> {
+            this->raw.lock();
+            return RwLockWriteGuard<T>(this);
+        }
+
+        /// @brief Try to acquire shared access without blocking.
+        /// @return the guard, or `None` if a writer holds or awaits the lock
+        ///
+        [[nodiscard]] inline auto try_read() noexcept -> Option<RwLockReadGuard<T>> {
+            auto slot = this->raw.try_lock_shared();
+            if (!slot) return Option<RwLockReadGuard<T>>();
+            return Option<RwLockReadGuard<T>>(RwLockReadGuard<T>(this, slot));
+        }
+
+        /// @brief Try to acquire exclusive access without blocking.
+        /// @return the guard, or `None` if any reader or writer holds the lock
+        ///
+        [[nodiscard]] inline auto try_write() noexcept -> Option<RwLockWriteGuard<T>> {
+            if (!this->raw.try_lock()) return Option<RwLockWriteGuard<T>>();
+            return Option<RwLockWriteGuard<T>>(RwLockWriteGuard<T>(this));
+        }
+
+        /// @brief Access the data without locking.
+        /// @warning The caller must guarantee no other thread holds or acquires the lock meanwhile.
+        /// @return the data
+        ///
+        inline constexpr auto get_mut() noexcept -> T& {
+            return this->data;
+        }
+
+#ifdef CODING_LOCK_STATS
+        /// @brief Contention counters of readers.
+        ///
+        inline auto read_stats() const noexcept -> LockStats const& {
+            return this->raw.read_stats;
+        }
+
+        /// @brief Contention counters of writers.
+        ///
+        inline auto write_stats() const noexcept -> LockStats const& {
+            return this->raw.write_stats();
+        }
+#endif
+    };
+}
@@ -57,6 +57,11 @@ namespace coding {
         ///
         inline constexpr Option(T const&& value) noexcept : tag(Some), value(value) {}
 
+        /// @brief Construct a `Some` value by moving.
+        /// @param value the value with
+        ///
+        inline constexpr Option(T&& value) noexcept : tag(Some), value(mv(value)) {}
+
         /// @brief Implicitly cast to `Tag`.
         /// This allows `switch`ing directly on the `Option`.
         /// 
@@ -84,6 +89,18 @@ namespace coding {
             return std::get<T>(this->value);
         }
 
+        /// @brief Unwrap the `Option` to a `Some` value, moving it out.
+        /// @return the value
+        ///
+        /// # Panic
+        ///
+        /// Panics if the value is `None`.
+        ///
+        inline auto unwrap() && noexcept -> T {
+            if (this->is_none()) panic("unwrap on `None` value");
+            return mv(std::get<T>(this->value));
+        }
+
         /// @brief Unwrap the `Option` to a `Some` value.
         /// @return the value
         ///
@@ -0,0 +1,442 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "pool.cc"
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/// @brief Data-parallel iterators on the work-stealing `thread::ThreadPool`. Acts like Rust's `rayon`.
+///
+/// Adapters like `map` and `filter` do not run anything: they fuse into one per-element pipeline,
+/// so `par_iter(v).map(f).filter(p).sum()` visits every element once without intermediate vectors.
+/// The terminal operation splits the source in halves through `ThreadPool::join` until every worker
+/// is busy; a piece that gets stolen splits further, so uneven work still balances.
+///
+namespace coding::par {
+
+    using thread::ThreadPool;
+
+    /// @brief Decides when to stop splitting, adapting to whether work is being stolen.
+    ///
+    struct Splitter final {
+
+        /// @brief How many more times to split before running sequentially.
+        ///
+        usize splits;
+
+        /// @brief Never split into pieces shorter than this.
+        ///
+        usize min_len;
+
+        usize threads;
+
+        /// @brief Decide whether to split a piece.
+        /// @param len length of the piece
+        /// @param migrated whether the piece was just stolen
+        /// @return whether to split
+        ///
+        inline auto try_split(usize len, bool migrated) noexcept -> bool {
+            if (len < 2 || len / 2 < this->min_len) return false;
+            if (migrated) {
+                this->splits = std::max(this->splits / 2, this->threads);
+                return true;
+            }
+            if (this->splits == 0) return false;
+            this->splits /= 2;
+            return true;
+        }
+    };
+
+    /// @brief Source over a contiguous slice, producing `T&`.
+    /// @tparam T the element type, possibly `const`
+    ///
+    template<typename T>
+    struct SliceSource final {
+
+        using Item = T&;
+
+        T* p;
+
+        usize n;
+
+        inline constexpr auto len() const noexcept -> usize {
+            return this->n;
+        }
+
+        inline constexpr auto split(usize mid) const noexcept -> std::pair<SliceSource, SliceSource> {
+            return { SliceSource{ this->p, mid }, SliceSource{ this->p + mid, this->n - mid } };
+        }
+
+        template<typename F>
+        inline constexpr auto for_each(F&& f) const noexcept {
+            for (auto i = (usize)0; i < this->n; i++) f(this->p[i]);
+        }
+    };
+
+    /// @brief Source over a half-open range of indices, producing `usize`.
+    ///
+    struct RangeSource final {
+
+        using Item = usize;
+
+        usize a;
+
+        usize b;
+
+        inline constexpr auto len() const noexcept -> usize {
+            return this->b - this->a;
+        }
+
+        inline constexpr auto split(usize mid) const noexcept -> std::pair<RangeSource, RangeSource> {
+            return { RangeSource{ this->a, this->a + mid }, RangeSource{ this->a + mid, this->b } };
+        }
+
+        template<typename F>
+        inline constexpr auto for_each(F&& f) const noexcept {
+            for (auto i = this->a; i < this->b; i++) f(i);
+        }
+    };
+
+    /// @brief Source over consecutive chunks of a slice, producing `std::span<T>`.
+    /// @note The last chunk may be shorter.
+    /// @tparam T the element type, possibly `const`
+    ///
+    template<typename T>
+    struct ChunkSource final {
+
+        using Item = std::span<T>;
+
+        T* p;
+
+        usize n;
+
+        usize size;
+
+        inline constexpr auto len() const noexcept -> usize {
+            return (this->n + this->size - 1) / this->size;
+        }
+
+        inline constexpr auto split(usize mid) const noexcept -> std::pair<ChunkSource, ChunkSource> {
+            auto k = std::min(mid * this->size, this->n);
+            return { ChunkSource{ this->p, k, this->size }, ChunkSource{ this->p + k, this->n - k, this->size } };
+        }
+
+        template<typename F>
+        inline constexpr auto for_each(F&& f) const noexcept {
+            for (auto i = (usize)0; i < this->n; i += this->size) f(std::span<T>(this->p + i, std::min(this->size, this->n - i)));
+        }
+    };
+
+    /// @brief Recursively split `src` and fold every leaf, combining results in order.
+    /// @tparam Acc the accumulator type
+    /// @param pool the pool to run on
+    /// @param src the source
+    /// @param sp the splitter state
+    /// @param migrated whether this piece was just stolen
+    /// @param leaf sequentially folds a source into `Acc`
+    /// @param combine combines the results of the left and right halves
+    /// @return the combined result
+    ///
+    template<typename Acc, typename Src, typename Leaf, typename Combine>
+    inline auto drive(ThreadPool& pool, Src src, Splitter sp, bool migrated, Leaf const& leaf, Combine const& combine) noexcept -> Acc {
+        auto len = src.len();
+        if (!sp.try_split(len, migrated)) return leaf(src);
+        auto [l, r] = src.split(len / 2);
+        auto [a, b] = pool.join(
+            [&]() { return drive<Acc>(pool, l, sp, false, leaf, combine); },
+            [&]() { return drive<Acc>(pool, r, sp, ThreadPool::migrated, leaf, combine); }
+        );
+        return combine(mv(a), mv(b));
+    }
+
+    /// @brief A lazy parallel iterator. Build it with `par_iter`, `par_range` or `par_chunks`.
+    /// @tparam Src the source type
+    /// @tparam Item the type of elements after every adapter
+    /// @tparam Pipe the fused adapters, called as `pipe(item, sink)`
+    ///
+    template<typename Src, typename Item, typename Pipe>
+    class ParIter final {
+
+    private:
+
+        Src src;
+
+        Pipe pipe;
+
+        ThreadPool* pool;
+
+        usize min_len = 1;
+
+        template<typename, typename, typename> friend class ParIter;
+
+        template<typename Acc, typename Id, typename Fold, typename Combine>
+        inline auto run(Id const& identity, Fold const& fold, Combine const& combine) const noexcept -> Acc {
+            auto& pool = *this->pool;
+            auto const& pipe = this->pipe;
+            auto leaf = [&](Src const& s) {
+                Acc acc = identity();
+                s.for_each([&](typename Src::Item x) {
+                    pipe(std::forward<typename Src::Item>(x), [&](Item y) { fold(acc, std::forward<Item>(y)); });
+                });
+                return acc;
+            };
+            auto threads = pool.threads_count();
+            return pool.install([&]() {
+                return drive<Acc>(pool, this->src, Splitter{ threads, this->min_len, threads }, false, leaf, combine);
+            });
+        }
+
+    public:
+
+        inline constexpr ParIter(Src src, Pipe pipe, ThreadPool* pool, usize min_len = 1) noexcept
+            : src(src), pipe(mv(pipe)), pool(pool), min_len(min_len) {}
+
+        /// @brief Transform every element.
+        /// @param f the mapping, called concurrently
+        ///
+        template<typename F>
+        inline constexpr auto map(F f) const noexcept {
+            using U = std::invoke_result_t<F const&, Item>;
+            auto next = [prev = this->pipe, f = mv(f)](typename Src::Item x, auto&& sink) {
+                prev(std::forward<typename Src::Item>(x), [&](Item y) { sink(f(std::forward<Item>(y))); });
+            };
+            return ParIter<Src, U, decltype(next)>(this->src, mv(next), this->pool, this->min_len);
+        }
+
+        /// @brief Keep only elements satisfying a predicate.
+        /// @param p the predicate, called concurrently
+        ///
+        template<typename P>
+        inline constexpr auto filter(P p) const noexcept {
+            auto next = [prev = this->pipe, p = mv(p)](typename Src::Item x, auto&& sink) {
+                prev(std::forward<typename Src::Item>(x), [&](Item y) { if (p(std::as_const(y))) sink(std::forward<Item>(y)); });
+            };
+            return ParIter<Src, Item, decltype(next)>(this->src, mv(next), this->pool, this->min_len);
+        }
+
+        /// @brief Never split the source into pieces shorter than `n`, for very cheap per-element work.
+        ///
+        inline constexpr auto with_min_len(usize n) const noexcept -> ParIter {
+            return ParIter(this->src, this->pipe, this->pool, std::max(n, (usize)1));
+        }
+
+        /// @brief Run on another pool than the global one.
+        ///
+        inline constexpr auto in(ThreadPool& pool) const noexcept -> ParIter {
+            return ParIter(this->src, this->pipe, &pool, this->min_len);
+        }
+
+        /// @brief Call `f` on every element, in no particular order.
+        ///
+        template<typename F>
+        inline auto for_each(F f) const noexcept {
+            this->run<unit>(
+                []() { return unit(); },
+                [&](unit&, Item x) { f(std::forward<Item>(x)); },
+                [](unit, unit) { return unit(); }
+            );
+        }
+
+        /// @brief Reduce every element with an associative operation.
+        /// @param identity returns the identity of `op`, called once per leaf
+        /// @param op the associative operation
+        /// @return the reduced value, `identity()` if empty
+        ///
+        template<typename Id, typename Op>
+        inline auto reduce(Id identity, Op op) const noexcept {
+            using Acc = std::invoke_result_t<Id const&>;
+            return this->run<Acc>(
+                identity,
+                [&](Acc& acc, Item x) { acc = op(mv(acc), std::forward<Item>(x)); },
+                [&](Acc a, Acc b) { return op(mv(a), mv(b)); }
+            );
+        }
+
+        /// @brief Sum every element, starting from a value-initialized one.
+        ///
+        inline auto sum() const noexcept {
+            using U = std::remove_cvref_t<Item>;
+            return this->reduce([]() { return U(); }, [](U a, U const& b) { return a + b; });
+        }
+
+        /// @brief Count the elements.
+        ///
+        inline auto count() const noexcept -> usize {
+            return this->run<usize>(
+                []() { return (usize)0; },
+                [](usize& acc, Item) { acc++; },
+                [](usize a, usize b) { return a + b; }
+            );
+        }
+
+        /// @brief Collect every element into a vector, keeping their order.
+        ///
+        inline auto collect() const noexcept -> std::vector<std::remove_cvref_t<Item>> {
+            using U = std::remove_cvref_t<Item>;
+            using Parts = std::vector<std::vector<U>>;
+            auto parts = this->run<Parts>(
+                []() { return Parts(1); },
+                [](Parts& acc, Item x) { acc.back().push_back(std::forward<Item>(x)); },
+                [](Parts a, Parts b) {
+                    a.insert(a.end(), std::make_move_iterator(b.begin()), std::make_move_iterator(b.end()));
+                    return a;
+                }
+            );
+            auto total = (usize)0;
+            for (auto const& p : parts) total += p.size();
+            auto ans = std::vector<U>();
+            ans.reserve(total);
+            for (auto& p : parts) ans.insert(ans.end(), std::make_move_iterator(p.begin()), std::make_move_iterator(p.end()));
+            return ans;
+        }
+    };
+
+    /// @brief The pipeline without any adapter.
+    ///
+    struct Identity final {
+        template<typename T, typename S>
+        inline constexpr auto operator()(T&& x, S&& sink) const noexcept {
+            sink(std::forward<T>(x));
+        }
+    };
+
+    /// @brief Iterate over the elements of a contiguous range (`Vec`, `std::array`, `std::span`...) in parallel.
+    /// @warning The range must outlive the iterator.
+    /// @param r the range
+    /// @return parallel iterator producing references to the elements
+    ///
+    template<std::ranges::contiguous_range R>
+    inline auto par_iter(R&& r) noexcept {
+        using T = std::remove_reference_t<std::ranges::range_reference_t<R>>;
+        auto src = SliceSource<T>{ std::ranges::data(r), (usize)std::ranges::size(r) };
+        return ParIter<SliceSource<T>, T&, Identity>(src, Identity(), &ThreadPool::global());
+    }
+
+    /// @brief Iterate over `[a, b)` in parallel.
+    ///
+    inline auto par_range(usize a, usize b) noexcept {
+        return ParIter<RangeSource, usize, Identity>(RangeSource{ a, std::max(a, b) }, Identity(), &ThreadPool::global());
+    }
+
+    /// @brief Iterate over consecutive chunks of `size` elements in parallel.
+    /// @warning The range must outlive the iterator.
+    /// @param r the range
+    /// @param size chunk size, the last chunk may be shorter
+    /// @return parallel iterator producing `std::span`s
+    ///
+    /// # Panic
+    ///
+    /// Panics if `size` is `0`.
+    ///
+    template<std::ranges::contiguous_range R>
+    inline auto par_chunks(R&& r, usize size) noexcept {
+        if (size == 0) panic("chunk size must be non-zero");
+        using T = std::remove_reference_t<std::ranges::range_reference_t<R>>;
+        auto src = ChunkSource<T>{ std::ranges::data(r), (usize)std::ranges::size(r), size };
+        return ParIter<ChunkSource<T>, std::span<T>, Identity>(src, Identity(), &ThreadPool::global());
+    }
+
+    /// @brief Call `f` on every element of a contiguous range in parallel.
+    ///
+    template<std::ranges::contiguous_range R, typename F>
+    inline auto par_for_each(R&& r, F f) noexcept {
+        par_iter(r).for_each(mv(f));
+    }
+
+    /// @brief Below this length, sorting falls back to the sequential algorithm.
+    ///
+    constexpr usize SORT_CUT = 2048;
+
+    /// @brief Below this length, merging is sequential.
+    ///
+    constexpr usize MERGE_CUT = 4096;
+
+    /// @brief Stably merge `a[0..na)` and `b[0..nb)` into `out` by moving, splitting the larger side in parallel.
+    ///
+    template<typename T, typename C>
+    inline auto merge_into(ThreadPool& pool, T* a, usize na, T* b, usize nb, T* out, C const& cmp) noexcept -> void {
+        if (na + nb <= MERGE_CUT) {
+            std::merge(std::make_move_iterator(a), std::make_move_iterator(a + na),
+                std::make_move_iterator(b), std::make_move_iterator(b + nb), out, cmp);
+            return;
+        }
+        usize ma, mb;
+        if (na >= nb) {
+            ma = na / 2;
+            mb = std::lower_bound(b, b + nb, a[ma], cmp) - b;
+        }
+        else {
+            mb = nb / 2;
+            ma = std::upper_bound(a, a + na, b[mb], cmp) - a;
+        }
+        pool.join(
+            [&]() { merge_into(pool, a, ma, b, mb, out, cmp); },
+            [&]() { merge_into(pool, a + ma, na - ma, b + mb, nb - mb, out + ma + mb, cmp); }
+        );
+    }
+
+    /// @brief Merge sort `v` in parallel, leaving the result in `buf` if `to_buf`.
+    ///
+    template<bool Stable, typename T, typename C>
+    inline auto sort_into(ThreadPool& pool, T* v, T* buf, usize n, bool to_buf, C const& cmp) noexcept -> void {
+        if (n <= SORT_CUT) {
+            if constexpr (Stable) std::stable_sort(v, v + n, cmp);
+            else std::sort(v, v + n, cmp);
+            if (to_buf) std::move(v, v + n, buf);
+            return;
+        }
+        auto m = n / 2;
+        pool.join(
+            [&]() { sort_into<Stable>(pool, v, buf, m, !to_buf, cmp); },
+            [&]() { sort_into<Stable>(pool, v + m, buf + m, n - m, !to_buf, cmp); }
+        );
+        auto src = to_buf ? v : buf;
+        auto dst = to_buf ? buf : v;
+        merge_into(pool, src, m, src + m, n - m, dst, cmp);
+    }
+
+    template<bool Stable, typename T, typename C>
+    inline auto sort_slice(T* v, usize n, C const& cmp) noexcept {
+        if constexpr (!std::is_default_constructible_v<T>) {
+            if constexpr (Stable) std::stable_sort(v, v + n, cmp);
+            else std::sort(v, v + n, cmp);
+        }
+        else {
+            if (n <= SORT_CUT) return sort_into<Stable>(ThreadPool::global(), v, v, n, false, cmp);
+            auto buf = std::unique_ptr<T[]>(new T[n]);
+            auto& pool = ThreadPool::global();
+            pool.install([&]() { sort_into<Stable>(pool, v, buf.get(), n, false, cmp); });
+        }
+    }
+
+    /// @brief Stably sort a contiguous range in parallel with a merge sort.
+    /// @note Needs a temporary buffer of the same length; types that are not default constructible are sorted sequentially.
+    /// @param r the range
+    /// @param cmp the strict weak ordering, `<` by default
+    ///
+    template<std::ranges::contiguous_range R, typename C = std::less<>>
+    inline auto par_sort(R&& r, C cmp = C()) noexcept {
+        sort_slice<true>(std::ranges::data(r), (usize)std::ranges::size(r), cmp);
+    }
+
+    /// @brief Sort a contiguous range in parallel, not necessarily keeping the order of equal elements.
+    /// @param r the range
+    /// @param cmp the strict weak ordering, `<` by default
+    ///
+    template<std::ranges::contiguous_range R, typename C = std::less<>>
+    inline auto par_sort_unstable(R&& r, C cmp = C()) noexcept {
+        sort_slice<false>(std::ranges::data(r), (usize)std::ranges::size(r), cmp);
+    }
+}
+
+namespace coding {
+
+    using par::par_iter, par::par_range, par::par_chunks, par::par_for_each, par::par_sort, par::par_sort_unstable;
+}
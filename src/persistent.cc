@@ -0,0 +1,924 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "hash.cc"
+#include "hashmap.cc"
+#include "ops.cc"
+#include "option.cc"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+namespace coding::collections {
+
+    /// @brief Reference counts for the nodes of persistent collections, and the tags choosing them.
+    ///
+    /// Nodes are shared between versions of a collection and freed by the last one. A node referenced once
+    /// belongs to a single version, which then updates it in place: a collection not shared with any snapshot
+    /// mutates like an ordinary one, and right after a snapshot only the first update of each node copies it.
+    ///
+    namespace persistent {
+
+        /// @brief Atomic counts, for versions shared across threads.
+        ///
+        struct Atomic {};
+
+        /// @brief Plain counts, for versions that stay on one thread. Cheaper by an atomic operation per node copied or freed.
+        ///
+        struct Local {};
+
+        template<typename R>
+        struct Count;
+
+        template<>
+        struct Count<Atomic> final {
+
+            std::atomic<u32> n = 1;
+
+            inline auto inc() noexcept -> void {
+                this->n.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            /// @return whether this was the last reference
+            ///
+            inline auto dec() noexcept -> bool {
+                return this->n.fetch_sub(1, std::memory_order_acq_rel) == 1;
+            }
+
+            inline auto unique() const noexcept -> bool {
+                return this->n.load(std::memory_order_acquire) == 1;
+            }
+        };
+
+        template<>
+        struct Count<Local> final {
+
+            u32 n = 1;
+
+            inline auto inc() noexcept -> void {
+                this->n++;
+            }
+
+            inline auto dec() noexcept -> bool {
+                return --this->n == 0;
+            }
+
+            inline auto unique() const noexcept -> bool {
+                return this->n == 1;
+            }
+        };
+
+        template<typename R>
+        concept Policy = std::same_as<R, Atomic> || std::same_as<R, Local>;
+
+        inline constexpr u32 BITS = 5;
+
+        inline constexpr u32 WIDTH = 1 << BITS;
+
+        inline constexpr u32 MASK = WIDTH - 1;
+
+        inline constexpr usize NONE = ~(usize)0;
+
+        inline constexpr auto round_up(usize n, usize align) noexcept -> usize {
+            return (n + align - 1) / align * align;
+        }
+    }
+
+    /// @brief A persistent hash map on a compressed hash array mapped trie (CHAMP). Copies are O(1) snapshots.
+    ///
+    /// Every node splits 5 bits of the hash 32 ways and stores, in one allocation, the entries it holds
+    /// directly and the pointers to subnodes, each indexed by a 32-bit bitmap. Keys of equal 64-bit hash
+    /// share a collision node at the bottom. Nodes with a single entry are folded into their parent, so
+    /// the shape depends on the keys alone.
+    ///
+    /// Updates copy the O(log n) nodes on the path from the root unless this version owns them alone,
+    /// in which case they happen in place. Readers of a snapshot are never disturbed: with `persistent::Atomic`,
+    /// snapshots may be read and dropped on any thread while another thread updates its own copy.
+    ///
+    /// @tparam K the key type
+    /// @tparam V the value type, copied when an update hits a shared node
+    /// @tparam R `persistent::Atomic` or `persistent::Local` reference counts
+    /// @tparam H the `BuildHasher`, copied into snapshots
+    ///
+    template<typename K, typename V, typename R = persistent::Atomic, typename H = hash::RandomState>
+        requires (ops::Eq<K> and hash::Hash<K> and persistent::Policy<R> and hash::BuildHasher<H>
+            and std::copy_constructible<K> and std::copy_constructible<V>)
+    class PersistentHashMap final {
+
+    private:
+
+        using Entry = KeyValue<K, V>;
+
+        using E = hash::StdEq;
+
+        struct Node {
+
+            persistent::Count<R> rc;
+
+            u32 datamap = 0;
+
+            u32 nodemap = 0;
+
+            /// @brief Number of entries and of subnodes.
+            ///
+            u32 nd = 0;
+
+            u32 nn = 0;
+
+            /// @brief Holds entries of one full hash in `nd`, with no bitmaps or subnodes.
+            ///
+            bool collision = false;
+
+            inline constexpr static usize DATA = persistent::round_up(sizeof(Node), alignof(Entry));
+
+            inline constexpr static usize ALIGN = std::max(alignof(Node), alignof(Entry));
+
+            inline static auto nodes_at(u32 nd) noexcept -> usize {
+                return persistent::round_up(DATA + nd * sizeof(Entry), alignof(Node*));
+            }
+
+            inline auto data() noexcept -> Entry* {
+                return reinterpret_cast<Entry*>(reinterpret_cast<u8*>(this) + DATA);
+            }
+
+            inline auto nodes() noexcept -> Node** {
+                return reinterpret_cast<Node**>(reinterpret_cast<u8*>(this) + nodes_at(this->nd));
+            }
+
+            /// @brief A node with room for `nd` entries and `nn` subnodes, none constructed.
+            ///
+            inline static auto make(u32 nd, u32 nn) noexcept -> Node* {
+                auto raw = ::operator new(nodes_at(nd) + nn * sizeof(Node*), std::align_val_t(ALIGN));
+                auto node = new (raw) Node();
+                node->nd = nd;
+                node->nn = nn;
+                return node;
+            }
+
+            /// @brief Free the memory of `node` alone, its entries and subnodes already moved away.
+            ///
+            inline static auto free(Node* node) noexcept -> void {
+                node->~Node();
+                ::operator delete(node, std::align_val_t(ALIGN));
+            }
+        };
+
+        Node* root = nullptr;
+
+        usize count = 0;
+
+        [[no_unique_address]] H hasher;
+
+        [[no_unique_address]] E eq;
+
+        inline static auto index(u32 map, u32 bit) noexcept -> u32 {
+            return (u32)std::popcount(map & (bit - 1));
+        }
+
+        inline static auto bit_of(u64 h, u32 shift) noexcept -> u32 {
+            return (u32)1 << ((h >> shift) & persistent::MASK);
+        }
+
+        inline static auto release(Node* node) noexcept -> void {
+            if (!node || !node->rc.dec()) return;
+            auto data = node->data();
+            for (auto i = (u32)0; i < node->nd; i++) data[i].~Entry();
+            auto nodes = node->nodes();
+            for (auto i = (u32)0; i < node->nn; i++) release(nodes[i]);
+            Node::free(node);
+        }
+
+        /// @brief `node` with entry `drop` removed and `add` inserted at `at`, subnode `drop_node` removed and
+        /// `add_node` inserted at `at_node`, any of them `NONE` or null for no change. Consumes the reference to `node`.
+        ///
+        /// A node owned alone is rebuilt by moving, its dropped entry destroyed and dropped subnode released.
+        /// A shared one is copied and left intact for its other owners.
+        ///
+        inline static auto reshape(Node* node, usize drop, Entry* add, usize at, usize drop_node, Node* add_node, usize at_node) noexcept -> Node* {
+            auto unique = node->rc.unique();
+            auto nd = node->nd - (drop != persistent::NONE) + (add != nullptr);
+            auto nn = node->nn - (drop_node != persistent::NONE) + (add_node != nullptr);
+            auto fresh = Node::make(nd, nn);
+            fresh->datamap = node->datamap;
+            fresh->nodemap = node->nodemap;
+            fresh->collision = node->collision;
+            auto from = node->data();
+            auto to = fresh->data();
+            auto j = (usize)0;
+            for (auto i = (usize)0; i <= node->nd; i++) {
+                if (add && i == at) new (to + j++) Entry(mv(*add));
+                if (i == node->nd) break;
+                if (i == drop) {
+                    if (unique) from[i].~Entry();
+                    continue;
+                }
+                if (unique) {
+                    new (to + j++) Entry(mv(from[i]));
+                    from[i].~Entry();
+                }
+                else new (to + j++) Entry(from[i]);
+            }
+            auto kids = node->nodes();
+            auto out = fresh->nodes();
+            j = 0;
+            for (auto i = (usize)0; i <= node->nn; i++) {
+                if (add_node && i == at_node) out[j++] = add_node;
+                if (i == node->nn) break;
+                if (i == drop_node) {
+                    if (unique) release(kids[i]);
+                    continue;
+                }
+                if (!unique) kids[i]->rc.inc();
+                out[j++] = kids[i];
+            }
+            if (unique) Node::free(node);
+            else release(node);
+            return fresh;
+        }
+
+        /// @brief `node` if owned alone, otherwise a copy owned alone. Consumes the reference to `node`.
+        ///
+        inline static auto own(Node* node) noexcept -> Node* {
+            if (node->rc.unique()) return node;
+            return reshape(node, persistent::NONE, nullptr, 0, persistent::NONE, nullptr, 0);
+        }
+
+        /// @brief A subtree holding the two entries of distinct keys `a` and `b`, from hash bit `shift` down.
+        ///
+        inline static auto pair(Entry&& a, u64 ha, Entry&& b, u64 hb, u32 shift) noexcept -> Node* {
+            if (shift >= 64) {
+                auto node = Node::make(2, 0);
+                node->collision = true;
+                new (node->data()) Entry(mv(a));
+                new (node->data() + 1) Entry(mv(b));
+                return node;
+            }
+            auto ba = bit_of(ha, shift);
+            auto bb = bit_of(hb, shift);
+            if (ba == bb) {
+                auto node = Node::make(0, 1);
+                node->nodemap = ba;
+                node->nodes()[0] = pair(mv(a), ha, mv(b), hb, shift + persistent::BITS);
+                return node;
+            }
+            auto node = Node::make(2, 0);
+            node->datamap = ba | bb;
+            auto first = ba < bb;
+            new (node->data() + !first) Entry(mv(a));
+            new (node->data() + first) Entry(mv(b));
+            return node;
+        }
+
+        template<typename Q>
+        inline auto find(Q const& key) const noexcept -> Entry* {
+            auto h = hash::hash_one(this->hasher, key);
+            auto node = this->root;
+            for (auto shift = (u32)0; node; shift += persistent::BITS) {
+                if (node->collision) {
+                    for (auto i = (u32)0; i < node->nd; i++) {
+                        if (this->eq(node->data()[i].key, key)) return node->data() + i;
+                    }
+                    return nullptr;
+                }
+                auto bit = bit_of(h, shift);
+                if (node->datamap & bit) {
+                    auto e = node->data() + index(node->datamap, bit);
+                    return this->eq(e->key, key) ? e : nullptr;
+                }
+                if (!(node->nodemap & bit)) return nullptr;
+                node = node->nodes()[index(node->nodemap, bit)];
+            }
+            return nullptr;
+        }
+
+        /// @brief Insert `e` of hash `h` below `node`. Consumes the reference to `node` and returns its replacement.
+        ///
+        inline auto insert(Node* node, u64 h, u32 shift, Entry&& e, Option<V>& old) noexcept -> Node* {
+            if (node->collision) {
+                for (auto i = (u32)0; i < node->nd; i++) {
+                    if (this->eq(node->data()[i].key, e.key)) {
+                        node = own(node);
+                        old = Option<V>(mv(node->data()[i].value));
+                        node->data()[i].value = mv(e.value);
+                        return node;
+                    }
+                }
+                return reshape(node, persistent::NONE, &e, node->nd, persistent::NONE, nullptr, 0);
+            }
+            auto bit = bit_of(h, shift);
+            if (node->datamap & bit) {
+                auto i = index(node->datamap, bit);
+                if (this->eq(node->data()[i].key, e.key)) {
+                    node = own(node);
+                    old = Option<V>(mv(node->data()[i].value));
+                    node->data()[i].value = mv(e.value);
+                    return node;
+                }
+                node = own(node);
+                auto& other = node->data()[i];
+                auto ho = hash::hash_one(this->hasher, other.key);
+                auto child = pair(mv(other), ho, mv(e), h, shift + persistent::BITS);
+                node = reshape(node, i, nullptr, 0, persistent::NONE, child, index(node->nodemap, bit));
+                node->datamap ^= bit;
+                node->nodemap |= bit;
+                return node;
+            }
+            if (node->nodemap & bit) {
+                node = own(node);
+                auto& child = node->nodes()[index(node->nodemap, bit)];
+                child = this->insert(child, h, shift + persistent::BITS, mv(e), old);
+                return node;
+            }
+            node = reshape(node, persistent::NONE, &e, index(node->datamap, bit), persistent::NONE, nullptr, 0);
+            node->datamap |= bit;
+            return node;
+        }
+
+        /// @brief Remove `key` of hash `h`, known present below `node`. Consumes the reference to `node` and
+        /// returns its replacement, which may hold a single entry for the parent to fold in.
+        ///
+        template<typename Q>
+        inline auto remove(Node* node, u64 h, u32 shift, Q const& key, Option<V>& old) noexcept -> Node* {
+            node = own(node);
+            if (node->collision) {
+                for (auto i = (u32)0; i < node->nd; i++) {
+                    if (this->eq(node->data()[i].key, key)) {
+                        old = Option<V>(mv(node->data()[i].value));
+                        return reshape(node, i, nullptr, 0, persistent::NONE, nullptr, 0);
+                    }
+                }
+                return node;
+            }
+            auto bit = bit_of(h, shift);
+            if (node->datamap & bit) {
+                auto i = index(node->datamap, bit);
+                old = Option<V>(mv(node->data()[i].value));
+                node = reshape(node, i, nullptr, 0, persistent::NONE, nullptr, 0);
+                node->datamap ^= bit;
+                return node;
+            }
+            auto j = index(node->nodemap, bit);
+            auto& child = node->nodes()[j];
+            child = this->remove(child, h, shift + persistent::BITS, key, old);
+            if (child->nd == 1 && child->nn == 0) {
+                // Fold the last entry of the subnode into this one.
+                auto last = child->rc.unique() ? Entry(mv(child->data()[0])) : Entry(child->data()[0]);
+                node = reshape(node, persistent::NONE, &last, index(node->datamap, bit), j, nullptr, 0);
+                node->datamap |= bit;
+                node->nodemap ^= bit;
+            }
+            return node;
+        }
+
+    public:
+
+        using key_type = K;
+
+        using mapped_type = V;
+
+        /// @brief Forward iterator over the entries in an unspecified order.
+        ///
+        class Iterator final {
+
+        private:
+
+            friend class PersistentHashMap;
+
+            /// @brief Levels of 5 bits cover 64 bits in 13, plus a collision node.
+            ///
+            inline constexpr static usize DEPTH = 15;
+
+            struct Frame {
+                Node* node;
+                u32 i;
+            };
+
+            Frame stack[DEPTH];
+
+            usize depth = 0;
+
+            /// @brief Descend to the next entry, popping exhausted nodes.
+            ///
+            inline auto settle() noexcept -> void {
+                while (this->depth > 0) {
+                    auto& top = this->stack[this->depth - 1];
+                    if (top.i < top.node->nd) return;
+                    auto k = top.i - top.node->nd;
+                    if (k < top.node->nn) {
+                        top.i++;
+                        this->stack[this->depth++] = Frame{ top.node->nodes()[k], 0 };
+                    }
+                    else this->depth--;
+                }
+            }
+
+            inline explicit Iterator(Node* root) noexcept {
+                if (!root) return;
+                this->stack[this->depth++] = Frame{ root, 0 };
+                this->settle();
+            }
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Entry;
+            using difference_type = isize;
+            using reference = Entry const&;
+
+            inline Iterator() noexcept = default;
+
+            inline auto operator*() const noexcept -> Entry const& {
+                auto& top = this->stack[this->depth - 1];
+                return top.node->data()[top.i];
+            }
+
+            inline auto operator->() const noexcept -> Entry const* {
+                return &**this;
+            }
+
+            inline auto operator++() noexcept -> Iterator& {
+                this->stack[this->depth - 1].i++;
+                this->settle();
+                return *this;
+            }
+
+            inline auto operator++(int) noexcept -> Iterator {
+                auto t = *this;
+                ++*this;
+                return t;
+            }
+
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool {
+                if (this->depth != rhs.depth) return false;
+                if (this->depth == 0) return true;
+                auto& a = this->stack[this->depth - 1];
+                auto& b = rhs.stack[rhs.depth - 1];
+                return a.node == b.node && a.i == b.i;
+            }
+        };
+
+        inline PersistentHashMap() noexcept = default;
+
+        inline explicit PersistentHashMap(H hasher) noexcept : hasher(mv(hasher)) {}
+
+        /// @brief A snapshot in O(1), sharing every node.
+        ///
+        inline PersistentHashMap(PersistentHashMap const& rhs) noexcept : root(rhs.root), count(rhs.count), hasher(rhs.hasher) {
+            if (this->root) this->root->rc.inc();
+        }
+
+        inline PersistentHashMap(PersistentHashMap&& rhs) noexcept
+            : root(std::exchange(rhs.root, nullptr)), count(std::exchange(rhs.count, 0)), hasher(rhs.hasher) {}
+
+        inline auto operator=(PersistentHashMap rhs) noexcept -> PersistentHashMap& {
+            std::swap(this->root, rhs.root);
+            std::swap(this->count, rhs.count);
+            std::swap(this->hasher, rhs.hasher);
+            return *this;
+        }
+
+        inline ~PersistentHashMap() noexcept {
+            release(this->root);
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->count;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->count == 0;
+        }
+
+        inline auto clear() noexcept -> void {
+            release(std::exchange(this->root, nullptr));
+            this->count = 0;
+        }
+
+        template<typename Q>
+            requires LookupBy<Q, K, H, E>
+        inline auto get(Q const& key) const noexcept -> V const* {
+            auto e = this->find(key);
+            return e ? &e->value : nullptr;
+        }
+
+        template<typename Q>
+            requires LookupBy<Q, K, H, E>
+        inline auto contains(Q const& key) const noexcept -> bool {
+            return this->find(key) != nullptr;
+        }
+
+        /// @brief Insert or replace the value of `key` in this version, copying the nodes it shares with snapshots.
+        /// @return the replaced value, if any
+        ///
+        inline auto insert(K key, V value) noexcept -> Option<V> {
+            auto h = hash::hash_one(this->hasher, key);
+            auto e = Entry{ mv(key), mv(value) };
+            auto old = Option<V>();
+            if (!this->root) {
+                this->root = Node::make(1, 0);
+                this->root->datamap = bit_of(h, 0);
+                new (this->root->data()) Entry(mv(e));
+            }
+            else this->root = this->insert(this->root, h, 0, mv(e), old);
+            if (old.is_none()) this->count++;
+            return old;
+        }
+
+        /// @brief Remove `key` from this version, copying the nodes it shares with snapshots.
+        /// @return its value, if present
+        ///
+        template<typename Q>
+            requires LookupBy<Q, K, H, E>
+        inline auto remove(Q const& key) noexcept -> Option<V> {
+            auto old = Option<V>();
+            if (!this->find(key)) return old;
+            this->root = this->remove(this->root, hash::hash_one(this->hasher, key), 0, key, old);
+            if (--this->count == 0) this->clear();
+            return old;
+        }
+
+        /// @brief A new version with `key` set to `value`, this one unchanged.
+        ///
+        inline auto with(K key, V value) const noexcept -> PersistentHashMap {
+            auto next = *this;
+            next.insert(mv(key), mv(value));
+            return next;
+        }
+
+        /// @brief A new version without `key`, this one unchanged.
+        ///
+        template<typename Q>
+            requires LookupBy<Q, K, H, E>
+        inline auto without(Q const& key) const noexcept -> PersistentHashMap {
+            auto next = *this;
+            next.remove(key);
+            return next;
+        }
+
+        inline auto begin() const noexcept -> Iterator { return Iterator(this->root); }
+        inline auto end() const noexcept -> Iterator { return Iterator(); }
+    };
+
+    /// @brief A persistent vector on a 32-way radix tree with a detached tail. Copies are O(1) snapshots.
+    ///
+    /// Elements sit in leaves of 32 under inner nodes of 32, so an index is found in `log32(n)` steps, at most
+    /// 7 for any length in memory. The last leaf is kept aside as the tail, so `push_back` and `pop_back`
+    /// touch the tree only once every 32 elements. Updates copy the path from the root unless this version
+    /// owns it alone, like `PersistentHashMap`.
+    ///
+    /// @tparam T the element type, copied when an update hits a shared leaf
+    /// @tparam R `persistent::Atomic` or `persistent::Local` reference counts
+    ///
+    template<typename T, typename R = persistent::Atomic>
+        requires (std::copy_constructible<T> and persistent::Policy<R>)
+    class PersistentVec final {
+
+    private:
+
+        inline constexpr static u32 BITS = persistent::BITS;
+
+        inline constexpr static usize WIDTH = persistent::WIDTH;
+
+        inline constexpr static usize MASK = persistent::MASK;
+
+        struct Leaf {
+
+            persistent::Count<R> rc;
+
+            u32 len = 0;
+
+            alignas(T) u8 storage[WIDTH * sizeof(T)];
+
+            inline auto items() noexcept -> T* {
+                return reinterpret_cast<T*>(this->storage);
+            }
+        };
+
+        struct Inner {
+
+            persistent::Count<R> rc;
+
+            u32 len = 0;
+
+            void* kids[WIDTH];
+        };
+
+        /// @brief The tree of full leaves, an `Inner` unless `shift` is zero and it is a `Leaf`.
+        ///
+        void* root = nullptr;
+
+        Leaf* tail = nullptr;
+
+        usize count = 0;
+
+        /// @brief Bit shift of the root level, zero when the root is a leaf.
+        ///
+        u32 shift = 0;
+
+        inline auto tail_offset() const noexcept -> usize {
+            return this->count - (this->tail ? this->tail->len : 0);
+        }
+
+        inline static auto release(void* node, u32 shift) noexcept -> void {
+            if (!node) return;
+            if (shift == 0) {
+                auto leaf = static_cast<Leaf*>(node);
+                if (!leaf->rc.dec()) return;
+                std::destroy_n(leaf->items(), leaf->len);
+                delete leaf;
+            }
+            else {
+                auto inner = static_cast<Inner*>(node);
+                if (!inner->rc.dec()) return;
+                for (auto i = (u32)0; i < inner->len; i++) release(inner->kids[i], shift - BITS);
+                delete inner;
+            }
+        }
+
+        inline static auto own(Leaf* leaf) noexcept -> Leaf* {
+            if (leaf->rc.unique()) return leaf;
+            auto fresh = new Leaf;
+            std::uninitialized_copy_n(leaf->items(), leaf->len, fresh->items());
+            fresh->len = leaf->len;
+            release(leaf, 0);
+            return fresh;
+        }
+
+        inline static auto own(Inner* inner, u32 shift) noexcept -> Inner* {
+            if (inner->rc.unique()) return inner;
+            auto fresh = new Inner;
+            fresh->len = inner->len;
+            for (auto i = (u32)0; i < inner->len; i++) {
+                fresh->kids[i] = inner->kids[i];
+                if (shift == BITS) static_cast<Leaf*>(inner->kids[i])->rc.inc();
+                else static_cast<Inner*>(inner->kids[i])->rc.inc();
+            }
+            release(inner, shift);
+            return fresh;
+        }
+
+        inline static auto own(void* node, u32 shift) noexcept -> void* {
+            if (shift == 0) return own(static_cast<Leaf*>(node));
+            return own(static_cast<Inner*>(node), shift);
+        }
+
+        /// @brief A chain of single-child inner nodes from level `shift` down to `leaf`.
+        ///
+        inline static auto path(u32 shift, Leaf* leaf) noexcept -> void* {
+            if (shift == 0) return leaf;
+            auto inner = new Inner;
+            inner->len = 1;
+            inner->kids[0] = path(shift - BITS, leaf);
+            return inner;
+        }
+
+        /// @brief Append the full `leaf` below `node` at level `shift`, holding `n` elements before it.
+        /// The subtree has room, and `node` is owned alone.
+        ///
+        inline static auto push_leaf(Inner* node, u32 shift, usize n, Leaf* leaf) noexcept -> void {
+            auto i = (n >> shift) & MASK;
+            if (shift == BITS) {
+                node->kids[i] = leaf;
+                node->len = (u32)i + 1;
+            }
+            else if (i < node->len) {
+                auto kid = own(static_cast<Inner*>(node->kids[i]), shift - BITS);
+                node->kids[i] = kid;
+                push_leaf(kid, shift - BITS, n, leaf);
+            }
+            else {
+                node->kids[i] = path(shift - BITS, leaf);
+                node->len = (u32)i + 1;
+            }
+        }
+
+        /// @brief Detach the last leaf below `node` at level `shift`, its last element at index `n - 1`.
+        /// @return the node to keep in place of `node`, null if it emptied
+        ///
+        inline static auto pop_leaf(void* node, u32 shift, usize n, Leaf*& leaf) noexcept -> void* {
+            if (shift == 0) {
+                leaf = static_cast<Leaf*>(node);
+                return nullptr;
+            }
+            auto inner = own(static_cast<Inner*>(node), shift);
+            auto i = ((n - 1) >> shift) & MASK;
+            auto kid = pop_leaf(inner->kids[i], shift - BITS, n, leaf);
+            if (kid) inner->kids[i] = kid;
+            else inner->len--;
+            if (inner->len == 0) {
+                delete inner;
+                return nullptr;
+            }
+            return inner;
+        }
+
+        inline auto leaf_for(usize i) const noexcept -> Leaf* {
+            if (i >= this->tail_offset()) return this->tail;
+            auto node = this->root;
+            for (auto s = this->shift; s > 0; s -= BITS) node = static_cast<Inner*>(node)->kids[(i >> s) & MASK];
+            return static_cast<Leaf*>(node);
+        }
+
+        inline auto check(usize i) const noexcept -> void {
+            if (i >= this->count) [[unlikely]] panic("index out of range");
+        }
+
+    public:
+
+        /// @brief Random-access iterator, walking each leaf before looking up the next.
+        ///
+        class Iterator final {
+
+        private:
+
+            friend class PersistentVec;
+
+            PersistentVec const* vec = nullptr;
+
+            usize i = 0;
+
+            inline Iterator(PersistentVec const* vec, usize i) noexcept : vec(vec), i(i) {}
+
+        public:
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = T;
+            using difference_type = isize;
+            using reference = T const&;
+
+            inline Iterator() noexcept = default;
+
+            inline auto operator*() const noexcept -> T const& { return (*this->vec)[this->i]; }
+            inline auto operator[](isize n) const noexcept -> T const& { return (*this->vec)[this->i + n]; }
+            inline auto operator++() noexcept -> Iterator& { ++this->i; return *this; }
+            inline auto operator++(int) noexcept -> Iterator { auto t = *this; ++this->i; return t; }
+            inline auto operator--() noexcept -> Iterator& { --this->i; return *this; }
+            inline auto operator--(int) noexcept -> Iterator { auto t = *this; --this->i; return t; }
+            inline auto operator+=(isize n) noexcept -> Iterator& { this->i += n; return *this; }
+            inline auto operator-=(isize n) noexcept -> Iterator& { this->i -= n; return *this; }
+            inline auto operator+(isize n) const noexcept -> Iterator { return Iterator(this->vec, this->i + n); }
+            inline auto operator-(isize n) const noexcept -> Iterator { return Iterator(this->vec, this->i - n); }
+            inline friend auto operator+(isize n, Iterator it) noexcept -> Iterator { return it += n; }
+            inline auto operator-(Iterator const& rhs) const noexcept -> isize { return (isize)this->i - (isize)rhs.i; }
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool { return this->i == rhs.i; }
+            inline auto operator<=>(Iterator const& rhs) const noexcept -> std::strong_ordering { return this->i <=> rhs.i; }
+        };
+
+        inline PersistentVec() noexcept = default;
+
+        template<std::ranges::input_range Range>
+        inline static auto from(Range&& elements) noexcept -> PersistentVec {
+            auto vec = PersistentVec();
+            for (auto&& x : elements) vec.push_back(T(x));
+            return vec;
+        }
+
+        /// @brief A snapshot in O(1), sharing every node.
+        ///
+        inline PersistentVec(PersistentVec const& rhs) noexcept : root(rhs.root), tail(rhs.tail), count(rhs.count), shift(rhs.shift) {
+            if (this->root) {
+                if (this->shift == 0) static_cast<Leaf*>(this->root)->rc.inc();
+                else static_cast<Inner*>(this->root)->rc.inc();
+            }
+            if (this->tail) this->tail->rc.inc();
+        }
+
+        inline PersistentVec(PersistentVec&& rhs) noexcept
+            : root(std::exchange(rhs.root, nullptr)), tail(std::exchange(rhs.tail, nullptr)),
+            count(std::exchange(rhs.count, 0)), shift(std::exchange(rhs.shift, 0)) {}
+
+        inline auto operator=(PersistentVec rhs) noexcept -> PersistentVec& {
+            std::swap(this->root, rhs.root);
+            std::swap(this->tail, rhs.tail);
+            std::swap(this->count, rhs.count);
+            std::swap(this->shift, rhs.shift);
+            return *this;
+        }
+
+        inline ~PersistentVec() noexcept {
+            this->clear();
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->count;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->count == 0;
+        }
+
+        inline auto clear() noexcept -> void {
+            release(std::exchange(this->root, nullptr), this->shift);
+            release(std::exchange(this->tail, nullptr), 0);
+            this->count = 0;
+            this->shift = 0;
+        }
+
+        inline auto operator[](usize i) const noexcept -> T const& {
+            this->check(i);
+            return this->leaf_for(i)->items()[i & MASK];
+        }
+
+        /// @brief The element at `i`, or `nullptr` if out of range.
+        ///
+        inline auto get(usize i) const noexcept -> T const* {
+            return i < this->count ? this->leaf_for(i)->items() + (i & MASK) : nullptr;
+        }
+
+        inline auto front() const noexcept -> T const& {
+            return (*this)[0];
+        }
+
+        inline auto back() const noexcept -> T const& {
+            return (*this)[this->count - 1];
+        }
+
+        /// @brief Replace the element at `i` in this version, copying the path it shares with snapshots.
+        ///
+        inline auto set(usize i, T value) noexcept -> void {
+            this->check(i);
+            if (i >= this->tail_offset()) {
+                this->tail = own(this->tail);
+                this->tail->items()[i & MASK] = mv(value);
+                return;
+            }
+            this->root = own(this->root, this->shift);
+            auto node = this->root;
+            for (auto s = this->shift; s > 0; s -= BITS) {
+                auto& kid = static_cast<Inner*>(node)->kids[(i >> s) & MASK];
+                kid = own(kid, s - BITS);
+                node = kid;
+            }
+            static_cast<Leaf*>(node)->items()[i & MASK] = mv(value);
+        }
+
+        inline auto push_back(T value) noexcept -> void {
+            if (this->tail && this->tail->len == WIDTH) {
+                // Move the full tail into the tree, growing a level if the tree is full.
+                auto n = this->count - WIDTH;
+                auto full = std::exchange(this->tail, nullptr);
+                if (!this->root) this->root = full;
+                else if (n == (WIDTH << this->shift)) {
+                    auto top = new Inner;
+                    top->len = 2;
+                    top->kids[0] = this->root;
+                    top->kids[1] = path(this->shift, full);
+                    this->root = top;
+                    this->shift += BITS;
+                }
+                else {
+                    auto top = own(static_cast<Inner*>(this->root), this->shift);
+                    this->root = top;
+                    push_leaf(top, this->shift, n, full);
+                }
+            }
+            if (!this->tail) this->tail = new Leaf;
+            else this->tail = own(this->tail);
+            new (this->tail->items() + this->tail->len) T(mv(value));
+            this->tail->len++;
+            this->count++;
+        }
+
+        inline auto pop_back() noexcept -> Option<T> {
+            if (this->count == 0) return Option<T>();
+            this->tail = own(this->tail);
+            auto last = this->tail->items() + this->tail->len - 1;
+            auto value = Option<T>(mv(*last));
+            std::destroy_at(last);
+            this->tail->len--;
+            this->count--;
+            if (this->tail->len == 0) {
+                release(std::exchange(this->tail, nullptr), 0);
+                if (this->root) {
+                    // The last leaf of the tree becomes the tail.
+                    this->root = pop_leaf(this->root, this->shift, this->count, this->tail);
+                    if (this->root && this->shift > 0 && static_cast<Inner*>(this->root)->len == 1) {
+                        auto top = static_cast<Inner*>(this->root);
+                        auto only = top->kids[0];
+                        if (top->rc.unique()) delete top;
+                        else {
+                            if (this->shift == BITS) static_cast<Leaf*>(only)->rc.inc();
+                            else static_cast<Inner*>(only)->rc.inc();
+                            release(top, this->shift);
+                        }
+                        this->root = only;
+                        this->shift -= BITS;
+                    }
+                }
+            }
+            return value;
+        }
+
+        inline auto begin() const noexcept -> Iterator { return Iterator(this, 0); }
+        inline auto end() const noexcept -> Iterator { return Iterator(this, this->count); }
+    };
+}
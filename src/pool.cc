@@ -0,0 +1,384 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "mutex.cc"
+#include "thread.cc"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace coding::thread {
+
+    /// @brief A unit of work scheduled on a `ThreadPool`.
+    /// @note Jobs are intrusive and never owned by the pool, their creator keeps them alive until `is_done`.
+    ///
+    struct Job {
+
+        /// @brief Run the job, then set `done`.
+        ///
+        void (*exec)(Job*) noexcept;
+
+        /// @brief Set once the job has finished, its creator may sleep on it.
+        ///
+        Done done;
+
+        inline constexpr Job(void (*exec)(Job*) noexcept) noexcept : exec(exec) {}
+
+        inline auto run() noexcept {
+            this->exec(this);
+        }
+
+        /// @brief Mark the job finished and wake its creator.
+        ///
+        inline auto finish() noexcept {
+            this->done.set();
+        }
+
+        inline auto is_done() const noexcept -> bool {
+            return this->done.is_set();
+        }
+    };
+
+    /// @brief What a closure returns, with `unit` standing for `void`.
+    /// @tparam F the closure type
+    ///
+    template<typename F>
+    using Ret = std::conditional_t<std::is_void_v<std::invoke_result_t<F&>>, unit, std::invoke_result_t<F&>>;
+
+    /// @brief A job living on its creator's stack, wrapping a closure and its result.
+    /// @tparam F the closure type
+    ///
+    template<typename F>
+    struct StackJob final : Job {
+
+        using R = std::invoke_result_t<F&>;
+
+        F f;
+
+        /// @brief Index of the worker that created the job, or `-1` outside of a pool.
+        ///
+        isize origin;
+
+        /// @brief Whether the job ran on another thread than its creator.
+        ///
+        bool stolen = false;
+
+        Ret<F> result;
+
+        inline StackJob(F f, isize origin) noexcept : Job(&StackJob::exec_impl), f(mv(f)), origin(origin), result() {}
+
+        inline static auto exec_impl(Job* job) noexcept -> void;
+
+        /// @brief Run on the creator's thread without going through the scheduler.
+        ///
+        inline auto run_inline() noexcept {
+            if constexpr (std::is_void_v<R>) this->f();
+            else this->result = this->f();
+        }
+    };
+
+    /// @brief A heap-allocated fire-and-forget job that frees itself after running.
+    /// @tparam F the closure type
+    ///
+    template<typename F>
+    struct HeapJob final : Job {
+
+        F f;
+
+        inline HeapJob(F f) noexcept : Job(&HeapJob::exec_impl), f(mv(f)) {}
+
+        inline static auto exec_impl(Job* job) noexcept -> void {
+            auto self = static_cast<HeapJob*>(job);
+            self->f();
+            delete self;
+        }
+    };
+
+    /// @brief A work-stealing thread pool for fork-join parallelism.
+    ///
+    /// Every worker owns a deque: it pushes and pops its own jobs at the back (LIFO, cache-hot),
+    /// while idle workers steal from the front of other deques (FIFO, the largest pieces of work).
+    /// Threads outside the pool submit through a shared injector queue.
+    /// Idle workers spin briefly and then sleep on a futex until new work is pushed.
+    ///
+    class ThreadPool final {
+
+    private:
+
+        /// @brief A locked job deque on its own cache line.
+        ///
+        struct alignas(CACHE_LINE) Queue {
+
+            RawMutex lock;
+
+            std::deque<Job*> jobs;
+
+            inline auto push(Job* job) noexcept {
+                this->lock.lock();
+                this->jobs.push_back(job);
+                this->lock.unlock();
+            }
+
+            inline auto pop() noexcept -> Job* {
+                this->lock.lock();
+                Job* job = nullptr;
+                if (!this->jobs.empty()) {
+                    job = this->jobs.back();
+                    this->jobs.pop_back();
+                }
+                this->lock.unlock();
+                return job;
+            }
+
+            inline auto steal() noexcept -> Job* {
+                this->lock.lock();
+                Job* job = nullptr;
+                if (!this->jobs.empty()) {
+                    job = this->jobs.front();
+                    this->jobs.pop_front();
+                }
+                this->lock.unlock();
+                return job;
+            }
+
+            /// @brief Take `job` back if nobody has stolen it yet.
+            /// @return whether `job` was taken back
+            ///
+            inline auto reclaim(Job* job) noexcept -> bool {
+                this->lock.lock();
+                auto ok = !this->jobs.empty() && this->jobs.back() == job;
+                if (ok) this->jobs.pop_back();
+                this->lock.unlock();
+                return ok;
+            }
+        };
+
+        std::unique_ptr<Queue[]> queues;
+
+        usize n;
+
+        Queue injector;
+
+        std::vector<std::thread> threads;
+
+        /// @brief Bumped whenever work is pushed, idle workers sleep on it.
+        ///
+        alignas(CACHE_LINE) std::atomic<u32> signal = 0;
+
+        std::atomic<u32> sleepers = 0;
+
+        std::atomic<bool> stop = false;
+
+        /// @brief The pool and worker index of the current thread, if it is a worker.
+        ///
+        inline static thread_local ThreadPool* current_pool = nullptr;
+        inline static thread_local usize current_index = 0;
+
+        template<typename F> friend struct StackJob;
+
+        inline auto notify() noexcept {
+            this->signal.fetch_add(1, std::memory_order_seq_cst);
+            if (this->sleepers.load(std::memory_order_seq_cst)) futex::wake(this->signal);
+        }
+
+        /// @brief Look for work: own deque first, then the injector, then steal from others.
+        /// @param me index of the calling worker
+        /// @return a job, or `nullptr`
+        ///
+        inline auto find(usize me) noexcept -> Job* {
+            if (auto job = this->queues[me].pop()) return job;
+            if (auto job = this->injector.steal()) return job;
+            for (auto i = (usize)1; i < this->n; i++) {
+                if (auto job = this->queues[(me + i) % this->n].steal()) return job;
+            }
+            return nullptr;
+        }
+
+        inline auto work(usize me) noexcept {
+            current_pool = this;
+            current_index = me;
+            while (!this->stop.load(std::memory_order_relaxed)) {
+                if (auto job = this->find(me)) {
+                    job->run();
+                    continue;
+                }
+                auto found = false;
+                for (auto i = 0; i < 64 && !found; i++) {
+                    relax();
+                    if (auto job = this->find(me)) {
+                        job->run();
+                        found = true;
+                    }
+                }
+                if (found) continue;
+                this->sleepers.fetch_add(1, std::memory_order_seq_cst);
+                auto s = this->signal.load(std::memory_order_seq_cst);
+                if (auto job = this->find(me)) {
+                    this->sleepers.fetch_sub(1, std::memory_order_relaxed);
+                    job->run();
+                    continue;
+                }
+                if (!this->stop.load(std::memory_order_relaxed)) futex::wait(this->signal, s);
+                this->sleepers.fetch_sub(1, std::memory_order_relaxed);
+            }
+            current_pool = nullptr;
+        }
+
+        /// @brief Keep the calling worker busy with other jobs until `job` is done, and sleep once there are none.
+        ///
+        inline auto wait_on(Job& job, usize me) noexcept {
+            auto idle = 0;
+            while (!job.is_done()) {
+                if (auto other = this->find(me)) {
+                    other->run();
+                    idle = 0;
+                }
+                else if (idle++ < 64) relax();
+                else {
+                    // The thief is running `job`, and wakes us when it is done.
+                    job.done.wait();
+                    return;
+                }
+            }
+        }
+
+    public:
+
+        /// @brief Start a pool.
+        /// @param n number of worker threads, `0` for one per hardware thread
+        ///
+        inline ThreadPool(usize n = 0) noexcept {
+            if (n == 0) n = std::max((usize)std::thread::hardware_concurrency(), (usize)1);
+            this->n = n;
+            this->queues = std::make_unique<Queue[]>(n);
+            this->threads.reserve(n);
+            for (auto i = (usize)0; i < n; i++) this->threads.emplace_back([this, i] { this->work(i); });
+        }
+
+        ThreadPool(ThreadPool const&) = delete;
+
+        /// @brief Stop and join every worker.
+        /// @warning Jobs still queued are not run, wait for your work before dropping the pool.
+        ///
+        inline ~ThreadPool() noexcept {
+            this->stop.store(true, std::memory_order_relaxed);
+            this->signal.fetch_add(1, std::memory_order_seq_cst);
+            futex::wake_all(this->signal);
+            for (auto& t : this->threads) t.join();
+        }
+
+        /// @brief The process-wide pool with one worker per hardware thread.
+        ///
+        inline static auto global() noexcept -> ThreadPool& {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        /// @brief Number of worker threads.
+        ///
+        inline auto threads_count() const noexcept -> usize {
+            return this->n;
+        }
+
+        /// @brief Index of the calling worker in this pool, or `-1` if the caller is not one.
+        ///
+        inline auto worker_index() const noexcept -> isize {
+            return current_pool == this ? (isize)current_index : -1;
+        }
+
+        /// @brief Push a job to run eventually. The caller keeps `job` alive until it is done.
+        /// @param job the job
+        ///
+        inline auto push(Job& job) noexcept {
+            if (current_pool == this) this->queues[current_index].push(&job);
+            else this->injector.push(&job);
+            this->notify();
+        }
+
+        /// @brief Run a closure eventually, without waiting for it.
+        /// @tparam F the closure type
+        /// @param f the closure
+        ///
+        template<typename F>
+        inline auto spawn(F f) noexcept {
+            this->push(*new HeapJob<F>(mv(f)));
+        }
+
+        /// @brief Run a closure inside the pool and block until it returns.
+        /// @tparam F the closure type
+        /// @param f the closure
+        /// @return whatever `f` returns
+        ///
+        template<typename F>
+        inline auto install(F f) noexcept -> std::invoke_result_t<F&> {
+            if (current_pool == this) return f();
+            auto job = StackJob<F>(mv(f), -1);
+            this->push(job);
+            job.done.wait();
+            if constexpr (!std::is_void_v<std::invoke_result_t<F&>>) return mv(job.result);
+        }
+
+        /// @brief Run two closures, potentially in parallel, and wait for both.
+        ///
+        /// `b` is offered to other workers while the caller runs `a`. If nobody stole it,
+        /// the caller runs `b` itself, so unneeded parallelism costs one deque push and pop.
+        ///
+        /// @param a the closure run by the caller
+        /// @param b the closure offered to be stolen
+        /// @return the pair of results, `unit` standing for `void`
+        ///
+        template<typename A, typename B>
+        inline auto join(A a, B b) noexcept -> std::pair<Ret<A>, Ret<B>> {
+            if (current_pool != this) {
+                return this->install([&]() { return this->join(mv(a), mv(b)); });
+            }
+            auto me = current_index;
+            auto job = StackJob<B>(mv(b), (isize)me);
+            this->queues[me].push(&job);
+            this->notify();
+            auto ra = [&] {
+                if constexpr (std::is_void_v<std::invoke_result_t<A&>>) { a(); return unit(); }
+                else return a();
+            }();
+            if (this->queues[me].reclaim(&job)) {
+                auto outer = migrated;
+                migrated = false;
+                job.run_inline();
+                migrated = outer;
+            }
+            else this->wait_on(job, me);
+            return { mv(ra), mv(job.result) };
+        }
+
+        /// @brief Whether the `b` side of the innermost `join` was stolen by another worker.
+        /// @note Only meaningful when read at the start of `b`. Parallel splitters use this to split more when work is being stolen.
+        ///
+        inline static thread_local bool migrated = false;
+    };
+
+    template<typename F>
+    inline auto StackJob<F>::exec_impl(Job* job) noexcept -> void {
+        auto self = static_cast<StackJob*>(job);
+        auto pool = ThreadPool::current_pool;
+        auto stolen = self->origin < 0 || pool == nullptr || (isize)ThreadPool::current_index != self->origin;
+        auto outer = ThreadPool::migrated;
+        ThreadPool::migrated = stolen;
+        self->stolen = stolen;
+        self->run_inline();
+        ThreadPool::migrated = outer;
+        self->finish();
+    }
+
+    /// @brief Same as `ThreadPool::global().join(a, b)`.
+    ///
+    template<typename A, typename B>
+    inline auto join(A a, B b) noexcept -> std::pair<Ret<A>, Ret<B>> {
+        return ThreadPool::global().join(mv(a), mv(b));
+    }
+}
@@ -43,7 +43,7 @@ namespace coding::result {
             /// @brief Construct the wrapper.
             /// @param value the original value
             /// 
-            inline constexpr Error(U value) noexcept : value(value) {}
+            inline constexpr Error(U value) noexcept : value(mv(value)) {}
 
             inline constexpr auto operator*() const noexcept -> U const& {
                 return this->value;
@@ -74,9 +74,9 @@ namespace coding::result {
         /// 
         std::variant<T, Error<E>> value;
 
-        inline constexpr Result(T ok) noexcept : tag(Ok), value(ok) {}
+        inline constexpr Result(T ok) noexcept : tag(Ok), value(mv(ok)) {}
 
-        inline constexpr Result(Error<E> err) noexcept : tag(Err), value(err) {}
+        inline constexpr Result(Error<E> err) noexcept : tag(Err), value(mv(err)) {}
 
     public:
 
@@ -85,7 +85,7 @@ namespace coding::result {
         /// @return new `Result`
         /// 
         inline constexpr static auto ok(T value) noexcept -> Result {
-            return Result(value);
+            return Result(mv(value));
         }
 
         /// @brief Construct an `Err` instance
@@ -93,7 +93,7 @@ namespace coding::result {
         /// @return new `Result`
         /// 
         inline constexpr static auto err(E value) noexcept -> Result {
-            return Result(Error<E>(value));
+            return Result(Error<E>(mv(value)));
         }
 
         /// @brief Implicitly cast to `Tag`.
@@ -127,6 +127,18 @@ namespace coding::result {
             return std::get<T>(this->value);
         }
 
+        /// @brief Unwrap the `Result` to an `Ok` value, moving it out.
+        /// @return the value
+        /// 
+        /// # Panic
+        /// 
+        /// Panics if the value is `Err`.
+        /// 
+        inline constexpr auto unwrap() && noexcept -> T {
+            if (this->is_err()) panic("unwrap `Result` on an `Err` value");
+            return mv(std::get<T>(this->value));
+        }
+
         /// @brief Unwrap the `Result` to an `Ok` value.
         /// @return the value
         /// 
@@ -223,7 +235,7 @@ namespace coding::result {
     /// 
     template<typename T, typename E>
     inline constexpr auto ok(T value) noexcept -> Result<T, E> {
-        return Result<T, E>::ok(value);
+        return Result<T, E>::ok(mv(value));
     }
 
     /// @brief Same as `Result<T,E>::err`, construct new `Result` instance with `Err` value.
@@ -234,7 +246,7 @@ namespace coding::result {
     /// 
     template<typename T, typename E>
     inline constexpr auto err(E value) noexcept -> Result<T, E> {
-        return Result<T, E>::err(value);
+        return Result<T, E>::err(mv(value));
     }
 
 }
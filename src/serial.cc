@@ -0,0 +1,760 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "hash.cc"
+#include "hashmap.cc"
+#include "result.cc"
+#include "str.cc"
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// @brief Zero-copy binary images of collections.
+///
+/// `encode` or `save` lays a value out as one contiguous image, which `load` or `Image::open` uses in place:
+/// strings become `Str`, sequences `Vec` and maps `Map`, read-only views whose lookups run directly on the
+/// bytes, and scalars and trivially copyable structs are stored as they are. Every reference inside the
+/// image is an offset from the field holding it, so an image works at whatever address it is mapped, and
+/// every object sits at its natural alignment. Mapped images are paged in on first access and shared
+/// through the page cache by all processes mapping the same file.
+///
+/// Loading checks the header, the type the image was written as and every offset, length and table of the
+/// image, without reading the scalar data, so a corrupt or hostile image is rejected instead of read out of
+/// bounds. Images use the byte order and type layouts of the machine, and are rejected on one of the other
+/// byte order.
+///
+namespace coding::serial {
+
+    /// @brief Why an image was rejected.
+    ///
+    enum class Error {
+
+        /// @brief A system call failed, `errno` tells why.
+        ///
+        Io,
+
+        /// @brief Not an image, or of the other byte order.
+        ///
+        Magic,
+
+        /// @brief An image of another version of the format.
+        ///
+        Version,
+
+        /// @brief An image of another type.
+        ///
+        Type,
+
+        /// @brief Shorter than its header says, or not aligned in memory.
+        ///
+        Truncated,
+
+        /// @brief An offset, length or table inside the image is out of bounds or inconsistent.
+        ///
+        Malformed,
+    };
+
+    inline constexpr u64 MAGIC = 0x31305245'53444f43; // "CODSER01"
+
+    inline constexpr u32 VERSION = 1;
+
+    /// @brief Alignment of the image in memory, and the largest alignment of a stored type.
+    ///
+    inline constexpr usize ALIGN = 16;
+
+    /// @brief Seed of the hashes of `Map` buckets. Part of the format, as `Map` lookups must hash alike.
+    ///
+    inline constexpr u64 SEED = 0x9e3779b97f4a7c15;
+
+    struct Header final {
+
+        u64 magic;
+
+        u32 version;
+
+        /// @brief `ALIGN`, checked as a guard against other ABIs.
+        ///
+        u32 align;
+
+        /// @brief Length of the whole image.
+        ///
+        u64 size;
+
+        /// @brief The `signature` of the root type.
+        ///
+        u64 type;
+    };
+
+    /// @brief The root object follows the header.
+    ///
+    inline constexpr usize ROOT = (sizeof(Header) + ALIGN - 1) / ALIGN * ALIGN;
+
+    class Writer;
+
+    class Bounds;
+
+    inline auto at(void const* from, i64 offset) noexcept -> u8 const* {
+        return static_cast<u8 const*>(from) + offset;
+    }
+
+    /// @brief A string inside an image, followed by a `NUL` so it also reads as a `str`.
+    ///
+    /// Like every view it lives only inside its image: it is neither copyable nor constructible.
+    ///
+    class Str final {
+
+    private:
+
+        friend class Writer;
+
+        friend class Bounds;
+
+        i64 offset;
+
+        u64 n;
+
+    public:
+
+        Str(Str const&) = delete;
+
+        auto operator=(Str const&) -> Str& = delete;
+
+        inline auto len() const noexcept -> usize {
+            return this->n;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->n == 0;
+        }
+
+        inline auto data() const noexcept -> char const* {
+            return reinterpret_cast<char const*>(at(this, this->offset));
+        }
+
+        inline auto as_str() const noexcept -> str {
+            return str(this->data(), this->n);
+        }
+
+        inline operator str() const noexcept {
+            return this->as_str();
+        }
+
+        inline operator std::string_view() const noexcept {
+            return std::string_view(this->data(), this->n);
+        }
+
+        inline auto operator==(std::string_view rhs) const noexcept -> bool {
+            return std::string_view(*this) == rhs;
+        }
+    };
+
+    /// @brief A sequence inside an image.
+    ///
+    template<typename T>
+    class Vec final {
+
+    private:
+
+        friend class Writer;
+
+        friend class Bounds;
+
+        i64 offset;
+
+        u64 n;
+
+    public:
+
+        Vec(Vec const&) = delete;
+
+        auto operator=(Vec const&) -> Vec& = delete;
+
+        inline auto len() const noexcept -> usize {
+            return this->n;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->n == 0;
+        }
+
+        inline auto data() const noexcept -> T const* {
+            return reinterpret_cast<T const*>(at(this, this->offset));
+        }
+
+        inline auto as_span() const noexcept -> std::span<T const> {
+            return std::span(this->data(), this->n);
+        }
+
+        inline auto get(usize i) const noexcept -> T const* {
+            return i < this->n ? this->data() + i : nullptr;
+        }
+
+        inline auto operator[](usize i) const noexcept -> T const& {
+            if (i >= this->n) [[unlikely]] panic("index out of range");
+            return this->data()[i];
+        }
+
+        inline auto begin() const noexcept -> T const* { return this->data(); }
+        inline auto end() const noexcept -> T const* { return this->data() + this->n; }
+    };
+
+    /// @brief A hash map inside an image, with keys of scalars or `Str`.
+    ///
+    /// Entries are grouped by bucket, `buckets[b]` being the first of bucket `b`, and there are as many
+    /// buckets as entries rounded up to a power of two, so a lookup hashes once and compares about one key.
+    /// Lookups take any key type hashing and comparing like the stored one, e.g. `str` for `Str` keys.
+    ///
+    template<typename K, typename V>
+    class Map final {
+
+    private:
+
+        friend class Writer;
+
+        friend class Bounds;
+
+        i64 keys_offset;
+
+        i64 values_offset;
+
+        i64 buckets_offset;
+
+        u64 n;
+
+        u64 mask;
+
+        inline auto buckets() const noexcept -> u32 const* {
+            return reinterpret_cast<u32 const*>(at(&this->buckets_offset, this->buckets_offset));
+        }
+
+    public:
+
+        /// @brief Random-access iterator over the entries in bucket order.
+        ///
+        class Iterator final {
+
+        private:
+
+            friend class Map;
+
+            K const* key;
+
+            V const* value;
+
+            inline Iterator(K const* key, V const* value) noexcept : key(key), value(value) {}
+
+        public:
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = collections::KeyValue<K const&, V const&>;
+            using difference_type = isize;
+            using reference = value_type;
+
+            inline Iterator() noexcept : key(nullptr), value(nullptr) {}
+
+            inline auto operator*() const noexcept -> value_type { return { *this->key, *this->value }; }
+            inline auto operator[](isize n) const noexcept -> value_type { return { this->key[n], this->value[n] }; }
+            inline auto operator++() noexcept -> Iterator& { ++this->key; ++this->value; return *this; }
+            inline auto operator++(int) noexcept -> Iterator { auto t = *this; ++*this; return t; }
+            inline auto operator--() noexcept -> Iterator& { --this->key; --this->value; return *this; }
+            inline auto operator--(int) noexcept -> Iterator { auto t = *this; --*this; return t; }
+            inline auto operator+=(isize n) noexcept -> Iterator& { this->key += n; this->value += n; return *this; }
+            inline auto operator-=(isize n) noexcept -> Iterator& { this->key -= n; this->value -= n; return *this; }
+            inline auto operator+(isize n) const noexcept -> Iterator { return Iterator(this->key + n, this->value + n); }
+            inline auto operator-(isize n) const noexcept -> Iterator { return Iterator(this->key - n, this->value - n); }
+            inline friend auto operator+(isize n, Iterator it) noexcept -> Iterator { return it += n; }
+            inline auto operator-(Iterator const& rhs) const noexcept -> isize { return this->key - rhs.key; }
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool { return this->key == rhs.key; }
+            inline auto operator<=>(Iterator const& rhs) const noexcept -> std::strong_ordering { return this->key <=> rhs.key; }
+        };
+
+        Map(Map const&) = delete;
+
+        auto operator=(Map const&) -> Map& = delete;
+
+        inline auto len() const noexcept -> usize {
+            return this->n;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->n == 0;
+        }
+
+        inline auto keys() const noexcept -> std::span<K const> {
+            return std::span(reinterpret_cast<K const*>(at(&this->keys_offset, this->keys_offset)), this->n);
+        }
+
+        inline auto values() const noexcept -> std::span<V const> {
+            return std::span(reinterpret_cast<V const*>(at(&this->values_offset, this->values_offset)), this->n);
+        }
+
+        template<typename Q>
+            requires hash::Hash<Q>
+        inline auto get(Q const& key) const noexcept -> V const* {
+            if constexpr (std::is_arithmetic_v<K> && std::is_arithmetic_v<Q> && !std::same_as<K, Q>) return this->get((K)key);
+            else {
+                auto b = hash::hash_one(hash::FixedState{ SEED }, key) & this->mask;
+                auto buckets = this->buckets();
+                auto keys = this->keys().data();
+                for (auto i = (usize)buckets[b]; i < buckets[b + 1]; i++) {
+                    if (hash::StdEq()(keys[i], key)) return this->values().data() + i;
+                }
+                return nullptr;
+            }
+        }
+
+        template<typename Q>
+            requires hash::Hash<Q>
+        inline auto contains(Q const& key) const noexcept -> bool {
+            return this->get(key) != nullptr;
+        }
+
+        inline auto begin() const noexcept -> Iterator { return Iterator(this->keys().data(), this->values().data()); }
+        inline auto end() const noexcept -> Iterator { return this->begin() + this->n; }
+    };
+
+    /// @brief How a source type is stored.
+    ///
+    enum class Kind { Text, Scalar, Map, Seq, Plain, Unsupported };
+
+    template<typename T>
+    concept MapEntry = requires(T const& e) { e.key; e.value; } || requires(T const& e) { e.first; e.second; };
+
+    /// @brief A range of known length, standard or with this repo's `len()`.
+    ///
+    template<typename T>
+    concept Sized = std::ranges::input_range<T const>
+        && (std::ranges::sized_range<T const> || requires(T const& v) { { v.len() } -> std::convertible_to<usize>; });
+
+    template<Sized T>
+    inline auto size_of(T const& v) noexcept -> usize {
+        if constexpr (std::ranges::sized_range<T const>) return (usize)std::ranges::size(v);
+        else return (usize)v.len();
+    }
+
+    /// @brief A map, standard or of this repo, which names its `key_type` and `mapped_type`.
+    /// Other ranges of pairs, such as `std::vector<std::pair<K, V>>`, are sequences and keep their order.
+    ///
+    template<typename T>
+    concept MapLike = Sized<T> && MapEntry<std::ranges::range_reference_t<T const>>
+        && requires { typename T::key_type; typename T::mapped_type; };
+
+    template<typename E>
+    inline auto key_of(E const& e) noexcept -> auto const& {
+        if constexpr (requires { e.key; }) return e.key;
+        else return e.first;
+    }
+
+    template<typename E>
+    inline auto value_of(E const& e) noexcept -> auto const& {
+        if constexpr (requires { e.value; }) return e.value;
+        else return e.second;
+    }
+
+    template<typename T>
+    inline consteval auto kind() noexcept -> Kind {
+        if constexpr (hash::Text<T>) return Kind::Text;
+        else if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) return Kind::Scalar;
+        else if constexpr (MapLike<T>) return Kind::Map;
+        else if constexpr (Sized<T>) return Kind::Seq;
+        else if constexpr (std::is_trivially_copyable_v<T> && !std::is_pointer_v<T> && !std::is_member_pointer_v<T>) return Kind::Plain;
+        else return Kind::Unsupported;
+    }
+
+    template<typename T, Kind = kind<T>()>
+    struct Layout {
+        static_assert(kind<T>() != Kind::Unsupported, "serial stores strings, scalars, maps, sized ranges and trivially copyable types");
+    };
+
+    /// @brief The type `T` is stored as, e.g. `Map<Str, Vec<u32>>` for `HashMap<String, std::vector<u32>>`.
+    ///
+    template<typename T>
+    using Stored = typename Layout<std::remove_cvref_t<T>>::Type;
+
+    template<typename T>
+    struct Layout<T, Kind::Text> { using Type = Str; };
+
+    template<typename T>
+    struct Layout<T, Kind::Scalar> { using Type = T; };
+
+    template<typename T>
+    struct Layout<T, Kind::Plain> { using Type = T; };
+
+    template<typename T>
+    struct Layout<T, Kind::Seq> { using Type = Vec<Stored<std::ranges::range_value_t<T const>>>; };
+
+    template<typename T>
+    struct Layout<T, Kind::Map> {
+        using Entry = std::remove_cvref_t<std::ranges::range_reference_t<T const>>;
+        using Key = std::remove_cvref_t<decltype(key_of(std::declval<Entry const&>()))>;
+        using Value = std::remove_cvref_t<decltype(value_of(std::declval<Entry const&>()))>;
+        static_assert(kind<Key>() == Kind::Text || kind<Key>() == Kind::Scalar, "serial map keys are strings or scalars");
+        using Type = Map<Stored<Key>, Stored<Value>>;
+    };
+
+    template<typename T>
+    inline constexpr bool IS_VEC = false;
+
+    template<typename T>
+    inline constexpr bool IS_VEC<Vec<T>> = true;
+
+    template<typename T>
+    inline constexpr bool IS_MAP = false;
+
+    template<typename K, typename V>
+    inline constexpr bool IS_MAP<Map<K, V>> = true;
+
+    /// @brief A fingerprint of the stored type `S`, so an image is never read as another type.
+    ///
+    /// Covers the shape, sizes and alignments of `S`, not the names of plain structs.
+    ///
+    template<typename S>
+    inline consteval auto signature() noexcept -> u64 {
+        auto mix = [](u64 h, u64 x) { return (h ^ x) * 0x100000001b3; };
+        auto h = (u64)0xcbf29ce484222325;
+        if constexpr (std::same_as<S, Str>) return mix(h, 1);
+        else if constexpr (IS_VEC<S>) return mix(mix(h, 2), signature<std::remove_cvref_t<decltype(std::declval<S const&>()[0])>>());
+        else if constexpr (IS_MAP<S>) {
+            using Key = std::remove_cvref_t<decltype(std::declval<S const&>().keys()[0])>;
+            using Value = std::remove_cvref_t<decltype(std::declval<S const&>().values()[0])>;
+            return mix(mix(mix(h, 3), signature<Key>()), signature<Value>());
+        }
+        else {
+            h = mix(mix(mix(h, 4), sizeof(S)), alignof(S));
+            if constexpr (std::is_arithmetic_v<S>) h = mix(mix(h, std::is_floating_point_v<S>), std::is_signed_v<S>);
+            return h;
+        }
+    }
+
+    /// @brief Builds an image in memory.
+    ///
+    /// Objects are placed in a slot reserved in advance, then fill in their contents after the end of the
+    /// image, so each offset is known when it is written. Gaps between objects are zero, but a trivially copyable
+    /// struct is copied as it is, padding included.
+    ///
+    class Writer final {
+
+    private:
+
+        std::vector<u8> buf;
+
+        inline auto reserve(usize size, usize align) noexcept -> usize {
+            auto pos = (this->buf.size() + align - 1) / align * align;
+            this->buf.resize(pos + size);
+            return pos;
+        }
+
+        template<typename S>
+        inline auto slot(usize pos) noexcept -> S* {
+            return reinterpret_cast<S*>(this->buf.data() + pos);
+        }
+
+        /// @brief Offset of `to` from the field at `from`.
+        ///
+        inline static auto rel(usize from, usize to) noexcept -> i64 {
+            return (i64)to - (i64)from;
+        }
+
+        /// @brief Write `value` into the slot reserved at `pos`.
+        ///
+        template<typename T>
+        inline auto fill(usize pos, T const& value) noexcept -> void {
+            using S = Stored<T>;
+            constexpr auto K = kind<std::remove_cvref_t<T>>();
+            if constexpr (K == Kind::Text) {
+                auto s = hash::text(value);
+                auto to = this->reserve(s.size() + 1, 1);
+                std::memcpy(this->buf.data() + to, s.data(), s.size());
+                this->slot<Str>(pos)->offset = rel(pos + offsetof(Str, offset), to);
+                this->slot<Str>(pos)->n = s.size();
+            }
+            else if constexpr (K == Kind::Scalar || K == Kind::Plain) {
+                std::memcpy(this->buf.data() + pos, &value, sizeof(S));
+            }
+            else if constexpr (K == Kind::Seq) {
+                using E = std::ranges::range_value_t<T const>;
+                using SE = Stored<E>;
+                auto n = size_of(value);
+                auto to = this->reserve(n * sizeof(SE), alignof(SE));
+                this->slot<S>(pos)->offset = rel(pos, to);
+                this->slot<S>(pos)->n = n;
+                if constexpr (std::ranges::contiguous_range<T const> && std::same_as<SE, E> && std::is_trivially_copyable_v<E>) {
+                    if (n > 0) std::memcpy(this->buf.data() + to, std::ranges::data(value), n * sizeof(E));
+                }
+                else {
+                    for (auto const& x : value) {
+                        this->fill(to, x);
+                        to += sizeof(SE);
+                    }
+                }
+            }
+            else {
+                using L = Layout<std::remove_cvref_t<T>>;
+                using SK = Stored<typename L::Key>;
+                using SV = Stored<typename L::Value>;
+                auto n = size_of(value);
+                if (n >= ~(u32)0) panic("serial map too large");
+                auto nb = std::bit_ceil(std::max(n, (usize)1));
+                auto mask = nb - 1;
+                // Counting sort of the entries by bucket.
+                auto entries = std::vector<std::pair<typename L::Key const*, typename L::Value const*>>();
+                auto bucket = std::vector<u64>();
+                auto starts = std::vector<u32>(nb + 1, 0);
+                entries.reserve(n);
+                bucket.reserve(n);
+                for (auto const& e : value) {
+                    entries.emplace_back(std::addressof(key_of(e)), std::addressof(value_of(e)));
+                    bucket.push_back(hash::hash_one(hash::FixedState{ SEED }, key_of(e)) & mask);
+                    starts[bucket.back() + 1]++;
+                }
+                for (auto b = (usize)0; b < nb; b++) starts[b + 1] += starts[b];
+                auto order = std::vector<usize>(n);
+                auto next = std::vector<u32>(starts.begin(), starts.end() - 1);
+                for (auto i = (usize)0; i < n; i++) order[next[bucket[i]]++] = i;
+                auto buckets = this->reserve((nb + 1) * sizeof(u32), alignof(u32));
+                std::memcpy(this->buf.data() + buckets, starts.data(), (nb + 1) * sizeof(u32));
+                auto keys = this->reserve(n * sizeof(SK), alignof(SK));
+                auto values = this->reserve(n * sizeof(SV), alignof(SV));
+                auto map = this->slot<S>(pos);
+                map->keys_offset = rel(pos + offsetof(S, keys_offset), keys);
+                map->values_offset = rel(pos + offsetof(S, values_offset), values);
+                map->buckets_offset = rel(pos + offsetof(S, buckets_offset), buckets);
+                map->n = n;
+                map->mask = mask;
+                for (auto i = (usize)0; i < n; i++) {
+                    this->fill(keys + i * sizeof(SK), *entries[order[i]].first);
+                    this->fill(values + i * sizeof(SV), *entries[order[i]].second);
+                }
+            }
+        }
+
+    public:
+
+        /// @brief The image of `value`.
+        ///
+        template<typename T>
+        inline static auto encode(T const& value) noexcept -> std::vector<u8> {
+            using S = Stored<T>;
+            static_assert(alignof(S) <= ALIGN);
+            auto w = Writer();
+            w.reserve(ROOT, 1);
+            auto root = w.reserve(sizeof(S), alignof(S));
+            w.fill(root, value);
+            w.reserve(0, ALIGN);
+            auto header = Header{ MAGIC, VERSION, (u32)ALIGN, w.buf.size(), signature<S>() };
+            std::memcpy(w.buf.data(), &header, sizeof(header));
+            return mv(w.buf);
+        }
+    };
+
+    /// @brief Validates an image: every object must lie inside it, aligned, before a view may read it.
+    ///
+    class Bounds final {
+
+    private:
+
+        u8 const* base;
+
+        usize size;
+
+        /// @brief Whether `n` objects of `T` at `offset` from `field` fit in the image, aligned.
+        ///
+        template<typename T>
+        inline auto fits(void const* field, i64 offset, u64 n, usize extra = 0) const noexcept -> bool {
+            auto from = (i64)(static_cast<u8 const*>(field) - this->base);
+            if (offset < -from || offset > (i64)this->size - from) return false;
+            auto pos = (usize)(from + offset);
+            if (pos % alignof(T) != 0) return false;
+            auto room = this->size - pos;
+            return n <= room / sizeof(T) && n * sizeof(T) + extra <= room;
+        }
+
+    public:
+
+        inline Bounds(u8 const* base, usize size) noexcept : base(base), size(size) {}
+
+        /// @brief Whether the contents of the view `s`, itself known to be inside the image, are.
+        ///
+        template<typename S>
+        inline auto check(S const& s) const noexcept -> bool {
+            if constexpr (std::same_as<S, Str>) {
+                return this->fits<char>(&s.offset, s.offset, s.n, 1) && s.data()[s.n] == 0;
+            }
+            else if constexpr (IS_VEC<S>) {
+                using E = std::remove_cvref_t<decltype(s[0])>;
+                if (!this->fits<E>(&s.offset, s.offset, s.n)) return false;
+                if constexpr (std::same_as<E, Str> || IS_VEC<E> || IS_MAP<E>) {
+                    for (auto const& x : s) if (!this->check(x)) return false;
+                }
+                return true;
+            }
+            else if constexpr (IS_MAP<S>) {
+                using K = std::remove_cvref_t<decltype(s.keys()[0])>;
+                using V = std::remove_cvref_t<decltype(s.values()[0])>;
+                auto nb = s.mask + 1;
+                if (nb == 0 || (nb & s.mask) != 0 || nb > std::bit_ceil(std::max(s.n, (u64)1))) return false;
+                if (!this->fits<u32>(&s.buckets_offset, s.buckets_offset, nb + 1)) return false;
+                if (!this->fits<K>(&s.keys_offset, s.keys_offset, s.n)) return false;
+                if (!this->fits<V>(&s.values_offset, s.values_offset, s.n)) return false;
+                auto buckets = s.buckets();
+                if (buckets[0] != 0 || buckets[nb] != s.n) return false;
+                for (auto b = (u64)0; b < nb; b++) if (buckets[b] > buckets[b + 1]) return false;
+                if constexpr (std::same_as<K, Str>) {
+                    for (auto const& k : s.keys()) if (!this->check(k)) return false;
+                }
+                if constexpr (std::same_as<V, Str> || IS_VEC<V> || IS_MAP<V>) {
+                    for (auto const& v : s.values()) if (!this->check(v)) return false;
+                }
+                return true;
+            }
+            else return true;
+        }
+    };
+
+    /// @brief The image of `value`, to `load` from memory or `save` to a file.
+    ///
+    template<typename T>
+    inline auto encode(T const& value) noexcept -> std::vector<u8> {
+        return Writer::encode(value);
+    }
+
+    /// @brief Validate the image `bytes` of a `T` and view its root in place. `bytes` must be `ALIGN`-aligned.
+    ///
+    template<typename T>
+    inline auto load(std::span<u8 const> bytes) noexcept -> Result<Stored<T> const*, Error> {
+        using S = Stored<T>;
+        using R = Result<S const*, Error>;
+        if (bytes.size() < ROOT + sizeof(S) || (uintptr_t)bytes.data() % ALIGN != 0) return R::err(Error::Truncated);
+        auto header = Header();
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (header.magic != MAGIC) return R::err(Error::Magic);
+        if (header.version != VERSION || header.align != ALIGN) return R::err(Error::Version);
+        if (header.type != signature<S>()) return R::err(Error::Type);
+        if (header.size > bytes.size()) return R::err(Error::Truncated);
+        auto root = reinterpret_cast<S const*>(bytes.data() + ROOT);
+        if (!Bounds(bytes.data(), header.size).check(*root)) return R::err(Error::Malformed);
+        return R::ok(root);
+    }
+
+    /// @brief Write the image of `value` to `path`, replacing it atomically: processes mapping the old file keep it intact.
+    ///
+    template<typename T>
+    inline auto save(str path, T const& value) noexcept -> Result<unit, Error> {
+        auto image = encode(value);
+        auto target = std::string(&path);
+        auto temp = target + ".tmp";
+        auto fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return Result<unit, Error>::err(Error::Io);
+        auto p = image.data();
+        auto left = image.size();
+        while (left > 0) {
+            auto n = ::write(fd, p, left);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) break;
+            p += n;
+            left -= n;
+        }
+        // The descriptor is closed whatever failed, and `errno` kept from the first failure.
+        auto failed = left > 0 || ::fsync(fd) < 0;
+        auto e = errno;
+        if (::close(fd) < 0 && !failed) {
+            failed = true;
+            e = errno;
+        }
+        if (!failed && ::rename(temp.c_str(), target.c_str()) < 0) {
+            failed = true;
+            e = errno;
+        }
+        if (failed) {
+            ::unlink(temp.c_str());
+            errno = e;
+            return Result<unit, Error>::err(Error::Io);
+        }
+        return Result<unit, Error>::ok(unit());
+    }
+
+    /// @brief A validated image of a `T` mapped read-only from a file, dereferencing to its root view.
+    ///
+    template<typename T>
+    class Image final {
+
+    private:
+
+        u8 const* base;
+
+        usize size;
+
+        inline Image(u8 const* base, usize size) noexcept : base(base), size(size) {}
+
+    public:
+
+        Image(Image const&) = delete;
+
+        auto operator=(Image const&) -> Image& = delete;
+
+        inline Image(Image&& rhs) noexcept : base(std::exchange(rhs.base, nullptr)), size(std::exchange(rhs.size, 0)) {}
+
+        inline auto operator=(Image&& rhs) noexcept -> Image& {
+            std::swap(this->base, rhs.base);
+            std::swap(this->size, rhs.size);
+            return *this;
+        }
+
+        inline ~Image() noexcept {
+            if (this->base) ::munmap(const_cast<u8*>(this->base), this->size);
+        }
+
+        /// @brief Map and validate the image at `path`. Pages are read from the page cache on first access.
+        ///
+        inline static auto open(str path) noexcept -> Result<Image, Error> {
+            using R = Result<Image, Error>;
+            auto p = std::string(&path);
+            auto fd = ::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0) return R::err(Error::Io);
+            struct stat st;
+            if (::fstat(fd, &st) < 0) {
+                ::close(fd);
+                return R::err(Error::Io);
+            }
+            if ((usize)st.st_size < ROOT + sizeof(Stored<T>)) {
+                ::close(fd);
+                return R::err(Error::Truncated);
+            }
+            auto addr = ::mmap(nullptr, (usize)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (addr == MAP_FAILED) return R::err(Error::Io);
+            auto image = Image(static_cast<u8 const*>(addr), (usize)st.st_size);
+            auto root = load<T>(image.bytes());
+            if (root.is_err()) return R::err(root.unwrap_err());
+            return R::ok(mv(image));
+        }
+
+        inline auto bytes() const noexcept -> std::span<u8 const> {
+            return std::span(this->base, this->size);
+        }
+
+        inline auto operator*() const noexcept -> Stored<T> const& {
+            return *reinterpret_cast<Stored<T> const*>(this->base + ROOT);
+        }
+
+        inline auto operator->() const noexcept -> Stored<T> const* {
+            return &**this;
+        }
+    };
+}
@@ -0,0 +1,197 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "mutex.cc"
+#include "thread.cc"
+
+#include <atomic>
+#include <concepts>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+namespace coding::thread {
+
+    /// @brief Merge policy adding shard values, for counters.
+    /// @tparam T the value type
+    ///
+    template<typename T>
+    struct Sum final {
+
+        inline constexpr static auto identity() noexcept -> T {
+            return T();
+        }
+
+        inline constexpr static auto merge(T const& a, T const& b) noexcept -> T {
+            return a + b;
+        }
+    };
+
+    /// @brief Merge policy keeping the largest shard value, for high-water gauges.
+    /// @tparam T the value type
+    ///
+    template<typename T>
+    struct Max final {
+
+        inline constexpr static auto identity() noexcept -> T {
+            return std::numeric_limits<T>::lowest();
+        }
+
+        inline constexpr static auto merge(T const& a, T const& b) noexcept -> T {
+            return a < b ? b : a;
+        }
+    };
+
+    /// @brief Merge policy keeping the smallest shard value, for low-water gauges.
+    /// @tparam T the value type
+    ///
+    template<typename T>
+    struct Min final {
+
+        inline constexpr static auto identity() noexcept -> T {
+            return std::numeric_limits<T>::max();
+        }
+
+        inline constexpr static auto merge(T const& a, T const& b) noexcept -> T {
+            return b < a ? b : a;
+        }
+    };
+
+    /// @brief Require a type to merge values of `T` associatively, with an identity.
+    /// @tparam Self the policy type
+    /// @tparam T the value type
+    ///
+    template<typename Self, typename T>
+    concept Merge = requires(T const& a, T const& b) {
+        { Self::identity() } -> std::convertible_to<T>;
+        { Self::merge(a, b) } -> std::convertible_to<T>;
+    };
+
+    /// @brief A value split into per-thread, cache-line padded shards, merged on read. Acts like Java's `LongAdder`.
+    ///
+    /// Every thread writes only its own shard, picked by `thread::index()`, so an update is a plain load,
+    /// modify and store with relaxed ordering: no locked instruction and no cache line shared with other writers.
+    /// `read()` walks every shard and merges them with `M`. Shards are per thread rather than per CPU:
+    /// a per-CPU shard would need restartable sequences to stay single-writer across preemption.
+    ///
+    /// Indices of exited threads are reused, so only while more threads than the capacity are alive at once do
+    /// the extra ones share an overflow shard behind a lock: correctness never depends on the capacity, only speed does.
+    ///
+    /// @tparam T the value type, lock-free atomic or at least trivially copyable
+    /// @tparam M the merge policy
+    ///
+    template<typename T, Merge<T> M = Sum<T>>
+    class Sharded final {
+
+    private:
+
+        static_assert(std::is_trivially_copyable_v<T>, "shard values are copied while being written");
+
+        constexpr static bool ATOMIC = std::atomic<T>::is_always_lock_free;
+
+        /// @brief One shard on its own cache line. Lock-free types are relaxed atomics,
+        /// others are guarded by a single-writer sequence lock.
+        ///
+        struct alignas(CACHE_LINE) Slot {
+
+            std::atomic<u32> seq = 0;
+
+            std::conditional_t<ATOMIC, std::atomic<T>, T> value = M::identity();
+
+            template<typename F>
+            inline auto update(F& f) noexcept {
+                if constexpr (ATOMIC) {
+                    auto v = this->value.load(std::memory_order_relaxed);
+                    f(v);
+                    this->value.store(v, std::memory_order_relaxed);
+                }
+                else {
+                    auto s = this->seq.load(std::memory_order_relaxed);
+                    this->seq.store(s + 1, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_release);
+                    f(this->value);
+                    this->seq.store(s + 2, std::memory_order_release);
+                }
+            }
+
+            inline auto load() const noexcept -> T {
+                if constexpr (ATOMIC) return this->value.load(std::memory_order_relaxed);
+                else loop {
+                    auto before = this->seq.load(std::memory_order_acquire);
+                    alignas(T) unsigned char copy[sizeof(T)];
+                    std::memcpy(copy, (void const*)&this->value, sizeof(T));
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (!(before & 1) && this->seq.load(std::memory_order_relaxed) == before) {
+                        T v;
+                        std::memcpy((void*)&v, copy, sizeof(T));
+                        return v;
+                    }
+                    relax();
+                }
+            }
+        };
+
+        std::unique_ptr<Slot[]> slots;
+
+        usize capacity;
+
+        Slot overflow;
+
+        RawMutex overflow_lock;
+
+    public:
+
+        /// @brief Construct with every shard at `M::identity()`.
+        /// @param capacity number of private shards, `0` for four per hardware thread
+        ///
+        inline Sharded(usize capacity = 0) noexcept {
+            if (capacity == 0) capacity = std::max((usize)std::thread::hardware_concurrency() * 4, (usize)16);
+            this->capacity = capacity;
+            this->slots = std::make_unique<Slot[]>(capacity);
+        }
+
+        Sharded(Sharded const&) = delete;
+
+        /// @brief Modify the shard of the current thread.
+        /// @param f called with `T&`
+        ///
+        template<typename F>
+        inline auto update(F f) noexcept {
+            auto i = thread::index();
+            if (i < this->capacity) [[likely]] return this->slots[i].update(f);
+            this->overflow_lock.lock();
+            this->overflow.update(f);
+            this->overflow_lock.unlock();
+        }
+
+        /// @brief Merge `x` into the shard of the current thread.
+        ///
+        inline auto add(T const& x) noexcept {
+            this->update([&](T& v) { v = M::merge(v, x); });
+        }
+
+        /// @brief Merge every shard.
+        /// @note Not a snapshot: updates racing with the read may or may not be included.
+        ///
+        inline auto read() const noexcept -> T {
+            auto ans = this->overflow.load();
+            for (auto i = (usize)0; i < this->capacity; i++) ans = M::merge(ans, this->slots[i].load());
+            return ans;
+        }
+    };
+
+    /// @brief A sharded counter: `add` is contention-free, `read` sums every shard.
+    ///
+    template<typename T = u64> using Counter = Sharded<T, Sum<T>>;
+
+    /// @brief A sharded gauge keeping the largest value recorded.
+    ///
+    template<typename T> using MaxGauge = Sharded<T, Max<T>>;
+
+    /// @brief A sharded gauge keeping the smallest value recorded.
+    ///
+    template<typename T> using MinGauge = Sharded<T, Min<T>>;
+}
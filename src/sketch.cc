@@ -0,0 +1,409 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "hash.cc"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <ranges>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/// @brief Namespace for probabilistic sketches: small, mergeable summaries of streams too large to keep.
+///
+/// Sketches hash with a fixed-seed `hash::FixedState` by default, so that instances built apart, one per thread
+/// for example, agree on every hash and can be merged. Only sketches of the same shape and builder merge.
+///
+namespace coding::sketch {
+
+    /// @brief Keys hashed per batch by bulk inserts, whose memory accesses are prefetched before any is made.
+    ///
+    inline constexpr usize BATCH = 16;
+
+    /// @brief Hash every element of `range` with `builder` and hand the hashes to `f` a batch at a time.
+    ///
+    template<typename B, std::ranges::input_range R, typename F>
+    inline auto batched(B const& builder, R&& range, F&& f) noexcept -> void {
+        u64 hashes[BATCH];
+        auto n = (usize)0;
+        for (auto const& v : range) {
+            hashes[n++] = hash::hash_one(builder, v);
+            if (n == BATCH) {
+                f(hashes, n);
+                n = 0;
+            }
+        }
+        if (n > 0) f(hashes, n);
+    }
+
+    /// @brief A split-block Bloom filter: each key sets 8 bits in one 32-byte block, one bit per 32-bit word.
+    ///
+    /// A lookup costs one cache miss where a classic filter costs one per bit, at the price of a slightly higher
+    /// false positive rate for the same size. The 8 bit positions are computed in one AVX2 multiply and shift.
+    ///
+    /// @tparam T the key type
+    /// @tparam B the `BuildHasher`
+    ///
+    template<typename T, typename B = hash::FixedState>
+        requires (hash::Hash<T> and hash::BuildHasher<B>)
+    class Bloom final {
+
+    private:
+
+        struct alignas(32) Block {
+            u32 words[8];
+        };
+
+        inline constexpr static u32 SALT[8] = {
+            0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d, 0x705495c7, 0x2df1424b, 0x9efc4947, 0x5c6bfb31,
+        };
+
+        std::vector<Block> blocks;
+
+        [[no_unique_address]] B builder;
+
+        inline auto block(u64 h) const noexcept -> usize {
+            return (usize)(((h >> 32) * (u64)this->blocks.size()) >> 32);
+        }
+
+#if defined(__AVX2__)
+        inline static auto mask(u64 h) noexcept -> __m256i {
+            auto salt = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(SALT));
+            auto bit = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32((i32)(u32)h), salt), 27);
+            return _mm256_sllv_epi32(_mm256_set1_epi32(1), bit);
+        }
+#else
+        inline static auto mask(u64 h, usize i) noexcept -> u32 {
+            return (u32)1 << (((u32)h * SALT[i]) >> 27);
+        }
+#endif
+
+        /// @brief False positive rate at `load` keys per block: blocks fill by a Poisson law, and a block with
+        /// `k` keys matches when each of 8 words has the probed bit among its about `k` set.
+        ///
+        inline static auto rate(double load) noexcept -> double {
+            auto spread = 12 * std::sqrt(load) + 12;
+            auto total = 0.0;
+            for (auto k = std::max(0.0, std::floor(load - spread)); k <= load + spread; k++) {
+                auto weight = std::exp(k * std::log(load) - load - std::lgamma(k + 1));
+                total += weight * std::pow(1 - std::pow(31.0 / 32, k), 8);
+            }
+            return total;
+        }
+
+    public:
+
+        /// @brief A filter sized for `expected` keys at a false positive rate of `fpp`.
+        ///
+        inline explicit Bloom(usize expected, double fpp = 0.01, B builder = B()) noexcept : builder(mv(builder)) {
+            if (!(fpp > 0 && fpp < 1)) panic("false positive rate must be in (0, 1)");
+            // Halve the search range over the block count, from a bound twice the classic filter's size.
+            auto n = (double)std::max(expected, (usize)1);
+            auto lo = (usize)1;
+            auto hi = std::max((usize)2, (usize)std::ceil(-2 * n * std::log(fpp) / std::log(2.0) / std::log(2.0) / 256));
+            while (rate(n / (double)hi) > fpp) hi *= 2;
+            while (lo < hi) {
+                auto mid = lo + (hi - lo) / 2;
+                if (rate(n / (double)mid) <= fpp) hi = mid;
+                else lo = mid + 1;
+            }
+            this->blocks.resize(lo);
+        }
+
+        /// @brief Size in bytes.
+        ///
+        inline auto size() const noexcept -> usize {
+            return this->blocks.size() * sizeof(Block);
+        }
+
+        inline auto insert_hash(u64 h) noexcept -> void {
+            auto& b = this->blocks[this->block(h)];
+#if defined(__AVX2__)
+            auto p = reinterpret_cast<__m256i*>(b.words);
+            _mm256_store_si256(p, _mm256_or_si256(_mm256_load_si256(p), mask(h)));
+#else
+            for (auto i = (usize)0; i < 8; i++) b.words[i] |= mask(h, i);
+#endif
+        }
+
+        inline auto contains_hash(u64 h) const noexcept -> bool {
+            auto& b = this->blocks[this->block(h)];
+#if defined(__AVX2__)
+            return _mm256_testc_si256(_mm256_load_si256(reinterpret_cast<__m256i const*>(b.words)), mask(h));
+#else
+            for (auto i = (usize)0; i < 8; i++) {
+                if (!(b.words[i] & mask(h, i))) return false;
+            }
+            return true;
+#endif
+        }
+
+        inline auto insert(T const& key) noexcept -> void {
+            this->insert_hash(hash::hash_one(this->builder, key));
+        }
+
+        /// @brief Whether `key` may have been inserted. Never false for an inserted key.
+        ///
+        inline auto contains(T const& key) const noexcept -> bool {
+            return this->contains_hash(hash::hash_one(this->builder, key));
+        }
+
+        /// @brief Insert every key of `keys`, prefetching the blocks of a batch before writing any.
+        ///
+        template<std::ranges::input_range R>
+        inline auto insert_all(R&& keys) noexcept -> void {
+            batched(this->builder, keys, [&](u64 const* hashes, usize n) {
+                for (auto i = (usize)0; i < n; i++) __builtin_prefetch(&this->blocks[this->block(hashes[i])], 1);
+                for (auto i = (usize)0; i < n; i++) this->insert_hash(hashes[i]);
+            });
+        }
+
+        /// @brief Add the keys of `rhs`, a filter of the same size and builder.
+        ///
+        inline auto merge(Bloom const& rhs) noexcept -> void {
+            if (this->blocks.size() != rhs.blocks.size()) panic("merging Bloom filters of different sizes");
+            for (auto i = (usize)0; i < this->blocks.size(); i++) {
+                for (auto j = (usize)0; j < 8; j++) this->blocks[i].words[j] |= rhs.blocks[i].words[j];
+            }
+        }
+
+        inline auto clear() noexcept -> void {
+            std::fill(this->blocks.begin(), this->blocks.end(), Block());
+        }
+    };
+
+    /// @brief A Count-Min sketch: frequency estimates that are never low and exceed the truth by at most
+    /// `epsilon` times the total count with probability `1 - delta`.
+    ///
+    /// Keys counted more than a chosen share of the total are the heavy hitters: `add` returns the new estimate
+    /// so a caller can keep the keys that cross the threshold.
+    /// Counters saturate at `u32` max.
+    ///
+    /// @tparam T the key type
+    /// @tparam B the `BuildHasher`
+    ///
+    template<typename T, typename B = hash::FixedState>
+        requires (hash::Hash<T> and hash::BuildHasher<B>)
+    class CountMin final {
+
+    private:
+
+        /// @brief `depth` rows of `width` counters, row after row.
+        ///
+        std::vector<u32> counters;
+
+        usize width;
+
+        usize depth;
+
+        u64 sum = 0;
+
+        [[no_unique_address]] B builder;
+
+        /// @brief Counter of row `r`, by double hashing from the two halves of `h`.
+        ///
+        inline auto index(u64 h, usize r) const noexcept -> usize {
+            auto step = (h >> 32) | 1;
+            return r * this->width + (usize)((h + r * step) & (this->width - 1));
+        }
+
+    public:
+
+        /// @param epsilon error bound relative to the total count
+        /// @param delta probability of exceeding the bound
+        ///
+        inline explicit CountMin(double epsilon = 0.001, double delta = 0.01, B builder = B()) noexcept : builder(mv(builder)) {
+            if (!(epsilon > 0 && epsilon < 1) || !(delta > 0 && delta < 1)) panic("Count-Min bounds must be in (0, 1)");
+            this->width = std::bit_ceil((usize)std::ceil(std::exp(1.0) / epsilon));
+            this->depth = (usize)std::ceil(std::log(1 / delta));
+            this->counters.resize(this->width * this->depth);
+        }
+
+        /// @brief Total count added.
+        ///
+        inline auto total() const noexcept -> u64 {
+            return this->sum;
+        }
+
+        inline auto add_hash(u64 h, u32 count = 1) noexcept -> u64 {
+            this->sum += count;
+            auto least = ~(u64)0;
+            for (auto r = (usize)0; r < this->depth; r++) {
+                auto& c = this->counters[this->index(h, r)];
+                c = (u32)std::min((u64)c + count, (u64)~(u32)0);
+                least = std::min(least, (u64)c);
+            }
+            return least;
+        }
+
+        inline auto estimate_hash(u64 h) const noexcept -> u64 {
+            auto least = ~(u64)0;
+            for (auto r = (usize)0; r < this->depth; r++) least = std::min(least, (u64)this->counters[this->index(h, r)]);
+            return least;
+        }
+
+        /// @brief Count `key` `count` more times.
+        /// @return the new estimate of `key`
+        ///
+        inline auto add(T const& key, u32 count = 1) noexcept -> u64 {
+            return this->add_hash(hash::hash_one(this->builder, key), count);
+        }
+
+        /// @brief An upper bound of the count of `key`, exact when no other key collides in every row.
+        ///
+        inline auto estimate(T const& key) const noexcept -> u64 {
+            return this->estimate_hash(hash::hash_one(this->builder, key));
+        }
+
+        /// @brief Count every key of `keys` once, prefetching the counters of a batch before writing any.
+        ///
+        template<std::ranges::input_range R>
+        inline auto add_all(R&& keys) noexcept -> void {
+            batched(this->builder, keys, [&](u64 const* hashes, usize n) {
+                for (auto i = (usize)0; i < n; i++) {
+                    for (auto r = (usize)0; r < this->depth; r++) __builtin_prefetch(&this->counters[this->index(hashes[i], r)], 1);
+                }
+                for (auto i = (usize)0; i < n; i++) this->add_hash(hashes[i]);
+            });
+        }
+
+        /// @brief Add the counts of `rhs`, a sketch of the same shape and builder.
+        ///
+        inline auto merge(CountMin const& rhs) noexcept -> void {
+            if (this->width != rhs.width || this->depth != rhs.depth) panic("merging Count-Min sketches of different shapes");
+            for (auto i = (usize)0; i < this->counters.size(); i++) {
+                this->counters[i] = (u32)std::min((u64)this->counters[i] + rhs.counters[i], (u64)~(u32)0);
+            }
+            this->sum += rhs.sum;
+        }
+
+        inline auto clear() noexcept -> void {
+            std::fill(this->counters.begin(), this->counters.end(), 0);
+            this->sum = 0;
+        }
+    };
+
+    /// @brief A HyperLogLog cardinality estimator over 64-bit hashes: `2^precision` one-byte registers and
+    /// a standard error of about `1.04 / sqrt(2^precision)`, 0.8% at the default of 16 KB.
+    ///
+    /// Estimates use Ertl's improved estimator, which is unbiased from zero to far beyond 2^32 without the
+    /// empirical bias tables and linear counting switch of HyperLogLog++.
+    /// Merging is a register-wise max, 32 registers per AVX2 instruction.
+    ///
+    /// @tparam T the key type
+    /// @tparam B the `BuildHasher`
+    ///
+    template<typename T, typename B = hash::FixedState>
+        requires (hash::Hash<T> and hash::BuildHasher<B>)
+    class HyperLogLog final {
+
+    private:
+
+        std::vector<u8> registers;
+
+        u32 p;
+
+        [[no_unique_address]] B builder;
+
+        /// @brief sigma of Ertl, the correction for empty registers.
+        ///
+        inline static auto sigma(double x) noexcept -> double {
+            if (x == 1) return INFINITY;
+            auto y = 1.0;
+            auto z = x;
+            for (auto prev = 0.0; prev != z;) {
+                x *= x;
+                prev = z;
+                z += x * y;
+                y += y;
+            }
+            return z;
+        }
+
+        /// @brief tau of Ertl, the correction for saturated registers.
+        ///
+        inline static auto tau(double x) noexcept -> double {
+            if (x == 0 || x == 1) return 0;
+            auto y = 1.0;
+            auto z = 1 - x;
+            for (auto prev = 0.0; prev != z;) {
+                x = std::sqrt(x);
+                prev = z;
+                y *= 0.5;
+                z -= (1 - x) * (1 - x) * y;
+            }
+            return z / 3;
+        }
+
+    public:
+
+        /// @param precision bits of hash choosing the register, from 4 to 18
+        ///
+        inline explicit HyperLogLog(u32 precision = 14, B builder = B()) noexcept : p(precision), builder(mv(builder)) {
+            if (precision < 4 || precision > 18) panic("HyperLogLog precision must be from 4 to 18");
+            this->registers.resize((usize)1 << precision);
+        }
+
+        inline auto precision() const noexcept -> u32 {
+            return this->p;
+        }
+
+        inline auto insert_hash(u64 h) noexcept -> void {
+            auto& r = this->registers[(usize)(h >> (64 - this->p))];
+            // One plus the leading zeros of the remaining bits, capped at `65 - p` by a sentinel one.
+            auto rank = (u8)(std::countl_zero((h << this->p) | ((u64)1 << (this->p - 1))) + 1);
+            r = std::max(r, rank);
+        }
+
+        inline auto insert(T const& key) noexcept -> void {
+            this->insert_hash(hash::hash_one(this->builder, key));
+        }
+
+        template<std::ranges::input_range R>
+        inline auto insert_all(R&& keys) noexcept -> void {
+            batched(this->builder, keys, [&](u64 const* hashes, usize n) {
+                for (auto i = (usize)0; i < n; i++) this->insert_hash(hashes[i]);
+            });
+        }
+
+        /// @brief The estimated number of distinct keys inserted.
+        ///
+        inline auto estimate() const noexcept -> double {
+            auto q = 64 - this->p;
+            auto m = (double)this->registers.size();
+            usize histogram[66] = {};
+            for (auto r : this->registers) histogram[r]++;
+            auto z = m * tau(1 - (double)histogram[q + 1] / m);
+            for (auto k = q; k >= 1; k--) z = 0.5 * (z + (double)histogram[k]);
+            z += m * sigma((double)histogram[0] / m);
+            return m * m / (2 * std::log(2.0)) / z;
+        }
+
+        /// @brief Add the keys of `rhs`, an estimator of the same precision and builder.
+        ///
+        inline auto merge(HyperLogLog const& rhs) noexcept -> void {
+            if (this->p != rhs.p) panic("merging HyperLogLogs of different precisions");
+            auto a = this->registers.data();
+            auto b = rhs.registers.data();
+            auto n = this->registers.size();
+            auto i = (usize)0;
+#if defined(__AVX2__)
+            for (; i + 32 <= n; i += 32) {
+                auto x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(a + i));
+                auto y = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(b + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), _mm256_max_epu8(x, y));
+            }
+#endif
+            for (; i < n; i++) a[i] = std::max(a[i], b[i]);
+        }
+
+        inline auto clear() noexcept -> void {
+            std::fill(this->registers.begin(), this->registers.end(), 0);
+        }
+    };
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "log.cc"
+#include "measure.cc"
+#include "str.cc"
+
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Structured log sites take a message followed by alternating keys and values,
+// e.g. `coding_sinfo("request done", "path", path, "status", 200, "secs", dt)`.
+#define coding_slog(level,msg,...) {if((level)<=CODING_LOG_LEVEL){static auto& _coding_module=coding::log::Module::get(CODING_LOG_MODULE);if(_coding_module.enabled(level))coding::log::structured(level,__FILE__,__LINE__,msg __VA_OPT__(,) __VA_ARGS__);}}
+
+#define coding_strace(msg,...) coding_slog(40,msg __VA_OPT__(,) __VA_ARGS__)
+
+#define coding_sdebug(msg,...) coding_slog(30,msg __VA_OPT__(,) __VA_ARGS__)
+
+#define coding_sinfo(msg,...) coding_slog(20,msg __VA_OPT__(,) __VA_ARGS__)
+
+#define coding_swarn(msg,...) coding_slog(10,msg __VA_OPT__(,) __VA_ARGS__)
+
+#define coding_serror(msg,...) coding_slog(0,msg __VA_OPT__(,) __VA_ARGS__)
+
+namespace coding::log {
+
+    /// @brief How structured log lines are serialized.
+    ///
+    enum class Format {
+
+        /// @brief `ts=... level=info at=file.cc:12 msg="..." key=value`.
+        ///
+        Logfmt,
+
+        /// @brief One JSON object per line.
+        ///
+        Json,
+    };
+
+    inline std::atomic<Format> FORMAT = Format::Logfmt;
+
+    inline auto set_format(Format format) noexcept {
+        FORMAT.store(format, std::memory_order_relaxed);
+    }
+
+    /// @brief The plain name of a level, as written in structured lines.
+    ///
+    inline auto level_name(int level) noexcept -> std::string_view {
+        if (level <= LOG_LEVEL_ERROR) return "error";
+        if (level <= LOG_LEVEL_WARN) return "warn";
+        if (level <= LOG_LEVEL_INFO) return "info";
+        if (level <= LOG_LEVEL_DEBUG) return "debug";
+        return "trace";
+    }
+
+    /// @brief Serializes one structured line straight into the thread's `Line`, without allocating.
+    ///
+    class Fields final {
+
+    private:
+
+        Line& line;
+
+        Format format;
+
+        template<typename T>
+        inline constexpr static bool STRING = std::is_same_v<std::remove_cvref_t<T>, str>
+            || std::is_convertible_v<std::remove_cvref_t<T> const&, std::string_view>;
+
+        inline static auto view(std::string_view s) noexcept -> std::string_view {
+            return s;
+        }
+
+        inline static auto view(str const& s) noexcept -> std::string_view {
+            return std::string_view(s.head, s.len);
+        }
+
+        inline static auto view(char const* s) noexcept -> std::string_view {
+            return s ? std::string_view(s) : std::string_view("(null)");
+        }
+
+        /// @brief Whether a logfmt value must be quoted.
+        ///
+        inline static auto needs_quotes(std::string_view s) noexcept -> bool {
+            if (s.empty()) return true;
+            for (auto c : s) {
+                if ((unsigned char)c <= ' ' || c == '=' || c == '"' || c == '\\' || c == 0x7f) return true;
+            }
+            return false;
+        }
+
+        inline auto put(char c) noexcept {
+            *this->line.reserve(1) = c;
+            this->line.advance(1);
+        }
+
+        /// @brief Write `s` escaped, without quotes: the same rules serve JSON and logfmt.
+        ///
+        inline auto escaped(std::string_view s) noexcept {
+            constexpr char HEX[] = "0123456789abcdef";
+            auto p = this->line.reserve(s.size() * 6);
+            auto start = p;
+            for (auto c : s) {
+                auto u = (unsigned char)c;
+                if (c == '"' || c == '\\') {
+                    *p++ = '\\';
+                    *p++ = c;
+                }
+                else if (c == '\n') { *p++ = '\\'; *p++ = 'n'; }
+                else if (c == '\t') { *p++ = '\\'; *p++ = 't'; }
+                else if (c == '\r') { *p++ = '\\'; *p++ = 'r'; }
+                else if (u < 0x20 || u == 0x7f) {
+                    std::memcpy(p, "\\u00", 4);
+                    p[4] = HEX[u >> 4];
+                    p[5] = HEX[u & 15];
+                    p += 6;
+                }
+                else *p++ = c;
+            }
+            this->line.advance((usize)(p - start));
+        }
+
+        inline auto quoted(std::string_view s) noexcept {
+            this->put('"');
+            this->escaped(s);
+            this->put('"');
+        }
+
+        inline auto string(std::string_view s) noexcept {
+            if (this->format == Format::Logfmt && !needs_quotes(s)) this->line.append(s);
+            else this->quoted(s);
+        }
+
+        template<typename T>
+        inline auto number(T v) noexcept {
+            auto p = this->line.reserve(32);
+            auto [end, ec] = std::to_chars(p, p + 32, v);
+            this->line.advance(ec == std::errc() ? (usize)(end - p) : 0);
+        }
+
+        inline auto key(std::string_view k) noexcept {
+            if (this->format == Format::Json) {
+                this->put(',');
+                this->quoted(k);
+                this->put(':');
+            }
+            else {
+                this->put(' ');
+                this->string(k);
+                this->put('=');
+            }
+        }
+
+    public:
+
+        inline Fields(Line& line, Format format) noexcept : line(line), format(format) {}
+
+        /// @brief Write the fixed fields: time with microseconds, level, call site and message.
+        ///
+        inline auto begin(int level, std::string_view file, u32 at, std::string_view msg) noexcept {
+            auto ts = timespec();
+            clock_gettime(CLOCK_REALTIME, &ts);
+            char time[std::size("yyyy-mm-ddThh:mm:ss.uuuuuuZ")];
+            std::memcpy(time, second_prefix(ts.tv_sec), 19);
+            time[19] = '.';
+            auto us = (u32)(ts.tv_nsec / 1000);
+            for (auto i = 25; i > 19; i--, us /= 10) time[i] = (char)('0' + us % 10);
+            time[26] = 'Z';
+            auto stamp = std::string_view(time, 27);
+            if (this->format == Format::Json) {
+                this->line.append("{\"ts\":\"");
+                this->line.append(stamp);
+                this->line.append("\",\"level\":\"");
+                this->line.append(level_name(level));
+                this->line.append("\",\"at\":");
+            }
+            else {
+                this->line.append("ts=");
+                this->line.append(stamp);
+                this->line.append(" level=");
+                this->line.append(level_name(level));
+                this->line.append(" at=");
+            }
+            // File names come from the build and may hold anything, the line number rides inside the same quotes.
+            auto quote = this->format == Format::Json || needs_quotes(file);
+            if (quote) this->put('"');
+            this->escaped(file);
+            this->put(':');
+            this->number(at);
+            if (quote) this->put('"');
+            if (this->format == Format::Json) {
+                this->line.append(",\"msg\":");
+                this->quoted(msg);
+            }
+            else {
+                this->line.append(" msg=");
+                this->string(msg);
+            }
+        }
+
+        /// @brief Write one key/value pair.
+        /// @tparam T a string, a number, `bool`, `char`, a pointer or a `measure::Quantity`, written as its number in SI units.
+        ///
+        template<typename T>
+        inline auto field(std::string_view k, T const& v) noexcept {
+            using U = std::remove_cvref_t<T>;
+            this->key(k);
+            if constexpr (std::is_same_v<U, bool>) this->line.append(v ? "true" : "false");
+            else if constexpr (std::is_same_v<U, char>) this->string(std::string_view(&v, 1));
+            else if constexpr (std::is_enum_v<U>) this->number(static_cast<std::underlying_type_t<U>>(v));
+            else if constexpr (std::is_integral_v<U>) this->number(v);
+            else if constexpr (std::is_floating_point_v<U>) {
+                if (this->format == Format::Json && !std::isfinite(v)) this->line.append("null");
+                else this->number(v);
+            }
+            else if constexpr (measure::IS_QUANTITY<U>) {
+                if (this->format == Format::Json && !std::isfinite(v.value())) this->line.append("null");
+                else this->number(v.value());
+            }
+            else if constexpr (STRING<U>) this->string(view(v));
+            else if constexpr (std::is_pointer_v<U>) {
+                this->line.append("\"0x");
+                auto p = this->line.reserve(16);
+                auto [end, ec] = std::to_chars(p, p + 16, (uintptr_t)v, 16);
+                this->line.advance((usize)(end - p));
+                this->put('"');
+            }
+            else static_assert(STRING<U>, "structured log values are strings, numbers or pointers");
+        }
+
+        inline auto end() noexcept {
+            if (this->format == Format::Json) this->put('}');
+            this->put('\n');
+            this->line.commit();
+        }
+    };
+
+    template<typename T, typename... A>
+    inline auto put_fields(Fields& f, std::string_view k, T const& v, A const&... rest) noexcept -> void {
+        f.field(k, v);
+        if constexpr (sizeof...(A) > 0) put_fields(f, rest...);
+    }
+
+    /// @brief Log one structured line, used by the `coding_slog` macros.
+    /// @param args alternating keys and values
+    ///
+    template<typename... A>
+    inline auto structured(int level, std::string_view file, u32 line, std::string_view msg, A const&... args) noexcept {
+        static_assert(sizeof...(A) % 2 == 0, "structured log fields are key, value pairs");
+        auto f = Fields(Line::get(), FORMAT.load(std::memory_order_relaxed));
+        f.begin(level, file, line, msg);
+        if constexpr (sizeof...(A) > 0) put_fields(f, args...);
+        f.end();
+    }
+}
@@ -0,0 +1,458 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "hashmap.cc"
+#include "option.cc"
+
+#include <bit>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace coding::collections {
+
+    namespace slot {
+
+        /// @brief A handle to a `SlotMap` entry: a slot index and the version of the slot when the entry was inserted.
+        ///
+        /// Removing an entry bumps the version of its slot, so stale keys are told apart from keys of later entries
+        /// reusing the slot. Versions of live entries are odd, so a default key never finds anything.
+        ///
+        struct Key final {
+
+            u32 index = 0;
+
+            u32 version = 0;
+
+            inline constexpr auto to_bits() const noexcept -> u64 {
+                return (u64)this->version << 32 | this->index;
+            }
+
+            inline constexpr static auto from_bits(u64 bits) noexcept -> Key {
+                return Key{ (u32)bits, (u32)(bits >> 32) };
+            }
+
+            inline constexpr auto is_null() const noexcept -> bool {
+                return this->version == 0;
+            }
+
+            inline constexpr auto operator==(Key const&) const noexcept -> bool = default;
+
+            template<typename H>
+            inline auto hash(H& h) const noexcept -> void {
+                h.write_u64(this->to_bits());
+            }
+        };
+
+        struct Slot final {
+
+            /// @brief Odd while the slot holds an entry.
+            ///
+            u32 version;
+
+            /// @brief Index of the entry in the dense arrays while occupied, of the next free slot while vacant.
+            ///
+            u32 next;
+        };
+
+        inline constexpr u32 END = ~(u32)0;
+    }
+
+    using slot::Key;
+
+    /// @brief A map from generated `Key`s to values, stored densely.
+    ///
+    /// Values sit contiguously in insertion order up to removals, which move the last value into the hole,
+    /// so iteration is a scan of an array. A slot per key maps it to the position of its value, and vacant
+    /// slots are reused through a free list. Insert, remove and lookup are O(1), and a removed key never
+    /// finds the value of a later insert reusing its slot. Slots whose version would wrap are retired.
+    ///
+    /// Handles replace pointers between objects: keys are plain 64-bit values, copied and compared freely,
+    /// and checked on every access instead of dangling.
+    ///
+    template<typename T>
+    class SlotMap final {
+
+    private:
+
+        /// @brief The values, packed without holes.
+        ///
+        std::vector<T> dense;
+
+        /// @brief The key of each value, to find the slot of a value moved by a removal.
+        ///
+        std::vector<Key> owners;
+
+        std::vector<slot::Slot> slots;
+
+        u32 free = slot::END;
+
+        inline auto find(Key key) const noexcept -> usize {
+            if (key.index >= this->slots.size()) return slot::END;
+            auto& s = this->slots[key.index];
+            return s.version == key.version && (key.version & 1) ? s.next : slot::END;
+        }
+
+    public:
+
+        /// @brief Random-access iterator over the entries in dense order.
+        ///
+        template<bool Const>
+        class Iterator final {
+
+        private:
+
+            friend class SlotMap;
+
+            Key const* key;
+
+            std::conditional_t<Const, T const*, T*> value;
+
+            inline Iterator(Key const* key, std::conditional_t<Const, T const*, T*> value) noexcept : key(key), value(value) {}
+
+        public:
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = KeyValue<Key, std::conditional_t<Const, T const&, T&>>;
+            using difference_type = isize;
+            using reference = value_type;
+
+            inline Iterator() noexcept : key(nullptr), value(nullptr) {}
+
+            inline auto operator*() const noexcept -> value_type { return { *this->key, *this->value }; }
+            inline auto operator[](isize n) const noexcept -> value_type { return { this->key[n], this->value[n] }; }
+            inline auto operator++() noexcept -> Iterator& { ++this->key; ++this->value; return *this; }
+            inline auto operator++(int) noexcept -> Iterator { auto t = *this; ++*this; return t; }
+            inline auto operator--() noexcept -> Iterator& { --this->key; --this->value; return *this; }
+            inline auto operator--(int) noexcept -> Iterator { auto t = *this; --*this; return t; }
+            inline auto operator+=(isize n) noexcept -> Iterator& { this->key += n; this->value += n; return *this; }
+            inline auto operator-=(isize n) noexcept -> Iterator& { this->key -= n; this->value -= n; return *this; }
+            inline auto operator+(isize n) const noexcept -> Iterator { return Iterator(this->key + n, this->value + n); }
+            inline auto operator-(isize n) const noexcept -> Iterator { return Iterator(this->key - n, this->value - n); }
+            inline friend auto operator+(isize n, Iterator it) noexcept -> Iterator { return it += n; }
+            inline auto operator-(Iterator const& rhs) const noexcept -> isize { return this->key - rhs.key; }
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool { return this->key == rhs.key; }
+            inline auto operator<=>(Iterator const& rhs) const noexcept -> std::strong_ordering { return this->key <=> rhs.key; }
+        };
+
+        inline SlotMap() noexcept = default;
+
+        inline static auto with_capacity(usize n) noexcept -> SlotMap {
+            auto map = SlotMap();
+            map.reserve(n);
+            return map;
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->dense.size();
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->dense.empty();
+        }
+
+        inline auto reserve(usize n) noexcept -> void {
+            this->dense.reserve(n);
+            this->owners.reserve(n);
+            this->slots.reserve(n);
+        }
+
+        /// @brief Remove every entry. Slots are kept with bumped versions, so no key issued before finds anything.
+        ///
+        inline auto clear() noexcept -> void {
+            for (auto key : this->owners) this->release(key.index);
+            this->dense.clear();
+            this->owners.clear();
+        }
+
+        /// @brief Insert a value built from its own key, for values that refer to themselves.
+        ///
+        template<typename F>
+            requires std::is_invocable_r_v<T, F, Key>
+        inline auto insert_with(F&& make) noexcept -> Key {
+            if (this->dense.size() >= slot::END) panic("slot map full");
+            auto index = this->free;
+            if (index == slot::END) {
+                index = (u32)this->slots.size();
+                this->slots.push_back(slot::Slot{ 0, slot::END });
+            }
+            auto& s = this->slots[index];
+            auto key = Key{ index, s.version + 1 };
+            this->dense.push_back(make(key));
+            if (index == this->free) this->free = s.next;
+            s.version = key.version;
+            s.next = (u32)this->owners.size();
+            this->owners.push_back(key);
+            return key;
+        }
+
+        inline auto insert(T value) noexcept -> Key {
+            return this->insert_with([&](Key) { return mv(value); });
+        }
+
+        inline auto contains(Key key) const noexcept -> bool {
+            return this->find(key) != slot::END;
+        }
+
+        inline auto get(Key key) const noexcept -> T const* {
+            auto i = this->find(key);
+            return i == slot::END ? nullptr : this->dense.data() + i;
+        }
+
+        inline auto get(Key key) noexcept -> T* {
+            auto i = this->find(key);
+            return i == slot::END ? nullptr : this->dense.data() + i;
+        }
+
+        inline auto operator[](Key key) const noexcept -> T const& {
+            auto v = this->get(key);
+            if (!v) [[unlikely]] panic("invalid slot map key");
+            return *v;
+        }
+
+        inline auto operator[](Key key) noexcept -> T& {
+            auto v = this->get(key);
+            if (!v) [[unlikely]] panic("invalid slot map key");
+            return *v;
+        }
+
+        /// @brief Remove the entry of `key`, moving the last value into its place.
+        /// @return its value, if `key` is live
+        ///
+        inline auto remove(Key key) noexcept -> Option<T> {
+            auto i = this->find(key);
+            if (i == slot::END) return Option<T>();
+            auto value = Option<T>(mv(this->dense[i]));
+            auto last = this->dense.size() - 1;
+            if (i != last) {
+                this->dense[i] = mv(this->dense[last]);
+                this->owners[i] = this->owners[last];
+                this->slots[this->owners[i].index].next = (u32)i;
+            }
+            this->dense.pop_back();
+            this->owners.pop_back();
+            this->release(key.index);
+            return value;
+        }
+
+        /// @brief Keep only the entries for which `keep(key, value)` holds.
+        ///
+        template<typename F>
+            requires std::is_invocable_r_v<bool, F, Key, T&>
+        inline auto retain(F&& keep) noexcept -> void {
+            for (auto i = (usize)0; i < this->dense.size();) {
+                if (keep(this->owners[i], this->dense[i])) i++;
+                else this->remove(this->owners[i]);
+            }
+        }
+
+        /// @brief The keys, in the same order as `values()`.
+        ///
+        inline auto keys() const noexcept -> std::span<Key const> {
+            return this->owners;
+        }
+
+        inline auto values() const noexcept -> std::span<T const> {
+            return this->dense;
+        }
+
+        inline auto values() noexcept -> std::span<T> {
+            return this->dense;
+        }
+
+        inline auto begin() noexcept -> Iterator<false> { return Iterator<false>(this->owners.data(), this->dense.data()); }
+        inline auto end() noexcept -> Iterator<false> { return this->begin() + this->len(); }
+        inline auto begin() const noexcept -> Iterator<true> { return Iterator<true>(this->owners.data(), this->dense.data()); }
+        inline auto end() const noexcept -> Iterator<true> { return this->begin() + this->len(); }
+
+    private:
+
+        /// @brief Vacate slot `index`, retiring it instead of freeing it if its version is exhausted.
+        ///
+        inline auto release(u32 index) noexcept -> void {
+            auto& s = this->slots[index];
+            // Past the last odd version the next would be 1 again, the version of keys issued long ago.
+            if (++s.version == 0) return;
+            s.next = this->free;
+            this->free = index;
+        }
+    };
+
+    /// @brief A typed index into an `Arena<T>`, so that indices of arenas of different types never mix.
+    ///
+    template<typename T>
+    struct Id final {
+
+        u32 index = 0;
+
+        inline constexpr auto operator==(Id const&) const noexcept -> bool = default;
+
+        inline constexpr auto operator<=>(Id const&) const noexcept = default;
+
+        template<typename H>
+        inline auto hash(H& h) const noexcept -> void {
+            h.write_u64(this->index);
+        }
+    };
+
+    /// @brief An append-only arena of `T`, handing out `Id<T>`s in allocation order.
+    ///
+    /// Storage grows by chunks doubling in size and never moves, so references to elements stay valid for
+    /// the life of the arena along with their ids. Elements are freed together when the arena is dropped,
+    /// which suits graphs and trees built once and traversed many times: nodes refer to each other by id,
+    /// 4 bytes instead of a pointer, with no reference counts.
+    ///
+    template<typename T>
+    class Arena final {
+
+    private:
+
+        /// @brief The first chunk holds `1 << FIRST` elements, chunk `c` holds `1 << (FIRST + c)`.
+        ///
+        inline constexpr static u32 FIRST = 4;
+
+        inline constexpr static u32 CHUNKS = 32 - FIRST;
+
+        /// @brief The number of elements the chunks hold together, short of `1 << 32` by the first chunk.
+        ///
+        inline constexpr static usize CAPACITY = ((usize)1 << 32) - ((usize)1 << FIRST);
+
+        T* chunks[CHUNKS] = {};
+
+        usize count = 0;
+
+        /// @brief The chunk and offset of index `i`: chunks start at `(1 << (FIRST + c)) - (1 << FIRST)`.
+        ///
+        inline static auto locate(usize i) noexcept -> std::pair<u32, usize> {
+            auto j = i + ((usize)1 << FIRST);
+            auto c = (u32)(std::bit_width(j) - 1 - FIRST);
+            return { c, j - ((usize)1 << (FIRST + c)) };
+        }
+
+        inline auto slot(usize i) const noexcept -> T* {
+            auto [c, offset] = locate(i);
+            return this->chunks[c] + offset;
+        }
+
+    public:
+
+        using Id = collections::Id<T>;
+
+        /// @brief Forward iterator over the elements in allocation order.
+        ///
+        template<bool Const>
+        class Iterator final {
+
+        private:
+
+            friend class Arena;
+
+            Arena const* arena;
+
+            usize i;
+
+            inline Iterator(Arena const* arena, usize i) noexcept : arena(arena), i(i) {}
+
+        public:
+
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = isize;
+            using reference = std::conditional_t<Const, T const&, T&>;
+
+            inline Iterator() noexcept : arena(nullptr), i(0) {}
+
+            inline auto operator*() const noexcept -> reference { return *this->arena->slot(this->i); }
+            inline auto operator->() const noexcept -> std::remove_reference_t<reference>* { return this->arena->slot(this->i); }
+            inline auto operator++() noexcept -> Iterator& { ++this->i; return *this; }
+            inline auto operator++(int) noexcept -> Iterator { auto t = *this; ++this->i; return t; }
+            inline auto operator==(Iterator const& rhs) const noexcept -> bool { return this->i == rhs.i; }
+        };
+
+        inline Arena() noexcept = default;
+
+        Arena(Arena const&) = delete;
+
+        auto operator=(Arena const&) -> Arena& = delete;
+
+        inline Arena(Arena&& rhs) noexcept : count(std::exchange(rhs.count, 0)) {
+            std::swap(this->chunks, rhs.chunks);
+        }
+
+        inline auto operator=(Arena&& rhs) noexcept -> Arena& {
+            std::swap(this->chunks, rhs.chunks);
+            std::swap(this->count, rhs.count);
+            return *this;
+        }
+
+        inline ~Arena() noexcept {
+            this->clear();
+            for (auto c = (u32)0; c < CHUNKS; c++) {
+                if (this->chunks[c]) ::operator delete(this->chunks[c], std::align_val_t(alignof(T)));
+            }
+        }
+
+        inline auto len() const noexcept -> usize {
+            return this->count;
+        }
+
+        inline auto is_empty() const noexcept -> bool {
+            return this->count == 0;
+        }
+
+        /// @brief Destroy every element, keeping the chunks. Every id issued before becomes invalid.
+        ///
+        inline auto clear() noexcept -> void {
+            for (auto i = (usize)0; i < this->count; i++) std::destroy_at(this->slot(i));
+            this->count = 0;
+        }
+
+        template<typename... Args>
+        inline auto emplace(Args&&... args) noexcept -> Id {
+            if (this->count >= CAPACITY) panic("arena full");
+            auto [c, offset] = locate(this->count);
+            if (!this->chunks[c]) {
+                auto size = sizeof(T) << (FIRST + c);
+                this->chunks[c] = static_cast<T*>(::operator new(size, std::align_val_t(alignof(T))));
+            }
+            new (this->chunks[c] + offset) T(std::forward<Args>(args)...);
+            return Id{ (u32)this->count++ };
+        }
+
+        inline auto alloc(T value) noexcept -> Id {
+            return this->emplace(mv(value));
+        }
+
+        inline auto contains(Id id) const noexcept -> bool {
+            return id.index < this->count;
+        }
+
+        inline auto get(Id id) const noexcept -> T const* {
+            return id.index < this->count ? this->slot(id.index) : nullptr;
+        }
+
+        inline auto get(Id id) noexcept -> T* {
+            return id.index < this->count ? this->slot(id.index) : nullptr;
+        }
+
+        inline auto operator[](Id id) const noexcept -> T const& {
+            if (id.index >= this->count) [[unlikely]] panic("arena id out of range");
+            return *this->slot(id.index);
+        }
+
+        inline auto operator[](Id id) noexcept -> T& {
+            if (id.index >= this->count) [[unlikely]] panic("arena id out of range");
+            return *this->slot(id.index);
+        }
+
+        inline auto begin() noexcept -> Iterator<false> { return Iterator<false>(this, 0); }
+        inline auto end() noexcept -> Iterator<false> { return Iterator<false>(this, this->count); }
+        inline auto begin() const noexcept -> Iterator<true> { return Iterator<true>(this, 0); }
+        inline auto end() const noexcept -> Iterator<true> { return Iterator<true>(this, this->count); }
+    };
+}
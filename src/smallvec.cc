@@ -0,0 +1,464 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "thread.cc"
+
+#include <algorithm>
+#include <compare>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace coding::collections {
+
+    /// @brief Whether moving a `T` and destroying the source is the same as copying its bytes.
+    /// Trivially copyable types are, and so are most others such as `std::unique_ptr`: specialize this to opt them in.
+    ///
+    template<typename T>
+    inline constexpr bool TRIVIALLY_RELOCATABLE = std::is_trivially_copyable_v<T>;
+
+    /// @brief Move `n` elements from `src` to the uninitialized `dst` and end their lifetime at `src`. Ranges may overlap.
+    ///
+    template<typename T>
+    inline auto relocate(T* dst, T* src, usize n) noexcept {
+        if (n == 0 || dst == src) return;
+        if constexpr (TRIVIALLY_RELOCATABLE<T>) std::memmove((void*)dst, (void const*)src, n * sizeof(T));
+        else if (dst < src) {
+            for (auto i = (usize)0; i < n; i++) {
+                new (dst + i) T(mv(src[i]));
+                src[i].~T();
+            }
+        }
+        else {
+            for (auto i = n; i-- > 0;) {
+                new (dst + i) T(mv(src[i]));
+                src[i].~T();
+            }
+        }
+    }
+
+    /// @brief A vector holding up to `N` elements inline, the implementation of `SmallVec` and `ArrayVec`.
+    ///
+    /// The interface follows `Vec`, so either can replace it in place.
+    /// Moving relocates inline elements, with one `memcpy` for `TRIVIALLY_RELOCATABLE` types.
+    ///
+    /// @tparam T the element type
+    /// @tparam N the inline capacity
+    /// @tparam Spill whether to move to the heap past `N` elements, or panic
+    ///
+    template<typename T, usize N, bool Spill>
+    class InlineVec final {
+
+    private:
+
+        static_assert(N > 0, "inline capacity must be positive");
+
+        usize count = 0;
+
+        /// @brief Heap capacity, or `N` while inline. Always `N` without `Spill`.
+        ///
+        usize cap = N;
+
+        union {
+
+            alignas(T) unsigned char buf[N * sizeof(T)];
+
+            T* heap;
+        };
+
+        inline auto spilled() const noexcept -> bool {
+            return Spill && this->cap > N;
+        }
+
+        inline auto inline_data() noexcept -> T* {
+            return std::launder(reinterpret_cast<T*>(this->buf));
+        }
+
+        /// @brief Move the elements to storage for `n`, which is inline when `n <= N`.
+        ///
+        inline auto move_to(usize n) noexcept {
+            auto from = this->data();
+            auto was_spilled = this->spilled();
+            if (n <= N) {
+                if (!was_spilled) return;
+                relocate(this->inline_data(), from, this->count);
+                this->cap = N;
+            }
+            else {
+                auto to = static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+                relocate(to, from, this->count);
+                this->heap = to;
+                this->cap = n;
+            }
+            if (was_spilled) ::operator delete(from, std::align_val_t(alignof(T)));
+        }
+
+        /// @brief Make room for `n` more elements.
+        ///
+        /// # Panic
+        ///
+        /// Panics without `Spill` if they do not fit in `N`.
+        ///
+        inline auto grow_for(usize n) noexcept {
+            if (this->count + n <= this->capacity()) [[likely]] return;
+            if constexpr (Spill) this->move_to(std::max(this->count + n, this->cap * 2));
+            else panic("`ArrayVec` capacity exceeded");
+        }
+
+        /// @brief Move to a heap buffer with room for `n` more elements, the `n` new ones at `i` built by `fill`.
+        ///
+        /// `fill` runs before the old elements move, so it may read them, as `v.push_back(v[0])` does.
+        ///
+        /// # Panic
+        ///
+        /// Panics without `Spill`.
+        ///
+        template<typename F>
+        inline auto grow_into(usize i, usize n, F&& fill) noexcept {
+            if constexpr (Spill) {
+                auto from = this->data();
+                auto was_spilled = this->spilled();
+                auto cap = std::max(this->count + n, this->cap * 2);
+                auto to = static_cast<T*>(::operator new(cap * sizeof(T), std::align_val_t(alignof(T))));
+                fill(to + i);
+                relocate(to, from, i);
+                relocate(to + i + n, from + i, this->count - i);
+                if (was_spilled) ::operator delete(from, std::align_val_t(alignof(T)));
+                this->heap = to;
+                this->cap = cap;
+                this->count += n;
+            }
+            else panic("`ArrayVec` capacity exceeded");
+        }
+
+        /// @brief Take over the elements of `rhs`, stealing its heap buffer, and leave it empty.
+        ///
+        inline auto take(InlineVec& rhs) noexcept {
+            if (rhs.spilled()) {
+                this->heap = rhs.heap;
+                this->cap = rhs.cap;
+                rhs.cap = N;
+            }
+            else relocate(this->inline_data(), rhs.inline_data(), rhs.count);
+            this->count = std::exchange(rhs.count, 0);
+        }
+
+    public:
+
+        using value_type = T;
+        using size_type = usize;
+        using difference_type = isize;
+        using reference = T&;
+        using const_reference = T const&;
+        using pointer = T*;
+        using const_pointer = T const*;
+        using iterator = T*;
+        using const_iterator = T const*;
+        using reverse_iterator = std::reverse_iterator<T*>;
+        using const_reverse_iterator = std::reverse_iterator<T const*>;
+
+        inline InlineVec() noexcept {}
+
+        inline explicit InlineVec(usize n) noexcept {
+            this->resize(n);
+        }
+
+        inline InlineVec(usize n, T const& value) noexcept {
+            this->resize(n, value);
+        }
+
+        inline InlineVec(std::initializer_list<T> init) noexcept {
+            this->insert(this->end(), init.begin(), init.end());
+        }
+
+        template<std::input_iterator I>
+        inline InlineVec(I first, I last) noexcept {
+            this->insert(this->end(), first, last);
+        }
+
+        inline InlineVec(InlineVec const& rhs) noexcept {
+            this->insert(this->end(), rhs.begin(), rhs.end());
+        }
+
+        inline InlineVec(InlineVec&& rhs) noexcept {
+            this->take(rhs);
+        }
+
+        inline auto operator=(InlineVec const& rhs) noexcept -> InlineVec& {
+            if (this != &rhs) {
+                this->clear();
+                this->insert(this->end(), rhs.begin(), rhs.end());
+            }
+            return *this;
+        }
+
+        inline auto operator=(InlineVec&& rhs) noexcept -> InlineVec& {
+            if (this != &rhs) {
+                this->clear();
+                if (this->spilled()) {
+                    ::operator delete(this->heap, std::align_val_t(alignof(T)));
+                    this->cap = N;
+                }
+                this->take(rhs);
+            }
+            return *this;
+        }
+
+        inline ~InlineVec() noexcept {
+            this->clear();
+            if (this->spilled()) ::operator delete(this->heap, std::align_val_t(alignof(T)));
+        }
+
+        inline auto data() noexcept -> T* {
+            return this->spilled() ? this->heap : this->inline_data();
+        }
+
+        inline auto data() const noexcept -> T const* {
+            return const_cast<InlineVec*>(this)->data();
+        }
+
+        inline auto size() const noexcept -> usize {
+            return this->count;
+        }
+
+        inline auto empty() const noexcept -> bool {
+            return this->count == 0;
+        }
+
+        inline auto capacity() const noexcept -> usize {
+            return this->cap;
+        }
+
+        /// @brief Whether the elements are stored inline, i.e. nothing is allocated.
+        ///
+        inline auto is_inline() const noexcept -> bool {
+            return !this->spilled();
+        }
+
+        inline auto operator[](usize i) noexcept -> T& { return this->data()[i]; }
+        inline auto operator[](usize i) const noexcept -> T const& { return this->data()[i]; }
+
+        /// @brief Index with bounds checking.
+        ///
+        /// # Panic
+        ///
+        /// Panics if `i` is out of bounds.
+        ///
+        inline auto at(usize i) noexcept -> T& {
+            if (i >= this->count) panic("index out of bounds");
+            return this->data()[i];
+        }
+
+        inline auto at(usize i) const noexcept -> T const& {
+            if (i >= this->count) panic("index out of bounds");
+            return this->data()[i];
+        }
+
+        inline auto front() noexcept -> T& { return this->data()[0]; }
+        inline auto front() const noexcept -> T const& { return this->data()[0]; }
+        inline auto back() noexcept -> T& { return this->data()[this->count - 1]; }
+        inline auto back() const noexcept -> T const& { return this->data()[this->count - 1]; }
+
+        inline auto begin() noexcept -> T* { return this->data(); }
+        inline auto end() noexcept -> T* { return this->data() + this->count; }
+        inline auto begin() const noexcept -> T const* { return this->data(); }
+        inline auto end() const noexcept -> T const* { return this->data() + this->count; }
+        inline auto cbegin() const noexcept -> T const* { return this->begin(); }
+        inline auto cend() const noexcept -> T const* { return this->end(); }
+        inline auto rbegin() noexcept -> reverse_iterator { return reverse_iterator(this->end()); }
+        inline auto rend() noexcept -> reverse_iterator { return reverse_iterator(this->begin()); }
+        inline auto rbegin() const noexcept -> const_reverse_iterator { return const_reverse_iterator(this->end()); }
+        inline auto rend() const noexcept -> const_reverse_iterator { return const_reverse_iterator(this->begin()); }
+
+        /// @brief Make room for `n` elements in total.
+        ///
+        /// # Panic
+        ///
+        /// Panics for an `ArrayVec` if `n` exceeds `N`.
+        ///
+        inline auto reserve(usize n) noexcept {
+            if (n > this->count) this->grow_for(n - this->count);
+        }
+
+        /// @brief Move the elements back inline if they fit, or into a heap buffer of their exact size.
+        ///
+        inline auto shrink_to_fit() noexcept {
+            if (this->spilled() && this->cap != this->count) this->move_to(std::max(this->count, N));
+        }
+
+        template<typename... A>
+        inline auto emplace_back(A&&... args) noexcept -> T& {
+            if (this->count == this->cap) [[unlikely]] {
+                this->grow_into(this->count, 1, [&](T* p) { new (p) T(std::forward<A>(args)...); });
+                return this->back();
+            }
+            auto p = new (this->data() + this->count) T(std::forward<A>(args)...);
+            this->count++;
+            return *p;
+        }
+
+        inline auto push_back(T const& value) noexcept {
+            this->emplace_back(value);
+        }
+
+        inline auto push_back(T&& value) noexcept {
+            this->emplace_back(mv(value));
+        }
+
+        /// @brief Push unless full, which only an `ArrayVec` can be.
+        /// @return whether `value` was pushed, it is left untouched otherwise
+        ///
+        inline auto try_push_back(T&& value) noexcept -> bool {
+            if (!Spill && this->count == N) return false;
+            this->emplace_back(mv(value));
+            return true;
+        }
+
+        inline auto try_push_back(T const& value) noexcept -> bool {
+            if (!Spill && this->count == N) return false;
+            this->emplace_back(value);
+            return true;
+        }
+
+        inline auto pop_back() noexcept {
+            this->data()[--this->count].~T();
+        }
+
+        template<typename... A>
+        inline auto emplace(T const* pos, A&&... args) noexcept -> T* {
+            auto i = (usize)(pos - this->data());
+            auto value = T(std::forward<A>(args)...);
+            this->grow_for(1);
+            auto p = this->data() + i;
+            relocate(p + 1, p, this->count - i);
+            new (p) T(mv(value));
+            this->count++;
+            return p;
+        }
+
+        inline auto insert(T const* pos, T const& value) noexcept -> T* {
+            return this->emplace(pos, value);
+        }
+
+        inline auto insert(T const* pos, T&& value) noexcept -> T* {
+            return this->emplace(pos, mv(value));
+        }
+
+        /// @brief Insert the elements of `[first, last)` before `pos`.
+        /// @return where the first of them is
+        ///
+        template<std::input_iterator I>
+        inline auto insert(T const* pos, I first, I last) noexcept -> T* {
+            auto i = (usize)(pos - this->data());
+            if constexpr (std::forward_iterator<I>) {
+                // The range may be part of this vector: it is copied before anything moves, into new storage,
+                // or in place when it is known not to overlap, or else after the elements and rotated in.
+                auto n = (usize)std::distance(first, last);
+                if (this->count + n > this->cap) {
+                    this->grow_into(i, n, [&](T* p) { std::uninitialized_copy(first, last, p); });
+                    return this->data() + i;
+                }
+                constexpr auto same = std::contiguous_iterator<I>
+                    && std::is_same_v<std::remove_cvref_t<std::iter_reference_t<I>>, T>;
+                if constexpr (same) {
+                    auto src = std::to_address(first);
+                    auto p = this->data() + i;
+                    if (n && (src + n <= this->data() || src >= this->data() + this->count)) {
+                        relocate(p + n, p, this->count - i);
+                        if constexpr (std::is_trivially_copyable_v<T>) std::memcpy((void*)p, src, n * sizeof(T));
+                        else std::uninitialized_copy(src, src + n, p);
+                        this->count += n;
+                        return p;
+                    }
+                }
+                auto end = this->data() + this->count;
+                std::uninitialized_copy(first, last, end);
+                this->count += n;
+                std::rotate(this->data() + i, end, end + n);
+            }
+            else {
+                auto n = this->count;
+                for (; first != last; ++first) this->emplace_back(*first);
+                std::rotate(this->data() + i, this->data() + n, this->data() + this->count);
+            }
+            return this->data() + i;
+        }
+
+        inline auto insert(T const* pos, std::initializer_list<T> init) noexcept -> T* {
+            return this->insert(pos, init.begin(), init.end());
+        }
+
+        inline auto erase(T const* first, T const* last) noexcept -> T* {
+            auto i = (usize)(first - this->data());
+            auto n = (usize)(last - first);
+            auto p = this->data() + i;
+            std::destroy(p, p + n);
+            relocate(p, p + n, this->count - i - n);
+            this->count -= n;
+            return p;
+        }
+
+        inline auto erase(T const* pos) noexcept -> T* {
+            return this->erase(pos, pos + 1);
+        }
+
+        inline auto clear() noexcept {
+            std::destroy(this->data(), this->data() + this->count);
+            this->count = 0;
+        }
+
+        inline auto resize(usize n) noexcept {
+            if (n <= this->count) {
+                std::destroy(this->data() + n, this->data() + this->count);
+                this->count = n;
+                return;
+            }
+            this->grow_for(n - this->count);
+            std::uninitialized_value_construct(this->data() + this->count, this->data() + n);
+            this->count = n;
+        }
+
+        inline auto resize(usize n, T const& value) noexcept {
+            if (n <= this->count) {
+                std::destroy(this->data() + n, this->data() + this->count);
+                this->count = n;
+                return;
+            }
+            if (n > this->cap) {
+                this->grow_into(this->count, n - this->count, [&](T* p) { std::uninitialized_fill(p, p + n - this->count, value); });
+                return;
+            }
+            std::uninitialized_fill(this->data() + this->count, this->data() + n, value);
+            this->count = n;
+        }
+
+        inline auto swap(InlineVec& rhs) noexcept {
+            auto t = mv(rhs);
+            rhs = mv(*this);
+            *this = mv(t);
+        }
+
+        inline auto operator==(InlineVec const& rhs) const noexcept -> bool {
+            return std::equal(this->begin(), this->end(), rhs.begin(), rhs.end());
+        }
+
+        inline auto operator<=>(InlineVec const& rhs) const noexcept {
+            return std::lexicographical_compare_three_way(this->begin(), this->end(), rhs.begin(), rhs.end());
+        }
+    };
+
+    /// @brief A `Vec` storing up to `N` elements inline, without allocating, and spilling to the heap past that.
+    ///
+    template<typename T, usize N>
+    using SmallVec = InlineVec<T, N, true>;
+
+    /// @brief A `Vec` of fixed capacity `N` that never allocates. Pushing past `N` panics, see `try_push_back`.
+    ///
+    template<typename T, usize N>
+    using ArrayVec = InlineVec<T, N, false>;
+}
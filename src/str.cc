@@ -7,6 +7,8 @@
 
 #include <cstring>
 #include <cstdlib>
+#include <functional>
+#include <string_view>
 #include <vector>
 
 #define str str
@@ -55,6 +57,12 @@ public:
         return std::string_view(this->head, this->len);
     }
 
+    /// @brief Compare the contents of two strings.
+    /// 
+    inline constexpr auto operator==(str const& rhs) const noexcept -> bool {
+        return std::string_view(this->head, this->len) == std::string_view(rhs.head, rhs.len);
+    }
+
     /// @brief Index the string.
     /// @param idx the index
     /// @return the `idx`th char
@@ -292,6 +300,10 @@ namespace coding {
             return this->data[idx];
         }
 
+        inline constexpr auto operator==(String const& rhs) const noexcept -> bool {
+            return this->data == rhs.data;
+        }
+
         inline constexpr auto operator+=(String const& rhs) noexcept {
             this->data.insert(this->data.end(), rhs.data.begin(), rhs.data.end());
         }
@@ -307,3 +319,17 @@ namespace coding {
 }
 
 inline constexpr auto operator"" _str(char const* s, usize len) noexcept -> str { return str(s, len); };
+
+template<>
+struct std::hash<str> {
+    inline auto operator()(str const& s) const noexcept -> usize {
+        return std::hash<std::string_view>{}(std::string_view(s.head, s.len));
+    }
+};
+
+template<>
+struct std::hash<coding::String> {
+    inline auto operator()(coding::String const& s) const noexcept -> usize {
+        return std::hash<str>{}(static_cast<str>(s));
+    }
+};
@@ -2,12 +2,34 @@
 
 #include "root.cc"
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
 #include <thread>
 #include <iostream>
+#include <vector>
 
 /// @brief Namespace for operating with threads.
 namespace coding::thread {
 
+    /// @brief Hooks run by `panic` before printing its message, e.g. to flush buffered logs.
+    /// 
+    inline std::atomic<void (*)()> PANIC_HOOKS[8] = {};
+
+    /// @brief Register a function for `panic` to run before the process exits.
+    /// @param hook the function, it must not panic itself
+    /// @return whether there was room left for it
+    /// 
+    inline auto on_panic(void (*hook)()) noexcept -> bool {
+        for (auto& slot : PANIC_HOOKS) {
+            void (*empty)() = nullptr;
+            if (slot.compare_exchange_strong(empty, hook, std::memory_order_acq_rel)) return true;
+        }
+        return false;
+    }
+
     /// @brief Panic the current thread.
     /// @tparam T a type able to be printed with `std::ostream`
     /// @param msg message to print to `stderr` before exit
@@ -15,12 +37,74 @@ namespace coding::thread {
     /// 
     template<typename T>
     auto panic(T msg = "") noexcept {
+        for (auto& slot : PANIC_HOOKS) {
+            if (auto hook = slot.load(std::memory_order_acquire)) hook();
+        }
         auto id = std::this_thread::get_id();
         std::cerr
             << std::endl << std::endl
             << "panic at thread '" << id << "': " << msg << std::endl;
         std::exit(-1);
     }
+
+    /// @brief Size of a cache line, used to pad data shared between threads.
+    /// 
+    constexpr std::size_t CACHE_LINE = 64;
+
+    /// @brief The index of a thread, returned to a pool when the thread exits.
+    /// 
+    struct Index final {
+
+        /// @brief Indices of exited threads, as a min-heap so the lowest are handed out first.
+        /// 
+        struct Pool final {
+
+            std::mutex lock;
+
+            std::vector<std::size_t> free;
+
+            std::size_t next = 0;
+        };
+
+        std::size_t id;
+
+        /// @brief The pool, never destroyed, as threads may exit after static destructors ran.
+        /// 
+        inline static auto pool() noexcept -> Pool& {
+            static auto p = new Pool();
+            return *p;
+        }
+
+        inline Index() noexcept {
+            auto& p = pool();
+            auto guard = std::lock_guard(p.lock);
+            if (p.free.empty()) this->id = p.next++;
+            else {
+                std::pop_heap(p.free.begin(), p.free.end(), std::greater<>());
+                this->id = p.free.back();
+                p.free.pop_back();
+            }
+        }
+
+        Index(Index const&) = delete;
+
+        inline ~Index() noexcept {
+            auto& p = pool();
+            auto guard = std::lock_guard(p.lock);
+            p.free.push_back(this->id);
+            std::push_heap(p.free.begin(), p.free.end(), std::greater<>());
+        }
+    };
+
+    /// @brief A small dense index of the current thread, assigned on first use.
+    /// @note Indices of exited threads are reused, lowest first, so they stay below the largest number of threads
+    /// alive at once. They may still exceed any fixed size: mask them before indexing a fixed table.
+    /// @return the index
+    /// 
+    inline auto index() noexcept -> std::size_t {
+        thread_local Index index;
+        return index.id;
+    }
 }
 
 namespace coding {
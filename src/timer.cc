@@ -0,0 +1,381 @@
+#pragma once
+
+#include "root.cc"
+#include "core.cc"
+#include "measure.cc"
+#include "mutex.cc"
+#include "pool.cc"
+#include "thread.cc"
+
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace coding::thread {
+
+    /// @brief Handle of a scheduled timer, used to cancel it.
+    /// @note Handles carry a generation, so cancelling a timer that already fired is a harmless no-op.
+    ///
+    struct TimerId final {
+
+        u32 index;
+
+        u32 generation;
+
+        inline constexpr auto operator==(TimerId const& rhs) const noexcept -> bool = default;
+    };
+
+    /// @brief A hashed hierarchical timer wheel counting in abstract ticks. Not thread-safe, see `Timers`.
+    ///
+    /// Four levels of 256 slots cover 2^32 ticks. A timer goes into the level whose span contains its
+    /// remaining delay, so inserting and cancelling are O(1) list operations. Whenever level `L` wraps,
+    /// the next slot of level `L + 1` is cascaded down. Timers further out wait in the top level and are
+    /// re-linked each time the wheel comes around to their slot, until they are within reach: none fires early. Timers live in one slab linked by indices,
+    /// so a wheel with hundreds of thousands of timers does one allocation per growth, not per timer.
+    ///
+    class TimerWheel final {
+
+    private:
+
+        constexpr static u32 NIL = UINT32_MAX;
+
+        constexpr static u32 BITS = 8;
+
+        constexpr static u32 SLOTS = 1 << BITS;
+
+        constexpr static u32 LEVELS = 4;
+
+        struct Node {
+
+            u32 prev = NIL;
+
+            u32 next = NIL;
+
+            u32 generation = 0;
+
+            /// @brief `LEVELS * SLOTS` for a free node.
+            ///
+            u32 slot = LEVELS * SLOTS;
+
+            u64 expires = 0;
+
+            /// @brief Re-arm period in ticks, `0` for one-shot timers.
+            ///
+            u64 period = 0;
+
+            std::function<void()> callback;
+        };
+
+        std::vector<Node> nodes;
+
+        u32 free = NIL;
+
+        /// @brief Heads of every slot list, level by level.
+        ///
+        u32 heads[LEVELS * SLOTS];
+
+        /// @brief One bit per non-empty slot of level 0, to skip idle ticks.
+        ///
+        u64 occupied[SLOTS / 64] = {};
+
+        /// @brief The next tick to process.
+        ///
+        u64 current = 0;
+
+        usize count = 0;
+
+        inline auto link(u32 i) noexcept {
+            auto& n = this->nodes[i];
+            auto delta = n.expires > this->current ? n.expires - this->current : 0;
+            auto level = (u32)0;
+            while (level + 1 < LEVELS && delta >= ((u64)1 << (BITS * (level + 1)))) level++;
+            // Out of reach: wait in the top-level slot being passed, cascaded again once the wheel comes around.
+            auto at = delta == 0 || delta >= ((u64)1 << (BITS * LEVELS)) ? this->current : n.expires;
+            auto slot = level * SLOTS + (u32)((at >> (BITS * level)) & (SLOTS - 1));
+            n.slot = slot;
+            n.prev = NIL;
+            n.next = this->heads[slot];
+            if (n.next != NIL) this->nodes[n.next].prev = i;
+            this->heads[slot] = i;
+            if (level == 0) this->occupied[slot / 64] |= (u64)1 << (slot % 64);
+        }
+
+        inline auto unlink(u32 i) noexcept {
+            auto& n = this->nodes[i];
+            if (n.prev != NIL) this->nodes[n.prev].next = n.next;
+            else this->heads[n.slot] = n.next;
+            if (n.next != NIL) this->nodes[n.next].prev = n.prev;
+            if (n.slot < SLOTS && this->heads[n.slot] == NIL) this->occupied[n.slot / 64] &= ~((u64)1 << (n.slot % 64));
+        }
+
+        inline auto release(u32 i) noexcept {
+            auto& n = this->nodes[i];
+            n.slot = LEVELS * SLOTS;
+            n.generation++;
+            n.callback = nullptr;
+            n.next = this->free;
+            this->free = i;
+            this->count--;
+        }
+
+        /// @brief Re-insert every timer of a higher-level slot relative to `current`.
+        ///
+        inline auto cascade(u32 level, u32 idx) noexcept {
+            auto slot = level * SLOTS + idx;
+            auto i = this->heads[slot];
+            this->heads[slot] = NIL;
+            while (i != NIL) {
+                auto next = this->nodes[i].next;
+                this->link(i);
+                i = next;
+            }
+        }
+
+        /// @brief Process the tick `current` and move on to the next one.
+        ///
+        template<typename F>
+        inline auto step(F& sink) noexcept {
+            auto idx = (u32)(this->current & (SLOTS - 1));
+            for (auto level = (u32)1; level < LEVELS; level++) {
+                if (((this->current >> (BITS * (level - 1))) & (SLOTS - 1)) != 0) break;
+                this->cascade(level, (u32)((this->current >> (BITS * level)) & (SLOTS - 1)));
+            }
+            auto i = this->heads[idx];
+            this->heads[idx] = NIL;
+            this->occupied[idx / 64] &= ~((u64)1 << (idx % 64));
+            while (i != NIL) {
+                auto& n = this->nodes[i];
+                auto next = n.next;
+                if (n.period) {
+                    sink(std::function<void()>(n.callback));
+                    // An overdue timer skips the periods it missed, keeping its phase, rather than firing late for each.
+                    n.expires += ((this->current - n.expires) / n.period + 1) * n.period;
+                    this->link(i);
+                }
+                else {
+                    sink(mv(n.callback));
+                    this->release(i);
+                }
+                i = next;
+            }
+            this->current++;
+        }
+
+    public:
+
+        inline TimerWheel() noexcept {
+            for (auto& h : this->heads) h = NIL;
+        }
+
+        /// @brief Number of pending timers.
+        ///
+        inline auto len() const noexcept -> usize {
+            return this->count;
+        }
+
+        /// @brief The next tick to be processed.
+        ///
+        inline auto now() const noexcept -> u64 {
+            return this->current;
+        }
+
+        /// @brief Schedule `callback` at tick `expires`, re-arming every `period` ticks if non-zero.
+        /// @note Ticks in the past fire on the next `advance`.
+        /// @return the handle to cancel it
+        ///
+        inline auto insert(u64 expires, std::function<void()> callback, u64 period = 0) noexcept -> TimerId {
+            u32 i;
+            if (this->free != NIL) {
+                i = this->free;
+                this->free = this->nodes[i].next;
+            }
+            else {
+                i = (u32)this->nodes.size();
+                this->nodes.emplace_back();
+            }
+            auto& n = this->nodes[i];
+            n.expires = expires;
+            n.period = period;
+            n.callback = mv(callback);
+            this->count++;
+            this->link(i);
+            return TimerId{ i, n.generation };
+        }
+
+        /// @brief Cancel a pending timer.
+        /// @return whether the timer was still pending
+        ///
+        inline auto cancel(TimerId id) noexcept -> bool {
+            if (id.index >= this->nodes.size()) return false;
+            auto& n = this->nodes[id.index];
+            if (n.generation != id.generation || n.slot == LEVELS * SLOTS) return false;
+            this->unlink(id.index);
+            this->release(id.index);
+            return true;
+        }
+
+        /// @brief Process every tick before `to`, handing the callbacks that expire to `sink` in one batch.
+        /// @param to the first tick not to process
+        /// @param sink called with each expired `std::function<void()>`
+        /// @warning `sink` must not touch the wheel, collect the callbacks and run them afterwards.
+        ///
+        template<typename F>
+        inline auto advance(u64 to, F sink) noexcept {
+            while (this->current < to) {
+                if (this->count == 0) {
+                    this->current = to;
+                    return;
+                }
+                auto idle = this->idle_ticks();
+                if (idle > 0) {
+                    this->current += std::min(idle, to - this->current);
+                    continue;
+                }
+                this->step(sink);
+            }
+        }
+
+        /// @brief How many ticks from `now()` are known to do nothing: no level-0 timer is due and no cascade happens.
+        ///
+        inline auto idle_ticks() const noexcept -> u64 {
+            auto idx = (u32)(this->current & (SLOTS - 1));
+            if (idx == 0) return 0;
+            for (auto i = idx; i < SLOTS;) {
+                auto word = this->occupied[i / 64] >> (i % 64);
+                if (word) return i + std::countr_zero(word) - idx;
+                i = (i / 64 + 1) * 64;
+            }
+            return SLOTS - idx;
+        }
+    };
+
+    /// @brief A timer service: a `TimerWheel` ticked by a background thread that hands expired callbacks to a `ThreadPool`.
+    ///
+    /// The thread sleeps until the next tick that can do any work, so idle timers cost nothing,
+    /// and every callback expiring on the same tick is dispatched in one batch.
+    ///
+    class Timers final {
+
+    private:
+
+        Mutex<TimerWheel> wheel;
+
+        ThreadPool* pool;
+
+        std::chrono::steady_clock::time_point start;
+
+        std::chrono::nanoseconds tick;
+
+        /// @brief Bumped to wake the ticking thread early.
+        ///
+        std::atomic<u32> signal = 0;
+
+        /// @brief The tick the thread plans to wake at.
+        ///
+        std::atomic<u64> planned = UINT64_MAX;
+
+        std::atomic<bool> stop = false;
+
+        std::thread ticker;
+
+        inline auto ticks_now() const noexcept -> u64 {
+            return (u64)((std::chrono::steady_clock::now() - this->start) / this->tick);
+        }
+
+        inline auto to_ticks(measure::Time t) const noexcept -> u64 {
+            auto ns = t.value() * 1e9;
+            if (ns <= 0) return 0;
+            return (u64)std::ceil(ns / (double)this->tick.count());
+        }
+
+        inline auto run() noexcept {
+            auto due = std::vector<std::function<void()>>();
+            while (!this->stop.load(std::memory_order_relaxed)) {
+                auto s = this->signal.load(std::memory_order_acquire);
+                auto now = this->ticks_now();
+                auto next = UINT64_MAX;
+                {
+                    auto w = this->wheel.lock();
+                    w->advance(now + 1, [&](std::function<void()> f) { due.push_back(mv(f)); });
+                    if (w->len()) next = w->now() + w->idle_ticks();
+                    this->planned.store(next, std::memory_order_seq_cst);
+                }
+                for (auto& f : due) this->pool->spawn(mv(f));
+                due.clear();
+                if (next == UINT64_MAX) futex::wait(this->signal, s);
+                else {
+                    auto at = this->start + this->tick * (i64)next;
+                    auto d = at - std::chrono::steady_clock::now();
+                    if (d > std::chrono::nanoseconds(0)) futex::wait_for(this->signal, s, std::chrono::duration_cast<std::chrono::nanoseconds>(d));
+                }
+            }
+        }
+
+        inline auto add(u64 expires, std::function<void()> f, u64 period) noexcept -> TimerId {
+            auto id = this->wheel.lock()->insert(expires, mv(f), period);
+            if (expires < this->planned.load(std::memory_order_seq_cst)) {
+                this->signal.fetch_add(1, std::memory_order_release);
+                futex::wake(this->signal);
+            }
+            return id;
+        }
+
+    public:
+
+        /// @brief Start the service.
+        /// @param tick the resolution, deadlines are rounded up to it, 1 ms by default
+        /// @param pool where callbacks run
+        ///
+        inline Timers(measure::Time tick = measure::Time(1e-3), ThreadPool& pool = ThreadPool::global()) noexcept
+            : pool(&pool), start(std::chrono::steady_clock::now()),
+            tick(std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::duration<double>(tick.value())), std::chrono::nanoseconds(1))) {
+            this->ticker = std::thread([this] { this->run(); });
+        }
+
+        Timers(Timers const&) = delete;
+
+        /// @brief Stop the ticking thread. Pending timers never fire.
+        ///
+        inline ~Timers() noexcept {
+            this->stop.store(true, std::memory_order_relaxed);
+            this->signal.fetch_add(1, std::memory_order_release);
+            futex::wake(this->signal);
+            this->ticker.join();
+        }
+
+        /// @brief Run `f` once after `delay`.
+        /// @return the handle to cancel it
+        ///
+        template<typename F>
+        inline auto after(measure::Time delay, F f) noexcept -> TimerId {
+            return this->add(this->ticks_now() + this->to_ticks(delay), std::function<void()>(mv(f)), 0);
+        }
+
+        /// @brief Run `f` every `period`, the first time after one `period`.
+        /// @note `f` is copied for every run, overlapping runs are possible if it is slower than `period`.
+        /// @return the handle to cancel it
+        ///
+        template<typename F>
+        inline auto every(measure::Time period, F f) noexcept -> TimerId {
+            auto p = std::max(this->to_ticks(period), (u64)1);
+            return this->add(this->ticks_now() + p, std::function<void()>(mv(f)), p);
+        }
+
+        /// @brief Cancel a timer.
+        /// @return whether it was still pending
+        ///
+        inline auto cancel(TimerId id) noexcept -> bool {
+            return this->wheel.lock()->cancel(id);
+        }
+
+        /// @brief Number of pending timers.
+        ///
+        inline auto len() noexcept -> usize {
+            return this->wheel.lock()->len();
+        }
+    };
+}
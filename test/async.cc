@@ -0,0 +1,136 @@
+#include "../src/async.cc"
+#include "check.cc"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace coding;
+using namespace coding::async;
+
+// Everything readable from `io` until the end of stream.
+static auto read_all(Io& io) -> Task<std::string> {
+    auto out = std::string();
+    char buf[4096];
+    loop {
+        auto r = co_await io.read(std::span<char>(buf, sizeof(buf)));
+        coding_check(r.is_ok());
+        auto n = r.unwrap();
+        if (n == 0) break;
+        out.append(buf, n);
+    }
+    co_return out;
+}
+
+static auto write_then_close(Io io, std::string data) -> Task<void> {
+    auto r = co_await io.write_all(std::span<char const>(data.data(), data.size()));
+    coding_check(r.is_ok() && r.unwrap() == data.size());
+}
+
+static auto pattern(usize n) -> std::string {
+    auto s = std::string(n, '\0');
+    for (auto i = (usize)0; i < n; i++) s[i] = (char)('a' + i * 7 % 26);
+    return s;
+}
+
+static auto pipes() -> Task<void> {
+    auto [r, w] = pipe().unwrap();
+    auto sent = (co_await w.write(str("hello"))).unwrap();
+    coding_check(sent == 5);
+    w.close();
+    coding_check(co_await read_all(r) == "hello");
+}
+
+// A write bigger than the socket buffer comes back short, then `write_all` finishes it while the other end reads.
+static auto sockets() -> Task<void> {
+    auto [a, b] = socketpair().unwrap();
+    auto data = pattern(8 << 20);
+    auto first = (co_await a.write(std::span<char const>(data.data(), data.size()))).unwrap();
+    coding_check(first > 0 && first < data.size());
+    Executor::get().schedule(detach(write_then_close(mv(a), data.substr(first))).h);
+    coding_check(co_await read_all(b) == data);
+}
+
+static auto sleeper(std::vector<int>* order, int id, double secs) -> Task<void> {
+    co_await sleep(measure::Time(secs));
+    order->push_back(id);
+}
+
+static auto sleeps() -> Task<void> {
+    auto order = std::vector<int>();
+    auto start = std::chrono::steady_clock::now();
+    auto& ex = Executor::get();
+    ex.schedule(detach(sleeper(&order, 1, 0.06)).h);
+    ex.schedule(detach(sleeper(&order, 2, 0.02)).h);
+    ex.schedule(detach(sleeper(&order, 3, 0.04)).h);
+    co_await sleep(measure::Time(0.01));
+    coding_check(order.empty());
+    co_await sleep(measure::Time(0.08));
+    coding_check((order == std::vector<int>{ 2, 3, 1 }));
+    coding_check(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(60));
+}
+
+static auto client(std::string path) -> Task<void> {
+    auto io = (co_await connect_unix(str(path.data(), path.size()))).unwrap();
+    coding_check((co_await io.write_all(std::span<char const>("ping", 4))).is_ok());
+    char buf[4];
+    auto got = (usize)0;
+    while (got < 4) got += (co_await io.read(std::span<char>(buf + got, 4 - got))).unwrap();
+    coding_check(std::string(buf, 4) == "pong");
+}
+
+// One round trip over a Unix socket, the client a task of its own.
+static auto unix_sockets(std::string path) -> Task<void> {
+    ::unlink(path.c_str());
+    auto server = listen_unix(str(path.data(), path.size())).unwrap();
+    Executor::get().schedule(detach(client(path)).h);
+    auto conn = (co_await server.accept()).unwrap();
+    char buf[4];
+    auto got = (usize)0;
+    while (got < 4) got += (co_await conn.read(std::span<char>(buf + got, 4 - got))).unwrap();
+    coding_check(std::string(buf, 4) == "ping");
+    coding_check((co_await conn.write_all(std::span<char const>("pong", 4))).is_ok());
+    coding_check((co_await conn.read(std::span<char>(buf, 4))).unwrap() == 0);
+    ::unlink(path.c_str());
+}
+
+static auto files(std::string path) -> Task<usize> {
+    auto data = pattern(300000);
+    {
+        auto f = open(str(path.data(), path.size()), O_WRONLY | O_CREAT | O_TRUNC).unwrap();
+        auto r = co_await f.write_all(std::span<char const>(data.data(), data.size()));
+        coding_check(r.is_ok() && r.unwrap() == data.size());
+    }
+    auto f = open(str(path.data(), path.size()), O_RDONLY).unwrap();
+    auto back = co_await read_all(f);
+    coding_check(back == data);
+    coding_check(open(str("/nonexistent/coding-test"), O_RDONLY).is_err());
+    ::unlink(path.c_str());
+    co_return back.size();
+}
+
+auto main() -> int {
+    auto dir = std::string("/tmp/coding-test-async.") + std::to_string(getpid());
+    {
+        auto rt = Runtime();
+        rt.block_on(pipes());
+        rt.block_on(sockets());
+        rt.block_on(sleeps());
+        rt.block_on(unix_sockets(dir + ".sock"));
+    }
+    // Regular files through `io_uring` when the kernel has it, and synchronously.
+    for (auto uring : { true, false }) {
+        auto rt = Runtime(uring);
+        if (!uring) coding_check(!rt.reactor().has_uring());
+        coding_check(rt.block_on(files(dir + ".file")) == 300000);
+    }
+    {
+        auto rt = ThreadedRuntime(2);
+        rt.block_on(sockets());
+        rt.block_on(unix_sockets(dir + ".sock"));
+        for (auto i = 0; i < 200; i++) rt.block_on(pipes());
+    }
+    return 0;
+}
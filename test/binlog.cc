@@ -0,0 +1,43 @@
+#include "../src/binlog.cc"
+#include "check.cc"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace coding;
+
+auto main() -> int {
+    auto path = std::string("/tmp/coding-test-binlog.") + std::to_string(getpid());
+    auto fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    coding_check(fd >= 0);
+    log::binary_output(fd);
+    auto long_a = std::string(700, 'a');
+    auto long_b = std::string(700, 'b');
+    // Two long strings and numbers after them: the strings are cut, the numbers kept whole.
+    coding_binfo("{} {} {} {}", long_a, long_b, (u64)123456789, 2.5);
+    // More strings than fit, then an empty record.
+    coding_binfo("{}|{}|{}|{}|{}|{}", long_a, long_a, long_a, long_b, long_b, (i32)-7);
+    coding_binfo("short {}", (u8)1);
+    log::Binary::get().flush();
+    ::close(fd);
+    auto in = std::ifstream(path, std::ios::binary);
+    auto out = std::ostringstream();
+    coding_check(log::decode(in, out));
+    ::unlink(path.c_str());
+    auto lines = std::vector<std::string>();
+    auto text = std::istringstream(out.str());
+    for (auto line = std::string(); std::getline(text, line);) lines.push_back(line);
+    coding_check(lines.size() == 3);
+    coding_check(lines[0].ends_with("... 123456789 2.5"));
+    coding_check(lines[0].find(std::string(300, 'a')) != std::string::npos);
+    coding_check(lines[1].ends_with("|-7"));
+    coding_check(lines[2].ends_with("short 1"));
+    for (auto const& line : lines) coding_check(line.size() < 1200);
+    return 0;
+}
@@ -0,0 +1,72 @@
+// flags: -std=c++20 -O1 -g -Wall -pthread -march=native -fsanitize=address,undefined
+#include "../src/bitvec.cc"
+#include "check.cc"
+
+#include <random>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+// Built with `-march=native`, so the AVX2 kernels and the BMI2 `select` run where the machine has them.
+auto main() -> int {
+    auto rng = std::mt19937_64(43);
+    // Lengths around word and block edges, and long enough for several `select` samples.
+    auto lengths = { (usize)0, (usize)1, (usize)63, (usize)64, (usize)65, (usize)511, (usize)512, (usize)513, (usize)5000, (usize)100000, (usize)300007 };
+    // Ones per million: none, sparse, dense, all.
+    auto densities = { (u64)0, (u64)50, (u64)10000, (u64)500000, (u64)990000, (u64)1000000 };
+    for (auto n : lengths) {
+        for (auto density : densities) {
+            auto v = BitVec();
+            auto bits = std::vector<bool>();
+            for (auto i = (usize)0; i < n; i++) {
+                auto b = rng() % 1000000 < density;
+                v.push(b);
+                bits.push_back(b);
+            }
+
+            // The naive scan: rank before every position, and where each one and each zero sits.
+            auto rank = std::vector<usize>(n + 1);
+            auto ones = std::vector<usize>();
+            auto zeros = std::vector<usize>();
+            for (auto i = (usize)0; i < n; i++) {
+                rank[i + 1] = rank[i] + bits[i];
+                (bits[i] ? ones : zeros).push_back(i);
+            }
+
+            coding_check(v.len() == n && v.count_ones() == ones.size() && v.count_zeros() == zeros.size());
+            auto i = (usize)0;
+            for (auto p : v.ones()) {
+                coding_check(i < ones.size() && p == ones[i]);
+                i++;
+            }
+            coding_check(i == ones.size());
+
+            auto index = RankSelect(v);
+            coding_check(index.count_ones() == ones.size());
+            for (auto j = (usize)0; j <= n; j++) {
+                coding_check(index.rank1(j) == rank[j]);
+                coding_check(index.rank0(j) == j - rank[j]);
+            }
+            for (auto k = (usize)0; k < ones.size(); k++) {
+                auto p = index.select1(k);
+                coding_check(p.is_some() && p.unwrap() == ones[k]);
+            }
+            for (auto k = (usize)0; k < zeros.size(); k++) {
+                auto p = index.select0(k);
+                coding_check(p.is_some() && p.unwrap() == zeros[k]);
+            }
+            coding_check(index.select1(ones.size()).is_none());
+            coding_check(index.select0(zeros.size()).is_none());
+
+            // The word kernels against the same bits, negated.
+            auto other = v;
+            other.negate();
+            coding_check(other.count_ones() == zeros.size());
+            coding_check(v.count_and(other) == 0 && v.count_and_not(other) == ones.size());
+            other |= v;
+            coding_check(other.all() && other.len() == n);
+        }
+    }
+    return 0;
+}
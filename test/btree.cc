@@ -0,0 +1,113 @@
+#include "../src/btree.cc"
+#include "check.cc"
+
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+// Every entry in order both ways, and a few bounds and ranges, against the model.
+template<typename Tree>
+static auto same(Tree const& tree, std::map<u64, std::string> const& model, std::mt19937_64& rng) -> void {
+    coding_check(tree.len() == model.size());
+    auto it = model.begin();
+    for (auto [k, v] : tree) {
+        coding_check(it != model.end() && k == it->first && v == it->second);
+        ++it;
+    }
+    coding_check(it == model.end());
+    auto back = tree.end();
+    for (auto rit = model.rbegin(); rit != model.rend(); ++rit) coding_check((*--back).key == rit->first);
+    coding_check(back == tree.begin());
+    for (auto q = 0; q < 50; q++) {
+        auto from = rng() % 20000;
+        auto to = from + rng() % 500;
+        auto lo = tree.lower_bound(from);
+        auto up = tree.upper_bound(from);
+        auto mlo = model.lower_bound(from);
+        auto mup = model.upper_bound(from);
+        coding_check((lo == tree.end()) == (mlo == model.end()));
+        if (mlo != model.end()) coding_check((*lo).key == mlo->first);
+        coding_check((up == tree.end()) == (mup == model.end()));
+        if (mup != model.end()) coding_check((*up).key == mup->first);
+        auto n = (usize)0;
+        for (auto [k, v] : tree.range(from, to)) {
+            coding_check(k >= from && k < to && model.at(k) == v);
+            n++;
+        }
+        coding_check(n == (usize)std::distance(model.lower_bound(from), model.lower_bound(to)));
+    }
+}
+
+auto main() -> int {
+    auto rng = std::mt19937_64(39);
+    auto value = [](u64 k) { return std::string(24, 'v') + std::to_string(k); };
+
+    // Random inserts and removals through splits, borrows and merges, down to empty and back.
+    auto tree = TreeMap<u64, std::string>();
+    auto model = std::map<u64, std::string>();
+    for (auto phase = 0; phase < 3; phase++) {
+        for (auto step = 0; step < 60000; step++) {
+            auto k = rng() % 20000;
+            if (rng() % 3 != 0) {
+                auto old = tree.insert(k, value(k + step));
+                auto it = model.find(k);
+                coding_check(old.is_some() == (it != model.end()));
+                if (old.is_some()) coding_check(old.unwrap() == it->second);
+                model[k] = value(k + step);
+            }
+            else {
+                auto old = tree.remove(k);
+                auto it = model.find(k);
+                coding_check(old.is_some() == (it != model.end()));
+                if (old.is_some()) {
+                    coding_check(old.unwrap() == it->second);
+                    model.erase(it);
+                }
+            }
+            if (step % 20000 == 0) same(tree, model, rng);
+        }
+        same(tree, model, rng);
+        auto keys = std::vector<u64>();
+        for (auto& [k, v] : model) keys.push_back(k);
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (auto i = (usize)0; i < keys.size(); i++) {
+            coding_check(tree.remove(keys[i]).unwrap() == model.at(keys[i]));
+            model.erase(keys[i]);
+            coding_check(!tree.contains(keys[i]));
+            if (i % 5000 == 0) same(tree, model, rng);
+        }
+        coding_check(tree.is_empty() && tree.begin() == tree.end());
+    }
+
+    // Bulk-loaded from sorted input, then modified like any other tree.
+    auto entries = std::vector<KeyValue<u64, std::string>>();
+    for (auto k = (u64)0; k < 50000; k++) {
+        entries.push_back({ k * 3, value(k) });
+        model[k * 3] = value(k);
+    }
+    auto loaded = TreeMap<u64, std::string>::from_sorted(entries);
+    same(loaded, model, rng);
+    for (auto step = 0; step < 30000; step++) {
+        auto k = rng() % 150000;
+        if (step % 2) {
+            loaded.insert(k, value(k));
+            model[k] = value(k);
+        }
+        else {
+            coding_check(loaded.remove(k).is_some() == (model.erase(k) == 1));
+        }
+    }
+    same(loaded, model, rng);
+
+    auto set = TreeSet<u32>::from_sorted(std::vector<u32>{ 1, 4, 9, 16 });
+    coding_check(set.insert(5) && !set.insert(9) && set.remove(1) && !set.contains(1));
+    auto elements = std::vector<u32>(set.begin(), set.end());
+    coding_check((elements == std::vector<u32>{ 4, 5, 9, 16 }));
+    return 0;
+}
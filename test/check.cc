@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+/// @brief Fail the driver with the location and text of `cond` unless it holds.
+///
+#define coding_check(cond) do{if(!(cond)){std::fprintf(stderr,"%s:%d: check failed: %s\n",__FILE__,__LINE__,#cond);std::exit(1);}}while(0)
@@ -0,0 +1,133 @@
+#include "../src/concurrent.cc"
+#include "check.cc"
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+constexpr usize THREADS = 4;
+
+constexpr usize SHARED = 16;
+
+// A value names its key in the high bits, so a read torn between two writes shows.
+static auto value(u64 key, u64 version) -> u64 {
+    return key << 20 | (version & 0xfffff);
+}
+
+// Every thread writes keys of its own, checked exactly against a model of its own, and reads everybody's keys.
+// All of them bump a few shared counters through `compute` and `get_or_insert_with`. Two shards, grown from empty,
+// so every shard migrates many times while all of this runs.
+template<typename Map>
+static auto run(Map& map, std::vector<std::unordered_map<u64, u64>>& models, std::vector<u64>& bumps) -> void {
+    auto start = std::atomic<bool>(false);
+    auto threads = std::vector<std::thread>();
+    for (auto t = (usize)0; t < THREADS; t++) {
+        threads.emplace_back([&, t] {
+            auto rng = std::mt19937_64(40 + t);
+            auto& model = models[t];
+            while (!start.load(std::memory_order_acquire)) {}
+            for (auto op = (u64)0; op < 60000; op++) {
+                auto key = SHARED + (rng() % 12000) * THREADS + t;
+                switch (rng() % 10) {
+                case 0: case 1: case 2: {
+                    auto v = value(key, op);
+                    auto old = map.insert(key, v);
+                    coding_check(old.is_some() == model.contains(key));
+                    if (old.is_some()) coding_check(old.unwrap() == model[key]);
+                    model[key] = v;
+                    break;
+                }
+                case 3: {
+                    auto old = map.remove(key);
+                    coding_check(old.is_some() == model.contains(key));
+                    if (old.is_some()) coding_check(old.unwrap() == model[key]);
+                    model.erase(key);
+                    break;
+                }
+                case 4: {
+                    // Drop odd versions, bump the others.
+                    auto next = map.compute(key, [&](u64* v) -> Option<u64> {
+                        if (v && (*v & 1)) return Option<u64>();
+                        return Option<u64>(value(key, v ? (*v & 0xfffff) + 1 : 0));
+                    });
+                    if (next.is_some()) model[key] = next.unwrap();
+                    else model.erase(key);
+                    break;
+                }
+                case 5: {
+                    auto shared = rng() % SHARED;
+                    map.compute(shared, [](u64* v) { return Option<u64>(v ? *v + 1 : 1); });
+                    bumps[t]++;
+                    break;
+                }
+                case 6:
+                    coding_check(map.get_or_insert_with(rng() % SHARED, [] { return (u64)0; }) < ((u64)1 << 20));
+                    break;
+                default: {
+                    auto got = map.get(key);
+                    coding_check(got.is_some() == model.contains(key));
+                    if (got.is_some()) coding_check(got.unwrap() == model[key]);
+                    // Another thread's key, present or not, never torn.
+                    auto other = SHARED + (rng() % 12000) * THREADS + (t + 1) % THREADS;
+                    if (auto v = map.get(other); v.is_some()) coding_check(v.unwrap() >> 20 == other);
+                }
+                }
+            }
+        });
+    }
+    start.store(true, std::memory_order_release);
+    for (auto& th : threads) th.join();
+}
+
+// `len` and `for_each` agree with the models: every key once, with its value.
+template<typename Map>
+static auto check(Map const& map, std::vector<std::unordered_map<u64, u64>> const& models, std::vector<u64> const& bumps) -> void {
+    auto expect = (usize)SHARED;
+    for (auto& m : models) expect += m.size();
+    coding_check(map.len() == expect);
+    auto seen = (usize)0;
+    auto counted = (u64)0;
+    map.for_each([&](u64 const& k, u64 const& v) {
+        seen++;
+        if (k < SHARED) counted += v;
+        else {
+            auto& m = models[(k - SHARED) % THREADS];
+            auto it = m.find(k);
+            coding_check(it != m.end() && it->second == v);
+        }
+    });
+    coding_check(seen == expect);
+    auto total = (u64)0;
+    for (auto b : bumps) total += b;
+    coding_check(counted == total);
+}
+
+auto main() -> int {
+    // Trivially copyable keys and values, so reads are optimistic.
+    {
+        auto map = ConcurrentHashMap<u64, u64>(2);
+        auto models = std::vector<std::unordered_map<u64, u64>>(THREADS);
+        auto bumps = std::vector<u64>(THREADS);
+        for (auto k = (u64)0; k < SHARED; k++) map.insert(k, 0);
+        run(map, models, bumps);
+        check(map, models, bumps);
+
+        // Emptied, then filled again over the tables it grew.
+        for (auto& m : models) {
+            for (auto [k, v] : m) coding_check(map.remove(k).unwrap() == v);
+            m.clear();
+        }
+        coding_check(map.len() == SHARED);
+        run(map, models, bumps);
+        check(map, models, bumps);
+        map.clear();
+        coding_check(map.len() == 0 && map.is_empty());
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "../src/deque.cc"
+#include "check.cc"
+
+#include <deque>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+// Every element in order, through indexing, iterators and the two slices.
+template<typename T>
+static auto same(VecDeque<T> const& d, std::deque<T> const& model) -> void {
+    coding_check(d.len() == model.size() && d.is_empty() == model.empty());
+    coding_check(d.capacity() >= d.len());
+    auto i = (usize)0;
+    for (auto const& x : d) coding_check(x == model[i++]);
+    coding_check(i == model.size());
+    auto [a, b] = d.as_slices();
+    coding_check(a.size() + b.size() == model.size());
+    coding_check(a.size() > 0 || b.empty());
+    for (auto j = (usize)0; j < a.size(); j++) coding_check(a[j] == model[j]);
+    for (auto j = (usize)0; j < b.size(); j++) coding_check(b[j] == model[a.size() + j]);
+    if (!model.empty()) {
+        coding_check(d.front() == model.front() && d.back() == model.back());
+        auto k = model.size() / 2;
+        coding_check(d[k] == model[k] && *d.get(k) == model[k]);
+    }
+    coding_check(d.get(model.size()) == nullptr);
+}
+
+// Random operations against `std::deque`. Pushes at both ends make the buffer wrap, so growth, extending, draining
+// and `make_contiguous` all meet a wrapped buffer.
+template<typename T, typename Make>
+static auto random(std::mt19937_64& rng, Make make) -> void {
+    auto d = VecDeque<T>();
+    auto model = std::deque<T>();
+    for (auto op = 0; op < 20000; op++) {
+        switch (rng() % 14) {
+        case 0: case 1: {
+            auto x = make(rng());
+            d.push_back(x);
+            model.push_back(x);
+            break;
+        }
+        case 2: case 3: {
+            auto x = make(rng());
+            d.push_front(x);
+            model.push_front(x);
+            break;
+        }
+        case 4: {
+            auto x = d.pop_back();
+            coding_check(x.is_some() == !model.empty());
+            if (x.is_some()) {
+                coding_check(mv(x).unwrap() == model.back());
+                model.pop_back();
+            }
+            break;
+        }
+        case 5: {
+            auto x = d.pop_front();
+            coding_check(x.is_some() == !model.empty());
+            if (x.is_some()) {
+                coding_check(mv(x).unwrap() == model.front());
+                model.pop_front();
+            }
+            break;
+        }
+        case 6: {
+            // A span, the `memcpy` path for trivial types.
+            auto items = std::vector<T>(rng() % 40);
+            for (auto& x : items) x = make(rng());
+            d.extend(std::span<T const>(items));
+            model.insert(model.end(), items.begin(), items.end());
+            break;
+        }
+        case 7: {
+            // Any other range.
+            auto items = std::list<T>();
+            for (auto n = rng() % 20; n > 0; n--) items.push_back(make(rng()));
+            d.extend(items);
+            model.insert(model.end(), items.begin(), items.end());
+            break;
+        }
+        case 8: {
+            auto out = std::vector<T>(rng() % 30);
+            auto n = d.drain_into(std::span<T>(out));
+            coding_check(n == std::min(out.size(), model.size()));
+            for (auto i = (usize)0; i < n; i++) {
+                coding_check(out[i] == model.front());
+                model.pop_front();
+            }
+            break;
+        }
+        case 9: {
+            auto s = d.make_contiguous();
+            coding_check(s.size() == model.size() && d.as_slices().second.empty());
+            for (auto i = (usize)0; i < s.size(); i++) coding_check(s[i] == model[i]);
+            break;
+        }
+        case 10: {
+            auto n = rng() % 8;
+            d.drop_front(n);
+            model.erase(model.begin(), model.begin() + (isize)std::min(n, model.size()));
+            break;
+        }
+        case 11: {
+            auto n = model.size() - std::min(model.size(), (usize)(rng() % 8));
+            d.truncate(n);
+            model.resize(n);
+            break;
+        }
+        case 12:
+            if (!model.empty()) {
+                auto i = rng() % model.size();
+                auto x = make(rng());
+                d[i] = x;
+                model[i] = x;
+            }
+            break;
+        default:
+            if (rng() % 50 == 0) {
+                d.clear();
+                model.clear();
+            }
+            else if (rng() % 10 == 0) {
+                auto copy = d;
+                same(copy, model);
+                d = mv(copy);
+            }
+            else d.reserve(rng() % 64);
+        }
+        same(d, model);
+    }
+}
+
+auto main() -> int {
+    auto rng = std::mt19937_64(37);
+    random<u64>(rng, [](u64 x) { return x; });
+    random<std::string>(rng, [](u64 x) { return std::string(x % 40, (char)('a' + x % 26)); });
+
+    // Growth while wrapped: the front run sits at the end of the buffer, the back run at its start.
+    for (auto cap : { (usize)8, (usize)64 }) {
+        auto d = VecDeque<u64>::with_capacity(cap);
+        auto model = std::deque<u64>();
+        auto start = d.capacity();
+        for (auto i = (u64)0; i < start - 2; i++) { d.push_back(i); model.push_back(i); }
+        for (auto i = (u64)0; i < start - 3; i++) { d.pop_front(); model.pop_front(); }
+        for (auto i = (u64)100; d.len() < start; i++) { d.push_back(i); model.push_back(i); }
+        coding_check(!d.as_slices().second.empty() && d.capacity() == start);
+        same(d, model);
+        d.push_back(7);
+        model.push_back(7);
+        coding_check(d.capacity() > start);
+        same(d, model);
+        d.push_front(9);
+        model.push_front(9);
+        same(d, model);
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include "../src/flatmap.cc"
+#include "check.cc"
+
+#include <map>
+#include <random>
+#include <ranges>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+// Long enough that a value moved from is empty, never equal to the original.
+static auto text(u64 x) -> std::string {
+    return std::string(24 + x % 8, (char)('a' + x % 26)) + std::to_string(x);
+}
+
+template<typename K, typename V>
+static auto same(FlatMap<K, V> const& map, std::map<K, V> const& model) -> void {
+    coding_check(map.len() == model.size() && map.is_empty() == model.empty());
+    auto it = model.begin();
+    for (auto [k, v] : map) {
+        coding_check(it != model.end() && k == it->first && v == it->second);
+        ++it;
+    }
+    coding_check(it == model.end());
+    coding_check(map.keys().size() == model.size() && map.values().size() == model.size());
+}
+
+// Random operations against `std::map`, few keys so that most operations hit, many so that searches leave the
+// linear scan for the binary search.
+template<typename K, typename Make>
+static auto random(std::mt19937_64& rng, u64 keys, Make key) -> void {
+    auto map = FlatMap<K, std::string>();
+    auto model = std::map<K, std::string>();
+    for (auto op = 0; op < 20000; op++) {
+        auto k = key(rng() % keys);
+        switch (rng() % 8) {
+        case 0: case 1: {
+            auto v = text(rng());
+            auto old = map.insert(k, v);
+            auto it = model.find(k);
+            coding_check(old.is_some() == (it != model.end()));
+            if (old.is_some()) coding_check(mv(old).unwrap() == it->second);
+            model[k] = v;
+            break;
+        }
+        case 2: {
+            auto old = map.remove(k);
+            auto it = model.find(k);
+            coding_check(old.is_some() == (it != model.end()));
+            if (old.is_some()) {
+                coding_check(mv(old).unwrap() == it->second);
+                model.erase(it);
+            }
+            break;
+        }
+        case 3: {
+            auto v = text(rng());
+            map[k] += v;
+            model[k] += v;
+            break;
+        }
+        case 4: {
+            // Bounds and ranges agree on keys present or not.
+            auto to = key(rng() % keys);
+            auto lower = map.lower_bound(k);
+            auto mlower = model.lower_bound(k);
+            coding_check((lower == map.end()) == (mlower == model.end()));
+            if (mlower != model.end()) coding_check((*lower).key == mlower->first);
+            auto upper = map.upper_bound(k);
+            coding_check(upper - map.begin() == (isize)std::distance(model.begin(), model.upper_bound(k)));
+            auto n = (usize)0;
+            for (auto [rk, rv] : map.range(k, to)) {
+                coding_check(!(rk < k) && rk < to && model.at(rk) == rv);
+                n++;
+            }
+            coding_check(n == (k < to ? (usize)std::distance(model.lower_bound(k), model.lower_bound(to)) : 0));
+            break;
+        }
+        default: {
+            auto v = std::as_const(map).get(k);
+            auto it = model.find(k);
+            coding_check((v != nullptr) == (it != model.end()) && map.contains(k) == (it != model.end()));
+            if (v) coding_check(*v == it->second);
+        }
+        }
+    }
+    same(map, model);
+    map.shrink_to_fit();
+    same(map, model);
+    map.clear();
+    coding_check(map.is_empty());
+}
+
+// The builders move from a temporary container, and copy from anything that only borrows its elements.
+static auto builders(std::mt19937_64& rng) -> void {
+    auto model = std::map<u64, std::string>();
+    for (auto i = 0; i < 500; i++) model[rng() % 2000] = text(rng());
+    auto sorted = std::vector<std::pair<u64, std::string>>(model.begin(), model.end());
+    auto unsorted = sorted;
+    for (auto i = 0; i < 200; i++) unsorted.emplace_back(rng() % 2000, text(rng()));
+    std::shuffle(unsorted.begin(), unsorted.end(), rng);
+    auto last = std::map<u64, std::string>();
+    for (auto& [k, v] : unsorted) last[k] = v;
+    auto const keep = sorted;
+    auto const keep_unsorted = unsorted;
+
+    same(FlatMap<u64, std::string>::from_sorted(sorted), model);
+    same(FlatMap<u64, std::string>::from_sorted(std::span(sorted)), model);
+    same(FlatMap<u64, std::string>::from_sorted(std::views::all(sorted)), model);
+    same(FlatMap<u64, std::string>::from_sorted(std::ranges::subrange(sorted.begin(), sorted.end())), model);
+    same(FlatMap<u64, std::string>::from_sorted(sorted | std::views::filter([](auto const&) { return true; })), model);
+    coding_check(sorted == keep);
+    same(FlatMap<u64, std::string>::from_unsorted(unsorted), last);
+    same(FlatMap<u64, std::string>::from_unsorted(std::span(unsorted)), last);
+    same(FlatMap<u64, std::string>::from_unsorted(std::views::all(unsorted)), last);
+    coding_check(unsorted == keep_unsorted);
+    same(FlatMap<u64, std::string>::from_sorted(mv(sorted)), model);
+    same(FlatMap<u64, std::string>::from_unsorted(mv(unsorted)), last);
+
+    // Sets likewise, against `std::set`.
+    auto elements = std::vector<std::string>();
+    for (auto& [k, v] : keep_unsorted) elements.push_back(text(k));
+    auto expect = std::set<std::string>(elements.begin(), elements.end());
+    auto const keep_elements = elements;
+    auto check = [&](FlatSet<std::string> const& set) {
+        coding_check(set.len() == expect.size());
+        coding_check(std::equal(set.as_slice().begin(), set.as_slice().end(), expect.begin(), expect.end()));
+        for (auto& x : keep_elements) coding_check(set.contains(x));
+    };
+    check(FlatSet<std::string>::from_unsorted(elements));
+    check(FlatSet<std::string>::from_unsorted(std::span(elements)));
+    coding_check(elements == keep_elements);
+    auto ordered = std::vector<std::string>(expect.begin(), expect.end());
+    check(FlatSet<std::string>::from_sorted(std::span(ordered)));
+    check(FlatSet<std::string>::from_sorted(std::views::all(ordered)));
+    coding_check(std::equal(ordered.begin(), ordered.end(), expect.begin(), expect.end()));
+    check(FlatSet<std::string>::from_sorted(mv(ordered)));
+    check(FlatSet<std::string>::from_unsorted(mv(elements)));
+}
+
+auto main() -> int {
+    auto rng = std::mt19937_64(45);
+    for (auto keys : { (u64)8, (u64)40, (u64)3000 }) {
+        random<u64>(rng, keys, [](u64 x) { return x; });
+        random<std::string>(rng, keys, [](u64 x) { return text(x); });
+    }
+    builders(rng);
+    return 0;
+}
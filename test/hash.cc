@@ -0,0 +1,43 @@
+#include "../src/hash.cc"
+#include "check.cc"
+
+#include <forward_list>
+#include <list>
+#include <vector>
+
+using namespace coding;
+
+// Equal whatever the case of `c`, and hashed so: the bytes of equal values differ.
+struct Letter final {
+
+    u8 c;
+
+    template<hash::Hasher H>
+    inline auto hash(H& h) const noexcept -> void {
+        h.write_u64(this->c | 0x20);
+    }
+};
+
+template<typename T>
+static auto hash_of(T const& v) -> u64 {
+    return hash::hash_one(hash::FixedState(), v);
+}
+
+auto main() -> int {
+    // Elements with a `hash` member are hashed by it, not by their bytes.
+    auto upper = std::vector<Letter>{ { 'A' }, { 'B' } };
+    auto lower = std::vector<Letter>{ { 'a' }, { 'b' } };
+    coding_check(hash_of(upper) == hash_of(lower));
+    coding_check(hash_of(std::list<Letter>{ { 'A' } }) == hash_of(std::list<Letter>{ { 'a' } }));
+
+    // Integers are one block, still told apart by length and value.
+    coding_check(hash_of(std::vector<u32>{ 1, 2, 3 }) == hash_of(std::vector<u32>{ 1, 2, 3 }));
+    coding_check(hash_of(std::vector<u32>{ 1, 2, 3 }) != hash_of(std::vector<u32>{ 1, 2, 4 }));
+    coding_check(hash_of(std::vector<std::vector<u32>>{ { 1, 2 }, { 3 } }) != hash_of(std::vector<std::vector<u32>>{ { 1 }, { 2, 3 } }));
+
+    // Ranges with no size up front, like `std::forward_list`, count their elements at the end to keep nested ones apart.
+    using Lists = std::vector<std::forward_list<u32>>;
+    coding_check(hash_of(Lists{ { 1, 2 }, { 3 } }) != hash_of(Lists{ { 1 }, { 2, 3 } }));
+    coding_check(hash_of(Lists{ { 1, 2 }, { 3 } }) == hash_of(Lists{ { 1, 2 }, { 3 } }));
+    return 0;
+}
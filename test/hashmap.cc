@@ -0,0 +1,87 @@
+#include "../src/hashmap.cc"
+#include "check.cc"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace coding;
+using namespace coding::collections;
+
+// Random inserts, lookups and removals against `std::unordered_map`, with a small key space so that slots
+// are deleted and reused many times over.
+template<typename H>
+static auto random_ops() -> void {
+    auto rng = std::mt19937_64(38);
+    auto map = HashMap<u64, u64, H>();
+    auto model = std::unordered_map<u64, u64>();
+    for (auto step = (u64)0; step < 300000; step++) {
+        auto key = rng() % 5000;
+        switch (rng() % 4) {
+        case 0:
+        case 1: {
+            auto old = map.insert(key, step);
+            auto it = model.find(key);
+            coding_check(old.is_some() == (it != model.end()));
+            if (old.is_some()) coding_check(old.unwrap() == it->second);
+            model[key] = step;
+            break;
+        }
+        case 2: {
+            auto v = map.get(key);
+            auto it = model.find(key);
+            coding_check((v != nullptr) == (it != model.end()));
+            if (v) coding_check(*v == it->second);
+            break;
+        }
+        default: {
+            auto old = map.remove(key);
+            coding_check(old.is_some() == (model.erase(key) == 1));
+        }
+        }
+        if (step % 50000 == 0) {
+            coding_check(map.len() == model.size());
+            auto n = (usize)0;
+            for (auto& [k, v] : map) {
+                coding_check(model.at(k) == v);
+                n++;
+            }
+            coding_check(n == model.size());
+        }
+    }
+    map.clear();
+    coding_check(map.is_empty() && !map.contains((u64)1));
+}
+
+auto main() -> int {
+    random_ops<hash::RandomState>();
+    random_ops<hash::FxState>();
+
+    // `str` finds `String` keys without building one.
+    auto words = HashMap<String, u32>();
+    for (auto i = 0u; i < 1000; i++) words.insert(String(std::to_string(i).c_str()), i);
+    coding_check(*words.get(str("123")) == 123 && !words.contains(str("1000")));
+    coding_check(words.remove(str("7")).unwrap() == 7 && words.len() == 999);
+    words[String("7")] = 70;
+    coding_check(*words.get(str("7")) == 70);
+
+    // Reserving up front leaves room for all of them without another rehash.
+    auto reserved = HashMap<u64, u64>::with_capacity(10000);
+    auto capacity = reserved.capacity();
+    coding_check(capacity >= 10000);
+    for (auto i = (u64)0; i < 10000; i++) reserved.insert(i * 7919, i);
+    coding_check(reserved.capacity() == capacity);
+
+    auto set = HashSet<u64>();
+    auto model = std::unordered_set<u64>();
+    auto rng = std::mt19937_64(1);
+    for (auto i = 0; i < 100000; i++) {
+        auto v = rng() % 3000;
+        if (rng() % 3) coding_check(set.insert(v) == model.insert(v).second);
+        else coding_check(set.remove(v) == (model.erase(v) == 1));
+    }
+    coding_check(set.len() == model.size());
+    for (auto v : set) coding_check(model.contains(v));
+    return 0;
+}
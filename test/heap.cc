@@ -0,0 +1,169 @@
+#include "../src/heap.cc"
+#include "check.cc"
+
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+// Random operations against `std::priority_queue` with the same comparison, few distinct values so that ties abound.
+template<typename T, usize D, typename C, typename Make>
+static auto against_queue(std::mt19937_64& rng, Make make) -> void {
+    auto heap = DaryHeap<T, D, C>();
+    auto model = std::priority_queue<T, std::vector<T>, C>();
+    auto cmp = C();
+    for (auto op = 0; op < 30000; op++) {
+        switch (rng() % 8) {
+        case 0: case 1: case 2: {
+            auto x = make(rng() % 500);
+            heap.push(x);
+            model.push(x);
+            break;
+        }
+        case 3: case 4: {
+            auto x = heap.pop();
+            coding_check(x.is_some() == !model.empty());
+            if (x.is_some()) {
+                coding_check(mv(x).unwrap() == model.top());
+                model.pop();
+            }
+            break;
+        }
+        case 5: {
+            // The greater of `x` and the top comes back.
+            auto x = make(rng() % 500);
+            auto got = heap.push_pop(x);
+            model.push(x);
+            coding_check(got == model.top());
+            model.pop();
+            break;
+        }
+        case 6: {
+            auto x = make(rng() % 500);
+            auto got = heap.replace_top(x);
+            coding_check(got.is_some() == !model.empty());
+            if (got.is_some()) {
+                coding_check(mv(got).unwrap() == model.top());
+                model.pop();
+            }
+            model.push(x);
+            break;
+        }
+        default:
+            if (rng() % 200 == 0) {
+                heap.clear();
+                model = {};
+            }
+        }
+        coding_check(heap.len() == model.size() && heap.is_empty() == model.empty());
+        coding_check((heap.peek() == nullptr) == model.empty());
+        if (!model.empty()) coding_check(*heap.peek() == model.top());
+    }
+
+    // Whatever is left comes out sorted by the comparison, and `from_vec` builds the same heap from scratch.
+    auto all = std::vector<T>(heap.begin(), heap.end());
+    auto copy = heap;
+    auto sorted = mv(copy).into_sorted_vec();
+    coding_check(std::is_sorted(sorted.begin(), sorted.end(), cmp) && sorted.size() == model.size());
+    auto built = DaryHeap<T, D, C>::from_vec(all);
+    while (!model.empty()) {
+        coding_check(*built.peek() == model.top());
+        coding_check(heap.pop().unwrap() == model.top());
+        coding_check(built.pop().unwrap() == model.top());
+        model.pop();
+    }
+    coding_check(heap.pop().is_none() && built.pop().is_none());
+}
+
+// Random operations on ids against a map from id to priority. Ties pop in any order, so a popped id must carry the
+// least priority present.
+template<usize D>
+static auto against_map(std::mt19937_64& rng) -> void {
+    auto heap = IndexedHeap<u64, D>();
+    auto model = std::map<usize, u64>();
+    for (auto op = 0; op < 30000; op++) {
+        auto id = (usize)(rng() % 600);
+        auto p = rng() % 1000;
+        auto it = model.find(id);
+        switch (rng() % 8) {
+        case 0: case 1:
+            if (it == model.end()) {
+                heap.push(id, p);
+                model[id] = p;
+            }
+            break;
+        case 2: case 3: {
+            // Only a priority before the current one changes anything.
+            auto changed = heap.decrease_key(id, p);
+            coding_check(changed == (it == model.end() || p < it->second));
+            if (changed) model[id] = p;
+            break;
+        }
+        case 4:
+            heap.update(id, p);
+            model[id] = p;
+            break;
+        case 5: {
+            auto old = heap.remove(id);
+            coding_check(old.is_some() == (it != model.end()));
+            if (old.is_some()) {
+                coding_check(old.unwrap() == it->second);
+                model.erase(it);
+            }
+            break;
+        }
+        case 6: {
+            auto top = heap.pop();
+            coding_check(top.is_some() == !model.empty());
+            if (top.is_some()) {
+                auto [key, value] = mv(top).unwrap();
+                auto least = std::min_element(model.begin(), model.end(), [](auto& a, auto& b) { return a.second < b.second; });
+                coding_check(model.contains(key) && model[key] == value && value == least->second);
+                model.erase(key);
+            }
+            break;
+        }
+        default:
+            if (rng() % 300 == 0) {
+                heap.clear();
+                model.clear();
+            }
+        }
+        coding_check(heap.len() == model.size() && heap.is_empty() == model.empty());
+        coding_check(heap.contains(id) == model.contains(id));
+        auto q = heap.priority(id);
+        coding_check((q != nullptr) == model.contains(id));
+        if (q) coding_check(*q == model[id]);
+    }
+
+    // Drained, priorities come out in order and every id once.
+    auto last = (u64)0;
+    while (!model.empty()) {
+        auto [key, value] = heap.pop().unwrap();
+        coding_check(value >= last && model.at(key) == value);
+        last = value;
+        model.erase(key);
+    }
+    coding_check(heap.is_empty() && heap.peek() == nullptr);
+}
+
+auto main() -> int {
+    auto rng = std::mt19937_64(46);
+    auto number = [](u64 x) { return x; };
+    auto text = [](u64 x) { return std::string(20, (char)('a' + x % 26)) + std::to_string(x); };
+    against_queue<u64, 2, std::less<u64>>(rng, number);
+    against_queue<u64, 3, std::less<u64>>(rng, number);
+    against_queue<u64, 4, std::greater<u64>>(rng, number);
+    against_queue<u64, 8, std::less<u64>>(rng, number);
+    against_queue<std::string, 2, std::less<std::string>>(rng, text);
+    against_queue<std::string, 4, std::greater<std::string>>(rng, text);
+    against_map<2>(rng);
+    against_map<4>(rng);
+    against_map<7>(rng);
+    return 0;
+}
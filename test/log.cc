@@ -0,0 +1,176 @@
+// Sites above debug are compiled out, whatever the runtime levels say.
+#define CODING_LOG_LEVEL 30
+#include "../src/log.cc"
+#include "check.cc"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace coding;
+
+// Every line written, in order.
+static auto written = std::string();
+static auto lock = std::mutex();
+
+struct Capture final : log::Sink {
+    inline auto write(std::span<iovec const> batch) noexcept -> void override {
+        auto guard = std::lock_guard(lock);
+        for (auto& v : batch) written.append(static_cast<char const*>(v.iov_base), v.iov_len);
+    }
+};
+
+// The messages written since the last call, without what precedes ` :: `.
+static auto take() -> std::vector<std::string> {
+    log::flush();
+    auto guard = std::lock_guard(lock);
+    auto out = std::vector<std::string>();
+    for (auto at = (usize)0; at < written.size();) {
+        auto end = written.find('\n', at);
+        auto line = std::string_view(written).substr(at, end - at);
+        auto msg = line.find(" :: ");
+        out.emplace_back(msg == line.npos ? line : line.substr(msg + 4));
+        at = end + 1;
+    }
+    written.clear();
+    return out;
+}
+
+// Lines of many threads through their rings, each thread's in order and, when they block on a full ring, all of them.
+// When they drop instead, the notices account for every line missing.
+static auto rings() -> void {
+    constexpr u64 THREADS = 4;
+    constexpr u64 LINES = 20000;
+    for (auto policy : { log::Overflow::Block, log::Overflow::Drop }) {
+        log::set_overflow(policy);
+        auto threads = std::vector<std::thread>();
+        for (auto t = (u64)0; t < THREADS; t++) {
+            threads.emplace_back([t] {
+                for (auto i = (u64)0; i < LINES; i++) coding_info("thread " << t << " line " << i << " padding the line out");
+            });
+        }
+        for (auto& th : threads) th.join();
+        auto next = std::vector<u64>(THREADS);
+        auto seen = (u64)0;
+        auto dropped = (u64)0;
+        for (auto& line : take()) {
+            auto t = (u64)0;
+            auto i = (u64)0;
+            if (std::sscanf(line.c_str(), "thread %lu line %lu", &t, &i) == 2) {
+                coding_check(t < THREADS && i >= next[t]);
+                if (policy == log::Overflow::Block) coding_check(i == next[t]);
+                next[t] = i + 1;
+                seen++;
+            }
+            else {
+                auto n = (u64)0;
+                coding_check(std::sscanf(line.c_str(), "... %lu log lines dropped", &n) == 1);
+                dropped += n;
+            }
+        }
+        coding_check(seen + dropped == THREADS * LINES);
+        if (policy == log::Overflow::Block) coding_check(dropped == 0);
+    }
+    log::set_overflow(log::Overflow::Block);
+}
+
+static auto at_debug(int level) -> void {
+    coding_debug("file debug");
+    coding_log("file runtime " << level, level, " R ");
+}
+
+#undef CODING_LOG_MODULE
+#define CODING_LOG_MODULE "net"
+
+static auto net_debug(int level) -> void {
+    coding_debug("net debug");
+    coding_trace("net trace");
+    coding_log("net runtime " << level, level, " R ");
+}
+
+#undef CODING_LOG_MODULE
+#define CODING_LOG_MODULE __FILE__
+
+// Levels per module from a spec, applied to modules met before and after it.
+static auto modules() -> void {
+    coding_check(log::configure("20,net=40"));
+    coding_check(log::Module::get_default() == 20);
+    coding_check(log::Module::get("net").get_level() == 40);
+    coding_check(log::Module::get("src/net").get_level() == 40);
+    coding_check(log::Module::get("src/internet").get_level() == 20);
+    coding_check(log::Module::get("db.cc").get_level() == 20);
+
+    // Debug gets through for `net` only, trace for nobody as it is compiled out, and runtime levels likewise.
+    at_debug(30);
+    net_debug(30);
+    net_debug(40);
+    auto lines = take();
+    coding_check((lines == std::vector<std::string>{ "net debug", "net runtime 30", "net debug" }));
+
+    // A bare level moves the modules without one of their own, a malformed rule stops the spec after applying
+    // those before it.
+    coding_check(log::configure("30,,"));
+    coding_check(log::Module::get("db.cc").get_level() == 30 && log::Module::get("net").get_level() == 40);
+    coding_check(!log::configure("net=10,db.cc=x,log.cc=0"));
+    coding_check(log::Module::get("net").get_level() == 10 && log::Module::get("db.cc").get_level() == 30);
+    coding_check(!log::configure("=") && !log::configure("20x"));
+    at_debug(20);
+    net_debug(20);
+    lines = take();
+    coding_check((lines == std::vector<std::string>{ "file debug", "file runtime 20" }));
+    log::configure("20,net=20");
+}
+
+// `EveryN` and `Every` let through what they promise and count what they hold back.
+static auto limiters() -> void {
+    auto every3 = log::EveryN(3);
+    auto got = std::vector<i64>();
+    for (auto i = 0; i < 7; i++) {
+        auto pass = every3.admit();
+        got.push_back(pass.is_some() ? (i64)pass.unwrap() : -1);
+    }
+    coding_check((got == std::vector<i64>{ 0, -1, -1, 2, -1, -1, 2 }));
+    for (auto i = 0; i < 7; i++) coding_info_every_n(3, "every third");
+    auto lines = take();
+    coding_check((lines == std::vector<std::string>{ "every third", "every third [2 suppressed]", "every third [2 suppressed]" }));
+
+    // One line per window, and the calls held back reported by the next line, all but those of the last window.
+    auto period = (i64)50000000;
+    auto every = log::Every(measure::Time(0.05));
+    auto start = log::coarse_ns();
+    auto calls = (u64)0;
+    auto admitted = (u64)0;
+    auto reported = (u64)0;
+    while (log::coarse_ns() - start < 6 * period) {
+        calls++;
+        if (auto pass = every.admit(); pass.is_some()) {
+            admitted++;
+            reported += pass.unwrap();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    auto windows = (u64)((log::coarse_ns() - start) / period + 1);
+    coding_check(admitted >= 2 && admitted <= windows + 1);
+    coding_check(admitted + reported <= calls && calls - admitted - reported < 2 * calls / admitted + 1);
+
+    // Windows are aligned, so two lines can come much closer than a period across a boundary.
+    auto fresh = log::Every(measure::Time(0.05));
+    while (log::coarse_ns() % period < period - period / 5) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    auto first = log::coarse_ns();
+    coding_check(fresh.admit().is_some());
+    auto window = first / period;
+    while (log::coarse_ns() / period == window) std::this_thread::sleep_for(std::chrono::microseconds(200));
+    coding_check(fresh.admit().is_some());
+    coding_check(log::coarse_ns() - first < period);
+}
+
+auto main() -> int {
+    log::set_sink(std::make_unique<Capture>());
+    rings();
+    modules();
+    limiters();
+    return 0;
+}
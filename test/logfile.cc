@@ -0,0 +1,67 @@
+#include "../src/logfile.cc"
+#include "check.cc"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace coding;
+
+// Files next to the log which only start like its rotated ones.
+static auto const OTHERS = { "app.log.keep", "app.log.20260101T000000.bak", "app.log.2026", "app.log.lock.gz" };
+
+// Rotated files of `app.log`, compressed or not.
+static auto count(std::filesystem::path const& dir, bool gz) -> usize {
+    auto n = (usize)0;
+    for (auto& e : std::filesystem::directory_iterator(dir)) {
+        auto name = e.path().filename().string();
+        if (!name.starts_with("app.log.") || std::find(OTHERS.begin(), OTHERS.end(), name) != OTHERS.end()) continue;
+        n += name.ends_with(".gz") == gz;
+    }
+    return n;
+}
+
+auto main() -> int {
+    auto dir = std::filesystem::path("/tmp/coding-test-logfile." + std::to_string(getpid()));
+    std::filesystem::create_directory(dir);
+    auto path = (dir / "app.log").string();
+    for (auto name : OTHERS) std::ofstream(dir / name) << "other\n";
+
+    // A compression hook held until released, renaming the file as gzip would.
+    auto hold = std::make_shared<std::atomic<bool>>(true);
+    auto options = log::FileOptions();
+    options.max_bytes = 10;
+    options.keep = 2;
+    options.compress = [hold](std::string const& name) {
+        while (hold->load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        std::filesystem::rename(name, name + ".gz");
+    };
+    auto sink = log::FileSink::open(path, options).unwrap();
+    auto line = std::string("a line of twenty b\n");
+    auto iov = iovec{ line.data(), line.size() };
+    for (auto i = 0; i < 5; i++) sink->write(std::span(&iov, 1));
+    // Four rotations, all being compressed, so none is pruned yet.
+    coding_check(count(dir, false) == 4);
+
+    hold->store(false);
+    for (auto i = 0; i < 5000 && count(dir, false) > 0; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    coding_check(count(dir, true) == 4);
+    hold->store(true);
+    sink->write(std::span(&iov, 1));
+    // The fifth rotation prunes the three oldest, compressed by now, and keeps the new one being compressed.
+    coding_check(count(dir, true) + count(dir, false) == 2);
+    coding_check(count(dir, false) == 1);
+    for (auto name : OTHERS) coding_check(std::filesystem::exists(dir / name));
+    hold->store(false);
+    sink.reset();
+    for (auto i = 0; i < 5000 && count(dir, false) > 0; i++) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::filesystem::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,34 @@
+#include "../src/measure.cc"
+#include "check.cc"
+
+#include <cmath>
+#include <vector>
+
+using namespace coding;
+using namespace coding::measure;
+
+auto main() -> int {
+    // Lengths past a vector step and a tail, through quantities, numbers and back.
+    auto feet = std::vector<double>(37);
+    for (auto i = (usize)0; i < feet.size(); i++) feet[i] = (double)i * 1.5;
+    auto lengths = std::vector<Length>(feet.size());
+    convert(feet, 1.0_ft, lengths);
+    for (auto i = (usize)0; i < feet.size(); i++) coding_check(std::abs(lengths[i].value() - feet[i] * 0.3048) < 1e-12);
+    auto metres = std::vector<double>(feet.size());
+    convert(lengths, 1.0_m, metres);
+    for (auto i = (usize)0; i < feet.size(); i++) coding_check(metres[i] == lengths[i].value());
+    auto back = std::vector<double>(feet.size());
+    to_units(lengths, 1.0_ft, back);
+    for (auto i = (usize)0; i < feet.size(); i++) coding_check(std::abs(back[i] - feet[i]) < 1e-12);
+
+    // In place, over the same array.
+    convert(std::span<double const>(metres), 1.0_m, 1.0_cm, std::span<double>(metres));
+    for (auto i = (usize)0; i < feet.size(); i++) coding_check(std::abs(metres[i] - lengths[i].value() * 100) < 1e-9);
+
+    // `float` quantities take the 16-wide path.
+    auto samples = std::vector<float>(50, 2.0f);
+    auto out = std::vector<Quantity<dim::LENGTH, float>>(samples.size());
+    convert(samples, Quantity<dim::LENGTH, float>(0.5f), out);
+    for (auto q : out) coding_check(q.value() == 1.0f);
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "../src/mutex.cc"
+#include "check.cc"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace coding;
+using namespace coding::thread;
+
+auto main() -> int {
+    // A counter bumped under contention loses no increment.
+    {
+        auto counter = Mutex<u64>(0);
+        auto threads = std::vector<std::thread>();
+        for (auto t = 0; t < 4; t++) {
+            threads.emplace_back([&] {
+                for (auto i = 0; i < 100000; i++) *counter.lock() += 1;
+            });
+        }
+        for (auto& th : threads) th.join();
+        coding_check(*counter.lock() == 400000);
+    }
+
+    // Writers fill every word with one number, a word at a time: a reader never sees two numbers at once.
+    {
+        auto words = RwLock<std::array<u64, 16>>();
+        auto stop = std::atomic<bool>(false);
+        auto reads = std::atomic<u64>(0);
+        auto threads = std::vector<std::thread>();
+        for (auto t = (u64)0; t < 2; t++) {
+            threads.emplace_back([&, t] {
+                for (auto n = t; n < 4000; n += 2) {
+                    auto w = words.write();
+                    for (auto& x : *w) {
+                        x = n;
+                        if (n % 64 == 0) std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        for (auto t = 0; t < 4; t++) {
+            threads.emplace_back([&] {
+                while (!stop.load(std::memory_order_relaxed)) {
+                    auto r = words.read();
+                    for (auto x : *r) coding_check(x == (*r)[0]);
+                    reads.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+        threads[0].join();
+        threads[1].join();
+        stop.store(true);
+        for (auto i = (usize)2; i < threads.size(); i++) threads[i].join();
+        coding_check(reads.load() > 0);
+    }
+
+    // `try_lock` fails exactly while the lock is held.
+    {
+        auto m = Mutex<int>(1);
+        {
+            auto g = m.lock();
+            auto other = std::thread([&] { coding_check(m.try_lock().is_none()); });
+            other.join();
+        }
+        {
+            auto g = m.try_lock();
+            coding_check(g.is_some());
+            coding_check(m.try_lock().is_none());
+        }
+        coding_check(m.try_lock().is_some());
+    }
+
+    // `try_read` and `try_write` against readers, writers and a writer waiting.
+    {
+        auto l = RwLock<int>(7);
+        coding_check(l.try_read().is_some());
+        coding_check(l.try_write().is_some());
+        {
+            auto r = l.read();
+            auto other = std::thread([&] {
+                coding_check(l.try_read().is_some());
+                coding_check(l.try_write().is_none());
+            });
+            other.join();
+            coding_check(l.try_write().is_none());
+        }
+        {
+            auto w = l.write();
+            auto other = std::thread([&] {
+                coding_check(l.try_read().is_none());
+                coding_check(l.try_write().is_none());
+            });
+            other.join();
+        }
+        // Once a writer waits behind a reader, new readers are held off: the lock prefers writers.
+        auto r = std::optional<RwLockReadGuard<int>>(l.read());
+        auto written = std::atomic<bool>(false);
+        auto writer = std::thread([&] {
+            *l.write() = 8;
+            written.store(true);
+        });
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (l.try_read().is_some() && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+        coding_check(l.try_read().is_none());
+        coding_check(!written.load());
+        r.reset();
+        writer.join();
+        coding_check(written.load() && *l.read() == 8);
+    }
+    return 0;
+}
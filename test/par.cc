@@ -0,0 +1,122 @@
+#include "../src/par.cc"
+#include "check.cc"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace coding;
+using namespace coding::par;
+
+static auto fib(ThreadPool& pool, u64 n) -> u64 {
+    if (n < 2) return n;
+    auto [a, b] = pool.join([&] { return fib(pool, n - 1); }, [&] { return fib(pool, n - 2); });
+    return a + b;
+}
+
+// Sorted by `key` only, `seq` records where equal keys started out.
+struct Item {
+    u32 key;
+    u32 seq;
+    inline auto operator==(Item const&) const -> bool = default;
+};
+
+// Not default constructible, which sorts sequentially.
+struct Boxed {
+    u32 key;
+    explicit Boxed(u32 key) : key(key) {}
+    inline auto operator==(Boxed const&) const -> bool = default;
+};
+
+auto main() -> int {
+    auto pool = ThreadPool(4);
+    auto rng = std::mt19937_64(27);
+
+    // `join` runs both sides and returns their results in order, `unit` for `void`.
+    coding_check(fib(pool, 20) == 6765);
+    auto side = std::atomic<int>(0);
+    auto [x, y] = pool.join([&] { side++; }, [] { return 5; });
+    coding_check(side == 1 && y == 5 && x == unit());
+    coding_check(thread::join([] { return 1; }, [] { return 2; }) == std::pair(1, 2));
+
+    for (auto n : { (usize)0, (usize)1, (usize)7, (usize)1000, (usize)100003 }) {
+        auto v = std::vector<u64>(n);
+        for (auto& e : v) e = rng() % 1000;
+        auto total = std::accumulate(v.begin(), v.end(), (u64)0);
+        auto it = par_iter(v).in(pool).with_min_len(1);
+
+        // Sums and reductions match the sequential ones, and are the identity on nothing.
+        coding_check(it.sum() == total);
+        coding_check(it.count() == n);
+        auto max = it.reduce([] { return (u64)0; }, [](u64 a, u64 b) { return std::max(a, b); });
+        coding_check(max == (n ? *std::max_element(v.begin(), v.end()) : 0));
+        coding_check(par_range(0, n).in(pool).map([](usize i) { return (u64)i * i; }).sum() == (n ? (u64)(n - 1) * n * (2 * n - 1) / 6 : 0));
+
+        // `collect` keeps the order, through fused `map` and `filter` which see each element once.
+        auto maps = std::atomic<usize>(0);
+        auto tests = std::atomic<usize>(0);
+        auto got = it
+            .map([&](u64 const& e) { maps++; return e * 3; })
+            .filter([&](u64 const& e) { tests++; return e % 2 == 0; })
+            .map([](u64 e) { return e + 1; })
+            .collect();
+        auto expect = std::vector<u64>();
+        for (auto e : v) {
+            if (e * 3 % 2 == 0) expect.push_back(e * 3 + 1);
+        }
+        coding_check(got == expect);
+        coding_check(maps == n && tests == n);
+        auto indices = std::vector<usize>(n);
+        std::iota(indices.begin(), indices.end(), (usize)5);
+        coding_check(par_range(5, 5 + n).in(pool).collect() == indices);
+
+        // Chunks cover the range in order, the last one shorter.
+        auto sums = par_chunks(v, 64).in(pool).map([](std::span<u64> c) { return std::accumulate(c.begin(), c.end(), (u64)0); }).collect();
+        coding_check(sums.size() == (n + 63) / 64);
+        coding_check(std::accumulate(sums.begin(), sums.end(), (u64)0) == total);
+
+        // `for_each` reaches every element once, by reference.
+        par_iter(v).in(pool).for_each([](u64& e) { e += 1; });
+        par_for_each(v, [](u64& e) { e *= 2; });
+        coding_check(par_iter(v).in(pool).sum() == 2 * (total + n));
+    }
+
+    // `par_sort` is stable: equal keys keep their order, exactly like `std::stable_sort`.
+    for (auto n : { (usize)0, (usize)1, (usize)100, SORT_CUT - 1, SORT_CUT, SORT_CUT + 1, MERGE_CUT * 3 + 17, (usize)300000 }) {
+        for (auto keys : { (u32)2, (u32)16, (u32)1000, (u32)1 << 30 }) {
+            auto v = std::vector<Item>(n);
+            for (auto i = (usize)0; i < n; i++) v[i] = Item{ (u32)(rng() % keys), (u32)i };
+            auto by_key = [](Item const& a, Item const& b) { return a.key < b.key; };
+            auto expect = v;
+            std::stable_sort(expect.begin(), expect.end(), by_key);
+            auto got = v;
+            par_sort(got, by_key);
+            coding_check(got == expect);
+
+            // Descending, still stable.
+            auto down = [](Item const& a, Item const& b) { return a.key > b.key; };
+            expect = v;
+            std::stable_sort(expect.begin(), expect.end(), down);
+            got = v;
+            par_sort(got, down);
+            coding_check(got == expect);
+
+            // Unstable: ordered by key, and the same items.
+            got = v;
+            par_sort_unstable(got, by_key);
+            coding_check(std::is_sorted(got.begin(), got.end(), by_key));
+            auto by_seq = [](Item const& a, Item const& b) { return a.seq < b.seq; };
+            std::sort(got.begin(), got.end(), by_seq);
+            coding_check(got == v);
+        }
+    }
+    auto boxed = std::vector<Boxed>();
+    for (auto i = 0; i < 5000; i++) boxed.emplace_back((u32)(rng() % 100));
+    auto expect = boxed;
+    std::stable_sort(expect.begin(), expect.end(), [](Boxed const& a, Boxed const& b) { return a.key < b.key; });
+    par_sort(boxed, [](Boxed const& a, Boxed const& b) { return a.key < b.key; });
+    coding_check(boxed == expect);
+    return 0;
+}
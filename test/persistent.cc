@@ -0,0 +1,138 @@
+#include "../src/persistent.cc"
+#include "check.cc"
+
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+// Hashes of keys equal modulo `M`, only in the top bits, so that paths run through single-child nodes down
+// to collision nodes, and many keys share one full hash.
+template<u64 M>
+struct Clumped final {
+
+    struct Hasher final {
+
+        u64 state = 0;
+
+        inline auto write(void const*, usize) noexcept -> void {}
+
+        inline auto write_u64(u64 x) noexcept -> void {
+            this->state = x % M;
+        }
+
+        inline auto finish() const noexcept -> u64 {
+            return this->state << 54 | (this->state & 1);
+        }
+    };
+
+    inline auto build_hasher() const noexcept -> Hasher {
+        return Hasher();
+    }
+};
+
+template<typename Map>
+static auto same(Map const& map, std::map<u64, std::string> const& model) -> void {
+    coding_check(map.len() == model.size());
+    auto n = (usize)0;
+    for (auto& [k, v] : map) {
+        coding_check(model.at(k) == v);
+        n++;
+    }
+    coding_check(n == model.size());
+    for (auto& [k, v] : model) coding_check(map.get(k) && *map.get(k) == v);
+}
+
+// Random updates in place and through `with`/`without`, keeping snapshots that must never change.
+template<typename Map>
+static auto random_ops(u64 space) -> void {
+    auto rng = std::mt19937_64(47);
+    auto map = Map();
+    auto model = std::map<u64, std::string>();
+    auto snapshots = std::vector<std::pair<Map, std::map<u64, std::string>>>();
+    for (auto step = (u64)0; step < 40000; step++) {
+        auto k = rng() % space;
+        auto v = std::string(20, 'h') + std::to_string(step);
+        switch (rng() % 4) {
+        case 0: {
+            auto old = map.insert(k, v);
+            coding_check(old.is_some() == model.contains(k));
+            model[k] = v;
+            break;
+        }
+        case 1:
+            map = map.with(k, v);
+            model[k] = v;
+            break;
+        case 2: {
+            auto old = map.remove(k);
+            coding_check(old.is_some() == (model.erase(k) == 1));
+            break;
+        }
+        default:
+            map = map.without(k);
+            model.erase(k);
+        }
+        if (step % 4000 == 0) snapshots.emplace_back(map, model);
+    }
+    same(map, model);
+    for (auto& [snapshot, then] : snapshots) same(snapshot, then);
+    for (auto& [k, v] : std::map(model)) coding_check(map.remove(k).is_some());
+    coding_check(map.is_empty() && map.begin() == map.end());
+    for (auto& [snapshot, then] : snapshots) same(snapshot, then);
+}
+
+static auto vec_ops() -> void {
+    auto rng = std::mt19937_64(7);
+    auto vec = PersistentVec<std::string>();
+    auto model = std::vector<std::string>();
+    auto snapshots = std::vector<std::pair<PersistentVec<std::string>, std::vector<std::string>>>();
+    // Grow past three levels, with a shrinking phase crossing the tail and level boundaries back down.
+    for (auto step = 0; step < 120000; step++) {
+        auto op = rng() % 10;
+        if (op < 6 || model.empty() || step < 40000) {
+            vec.push_back(std::to_string(step));
+            model.push_back(std::to_string(step));
+        }
+        else if (op < 8 || step > 80000) {
+            coding_check(vec.pop_back().unwrap() == model.back());
+            model.pop_back();
+        }
+        else {
+            auto i = rng() % model.size();
+            vec.set(i, "set" + std::to_string(step));
+            model[i] = "set" + std::to_string(step);
+        }
+        if (step % 10007 == 0) snapshots.emplace_back(vec, model);
+    }
+    for (auto& [snapshot, then] : snapshots) {
+        coding_check(snapshot.len() == then.size());
+        for (auto i = (usize)0; i < then.size(); i++) coding_check(snapshot[i] == then[i]);
+    }
+    coding_check(std::equal(vec.begin(), vec.end(), model.begin(), model.end()));
+}
+
+auto main() -> int {
+    random_ops<PersistentHashMap<u64, std::string>>(3000);
+    random_ops<PersistentHashMap<u64, std::string, persistent::Local>>(3000);
+    random_ops<PersistentHashMap<u64, std::string, persistent::Atomic, Clumped<64>>>(600);
+    vec_ops();
+
+    // Snapshots shared by threads, each changing its own copy and dropping it, the shared nodes untouched.
+    auto base = PersistentHashMap<u64, std::string>();
+    for (auto k = (u64)0; k < 5000; k++) base.insert(k, std::to_string(k));
+    auto threads = std::vector<std::thread>();
+    for (auto t = (u64)0; t < 4; t++) {
+        threads.emplace_back([base, t]() mutable {
+            for (auto k = t; k < 5000; k += 4) base.remove(k);
+            for (auto k = (u64)0; k < 5000; k++) coding_check(base.contains(k) == (k % 4 != t));
+        });
+    }
+    for (auto& t : threads) t.join();
+    coding_check(base.len() == 5000 && *base.get((u64)4321) == "4321");
+    return 0;
+}
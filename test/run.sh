@@ -0,0 +1,25 @@
+#!/bin/sh
+# Build and run the test drivers, all of them or those named: `test/run.sh [smallvec ...]`.
+# Drivers are single files including the headers under `src/` by relative path, built with the sanitizers by default;
+# a driver too slow for them names its own flags on a first line `// flags: ...`.
+set -e
+dir=$(cd "$(dirname "$0")" && pwd)
+out=${TMPDIR:-/tmp}/coding-test
+mkdir -p "$out"
+cxx=${CXX:-g++}
+flags=${CXXFLAGS:--std=c++20 -O1 -g -Wall -pthread -fsanitize=address,undefined}
+names=$*
+if [ -z "$names" ]; then
+    names=$(cd "$dir" && ls *.cc | sed 's/\.cc$//' | grep -v '^check$')
+fi
+failed=0
+for name in $names; do
+    own=$(sed -n '1s|^// flags: ||p' "$dir/$name.cc")
+    if $cxx ${own:-$flags} "$dir/$name.cc" -o "$out/$name" && "$out/$name"; then
+        echo "ok   $name"
+    else
+        echo "FAIL $name"
+        failed=1
+    fi
+done
+exit $failed
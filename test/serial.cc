@@ -0,0 +1,56 @@
+#include "../src/serial.cc"
+#include "check.cc"
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace coding;
+using namespace coding::collections;
+
+static auto open_fds() -> usize {
+    auto it = std::filesystem::directory_iterator("/proc/self/fd");
+    return (usize)std::distance(begin(it), end(it));
+}
+
+auto main() -> int {
+    // Maps name their key and mapped types, and become `Map`s.
+    auto words = HashMap<String, std::vector<u32>>();
+    words.insert(String("one"), std::vector<u32>{ 1 });
+    words.insert(String("two"), std::vector<u32>{ 1, 2 });
+    static_assert(std::same_as<serial::Stored<decltype(words)>, serial::Map<serial::Str, serial::Vec<u32>>>);
+    static_assert(std::same_as<serial::Stored<std::map<u32, f64>>, serial::Map<u32, f64>>);
+    auto bytes = serial::encode(words);
+    auto map = serial::load<decltype(words)>(bytes).unwrap();
+    coding_check(map->len() == 2 && map->get(str("two"))->len() == 2 && !map->contains(str("three")));
+
+    // A vector of pairs is a sequence, and keeps its order and duplicate keys.
+    using Pairs = std::vector<KeyValue<u32, u32>>;
+    static_assert(std::same_as<serial::Stored<Pairs>, serial::Vec<KeyValue<u32, u32>>>);
+    auto pairs = Pairs{ { 3, 30 }, { 1, 10 }, { 3, 31 } };
+    bytes = serial::encode(pairs);
+    auto seq = serial::load<Pairs>(bytes).unwrap();
+    coding_check(seq->len() == 3);
+    for (auto i = (usize)0; i < 3; i++) coding_check(seq->get(i)->key == pairs[i].key && seq->get(i)->value == pairs[i].value);
+
+    // Saving round trips through a file, and failures leave no descriptor or temporary file behind.
+    auto dir = std::string("/tmp/coding-test-serial.") + std::to_string(getpid());
+    std::filesystem::create_directory(dir);
+    auto path = dir + "/words";
+    coding_check(serial::save(str(path.c_str()), words).is_ok());
+    auto image = serial::Image<decltype(words)>::open(str(path.c_str())).unwrap();
+    coding_check(image->len() == 2 && image->get(str("one"))->len() == 1);
+    auto fds = open_fds();
+    auto blocked = dir + "/blocked";
+    std::filesystem::create_directories(blocked + "/inside");
+    coding_check(serial::save(str(blocked.c_str()), words).is_err());
+    coding_check(serial::save(str((dir + "/missing/words").c_str()), words).is_err());
+    coding_check(open_fds() == fds);
+    coding_check(!std::filesystem::exists(blocked + ".tmp"));
+    std::filesystem::remove_all(dir);
+    return 0;
+}
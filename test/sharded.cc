@@ -0,0 +1,43 @@
+#include "../src/sharded.cc"
+#include "check.cc"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace coding;
+
+auto main() -> int {
+    auto main_index = thread::index();
+    auto counter = thread::Counter<u64>(4);
+    // Hundreds of threads, at most three alive at once, keep to the indices of those three and the main thread.
+    auto highest = std::atomic<usize>(0);
+    for (auto round = 0; round < 100; round++) {
+        auto threads = std::vector<std::thread>();
+        for (auto t = 0; t < 3; t++) {
+            threads.emplace_back([&] {
+                auto i = thread::index();
+                for (auto seen = highest.load(); i > seen && !highest.compare_exchange_weak(seen, i););
+                for (auto k = 0; k < 1000; k++) counter.add(1);
+            });
+        }
+        for (auto& t : threads) t.join();
+    }
+    coding_check(highest.load() <= 3 && main_index <= 3);
+    coding_check(counter.read() == 300 * 1000);
+
+    // More threads alive than shards: the extra ones share the overflow shard, losing nothing.
+    auto gauge = thread::MaxGauge<i64>(2);
+    auto total = thread::Counter<u64>(2);
+    auto threads = std::vector<std::thread>();
+    for (auto t = 0; t < 16; t++) {
+        threads.emplace_back([&, t] {
+            for (auto k = 0; k < 10000; k++) total.add(1);
+            gauge.add(t);
+        });
+    }
+    for (auto& t : threads) t.join();
+    coding_check(total.read() == 16 * 10000);
+    coding_check(gauge.read() == 15);
+    return 0;
+}
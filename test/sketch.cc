@@ -0,0 +1,131 @@
+// flags: -std=c++20 -O1 -g -Wall -pthread -march=native -fsanitize=address,undefined
+#include "../src/sketch.cc"
+#include "check.cc"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace coding;
+using namespace coding::sketch;
+
+// Distinct keys from a seed, the top bit clear so that keys with it set are never inserted.
+static auto keys(std::mt19937_64& rng, usize n) -> std::vector<u64> {
+    auto out = std::vector<u64>(n);
+    for (auto i = (usize)0; i < n; i++) out[i] = rng() << 23 >> 1 | i;
+    return out;
+}
+
+// Every inserted key is found, and absent keys pass at about the rate asked for: within 4 sigma of a binomial over
+// the probes, and 10% for the Poisson model of block loads sizing the filter.
+static auto bloom(std::mt19937_64& rng) -> void {
+    for (auto fpp : { 0.05, 0.01, 0.001 }) {
+        for (auto n : { (usize)1, (usize)1000, (usize)100000 }) {
+            auto in = keys(rng, n);
+            auto filter = Bloom<u64>(n, fpp);
+            for (auto i = (usize)0; i < n / 2; i++) filter.insert(in[i]);
+            filter.insert_all(std::span<u64 const>(in).subspan(n / 2));
+            for (auto k : in) coding_check(filter.contains(k));
+
+            auto probes = (usize)200000;
+            auto hits = (usize)0;
+            for (auto i = (usize)0; i < probes; i++) hits += filter.contains(rng() | (u64)1 << 63);
+            auto rate = (double)hits / (double)probes;
+            coding_check(rate <= fpp * 1.1 + 4 * std::sqrt(fpp / (double)probes));
+
+            // Two halves merged find everything either did.
+            auto a = Bloom<u64>(n, fpp);
+            auto b = Bloom<u64>(n, fpp);
+            coding_check(a.size() == filter.size());
+            for (auto i = (usize)0; i < n; i++) (i % 2 ? a : b).insert(in[i]);
+            a.merge(b);
+            for (auto k : in) coding_check(a.contains(k));
+            a.clear();
+            coding_check(!a.contains(in[0]));
+        }
+    }
+}
+
+// Estimates within 3 standard errors, `1.04 / sqrt(m)`, from empty to a million, and unmoved by repeats and merges.
+// Each count is checked on the median of five independently seeded estimators, so twelve checks at 3 sigma do not
+// make a single unlucky estimate fail the run.
+static auto hyperloglog(std::mt19937_64& rng) -> void {
+    for (auto p : { (u32)10, (u32)14 }) {
+        auto sigma = 1.04 / std::sqrt((double)((usize)1 << p));
+        coding_check(HyperLogLog<u64>(p).estimate() == 0);
+        for (auto n : { (usize)1, (usize)10, (usize)1000, (usize)20000, (usize)300000, (usize)1000000 }) {
+            auto in = keys(rng, n);
+            auto estimates = std::vector<double>();
+            for (auto seed = (u64)0; seed < 5; seed++) {
+                auto h = HyperLogLog<u64>(p, hash::FixedState{ seed });
+                h.insert_all(in);
+                estimates.push_back(h.estimate());
+            }
+            std::sort(estimates.begin(), estimates.end());
+            coding_check(std::abs(estimates[2] - (double)n) <= 3 * sigma * (double)n + 0.5);
+
+            auto h = HyperLogLog<u64>(p);
+            h.insert_all(in);
+            auto e = h.estimate();
+            for (auto i = (usize)0; i < n; i += 3) h.insert(in[i]);
+            coding_check(h.estimate() == e);
+
+            auto a = HyperLogLog<u64>(p);
+            auto b = HyperLogLog<u64>(p);
+            for (auto i = (usize)0; i < n; i++) (i % 3 ? a : b).insert(in[i]);
+            a.merge(b);
+            coding_check(a.estimate() == e);
+        }
+    }
+}
+
+// Skewed counts: no estimate is ever below the truth, and those above it by more than `epsilon` times the total
+// are at most a `delta` share, with some room.
+static auto countmin(std::mt19937_64& rng) -> void {
+    for (auto [epsilon, delta] : { std::pair(0.01, 0.05), std::pair(0.001, 0.01) }) {
+        auto sketch = CountMin<u64>(epsilon, delta);
+        auto half = CountMin<u64>(epsilon, delta);
+        auto truth = std::unordered_map<u64, u64>();
+        auto total = (u64)0;
+        for (auto i = 0; i < 200000; i++) {
+            // About a Zipf law: small keys far more often.
+            auto k = (u64)std::exp(std::uniform_real_distribution<double>(0, std::log(100000.0))(rng));
+            auto count = (u32)(rng() % 3 + 1);
+            auto& t = truth[k];
+            t += count;
+            total += count;
+            auto& into = i % 2 ? sketch : half;
+            auto e = into.add(k, count);
+            coding_check(e == into.estimate(k));
+        }
+        sketch.merge(half);
+        auto batch = std::vector<u64>();
+        for (auto i = 0; i < 5000; i++) batch.push_back(rng() % 50);
+        sketch.add_all(batch);
+        for (auto k : batch) {
+            truth[k]++;
+            total++;
+        }
+        coding_check(sketch.total() == total);
+
+        auto over = (usize)0;
+        for (auto [k, t] : truth) {
+            auto e = sketch.estimate(k);
+            coding_check(e >= t);
+            if ((double)(e - t) > epsilon * (double)total) over++;
+        }
+        coding_check((double)over <= 1.5 * delta * (double)truth.size() + 3);
+        sketch.clear();
+        coding_check(sketch.total() == 0 && sketch.estimate(1) == 0);
+    }
+}
+
+auto main() -> int {
+    auto rng = std::mt19937_64(44);
+    bloom(rng);
+    hyperloglog(rng);
+    countmin(rng);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include "../src/slog.cc"
+#include "check.cc"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+using namespace coding;
+
+// Every line written, in order.
+static auto lines = std::string();
+static auto lock = std::mutex();
+
+struct Capture final : log::Sink {
+    inline auto write(std::span<iovec const> batch) noexcept -> void override {
+        auto guard = std::lock_guard(lock);
+        for (auto& v : batch) lines.append(static_cast<char const*>(v.iov_base), v.iov_len);
+    }
+};
+
+// The part of the last line from `from` on, without the newline.
+static auto tail(std::string_view from) -> std::string {
+    log::flush();
+    auto guard = std::lock_guard(lock);
+    auto line = std::string_view(lines).substr(std::string_view(lines).rfind('\n', lines.size() - 2) + 1);
+    auto at = line.find(from);
+    return at == line.npos ? std::string() : std::string(line.substr(at, line.size() - at - 1));
+}
+
+auto main() -> int {
+    log::set_sink(std::make_unique<Capture>());
+
+    // Plain names stay bare in logfmt.
+    log::set_format(log::Format::Logfmt);
+    log::structured(log::LOG_LEVEL_INFO, "src/app.cc", 7, "hi", "path", "/x");
+    coding_check(tail(" at=") == " at=src/app.cc:7 msg=hi path=/x");
+
+    // Names with spaces, quotes or control bytes are quoted and escaped, keys like values.
+    log::structured(log::LOG_LEVEL_INFO, "my \"dir\"/a.cc", 8, "hi", "bad key", 1, "k=v", "x\n");
+    coding_check(tail(" at=") == " at=\"my \\\"dir\\\"/a.cc:8\" msg=hi \"bad key\"=1 \"k=v\"=\"x\\n\"");
+
+    // JSON escapes the file and the keys alike.
+    log::set_format(log::Format::Json);
+    log::structured(log::LOG_LEVEL_INFO, "c:\\src\\a.cc", 9, "hi", "q\"k", true);
+    coding_check(tail("\"at\"") == "\"at\":\"c:\\\\src\\\\a.cc:9\",\"msg\":\"hi\",\"q\\\"k\":true}");
+    log::structured(log::LOG_LEVEL_INFO, "a\x01.cc", 10, "hi");
+    coding_check(tail("\"at\"") == "\"at\":\"a\\u0001.cc:10\",\"msg\":\"hi\"}");
+    return 0;
+}
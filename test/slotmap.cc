@@ -0,0 +1,87 @@
+// flags: -std=c++20 -O2 -g -Wall -pthread
+#include "../src/slotmap.cc"
+#include "check.cc"
+
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+// Random inserts and removals against `std::map`, with every key ever issued kept to check stale ones stay dead.
+static auto random_ops() -> void {
+    auto rng = std::mt19937_64(49);
+    auto map = SlotMap<u64>();
+    auto model = std::map<u64, u64>();
+    auto dead = std::vector<Key>();
+    auto live = std::vector<Key>();
+    for (auto step = (u64)0; step < 200000; step++) {
+        if (live.empty() || rng() % 5 < 3) {
+            auto key = map.insert(step);
+            coding_check((key.version & 1) == 1);
+            coding_check(!model.contains(key.to_bits()));
+            model[key.to_bits()] = step;
+            live.push_back(key);
+        } else {
+            auto at = rng() % live.size();
+            auto key = live[at];
+            live[at] = live.back();
+            live.pop_back();
+            auto value = map.remove(key);
+            coding_check(value.is_some() && value.unwrap() == model[key.to_bits()]);
+            model.erase(key.to_bits());
+            coding_check(map.remove(key).is_none());
+            dead.push_back(key);
+        }
+        if (step % 997 == 0) {
+            coding_check(map.len() == model.size());
+            for (auto [key, value] : map) coding_check(model.at(key.to_bits()) == value);
+            for (auto key : dead) coding_check(!map.contains(key) && map.get(key) == nullptr);
+        }
+    }
+    map.clear();
+    for (auto key : live) coding_check(!map.contains(key));
+    coding_check(!map.contains(Key()));
+}
+
+// One slot inserted into and removed from until its versions run out: it is retired, never handing out 1 again.
+static auto version_wrap() -> void {
+    auto map = SlotMap<u32>();
+    auto first = map.insert(0);
+    map.remove(first);
+    auto last = Key();
+    for (auto i = (u64)1; i < ((u64)1 << 31); i++) {
+        last = map.insert((u32)i);
+        map.remove(last);
+    }
+    coding_check(last.index == first.index && last.version == slot::END);
+    auto next = map.insert(1);
+    coding_check(next.index != first.index);
+    coding_check(!map.contains(first) && !map.contains(last));
+    coding_check(map.len() == 1 && map[next] == 1);
+}
+
+static auto arena() -> void {
+    auto arena = Arena<std::vector<u32>>();
+    auto ids = std::vector<Id<std::vector<u32>>>();
+    for (auto i = (u32)0; i < 5000; i++) ids.push_back(arena.alloc(std::vector<u32>(i % 7, i)));
+    auto first = &arena[ids[0]];
+    for (auto i = (u32)0; i < 5000; i++) coding_check(ids[i].index == i && arena[ids[i]] == std::vector<u32>(i % 7, i));
+    coding_check(&arena[ids[0]] == first);
+    auto n = (u32)0;
+    for (auto& v : arena) {
+        coding_check(v == std::vector<u32>(n % 7, n));
+        n++;
+    }
+    coding_check(n == 5000);
+    arena.clear();
+    coding_check(arena.is_empty() && !arena.contains(ids[0]));
+}
+
+auto main() -> int {
+    random_ops();
+    arena();
+    version_wrap();
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include "../src/smallvec.cc"
+#include "check.cc"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace coding;
+using namespace coding::collections;
+
+template<typename V, typename S>
+static auto same(V const& v, S const& s) -> bool {
+    return v.size() == s.size() && std::equal(v.begin(), v.end(), s.begin());
+}
+
+// Elements passed back into the vector they come from, growing it or not.
+template<typename T, typename Make>
+static auto aliasing(Make make) -> void {
+    for (auto start = (usize)1; start <= 9; start++) {
+        auto v = SmallVec<T, 4>();
+        auto s = std::vector<T>();
+        for (auto i = (usize)0; i < start; i++) v.push_back(make(i)), s.push_back(make(i));
+        for (auto round = 0; round < 6; round++) {
+            v.push_back(v[0]);
+            s.push_back(T(s[0]));
+            coding_check(same(v, s));
+            v.emplace_back(v.back());
+            s.emplace_back(T(s.back()));
+            coding_check(same(v, s));
+        }
+        auto t = s;
+        s.insert(s.begin() + 1, t.begin(), t.end());
+        v.insert(v.begin() + 1, v.begin(), v.end());
+        coding_check(same(v, s));
+        // Enough room this time, so the range is copied after the elements and rotated in.
+        v.reserve(v.size() * 3);
+        t = s;
+        s.insert(s.begin() + 2, t.begin() + 1, t.begin() + 4);
+        v.insert(v.begin() + 2, v.begin() + 1, v.begin() + 4);
+        coding_check(same(v, s));
+        s.resize(s.size() * 2 + 50, T(s[1]));
+        v.resize(v.size() * 2 + 50, v[1]);
+        coding_check(same(v, s));
+    }
+}
+
+// Random operations against `std::vector`, across the inline and heap states.
+template<typename T, typename Make>
+static auto random_ops(Make make) -> void {
+    auto rng = std::mt19937_64(41);
+    auto v = SmallVec<T, 8>();
+    auto s = std::vector<T>();
+    for (auto step = (usize)0; step < 20000; step++) {
+        auto op = rng() % 8;
+        auto at = s.empty() ? 0 : rng() % (s.size() + 1);
+        if (op < 3) v.push_back(make(step)), s.push_back(make(step));
+        else if (op == 3) v.insert(v.begin() + at, make(step)), s.insert(s.begin() + at, make(step));
+        else if (op == 4 && !s.empty()) v.pop_back(), s.pop_back();
+        else if (op == 5 && at < s.size()) v.erase(v.begin() + at), s.erase(s.begin() + at);
+        else if (op == 6) {
+            auto n = rng() % 5;
+            auto more = std::vector<T>();
+            for (auto i = (usize)0; i < n; i++) more.push_back(make(step + i));
+            v.insert(v.begin() + at, more.begin(), more.end());
+            s.insert(s.begin() + at, more.begin(), more.end());
+        }
+        else if (op == 7 && rng() % 64 == 0) v.shrink_to_fit(), v.clear(), s.clear();
+        coding_check(same(v, s));
+    }
+    auto copy = v;
+    auto moved = mv(copy);
+    coding_check(same(moved, s) && copy.empty());
+}
+
+auto main() -> int {
+    auto number = [](usize i) { return (u64)i * 2654435761u; };
+    // Long enough to live on the heap, so reading a moved-from or freed one is caught.
+    auto text = [](usize i) { return std::string(40, (char)('a' + i % 26)) + std::to_string(i); };
+    aliasing<u64>(number);
+    aliasing<std::string>(text);
+    random_ops<u64>(number);
+    random_ops<std::string>(text);
+    auto a = ArrayVec<u32, 4>{ 1, 2, 3 };
+    a.push_back(a[0]);
+    coding_check(a.size() == 4 && a[3] == 1 && !a.try_push_back(a[0]));
+    return 0;
+}
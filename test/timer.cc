@@ -0,0 +1,168 @@
+#include "../src/timer.cc"
+#include "check.cc"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace coding;
+using namespace coding::thread;
+
+// A wheel beside a model of when each timer is due, checked tick for tick on every advance.
+struct Checked final {
+
+    struct Timer {
+        TimerId id;
+        u64 expires;
+        u64 period;
+        bool live;
+    };
+
+    TimerWheel wheel;
+
+    std::vector<Timer> timers;
+
+    std::multimap<u64, usize> due;
+
+    std::vector<std::pair<u64, usize>> fired;
+
+    auto insert(u64 expires, u64 period = 0) -> usize {
+        auto k = this->timers.size();
+        auto id = this->wheel.insert(expires, [this, k] { this->fired.emplace_back(this->wheel.now(), k); }, period);
+        this->timers.push_back({ id, expires, period, true });
+        this->due.emplace(std::max(expires, this->wheel.now()), k);
+        return k;
+    }
+
+    // A few periodic timers at a time, so long advances stay quick.
+    auto periodic() const -> usize {
+        return (usize)std::count_if(this->timers.begin(), this->timers.end(), [](Timer const& t) { return t.live && t.period; });
+    }
+
+    auto cancel(usize k) -> void {
+        auto& t = this->timers[k];
+        coding_check(this->wheel.cancel(t.id) == t.live);
+        coding_check(!this->wheel.cancel(t.id));
+        if (!t.live) return;
+        t.live = false;
+        for (auto it = this->due.begin(); it != this->due.end(); ++it) {
+            if (it->second == k) {
+                this->due.erase(it);
+                break;
+            }
+        }
+    }
+
+    auto advance(u64 to) -> void {
+        auto expect = std::vector<std::pair<u64, usize>>();
+        while (!this->due.empty() && this->due.begin()->first < to) {
+            auto [at, k] = *this->due.begin();
+            this->due.erase(this->due.begin());
+            expect.emplace_back(at, k);
+            auto& t = this->timers[k];
+            // Periodic timers keep their phase, skipping the periods they missed.
+            if (t.period) {
+                t.expires += ((at - t.expires) / t.period + 1) * t.period;
+                this->due.emplace(t.expires, k);
+            }
+            else t.live = false;
+        }
+        this->fired.clear();
+        this->wheel.advance(to, [](std::function<void()> f) { f(); });
+        coding_check(this->wheel.now() == to);
+        std::sort(expect.begin(), expect.end());
+        std::sort(this->fired.begin(), this->fired.end());
+        coding_check(this->fired == expect);
+        coding_check(this->wheel.len() == this->due.size());
+    }
+};
+
+auto main() -> int {
+    auto rng = std::mt19937_64(29);
+
+    // Delays on either side of every level boundary, and plain random ones.
+    auto const EDGES = std::vector<u64>{ 0, 1, 254, 255, 256, 257, 511, 512, 65535, 65536, 65537,
+        (1 << 24) - 1, 1 << 24, (1 << 24) + 1 };
+    for (auto round = 0; round < 4; round++) {
+        auto c = Checked();
+        for (auto op = 0; op < 3000; op++) {
+            auto now = c.wheel.now();
+            switch (rng() % 8) {
+            case 0: case 1: case 2: {
+                auto delay = rng() % 2 ? EDGES[rng() % EDGES.size()] : rng() % (rng() % 2 ? 300 : 200000);
+                auto period = rng() % 6 == 0 && c.periodic() < 8 ? 1 + rng() % 700 : 0;
+                c.insert(now + delay, period);
+                break;
+            }
+            case 3:
+                // Already due, some periods ago.
+                c.insert(now - std::min(now, rng() % 1000), rng() % 2 && c.periodic() < 8 ? 10 : 0);
+                break;
+            case 4:
+                if (!c.timers.empty()) c.cancel(rng() % c.timers.size());
+                break;
+            case 5: {
+                // Onto, or just around, the next wrap of a level.
+                auto span = (u64)1 << (rng() % 4 ? 8 : 16);
+                auto wrap = (now / span + 1) * span;
+                c.advance(wrap - 1 + rng() % 3);
+                break;
+            }
+            default:
+                c.advance(now + 1 + rng() % (rng() % 4 ? 50 : 5000));
+            }
+        }
+        // Drain the one-shot timers, all of them past the top level.
+        for (auto k = (usize)0; k < c.timers.size(); k++) {
+            if (c.timers[k].period) c.cancel(k);
+        }
+        c.advance(c.wheel.now() + (1 << 25));
+        for (auto k = (usize)0; k < c.timers.size(); k++) c.cancel(k);
+        coding_check(c.wheel.len() == 0);
+    }
+
+    // Cancelled while still in a higher level, and once cascaded to level 0.
+    {
+        auto c = Checked();
+        auto high = c.insert(65536 + 5);
+        auto low = c.insert(65536 + 9);
+        c.advance(300);
+        c.cancel(high);
+        c.advance(65536 + 1);
+        c.cancel(low);
+        c.advance(70000);
+        coding_check(c.fired.empty());
+    }
+
+    // An overdue periodic timer fires at once, then keeps its phase on the next tick of it.
+    {
+        auto c = Checked();
+        c.advance(1000);
+        auto k = c.insert(500, 10);
+        c.advance(1011);
+        coding_check(c.fired.size() == 2 && c.fired[0].first == 1000 && c.fired[1].first == 1010);
+        c.cancel(k);
+    }
+
+    // Past the reach of the wheel: never early, wherever the wheel stands when they are inserted.
+    {
+        auto c = Checked();
+        constexpr auto REACH = (u64)1 << 32;
+        c.insert(REACH - 1);
+        c.insert(REACH);
+        c.insert(REACH + 1000);
+        c.insert(2 * REACH + 7);
+        c.insert(2 * REACH + 65536);
+        c.advance(12345);
+        c.insert(12345 + REACH + 3);
+        c.insert(12345 + REACH + (1 << 24));
+        for (auto to = (u64)12345; to < 2 * REACH + 70000;) {
+            to = std::min(to + (rng() >> 33), 2 * REACH + 70000);
+            c.advance(to);
+        }
+        coding_check(c.wheel.len() == 0);
+    }
+    return 0;
+}